@@ -0,0 +1,343 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "builder.h"
+#include "duckdb.hpp"
+#include "pgm/pgm_index_dynamic.hpp"
+#include "radix_spline.h"
+#include "sharded_alex.h"
+#include "updatable_radix_spline.h"
+
+namespace duckdb {
+namespace bench {
+
+using Key = uint64_t;
+using Payload = double;
+using KeyValue = std::pair<Key, Payload>;
+
+// Radix table and error bound of the RadixSpline indexes of the extension.
+constexpr size_t kNumRadixBits = 18;
+constexpr size_t kMaxError = 32;
+
+// The indexes under benchmark share one interface, so the runner is a template
+// over them and calls them without virtual dispatch:
+//
+//   Build(pairs)            bulk loads the sorted, distinct pairs
+//   BuildForInserts(pairs)  bulk loads the pairs the insert benchmark starts
+//                           from
+//   Lookup(key, &payload)   returns whether `key` is there
+//   RangeSum(lo, hi)        sums the payloads of the keys in [lo, hi)
+//   Insert(key, payload)    inserts the key, or sets its payload if it is
+//                           there
+//   Update(key, payload)    sets the payload of a key that is there
+//   FinishInserts()         completes work the inserts left in the background
+//   SizeInBytes()
+//
+// and two flags: `kConcurrentLookups`, whether threads may call `Lookup` on
+// one built index at the same time, which the scaling benchmark needs, and
+// `kPayloadsAfterInserts`, whether after `BuildForInserts` the index takes
+// lookups, range sums and updates as well as inserts, which YCSB needs.
+
+// The ALEX index of the extension, with nodes from the memory pool.
+//
+// Concurrent lookups race on the cost model counters ALEX bumps, as they do
+// in the extension, see sharded_alex.h; the scaling benchmark includes what
+// that costs in cache line traffic.
+class AlexBenchIndex {
+ public:
+  static constexpr const char* kName = "alex";
+  static constexpr bool kConcurrentLookups = true;
+  static constexpr bool kPayloadsAfterInserts = true;
+
+  void Build(const std::vector<KeyValue>& pairs) {
+    index_ = std::make_unique<AlexIndex<Key, Payload>>();
+    index_->bulk_load(pairs.data(), static_cast<int>(pairs.size()));
+  }
+
+  void BuildForInserts(const std::vector<KeyValue>& pairs) { Build(pairs); }
+
+  bool Lookup(Key key, Payload* payload) const {
+    const Payload* found = index_->get_payload(key);
+    if (!found) return false;
+    *payload = *found;
+    return true;
+  }
+
+  Payload RangeSum(Key lo, Key hi) const {
+    Payload sum = 0;
+    for (auto it = index_->lower_bound(lo); it != index_->end() && it.key() < hi;
+         it++)
+      sum += it.payload();
+    return sum;
+  }
+
+  // ALEX keeps duplicate keys, the other indexes keep one payload per key.
+  void Insert(Key key, Payload payload) {
+    Payload* found = index_->get_payload(key);
+    if (found)
+      *found = payload;
+    else
+      index_->insert(key, payload);
+  }
+
+  void Update(Key key, Payload payload) {
+    Payload* found = index_->get_payload(key);
+    if (found) *found = payload;
+  }
+
+  void FinishInserts() {}
+
+  size_t SizeInBytes() const {
+    return index_->model_size() + index_->data_size();
+  }
+
+ private:
+  std::unique_ptr<AlexIndex<Key, Payload>> index_;
+};
+
+// The dynamic PGM index the extension keeps for writable columns.
+class PGMBenchIndex {
+ public:
+  static constexpr const char* kName = "pgm";
+  static constexpr bool kConcurrentLookups = true;
+  static constexpr bool kPayloadsAfterInserts = true;
+
+  void Build(const std::vector<KeyValue>& pairs) {
+    index_ = std::make_unique<pgm::DynamicPGMIndex<Key, Payload>>(pairs.begin(),
+                                                                  pairs.end());
+  }
+
+  void BuildForInserts(const std::vector<KeyValue>& pairs) { Build(pairs); }
+
+  bool Lookup(Key key, Payload* payload) const {
+    const auto it = index_->find(key);
+    if (it == index_->end()) return false;
+    *payload = it->second;
+    return true;
+  }
+
+  Payload RangeSum(Key lo, Key hi) const {
+    Payload sum = 0;
+    for (auto it = index_->lower_bound(lo); it != index_->end() && it->first < hi;
+         ++it)
+      sum += it->second;
+    return sum;
+  }
+
+  void Insert(Key key, Payload payload) {
+    index_->insert_or_assign(key, payload);
+  }
+
+  void Update(Key key, Payload payload) {
+    index_->insert_or_assign(key, payload);
+  }
+
+  void FinishInserts() {}
+
+  size_t SizeInBytes() const { return index_->size_in_bytes(); }
+
+ private:
+  std::unique_ptr<pgm::DynamicPGMIndex<Key, Payload>> index_;
+};
+
+// A RadixSpline over the sorted keys with the payloads in a parallel array.
+// The spline itself is read-only, so the insert benchmark measures the
+// `UpdatableRadixSpline` of the extension instead, which buffers new keys in
+// a sorted delta and merges them in the background. That one keeps no
+// payloads, like the spline indexes of the extension, which find rows of the
+// table, so after `BuildForInserts` it only takes inserts.
+class RadixSplineBenchIndex {
+ public:
+  static constexpr const char* kName = "radixspline";
+  static constexpr bool kConcurrentLookups = true;
+  static constexpr bool kPayloadsAfterInserts = false;
+
+  void Build(const std::vector<KeyValue>& pairs) {
+    updatable_.reset();
+    keys_.clear();
+    payloads_.clear();
+    keys_.reserve(pairs.size());
+    payloads_.reserve(pairs.size());
+    for (const auto& pair : pairs) {
+      keys_.push_back(pair.first);
+      payloads_.push_back(pair.second);
+    }
+    const Key min_key = keys_.empty() ? 0 : keys_.front();
+    const Key max_key = keys_.empty() ? 0 : keys_.back();
+    rs::Builder<Key> builder(min_key, max_key, kNumRadixBits, kMaxError);
+    for (const Key key : keys_) builder.AddKey(key);
+    spline_ = builder.Finalize();
+  }
+
+  void BuildForInserts(const std::vector<KeyValue>& pairs) {
+    std::vector<Key> keys;
+    keys.reserve(pairs.size());
+    for (const auto& pair : pairs) keys.push_back(pair.first);
+    updatable_ = std::make_unique<rs::UpdatableRadixSpline<Key>>();
+    updatable_->Build(std::move(keys), kNumRadixBits, kMaxError);
+  }
+
+  bool Lookup(Key key, Payload* payload) const {
+    const size_t position = LowerBound(key);
+    if (position == keys_.size() || keys_[position] != key) return false;
+    *payload = payloads_[position];
+    return true;
+  }
+
+  Payload RangeSum(Key lo, Key hi) const {
+    Payload sum = 0;
+    for (size_t i = LowerBound(lo); i < keys_.size() && keys_[i] < hi; ++i)
+      sum += payloads_[i];
+    return sum;
+  }
+
+  void Insert(Key key, Payload) { updatable_->Insert(key); }
+
+  void Update(Key key, Payload payload) {
+    const size_t position = LowerBound(key);
+    if (position != keys_.size() && keys_[position] == key)
+      payloads_[position] = payload;
+  }
+
+  // Waits for the background merges of the inserts to finish, so that they
+  // are part of the measured time.
+  void FinishInserts() {
+    if (updatable_) updatable_->WaitForMerge();
+  }
+
+  size_t SizeInBytes() const {
+    if (updatable_) return updatable_->GetSize();
+    return spline_.GetSize() + keys_.capacity() * sizeof(Key) +
+           payloads_.capacity() * sizeof(Payload);
+  }
+
+ private:
+  size_t LowerBound(Key key) const {
+    if (keys_.empty()) return 0;
+    const rs::SearchBound bound = spline_.GetSearchBound(key);
+    return std::lower_bound(keys_.begin() + bound.begin,
+                            keys_.begin() + bound.end, key) -
+           keys_.begin();
+  }
+
+  std::vector<Key> keys_;
+  std::vector<Payload> payloads_;
+  rs::RadixSpline<Key> spline_;
+  std::unique_ptr<rs::UpdatableRadixSpline<Key>> updatable_;
+};
+
+// DuckDB's own ART index on a table of the pairs in an in-memory database.
+// The index is unique, so that inserts can update a key that is there. Every
+// operation is a prepared statement with bound parameters, so the
+// numbers include executing a query, but not parsing it. All of them run on
+// one connection, which can not run queries concurrently.
+class ARTBenchIndex {
+ public:
+  static constexpr const char* kName = "art";
+  static constexpr bool kConcurrentLookups = false;
+  static constexpr bool kPayloadsAfterInserts = true;
+
+  ARTBenchIndex() : database_(nullptr), connection_(database_) {}
+
+  void Build(const std::vector<KeyValue>& pairs) {
+    CreateTable();
+    Append(pairs);
+    Execute("CREATE UNIQUE INDEX bench_art ON bench(key);");
+    Prepare();
+  }
+
+  // Creates the index before appending the pairs, so that it grows the way
+  // it does on inserts.
+  void BuildForInserts(const std::vector<KeyValue>& pairs) {
+    CreateTable();
+    Execute("CREATE UNIQUE INDEX bench_art ON bench(key);");
+    Append(pairs);
+    Prepare();
+  }
+
+  bool Lookup(Key key, Payload* payload) const {
+    auto result = Run(*lookup_, {Value::UBIGINT(key)});
+    auto& rows = result->Cast<MaterializedQueryResult>();
+    if (rows.RowCount() == 0) return false;
+    *payload = rows.GetValue(0, 0).GetValue<double>();
+    return true;
+  }
+
+  Payload RangeSum(Key lo, Key hi) const {
+    auto result = Run(*range_, {Value::UBIGINT(lo), Value::UBIGINT(hi)});
+    const Value sum = result->Cast<MaterializedQueryResult>().GetValue(0, 0);
+    return sum.IsNull() ? 0 : sum.GetValue<double>();
+  }
+
+  void Insert(Key key, Payload payload) {
+    Run(*insert_, {Value::UBIGINT(key), Value::DOUBLE(payload)});
+  }
+
+  void Update(Key key, Payload payload) {
+    Run(*update_, {Value::UBIGINT(key), Value::DOUBLE(payload)});
+  }
+
+  void FinishInserts() {}
+
+  size_t SizeInBytes() const {
+    auto result = connection_.Query(
+        "SELECT memory_usage_bytes FROM duckdb_memory() WHERE tag = "
+        "'ART_INDEX';");
+    if (result->HasError() || result->RowCount() == 0) return 0;
+    return result->GetValue(0, 0).GetValue<int64_t>();
+  }
+
+ private:
+  void CreateTable() {
+    Execute("DROP TABLE IF EXISTS bench;");
+    Execute("CREATE TABLE bench(key UBIGINT, payload DOUBLE);");
+  }
+
+  void Append(const std::vector<KeyValue>& pairs) {
+    Appender appender(connection_, "bench");
+    for (const auto& pair : pairs) appender.AppendRow(pair.first, pair.second);
+    appender.Close();
+  }
+
+  // Prepared once the index exists, so that the plans use it.
+  void Prepare() {
+    lookup_ = connection_.Prepare("SELECT payload FROM bench WHERE key = $1;");
+    range_ = connection_.Prepare(
+        "SELECT sum(payload) FROM bench WHERE key >= $1 AND key < $2;");
+    insert_ = connection_.Prepare(
+        "INSERT INTO bench VALUES ($1, $2) ON CONFLICT (key) DO UPDATE SET "
+        "payload = excluded.payload;");
+    update_ = connection_.Prepare(
+        "UPDATE bench SET payload = $2 WHERE key = $1;");
+  }
+
+  void Execute(const std::string& query) {
+    auto result = connection_.Query(query);
+    if (result->HasError()) result->ThrowError();
+  }
+
+  // Materializes the result, so that the whole query is measured.
+  static unique_ptr<QueryResult> Run(PreparedStatement& statement,
+                                     vector<Value> values) {
+    auto result = statement.Execute(values, false);
+    if (result->HasError()) result->ThrowError();
+    return result;
+  }
+
+  DuckDB database_;
+  mutable Connection connection_;
+  unique_ptr<PreparedStatement> lookup_;
+  unique_ptr<PreparedStatement> range_;
+  unique_ptr<PreparedStatement> insert_;
+  unique_ptr<PreparedStatement> update_;
+};
+
+}  // namespace bench
+}  // namespace duckdb
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "perf_counters.h"
+
+namespace duckdb {
+namespace bench {
+
+// One measured repetition of a benchmark on one index.
+struct BenchResult {
+  std::string index;
+  std::string benchmark;
+  std::string dataset;
+  uint64_t num_keys = 0;
+  uint64_t operations = 0;
+  uint64_t repetition = 0;
+  // Threads the operations were split over; `seconds` is the wall time.
+  uint64_t threads = 1;
+  double seconds = 0;
+  uint64_t size_bytes = 0;
+  // Sum of the payloads found, equal across indexes that return payloads.
+  double checksum = 0;
+  // Hardware events of the timed region, if they could be counted.
+  PerfCounters::Sample counters;
+  // For the scaling benchmark, the throughput relative to `threads` times that
+  // of a single thread.
+  std::optional<double> scaling_efficiency;
+
+  double NanosPerOperation() const {
+    return operations == 0 ? 0 : seconds * 1e9 / operations;
+  }
+  double OperationsPerSecond() const {
+    return seconds == 0 ? 0 : operations / seconds;
+  }
+  double EventsPerOperation(PerfCounters::Event event) const {
+    return operations == 0 ? 0 : counters.Get(event) / operations;
+  }
+};
+
+// Writes results as CSV with a header line, or as a JSON document with the
+// configuration of the run and an array of results. Both are meant to be
+// loaded as they are, e.g. with `read_csv` or `read_json` in DuckDB. Hardware
+// events are reported per operation, as empty fields or nulls where they were
+// not counted.
+class BenchReport {
+ public:
+  enum class Format { kCsv, kJson };
+
+  void SetConfig(std::vector<std::pair<std::string, std::string>> config) {
+    config_ = std::move(config);
+  }
+
+  void Add(BenchResult result) { results_.push_back(std::move(result)); }
+
+  const std::vector<BenchResult>& results() const { return results_; }
+
+  void Write(std::ostream& out, Format format) const {
+    if (format == Format::kCsv)
+      WriteCsv(out);
+    else
+      WriteJson(out);
+  }
+
+ private:
+  void WriteCsv(std::ostream& out) const {
+    out << "index,benchmark,dataset,num_keys,operations,repetition,threads,"
+           "seconds,ns_per_op,ops_per_sec,size_bytes,checksum,"
+           "scaling_efficiency";
+    for (int event = 0; event < PerfCounters::kNumEvents; ++event)
+      out << ',' << PerfCounters::GetName(static_cast<PerfCounters::Event>(event))
+          << "_per_op";
+    out << '\n';
+    for (const auto& result : results_) {
+      out << result.index << ',' << result.benchmark << ',' << result.dataset
+          << ',' << result.num_keys << ',' << result.operations << ','
+          << result.repetition << ',' << result.threads << ','
+          << Number(result.seconds) << ','
+          << Number(result.NanosPerOperation()) << ','
+          << Number(result.OperationsPerSecond()) << ',' << result.size_bytes
+          << ',' << Number(result.checksum) << ',';
+      if (result.scaling_efficiency)
+        out << Number(*result.scaling_efficiency);
+      for (int event = 0; event < PerfCounters::kNumEvents; ++event) {
+        const auto counter = static_cast<PerfCounters::Event>(event);
+        out << ',';
+        if (result.counters.Has(counter))
+          out << Number(result.EventsPerOperation(counter));
+      }
+      out << '\n';
+    }
+  }
+
+  void WriteJson(std::ostream& out) const {
+    out << "{\n  \"config\": {";
+    for (size_t i = 0; i < config_.size(); ++i) {
+      out << (i == 0 ? "\n" : ",\n") << "    " << Quote(config_[i].first)
+          << ": " << Quote(config_[i].second);
+    }
+    out << "\n  },\n  \"results\": [";
+    for (size_t i = 0; i < results_.size(); ++i) {
+      const BenchResult& result = results_[i];
+      out << (i == 0 ? "\n" : ",\n") << "    {\"index\": "
+          << Quote(result.index) << ", \"benchmark\": "
+          << Quote(result.benchmark) << ", \"dataset\": "
+          << Quote(result.dataset) << ", \"num_keys\": " << result.num_keys
+          << ", \"operations\": " << result.operations
+          << ", \"repetition\": " << result.repetition
+          << ", \"threads\": " << result.threads
+          << ", \"seconds\": " << Number(result.seconds)
+          << ", \"ns_per_op\": " << Number(result.NanosPerOperation())
+          << ", \"ops_per_sec\": " << Number(result.OperationsPerSecond())
+          << ", \"size_bytes\": " << result.size_bytes
+          << ", \"checksum\": " << Number(result.checksum)
+          << ", \"scaling_efficiency\": "
+          << (result.scaling_efficiency ? Number(*result.scaling_efficiency)
+                                        : "null");
+      for (int event = 0; event < PerfCounters::kNumEvents; ++event) {
+        const auto counter = static_cast<PerfCounters::Event>(event);
+        out << ", " << Quote(std::string(PerfCounters::GetName(counter)) +
+                             "_per_op")
+            << ": "
+            << (result.counters.Has(counter)
+                    ? Number(result.EventsPerOperation(counter))
+                    : "null");
+      }
+      out << "}";
+    }
+    out << "\n  ]\n}\n";
+  }
+
+  static std::string Number(double value) {
+    std::ostringstream out;
+    out << std::setprecision(17) << value;
+    return out.str();
+  }
+
+  static std::string Quote(const std::string& value) {
+    std::string quoted = "\"";
+    for (const char c : value) {
+      if (c == '"' || c == '\\') {
+        quoted += '\\';
+        quoted += c;
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        std::ostringstream escape;
+        escape << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+               << static_cast<int>(c);
+        quoted += escape.str();
+      } else {
+        quoted += c;
+      }
+    }
+    return quoted + "\"";
+  }
+
+  std::vector<std::pair<std::string, std::string>> config_;
+  std::vector<BenchResult> results_;
+};
+
+}  // namespace bench
+}  // namespace duckdb
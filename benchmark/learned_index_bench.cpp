@@ -0,0 +1,713 @@
+// Standalone benchmark of the learned indexes of the alex extension against
+// DuckDB's ART. Unlike the benchmark pragmas of the extension it runs the
+// index code directly, without SQL or printing in the timed loops, and gives
+// every index the same keys, lookups, ranges and inserts:
+//
+//   learned_index_bench --distribution=lognormal --keys=10000000
+//       --indexes=alex,pgm,radixspline,art --format=csv --output=run.csv
+//
+// Every benchmark runs `--warmup` unreported and `--repetitions` reported
+// times. Results are one CSV line or JSON object per repetition, see
+// bench_report.h. Where perf events are available, the timed regions also
+// count hardware events like cache and TLB misses, see perf_counters.h.
+//
+// The `scaling` benchmark, which only runs if asked for, measures lookups
+// from 1, 2, 4, ... up to `--threads` threads at once on one built index, each
+// thread with its own stream of lookups, and reports the throughput and the
+// scaling efficiency for every thread count:
+//
+//   learned_index_bench --benchmarks=scaling --threads=32 --pin_threads=true
+//
+// The `ycsb` benchmark, which only runs if asked for too, runs a mixed
+// workload of YCSB core workload `--workload`, see ycsb.h, on an index loaded
+// the way the insert benchmark loads it. It skips the RadixSpline index, which
+// keeps no payloads once it takes inserts. The proportions of the operations
+// and the request distribution can be changed one by one:
+//
+//   learned_index_bench --benchmarks=ycsb --workload=a --update_proportion=0.2
+//       --read_proportion=0.8
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "bench_indexes.h"
+#include "bench_report.h"
+#include "utils.h"
+#include "ycsb.h"
+
+namespace duckdb {
+namespace bench {
+namespace {
+
+struct Options {
+  // A file of keys in the SOSD format: the number of keys, then the keys,
+  // all as little-endian uint64. Used instead of `distribution` if set.
+  std::string data_file;
+  // "uniform", "lognormal" or "sequential".
+  std::string distribution = "uniform";
+  // Keys to generate or, for `data_file`, to read at most; 0 reads all.
+  uint64_t num_keys = 1000000;
+  uint64_t num_lookups = 1000000;
+  // "uniform" or "zipf" over the keys.
+  std::string lookup_distribution = "uniform";
+  uint64_t num_ranges = 100000;
+  uint64_t range_length = 100;
+  // Share of the keys the insert benchmark inserts into an index built on
+  // the others.
+  double insert_fraction = 0.5;
+  uint64_t warmup = 1;
+  uint64_t repetitions = 3;
+  uint64_t seed = 42;
+  std::vector<std::string> indexes = {"alex", "pgm", "radixspline", "art"};
+  std::vector<std::string> benchmarks = {"build", "lookup", "range", "insert"};
+  // Most threads of the scaling benchmark; 0 uses one per hardware thread.
+  uint64_t max_threads = 0;
+  // Pins the threads of the scaling benchmark to one CPU each.
+  bool pin_threads = false;
+  // YCSB core workload of the ycsb benchmark, "a" to "f", and its mix with
+  // the proportions given one by one applied.
+  std::string workload = "a";
+  YcsbMix mix;
+  uint64_t num_operations = 1000000;
+  BenchReport::Format format = BenchReport::Format::kCsv;
+  // Counts hardware events around the timed regions if perf events allow it.
+  bool perf_counters = true;
+  // Written to stdout if empty.
+  std::string output;
+};
+
+// Everything the indexes are measured on, generated once per run.
+struct Workload {
+  std::string dataset;
+  // Sorted and distinct.
+  std::vector<KeyValue> pairs;
+  std::vector<Key> lookups;
+  std::vector<std::pair<Key, Key>> ranges;
+  // Sorted; the insert benchmark builds on them.
+  std::vector<KeyValue> initial_pairs;
+  // In the order they are inserted.
+  std::vector<KeyValue> inserts;
+  // For the scaling benchmark, `num_lookups` lookups per thread, drawn with
+  // a seed of their own.
+  std::vector<std::vector<Key>> thread_lookups;
+  // Of the ycsb benchmark, starting from `initial_pairs`.
+  std::vector<YcsbOperation> ycsb;
+};
+
+void PrintUsage() {
+  std::cerr
+      << "Usage: learned_index_bench [--option=value ...]\n"
+         "  --data_file=PATH            SOSD file of uint64 keys\n"
+         "  --distribution=NAME         uniform, lognormal or sequential\n"
+         "  --keys=N                    keys to generate or read\n"
+         "  --lookups=N                 point lookups per repetition\n"
+         "  --lookup_distribution=NAME  uniform or zipf\n"
+         "  --ranges=N                  range scans per repetition\n"
+         "  --range_length=N            keys per range scan\n"
+         "  --insert_fraction=F         share of the keys inserted\n"
+         "  --warmup=N                  unreported repetitions\n"
+         "  --repetitions=N             reported repetitions\n"
+         "  --seed=N                    seed of the generated keys and "
+         "operations\n"
+         "  --indexes=LIST              of alex, pgm, radixspline, art\n"
+         "  --benchmarks=LIST           of build, lookup, range, insert, "
+         "scaling, ycsb\n"
+         "  --threads=N                 most threads of the scaling benchmark\n"
+         "  --pin_threads=true|false    pins them to one CPU each\n"
+         "  --workload=a|b|c|d|e|f      YCSB workload of the ycsb benchmark\n"
+         "  --operations=N              operations per YCSB repetition\n"
+         "  --read_proportion=F         overrides the workload's share of "
+         "reads,\n"
+         "  --update_proportion=F       updates,\n"
+         "  --insert_proportion=F       inserts,\n"
+         "  --scan_proportion=F         scans of up to range_length keys\n"
+         "  --rmw_proportion=F          and read-modify-writes\n"
+         "  --request_distribution=NAME zipfian, uniform or latest\n"
+         "  --format=csv|json\n"
+         "  --perf_counters=true|false  count hardware events\n"
+         "  --output=PATH               instead of stdout\n";
+}
+
+std::vector<std::string> SplitList(const std::string& list) {
+  std::vector<std::string> items;
+  std::istringstream in(list);
+  std::string item;
+  while (std::getline(in, item, ','))
+    if (!item.empty()) items.push_back(item);
+  return items;
+}
+
+bool Contains(const std::vector<std::string>& items, const std::string& item) {
+  return std::find(items.begin(), items.end(), item) != items.end();
+}
+
+// Returns false on an unknown or malformed option.
+bool ParseOptions(int argc, char** argv, Options* options) {
+  // Applied to the mix of `workload` once all options are read.
+  std::vector<std::pair<std::string, std::string>> mix_options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string argument = argv[i];
+    const size_t equals = argument.find('=');
+    if (argument.compare(0, 2, "--") != 0 || equals == std::string::npos)
+      return false;
+    const std::string name = argument.substr(2, equals - 2);
+    const std::string value = argument.substr(equals + 1);
+    try {
+      if (name == "data_file") {
+        options->data_file = value;
+      } else if (name == "distribution") {
+        options->distribution = value;
+      } else if (name == "keys") {
+        options->num_keys = std::stoull(value);
+      } else if (name == "lookups") {
+        options->num_lookups = std::stoull(value);
+      } else if (name == "lookup_distribution") {
+        options->lookup_distribution = value;
+      } else if (name == "ranges") {
+        options->num_ranges = std::stoull(value);
+      } else if (name == "range_length") {
+        options->range_length = std::stoull(value);
+      } else if (name == "insert_fraction") {
+        options->insert_fraction = std::stod(value);
+      } else if (name == "warmup") {
+        options->warmup = std::stoull(value);
+      } else if (name == "repetitions") {
+        options->repetitions = std::stoull(value);
+      } else if (name == "seed") {
+        options->seed = std::stoull(value);
+      } else if (name == "indexes") {
+        options->indexes = SplitList(value);
+      } else if (name == "benchmarks") {
+        options->benchmarks = SplitList(value);
+      } else if (name == "format") {
+        if (value == "csv")
+          options->format = BenchReport::Format::kCsv;
+        else if (value == "json")
+          options->format = BenchReport::Format::kJson;
+        else
+          return false;
+      } else if (name == "workload") {
+        options->workload = value;
+      } else if (name == "operations") {
+        options->num_operations = std::stoull(value);
+      } else if (name == "read_proportion" || name == "update_proportion" ||
+                 name == "insert_proportion" || name == "scan_proportion" ||
+                 name == "rmw_proportion" || name == "request_distribution") {
+        mix_options.emplace_back(name, value);
+      } else if (name == "threads") {
+        options->max_threads = std::stoull(value);
+      } else if (name == "perf_counters" || name == "pin_threads") {
+        bool* flag = name == "perf_counters" ? &options->perf_counters
+                                             : &options->pin_threads;
+        if (value == "true")
+          *flag = true;
+        else if (value == "false")
+          *flag = false;
+        else
+          return false;
+      } else if (name == "output") {
+        options->output = value;
+      } else {
+        return false;
+      }
+    } catch (const std::logic_error&) {
+      return false;
+    }
+  }
+  for (const auto& index : options->indexes)
+    if (!Contains({"alex", "pgm", "radixspline", "art"}, index)) return false;
+  for (const auto& benchmark : options->benchmarks)
+    if (!Contains({"build", "lookup", "range", "insert", "scaling", "ycsb"},
+                  benchmark))
+      return false;
+  if (!GetYcsbPreset(options->workload, &options->mix)) return false;
+  try {
+    for (const auto& option : mix_options) {
+      const std::string& name = option.first;
+      if (name == "request_distribution") {
+        options->mix.request_distribution = option.second;
+        continue;
+      }
+      const double proportion = std::stod(option.second);
+      if (proportion < 0) return false;
+      if (name == "read_proportion")
+        options->mix.read = proportion;
+      else if (name == "update_proportion")
+        options->mix.update = proportion;
+      else if (name == "insert_proportion")
+        options->mix.insert = proportion;
+      else if (name == "scan_proportion")
+        options->mix.scan = proportion;
+      else
+        options->mix.read_modify_write = proportion;
+    }
+  } catch (const std::logic_error&) {
+    return false;
+  }
+  if (options->max_threads == 0)
+    options->max_threads = std::max(1u, std::thread::hardware_concurrency());
+  return options->insert_fraction >= 0 && options->insert_fraction < 1;
+}
+
+std::vector<Key> ReadSosdKeys(const std::string& path, uint64_t max_keys) {
+  std::ifstream in(path, std::ios::binary);
+  uint64_t count = 0;
+  if (!in || !in.read(reinterpret_cast<char*>(&count), sizeof(count)))
+    throw std::runtime_error("could not read " + path);
+  if (max_keys != 0) count = std::min(count, max_keys);
+  std::vector<Key> keys(count);
+  if (!in.read(reinterpret_cast<char*>(keys.data()), count * sizeof(Key)))
+    throw std::runtime_error(path + " is truncated");
+  return keys;
+}
+
+std::vector<Key> GenerateKeys(const Options& options) {
+  std::mt19937_64 gen(options.seed);
+  std::vector<Key> keys(options.num_keys);
+  if (options.distribution == "uniform") {
+    std::uniform_int_distribution<Key> dis(0, uint64_t(1) << 62);
+    for (auto& key : keys) key = dis(gen);
+  } else if (options.distribution == "lognormal") {
+    std::lognormal_distribution<double> dis(0, 2);
+    for (auto& key : keys) key = static_cast<Key>(dis(gen) * 1e9);
+  } else if (options.distribution == "sequential") {
+    for (size_t i = 0; i < keys.size(); ++i) keys[i] = i;
+  } else {
+    throw std::runtime_error("unknown distribution " + options.distribution);
+  }
+  return keys;
+}
+
+// Draws `num_lookups` of `keys` as `lookup_distribution` says, with `gen`
+// for uniform and a generator seeded with `zipf_seed` for zipf lookups.
+std::vector<Key> GenerateLookups(const Options& options,
+                                 const std::vector<Key>& keys,
+                                 std::mt19937_64& gen, uint64_t zipf_seed) {
+  const int num_keys = static_cast<int>(keys.size());
+  std::vector<Key> lookups;
+  lookups.reserve(options.num_lookups);
+  if (options.lookup_distribution == "zipf") {
+    ScrambledZipfianGenerator zipf(num_keys, zipf_seed);
+    for (uint64_t i = 0; i < options.num_lookups; ++i)
+      lookups.push_back(keys[zipf.nextValue()]);
+  } else if (options.lookup_distribution == "uniform") {
+    std::uniform_int_distribution<int> dis(0, num_keys - 1);
+    for (uint64_t i = 0; i < options.num_lookups; ++i)
+      lookups.push_back(keys[dis(gen)]);
+  } else {
+    throw std::runtime_error("unknown lookup distribution " +
+                             options.lookup_distribution);
+  }
+  return lookups;
+}
+
+Workload MakeWorkload(const Options& options) {
+  Workload workload;
+  std::vector<Key> keys;
+  if (!options.data_file.empty()) {
+    keys = ReadSosdKeys(options.data_file, options.num_keys);
+    workload.dataset = options.data_file;
+  } else {
+    keys = GenerateKeys(options);
+    workload.dataset = options.distribution;
+  }
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  if (keys.empty()) throw std::runtime_error("no keys to benchmark");
+
+  std::mt19937_64 gen(options.seed + 1);
+  std::uniform_real_distribution<Payload> payload_dis(0, 1);
+  workload.pairs.reserve(keys.size());
+  for (const Key key : keys) workload.pairs.emplace_back(key, payload_dis(gen));
+
+  workload.lookups = GenerateLookups(options, keys, gen, options.seed + 2);
+
+  // A range [lo, hi) covers `range_length` keys, fewer at the end.
+  std::uniform_int_distribution<size_t> range_dis(0, keys.size() - 1);
+  workload.ranges.reserve(options.num_ranges);
+  for (uint64_t i = 0; i < options.num_ranges; ++i) {
+    const size_t begin = range_dis(gen);
+    const size_t end = begin + options.range_length;
+    workload.ranges.emplace_back(
+        keys[begin],
+        end < keys.size() ? keys[end] : std::numeric_limits<Key>::max());
+  }
+
+  std::vector<KeyValue> shuffled = workload.pairs;
+  std::shuffle(shuffled.begin(), shuffled.end(), gen);
+  const size_t num_inserts =
+      static_cast<size_t>(shuffled.size() * options.insert_fraction);
+  workload.inserts.assign(shuffled.begin(), shuffled.begin() + num_inserts);
+  workload.initial_pairs.assign(shuffled.begin() + num_inserts, shuffled.end());
+  std::sort(workload.initial_pairs.begin(), workload.initial_pairs.end());
+
+  if (Contains(options.benchmarks, "ycsb")) {
+    workload.ycsb = GenerateYcsb(options.mix, workload.pairs,
+                                 workload.initial_pairs, workload.inserts,
+                                 options.num_operations, options.range_length,
+                                 options.seed + 3);
+  }
+  if (Contains(options.benchmarks, "scaling")) {
+    for (uint64_t thread = 0; thread < options.max_threads; ++thread) {
+      const uint64_t seed = options.seed + 4 + thread;
+      std::mt19937_64 thread_gen(seed);
+      workload.thread_lookups.push_back(
+          GenerateLookups(options, keys, thread_gen, seed));
+    }
+  }
+  return workload;
+}
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+template <class Index>
+class IndexBenchmark {
+ public:
+  IndexBenchmark(const Options& options, const Workload& workload,
+                 BenchReport* report)
+      : options_(options),
+        workload_(workload),
+        report_(report),
+        counters_(options.perf_counters) {}
+
+  void Run() {
+    if (Contains(options_.benchmarks, "build")) RunBuild();
+    if (Contains(options_.benchmarks, "lookup") ||
+        Contains(options_.benchmarks, "range")) {
+      Index index;
+      index.Build(workload_.pairs);
+      if (Contains(options_.benchmarks, "lookup")) RunLookup(index);
+      if (Contains(options_.benchmarks, "range")) RunRange(index);
+    }
+    if (Contains(options_.benchmarks, "scaling")) {
+      if (Index::kConcurrentLookups) {
+        Index index;
+        index.Build(workload_.pairs);
+        RunScaling(index);
+      } else {
+        std::cerr << Index::kName << " scaling: skipped, no concurrent lookups\n";
+      }
+    }
+    if (Contains(options_.benchmarks, "insert")) RunInsert();
+    if (Contains(options_.benchmarks, "ycsb")) {
+      if (Index::kPayloadsAfterInserts) {
+        RunYcsbWorkload();
+      } else {
+        std::cerr << Index::kName
+                  << " ycsb: skipped, no payloads after inserts\n";
+      }
+    }
+  }
+
+ private:
+  void RunBuild() {
+    for (uint64_t repetition = 0; repetition < Repetitions(); ++repetition) {
+      Index index;
+      counters_.Start();
+      const auto start = std::chrono::steady_clock::now();
+      index.Build(workload_.pairs);
+      const double seconds = SecondsSince(start);
+      sample_ = counters_.Stop();
+      Report("build", repetition, workload_.pairs.size(), seconds,
+             index.SizeInBytes(), 0);
+    }
+  }
+
+  void RunLookup(Index& index) {
+    for (uint64_t repetition = 0; repetition < Repetitions(); ++repetition) {
+      Payload checksum = 0;
+      counters_.Start();
+      const auto start = std::chrono::steady_clock::now();
+      for (const Key key : workload_.lookups) {
+        Payload payload;
+        if (index.Lookup(key, &payload)) checksum += payload;
+      }
+      const double seconds = SecondsSince(start);
+      sample_ = counters_.Stop();
+      Report("lookup", repetition, workload_.lookups.size(), seconds,
+             index.SizeInBytes(), checksum);
+    }
+  }
+
+  void RunRange(Index& index) {
+    for (uint64_t repetition = 0; repetition < Repetitions(); ++repetition) {
+      Payload checksum = 0;
+      counters_.Start();
+      const auto start = std::chrono::steady_clock::now();
+      for (const auto& range : workload_.ranges)
+        checksum += index.RangeSum(range.first, range.second);
+      const double seconds = SecondsSince(start);
+      sample_ = counters_.Stop();
+      Report("range", repetition, workload_.ranges.size(), seconds,
+             index.SizeInBytes(), checksum);
+    }
+  }
+
+  void RunInsert() {
+    for (uint64_t repetition = 0; repetition < Repetitions(); ++repetition) {
+      Index index;
+      index.BuildForInserts(workload_.initial_pairs);
+      counters_.Start();
+      const auto start = std::chrono::steady_clock::now();
+      for (const auto& pair : workload_.inserts)
+        index.Insert(pair.first, pair.second);
+      index.FinishInserts();
+      const double seconds = SecondsSince(start);
+      sample_ = counters_.Stop();
+      Report("insert", repetition, workload_.inserts.size(), seconds,
+             index.SizeInBytes(), 0);
+    }
+  }
+
+  // Like the insert benchmark, includes the background work the inserts
+  // leave.
+  void RunYcsbWorkload() {
+    const std::string benchmark = "ycsb_" + options_.workload;
+    for (uint64_t repetition = 0; repetition < Repetitions(); ++repetition) {
+      Index index;
+      index.BuildForInserts(workload_.initial_pairs);
+      counters_.Start();
+      const auto start = std::chrono::steady_clock::now();
+      const Payload checksum = RunYcsb(index, workload_.ycsb);
+      index.FinishInserts();
+      const double seconds = SecondsSince(start);
+      sample_ = counters_.Stop();
+      Report(benchmark.c_str(), repetition, workload_.ycsb.size(), seconds,
+             index.SizeInBytes(), checksum);
+    }
+  }
+
+  // Runs the lookups with 1, 2, 4, ... and `max_threads` threads. The threads
+  // wait for each other before they start, and the time runs until the last
+  // one is done, so a thread that is slowed down by the others counts.
+  void RunScaling(const Index& index) {
+    std::vector<uint64_t> thread_counts;
+    for (uint64_t threads = 1; threads < options_.max_threads; threads *= 2)
+      thread_counts.push_back(threads);
+    thread_counts.push_back(options_.max_threads);
+    // The throughput of one thread, per repetition.
+    std::vector<double> single_thread(Repetitions(), 0);
+    for (const uint64_t threads : thread_counts) {
+      for (uint64_t repetition = 0; repetition < Repetitions(); ++repetition) {
+        Payload checksum = 0;
+        PerfCounters::Sample sample;
+        const double seconds =
+            RunThreads(index, threads, &checksum, &sample);
+        const uint64_t operations = threads * options_.num_lookups;
+        const double throughput = seconds == 0 ? 0 : operations / seconds;
+        if (threads == 1) single_thread[repetition] = throughput;
+        sample_ = sample;
+        Report("scaling", repetition, operations, seconds, index.SizeInBytes(),
+               checksum, threads,
+               single_thread[repetition] == 0
+                   ? 0
+                   : throughput / (threads * single_thread[repetition]));
+      }
+    }
+  }
+
+  // Returns the wall time of `threads` threads doing their lookups.
+  double RunThreads(const Index& index, uint64_t threads, Payload* checksum,
+                    PerfCounters::Sample* sample) {
+    std::atomic<uint64_t> ready(0);
+    std::atomic<bool> start(false);
+    std::vector<Payload> checksums(threads, 0);
+    std::vector<PerfCounters::Sample> samples(threads);
+    std::vector<std::chrono::steady_clock::time_point> ends(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (uint64_t thread = 0; thread < threads; ++thread) {
+      workers.emplace_back([&, thread] {
+        if (options_.pin_threads) Pin(thread);
+        // Every thread counts its own events.
+        PerfCounters counters(options_.perf_counters);
+        const std::vector<Key>& lookups = workload_.thread_lookups[thread];
+        Payload sum = 0;
+        ready.fetch_add(1);
+        while (!start.load(std::memory_order_acquire))
+          std::this_thread::yield();
+        counters.Start();
+        for (const Key key : lookups) {
+          Payload payload;
+          if (index.Lookup(key, &payload)) sum += payload;
+        }
+        ends[thread] = std::chrono::steady_clock::now();
+        samples[thread] = counters.Stop();
+        checksums[thread] = sum;
+      });
+    }
+    while (ready.load() < threads) std::this_thread::yield();
+    const auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (auto& worker : workers) worker.join();
+    *sample = PerfCounters::Sample::Total();
+    for (uint64_t thread = 0; thread < threads; ++thread) {
+      *checksum += checksums[thread];
+      sample->Add(samples[thread]);
+    }
+    const auto end = *std::max_element(ends.begin(), ends.end());
+    return std::chrono::duration<double>(end - begin).count();
+  }
+
+  // Spreads the threads over the CPUs this process may run on. Does nothing
+  // where the affinity can not be set.
+  static void Pin(uint64_t thread) {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+    const int num_cpus = CPU_COUNT(&allowed);
+    if (num_cpus == 0) return;
+    int nth = static_cast<int>(thread % num_cpus);
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (!CPU_ISSET(cpu, &allowed) || nth-- > 0) continue;
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(cpu, &set);
+      pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+      return;
+    }
+#else
+    (void)thread;
+#endif
+  }
+
+  uint64_t Repetitions() const {
+    return options_.warmup + options_.repetitions;
+  }
+
+  // Drops the warmup repetitions. The hardware events are those of the last
+  // timed region, in `sample_`.
+  void Report(const char* benchmark, uint64_t repetition, uint64_t operations,
+              double seconds, size_t size_bytes, Payload checksum,
+              uint64_t threads = 1,
+              std::optional<double> scaling_efficiency = std::nullopt) {
+    if (repetition < options_.warmup) return;
+    BenchResult result;
+    result.index = Index::kName;
+    result.benchmark = benchmark;
+    result.dataset = workload_.dataset;
+    result.num_keys = workload_.pairs.size();
+    result.operations = operations;
+    result.repetition = repetition - options_.warmup;
+    result.threads = threads;
+    result.seconds = seconds;
+    result.size_bytes = size_bytes;
+    result.checksum = checksum;
+    result.counters = sample_;
+    result.scaling_efficiency = scaling_efficiency;
+    std::cerr << result.index << ' ' << result.benchmark << " #"
+              << result.repetition;
+    if (scaling_efficiency) {
+      std::cerr << ", " << threads << " threads: "
+                << result.OperationsPerSecond() << " ops/s, efficiency "
+                << *scaling_efficiency << '\n';
+    } else {
+      std::cerr << ": " << result.NanosPerOperation() << " ns/op\n";
+    }
+    report_->Add(std::move(result));
+  }
+
+  const Options& options_;
+  const Workload& workload_;
+  BenchReport* report_;
+  // Counts this thread only, so work the indexes do in background threads,
+  // like the merges of `RadixSplineBenchIndex`, is timed but not counted.
+  PerfCounters counters_;
+  PerfCounters::Sample sample_;
+};
+
+template <class Index>
+void RunIndex(const Options& options, const Workload& workload,
+              BenchReport* report) {
+  if (!Contains(options.indexes, Index::kName)) return;
+  IndexBenchmark<Index>(options, workload, report).Run();
+}
+
+std::vector<std::pair<std::string, std::string>> DescribeOptions(
+    const Options& options, const Workload& workload) {
+  auto join = [](const std::vector<std::string>& items) {
+    std::string joined;
+    for (const auto& item : items) joined += (joined.empty() ? "" : ",") + item;
+    return joined;
+  };
+  return {{"dataset", workload.dataset},
+          {"num_keys", std::to_string(workload.pairs.size())},
+          {"num_lookups", std::to_string(options.num_lookups)},
+          {"lookup_distribution", options.lookup_distribution},
+          {"num_ranges", std::to_string(options.num_ranges)},
+          {"range_length", std::to_string(options.range_length)},
+          {"insert_fraction", std::to_string(options.insert_fraction)},
+          {"warmup", std::to_string(options.warmup)},
+          {"repetitions", std::to_string(options.repetitions)},
+          {"seed", std::to_string(options.seed)},
+          {"indexes", join(options.indexes)},
+          {"benchmarks", join(options.benchmarks)},
+          {"threads", std::to_string(options.max_threads)},
+          {"workload", options.workload},
+          {"num_operations", std::to_string(options.num_operations)},
+          {"read_proportion", std::to_string(options.mix.read)},
+          {"update_proportion", std::to_string(options.mix.update)},
+          {"insert_proportion", std::to_string(options.mix.insert)},
+          {"scan_proportion", std::to_string(options.mix.scan)},
+          {"rmw_proportion", std::to_string(options.mix.read_modify_write)},
+          {"request_distribution", options.mix.request_distribution},
+          {"pin_threads", options.pin_threads ? "true" : "false"},
+          {"perf_counters", options.perf_counters ? "true" : "false"}};
+}
+
+}  // namespace
+}  // namespace bench
+}  // namespace duckdb
+
+int main(int argc, char** argv) {
+  using namespace duckdb::bench;
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    PrintUsage();
+    return 1;
+  }
+  try {
+    const Workload workload = MakeWorkload(options);
+    BenchReport report;
+    report.SetConfig(DescribeOptions(options, workload));
+    RunIndex<AlexBenchIndex>(options, workload, &report);
+    RunIndex<PGMBenchIndex>(options, workload, &report);
+    RunIndex<RadixSplineBenchIndex>(options, workload, &report);
+    RunIndex<ARTBenchIndex>(options, workload, &report);
+    if (options.output.empty()) {
+      report.Write(std::cout, options.format);
+    } else {
+      std::ofstream out(options.output);
+      report.Write(out, options.format);
+      if (!out) throw std::runtime_error("could not write " + options.output);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "learned_index_bench: " << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
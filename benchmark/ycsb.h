@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bench_indexes.h"
+#include "utils.h"
+
+namespace duckdb {
+namespace bench {
+
+// Mixed workloads in the style of the Yahoo! Cloud Serving Benchmark: an
+// index is loaded with some keys, then runs a stream of reads, updates,
+// inserts of new keys, short range scans and read-modify-writes in the given
+// proportions.
+struct YcsbMix {
+  double read = 0;
+  double update = 0;
+  double insert = 0;
+  double scan = 0;
+  double read_modify_write = 0;
+  // Which keys the operations other than inserts pick: "zipfian", "uniform"
+  // or "latest", which prefers the keys inserted last.
+  std::string request_distribution = "zipfian";
+};
+
+// Sets `mix` to the core workload `name`, "a" to "f", and returns whether
+// there is one:
+//
+//   a  update heavy        50% reads, 50% updates
+//   b  read mostly         95% reads, 5% updates
+//   c  read only           100% reads
+//   d  read latest         95% reads, 5% inserts, of the latest keys
+//   e  short ranges        95% scans, 5% inserts
+//   f  read-modify-write   50% reads, 50% read-modify-writes
+inline bool GetYcsbPreset(const std::string& name, YcsbMix* mix) {
+  *mix = YcsbMix();
+  if (name == "a") {
+    mix->read = 0.5;
+    mix->update = 0.5;
+  } else if (name == "b") {
+    mix->read = 0.95;
+    mix->update = 0.05;
+  } else if (name == "c") {
+    mix->read = 1;
+  } else if (name == "d") {
+    mix->read = 0.95;
+    mix->insert = 0.05;
+    mix->request_distribution = "latest";
+  } else if (name == "e") {
+    mix->scan = 0.95;
+    mix->insert = 0.05;
+  } else if (name == "f") {
+    mix->read = 0.5;
+    mix->read_modify_write = 0.5;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+struct YcsbOperation {
+  enum Type { kRead, kUpdate, kInsert, kScan, kReadModifyWrite };
+
+  Type type;
+  Key key;
+  // The end of the range of a scan, exclusive.
+  Key end;
+  // Of an insert or update.
+  Payload payload;
+};
+
+// Generates `num_operations` operations of `mix` on an index loaded with
+// `initial_pairs`. Inserts take the pairs of `inserts` in order. Scans cover
+// 1 to `max_scan_length` keys of `pairs`, all keys sorted, starting from a
+// key that is there. Every index runs the same operations, so they are
+// generated before and not as part of the measured time.
+inline std::vector<YcsbOperation> GenerateYcsb(
+    const YcsbMix& mix, const std::vector<KeyValue>& pairs,
+    const std::vector<KeyValue>& initial_pairs,
+    const std::vector<KeyValue>& inserts, uint64_t num_operations,
+    uint64_t max_scan_length, uint64_t seed) {
+  const double total = mix.read + mix.update + mix.insert + mix.scan +
+                       mix.read_modify_write;
+  if (!(total > 0)) throw std::runtime_error("all YCSB proportions are 0");
+  if (initial_pairs.empty())
+    throw std::runtime_error("YCSB needs keys to start from");
+
+  std::mt19937_64 gen(seed);
+  std::uniform_real_distribution<double> dis(0, total);
+  std::vector<YcsbOperation::Type> types(num_operations);
+  size_t num_inserts = 0;
+  for (auto& type : types) {
+    double draw = dis(gen);
+    if ((draw -= mix.read) < 0)
+      type = YcsbOperation::kRead;
+    else if ((draw -= mix.update) < 0)
+      type = YcsbOperation::kUpdate;
+    else if ((draw -= mix.insert) < 0)
+      type = YcsbOperation::kInsert;
+    else if ((draw -= mix.scan) < 0)
+      type = YcsbOperation::kScan;
+    else
+      type = YcsbOperation::kReadModifyWrite;
+    if (type == YcsbOperation::kInsert) ++num_inserts;
+  }
+  if (num_inserts > inserts.size())
+    throw std::runtime_error(
+        "not enough keys held back for the inserts of the YCSB workload, "
+        "raise --insert_fraction");
+
+  // The keys that are there, in the order they were loaded and inserted.
+  std::vector<Key> present;
+  present.reserve(initial_pairs.size() + num_inserts);
+  for (const auto& pair : initial_pairs) present.push_back(pair.first);
+  // Over the keys there will be at the end, like in YCSB, drawing again for
+  // the ones not inserted yet.
+  ScrambledZipfianGenerator zipf(
+      static_cast<int>(std::min<size_t>(present.size() + num_inserts,
+                                        std::numeric_limits<int>::max())),
+      seed + 1);
+  auto pick = [&]() -> Key {
+    if (mix.request_distribution == "uniform") {
+      std::uniform_int_distribution<size_t> uniform(0, present.size() - 1);
+      return present[uniform(gen)];
+    }
+    if (mix.request_distribution == "latest")
+      return present[present.size() - 1 - zipf.nextRank() % present.size()];
+    size_t position;
+    do {
+      position = zipf.nextValue();
+    } while (position >= present.size());
+    return present[position];
+  };
+  if (mix.request_distribution != "zipfian" &&
+      mix.request_distribution != "uniform" &&
+      mix.request_distribution != "latest")
+    throw std::runtime_error("unknown request distribution " +
+                             mix.request_distribution);
+
+  std::uniform_real_distribution<Payload> payload_dis(0, 1);
+  std::uniform_int_distribution<uint64_t> length_dis(
+      1, std::max<uint64_t>(max_scan_length, 1));
+  std::vector<YcsbOperation> operations;
+  operations.reserve(num_operations);
+  size_t next_insert = 0;
+  for (const auto type : types) {
+    YcsbOperation operation{type, 0, 0, 0};
+    switch (type) {
+      case YcsbOperation::kInsert:
+        operation.key = inserts[next_insert].first;
+        operation.payload = inserts[next_insert].second;
+        ++next_insert;
+        present.push_back(operation.key);
+        break;
+      case YcsbOperation::kScan: {
+        operation.key = pick();
+        const size_t begin =
+            std::lower_bound(pairs.begin(), pairs.end(),
+                             KeyValue(operation.key,
+                                      -std::numeric_limits<Payload>::max())) -
+            pairs.begin();
+        const size_t end = begin + length_dis(gen);
+        operation.end = end < pairs.size() ? pairs[end].first
+                                           : std::numeric_limits<Key>::max();
+        break;
+      }
+      default:
+        operation.key = pick();
+        operation.payload = payload_dis(gen);
+        break;
+    }
+    operations.push_back(operation);
+  }
+  return operations;
+}
+
+// Runs `operations` on `index` and returns the sum of the payloads read.
+template <class Index>
+Payload RunYcsb(Index& index, const std::vector<YcsbOperation>& operations) {
+  Payload checksum = 0;
+  for (const auto& operation : operations) {
+    Payload payload;
+    switch (operation.type) {
+      case YcsbOperation::kRead:
+        if (index.Lookup(operation.key, &payload)) checksum += payload;
+        break;
+      case YcsbOperation::kUpdate:
+        index.Update(operation.key, operation.payload);
+        break;
+      case YcsbOperation::kInsert:
+        index.Insert(operation.key, operation.payload);
+        break;
+      case YcsbOperation::kScan:
+        checksum += index.RangeSum(operation.key, operation.end);
+        break;
+      case YcsbOperation::kReadModifyWrite:
+        if (index.Lookup(operation.key, &payload)) {
+          checksum += payload;
+          index.Update(operation.key, payload + operation.payload);
+        }
+        break;
+    }
+  }
+  return checksum;
+}
+
+}  // namespace bench
+}  // namespace duckdb
@@ -28,12 +28,14 @@
 #include "builder.h"
 #include "radix_spline.h"
 #include "serializer.h"
+#include "updatable_radix_spline.h"
 #include "common.h"
 
 #include <fstream>
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <cmath>
 
 // OpenSSL linked through vcpkg
 #include <openssl/opensslv.h>
@@ -42,10 +44,36 @@
 #include "utils.h"
 #include <chrono>
 #include <numeric>
+#include <type_traits>
 #include<iomanip>
 #include <iostream>
 #include "pgm/pgm_index.hpp"
 #include "pgm/pgm_index_dynamic.hpp"
+#include "hot_key_cache.h"
+#include "published_index.h"
+#include "sharded_alex.h"
+#include "learned_index_sidecar.h"
+#include "learned_index_log.h"
+#include "static_pgm_index.h"
+#include "latency_histogram.h"
+#include "perf_counters.h"
+#include "duckdb/parallel/task_scheduler.hpp"
+#include "duckdb/function/table_function.hpp"
+#include "duckdb/main/appender.hpp"
+#include "duckdb/common/file_system.hpp"
+#include "duckdb/storage/buffer_manager.hpp"
+#include "duckdb/common/vector_operations/vector_operations.hpp"
+#include "duckdb/parser/keyword_helper.hpp"
+#include "duckdb/main/config.hpp"
+#include "duckdb/optimizer/optimizer_extension.hpp"
+#include "duckdb/planner/operator/logical_delete.hpp"
+#include "duckdb/planner/operator/logical_insert.hpp"
+#include "duckdb/planner/operator/logical_update.hpp"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <set>
 #define DOUBLE_KEY_TYPE double
 #define GENERAL_PAYLOAD_TYPE double
 #define KEY_TYPE int
@@ -63,21 +91,57 @@
 
 namespace duckdb {
 
-// ALEX Index instances
-alex::Alex<DOUBLE_KEY_TYPE, INDEX_PAYLOAD_TYPE> double_alex_index;
-alex::Alex<INT64_KEY_TYPE, INDEX_PAYLOAD_TYPE> big_int_alex_index;
-alex::Alex<UNSIGNED_INT64_KEY_TYPE, INDEX_PAYLOAD_TYPE> unsigned_big_int_alex_index;
-alex::Alex<INT_KEY_TYPE, INDEX_PAYLOAD_TYPE> int_alex_index;
+// ALEX Index instances, split into key ranges with create_alex_index(..., shards := N) and in a single shard otherwise,
+// so that all lookups go without a lock, see sharded_alex.h. Rebuilds publish a new version atomically, see
+// published_index.h.
+PublishedIndex<ShardedAlex<DOUBLE_KEY_TYPE, INDEX_PAYLOAD_TYPE>> double_alex_index;
+PublishedIndex<ShardedAlex<INT64_KEY_TYPE, INDEX_PAYLOAD_TYPE>> big_int_alex_index;
+PublishedIndex<ShardedAlex<UNSIGNED_INT64_KEY_TYPE, INDEX_PAYLOAD_TYPE>> unsigned_big_int_alex_index;
+PublishedIndex<ShardedAlex<INT_KEY_TYPE, INDEX_PAYLOAD_TYPE>> int_alex_index;
 
 // PGM Index instances
-pgm::DynamicPGMIndex<double, double> double_dynamic_index;
-pgm::DynamicPGMIndex<INT64_KEY_TYPE, INDEX_PAYLOAD_TYPE> big_int_dynamic_index;
-pgm::DynamicPGMIndex<UNSIGNED_INT64_KEY_TYPE, INDEX_PAYLOAD_TYPE> unsigned_big_int_dynamic_index;
-pgm::DynamicPGMIndex<INT_KEY_TYPE, INDEX_PAYLOAD_TYPE> int_dynamic_index;
+PublishedIndex<pgm::DynamicPGMIndex<double, double>> double_dynamic_index;
+PublishedIndex<pgm::DynamicPGMIndex<INT64_KEY_TYPE, INDEX_PAYLOAD_TYPE>> big_int_dynamic_index;
+PublishedIndex<pgm::DynamicPGMIndex<UNSIGNED_INT64_KEY_TYPE, INDEX_PAYLOAD_TYPE>> unsigned_big_int_dynamic_index;
+PublishedIndex<pgm::DynamicPGMIndex<INT_KEY_TYPE, INDEX_PAYLOAD_TYPE>> int_dynamic_index;
+
+// Static PGM Index instances, built instead of the dynamic ones with create_pgm_index(..., read_only := true)
+PublishedIndex<StaticPGMIndex<DOUBLE_KEY_TYPE, INDEX_PAYLOAD_TYPE>> double_static_pgm_index;
+PublishedIndex<StaticPGMIndex<INT64_KEY_TYPE, INDEX_PAYLOAD_TYPE>> big_int_static_pgm_index;
+PublishedIndex<StaticPGMIndex<UNSIGNED_INT64_KEY_TYPE, INDEX_PAYLOAD_TYPE>> unsigned_big_int_static_pgm_index;
+PublishedIndex<StaticPGMIndex<INT_KEY_TYPE, INDEX_PAYLOAD_TYPE>> int_static_pgm_index;
+
+// Hot-key caches in front of the indexes above, disabled until sized with PRAGMA hot_key_cache_size. Resizing
+// publishes new caches, lookups keep probing the one they loaded until they are done with it.
+PublishedIndex<HotKeyCache<DOUBLE_KEY_TYPE, INDEX_PAYLOAD_TYPE>> double_alex_hot_key_cache;
+PublishedIndex<HotKeyCache<INT64_KEY_TYPE, INDEX_PAYLOAD_TYPE>> big_int_alex_hot_key_cache;
+PublishedIndex<HotKeyCache<UNSIGNED_INT64_KEY_TYPE, INDEX_PAYLOAD_TYPE>> unsigned_big_int_alex_hot_key_cache;
+PublishedIndex<HotKeyCache<INT_KEY_TYPE, INDEX_PAYLOAD_TYPE>> int_alex_hot_key_cache;
+PublishedIndex<HotKeyCache<DOUBLE_KEY_TYPE, INDEX_PAYLOAD_TYPE>> double_pgm_hot_key_cache;
+PublishedIndex<HotKeyCache<INT64_KEY_TYPE, INDEX_PAYLOAD_TYPE>> big_int_pgm_hot_key_cache;
+PublishedIndex<HotKeyCache<UNSIGNED_INT64_KEY_TYPE, INDEX_PAYLOAD_TYPE>> unsigned_big_int_pgm_hot_key_cache;
+PublishedIndex<HotKeyCache<INT_KEY_TYPE, INDEX_PAYLOAD_TYPE>> int_pgm_hot_key_cache;
+// Entries per cache, the RadixSpline indexes created later size their caches with it too
+std::atomic<size_t> hot_key_cache_capacity{0};
+
+template <typename K, typename P>
+void publishHotKeyCache(PublishedIndex<HotKeyCache<K, P>> &cache, size_t capacity){
+    cache.Publish(std::make_shared<HotKeyCache<K, P>>(capacity));
+}
+
+// Memory of the dynamic PGM indexes, which do not allocate from the learned index memory pool. ALEX and the
+// read-only PGM indexes do, see learned_index_allocator.h.
+LearnedIndexMemoryCharge double_pgm_memory;
+LearnedIndexMemoryCharge big_int_pgm_memory;
+LearnedIndexMemoryCharge unsigned_big_int_pgm_memory;
+LearnedIndexMemoryCharge int_pgm_memory;
 
 // Global variables
+// The table and column the ALEX and PGM indexes of each key type belong to, by key type name. The indexes are
+// global per key type, so writes to any other table must leave them alone. Builds and restores set it while
+// other connections read it, so it is only used under index_type_table_name_lock.
+std::mutex index_type_table_name_lock;
 std::map<std::string, std::pair<std::string, std::string>> index_type_table_name_map;
-std::vector<std::vector<unique_ptr<Base>>> results;
 int load_end_point = 0;
 
 /*
@@ -96,15 +160,221 @@ struct RadixSplineStats {
 const size_t kNumRadixBits = 18;
 const size_t kMaxError = 32;
 
-// Separate maps for different key types, for each table
-std::map<std::string, rs::RadixSpline<uint32_t>> radix_spline_map_int32;
-std::map<std::string, rs::RadixSpline<uint64_t>> radix_spline_map_int64;
+/*
+* A RadixSpline index on a column and the stats of its last build
+*/
+template <typename T>
+struct RadixSplineEntry {
+    rs::UpdatableRadixSpline<T> index;
+    // Hot-key cache of the keys the index has, RadixSpline indexes have no payloads. Inserts can not make a
+    // cached key stale, only erases invalidate it.
+    PublishedIndex<HotKeyCache<T, bool>> cache;
+    // Guarded by radix_spline_maps_lock, the build of the index writes it from the scheduler thread
+    RadixSplineStats stats;
+
+    RadixSplineEntry() {
+        if (hot_key_cache_capacity > 0) {
+            publishHotKeyCache(cache, hot_key_cache_capacity);
+        }
+    }
+};
+
+template <typename T>
+using RadixSplineMap = std::map<std::string, std::shared_ptr<RadixSplineEntry<T>>>;
+
+// Separate maps for different key types, for each table. New keys go to the delta buffer of the
+// index and are merged into a rebuilt spline in the background.
+// The maps are shared by all connections and the background builds, so they are only used under
+// radix_spline_maps_lock. The indexes lock themselves: an entry is used after the lock is released,
+// and stays alive if drop_radixspline_index removes it meanwhile.
+std::mutex radix_spline_maps_lock;
+RadixSplineMap<uint32_t> radix_spline_map_int32;
+RadixSplineMap<uint64_t> radix_spline_map_int64;
+
+/**
+ * Returns the RadixSpline index of the map key, or nullptr if there is none.
+*/
+template <typename T>
+std::shared_ptr<RadixSplineEntry<T>> findRadixSpline(const RadixSplineMap<T> &index_map, const std::string &map_key) {
+    std::lock_guard<std::mutex> guard(radix_spline_maps_lock);
+    auto it = index_map.find(map_key);
+    return it == index_map.end() ? nullptr : it->second;
+}
+
+/**
+ * Returns the RadixSpline index of the map key, adding an empty one if there is none.
+*/
+template <typename T>
+std::shared_ptr<RadixSplineEntry<T>> findOrAddRadixSpline(RadixSplineMap<T> &index_map, const std::string &map_key) {
+    std::lock_guard<std::mutex> guard(radix_spline_maps_lock);
+    auto &entry = index_map[map_key];
+    if (!entry) {
+        entry = std::make_shared<RadixSplineEntry<T>>();
+    }
+    return entry;
+}
+
+/**
+ * Adds a RadixSpline index that was loaded on the side, unless one was added for the map key meanwhile.
+*/
+template <typename T>
+bool addRadixSpline(RadixSplineMap<T> &index_map, const std::string &map_key, std::shared_ptr<RadixSplineEntry<T>> entry) {
+    std::lock_guard<std::mutex> guard(radix_spline_maps_lock);
+    return index_map.emplace(map_key, std::move(entry)).second;
+}
+
+/**
+ * Removes the RadixSpline index of the map key, returns false if there is none.
+*/
+template <typename T>
+bool eraseRadixSpline(RadixSplineMap<T> &index_map, const std::string &map_key) {
+    std::lock_guard<std::mutex> guard(radix_spline_maps_lock);
+    return index_map.erase(map_key) > 0;
+}
+
+/**
+ * Returns the RadixSpline indexes with their map keys, to be used without holding the lock.
+*/
+template <typename T>
+std::vector<std::pair<std::string, std::shared_ptr<RadixSplineEntry<T>>>> listRadixSplines(const RadixSplineMap<T> &index_map) {
+    std::lock_guard<std::mutex> guard(radix_spline_maps_lock);
+    return {index_map.begin(), index_map.end()};
+}
+
+template <typename T>
+RadixSplineStats getRadixSplineStats(const RadixSplineEntry<T> &entry) {
+    std::lock_guard<std::mutex> guard(radix_spline_maps_lock);
+    return entry.stats;
+}
+
+template <typename T>
+void setRadixSplineStats(RadixSplineEntry<T> &entry, const RadixSplineStats &stats) {
+    std::lock_guard<std::mutex> guard(radix_spline_maps_lock);
+    entry.stats = stats;
+}
+
+// Memory of all RadixSpline indexes, see accountRadixSplineMemory
+LearnedIndexMemoryCharge radix_spline_memory;
+
+/**
+ * Looks the key up in the hot-key cache in front of an index, and in the index on a miss. Every lookup of a key
+ * in a learned index goes through here. A key the index has is admitted to the cache, unless a write invalidated
+ * keys of the cache while the index was probed.
+*/
+template <typename K, typename P, typename IndexLookup>
+bool cachedLookup(HotKeyCache<K, P> &cache, K key, P *payload, IndexLookup index_lookup){
+    if (!cache.Enabled()) {
+        return index_lookup(key, payload);
+    }
+    if (cache.Lookup(key, payload)) {
+        return true;
+    }
+    const uint64_t invalidations = cache.GetInvalidations();
+    if (!index_lookup(key, payload)) {
+        return false;
+    }
+    cache.Admit(key, *payload, invalidations);
+    return true;
+}
+
+template <typename K>
+bool findInAlex(const ShardedAlex<K, INDEX_PAYLOAD_TYPE> &index, HotKeyCache<K, INDEX_PAYLOAD_TYPE> &cache, K key,
+                INDEX_PAYLOAD_TYPE *payload){
+    return cachedLookup(cache, key, payload, [&index](K key, INDEX_PAYLOAD_TYPE *payload) {
+        auto found = index.get_payload(key);
+        if (!found) {
+            return false;
+        }
+        *payload = *found;
+        return true;
+    });
+}
+
+/**
+ * Looks the key up in a dynamic or read-only PGM index, which share the cache of their key type.
+*/
+template <typename Index, typename K>
+bool findInPgm(Index &index, HotKeyCache<K, INDEX_PAYLOAD_TYPE> &cache, K key, INDEX_PAYLOAD_TYPE *payload){
+    return cachedLookup(cache, key, payload, [&index](K key, INDEX_PAYLOAD_TYPE *payload) {
+        auto it = index.find(key);
+        if (it == index.end()) {
+            return false;
+        }
+        *payload = it->second;
+        return true;
+    });
+}
+
+template <typename T>
+bool findInRadixSpline(const rs::UpdatableRadixSpline<T> &index, HotKeyCache<T, bool> &cache, T key){
+    bool found = false;
+    return cachedLookup(cache, key, &found, [&index](T key, bool *found) {
+        return *found = index.Contains(key);
+    });
+}
+
+// Restores the RadixSpline indexes saved by checkpoint_learned_indexes on their first use
+void restorePendingRadixSplines(ClientContext &context);
+
+// Table mutations since the last checkpoint_learned_indexes, replayed onto the saved indexes when they are restored
+LearnedIndexLog learned_index_log;
+
+/**
+ * The key type name of the key type, as in index_type_table_name_map.
+*/
+template<typename K>
+std::string getKeyTypeName(){
+    if constexpr (std::is_same<K, DOUBLE_KEY_TYPE>::value) {
+        return "double";
+    } else if constexpr (std::is_same<K, INT64_KEY_TYPE>::value) {
+        return "bigint";
+    } else if constexpr (std::is_same<K, UNSIGNED_INT64_KEY_TYPE>::value) {
+        return "ubigint";
+    } else {
+        return "int";
+    }
+}
+
+/**
+ * The learned index log record of a mutation of the table, named as by getQualifiedTableName.
+*/
+template<typename K>
+LearnedIndexLog::Record makeMutationRecord(LearnedIndexLog::Op op,const std::string &qualified_table,K key,INDEX_PAYLOAD_TYPE payload,
+                                           int64_t row_delta,uint64_t hash_delta){
+    LearnedIndexLog::Record record;
+    record.op = op;
+    record.key_type = getKeyTypeName<K>();
+    record.table_name = qualified_table;
+    record.key = LearnedIndexLog::EncodeKey(key);
+    record.payload = payload;
+    record.row_delta = row_delta;
+    record.hash_delta = hash_delta;
+    return record;
+}
 
-// Maps for storing the stats efficiently
-std::map<std::string, RadixSplineStats> radix_spline_stats_map_int32;
-std::map<std::string, RadixSplineStats> radix_spline_stats_map_int64;
+/**
+ * Commits the transaction of con in which a mutation pragma changed a table, once the records of the change are in
+ * the learned index log and on disk, so that the log holds every committed change. If they can not be written, the
+ * change is rolled back and the pragma fails. Called before the indexes are touched, as touching them may restore
+ * them, which checks the table against the log.
+*/
+static void commitLoggedMutations(duckdb::Connection &con,const std::string &qualified_table,const std::vector<LearnedIndexLog::Record> &records){
+    if(!learned_index_log.Append(records)){
+        con.Rollback();
+        throw IOException("Could not write the learned index log, %s was not changed", qualified_table);
+    }
+    con.Commit();
+}
 
 // Helper functions
+static bool GetBooleanParameter(const FunctionParameters &parameters, const string &name) {
+    auto entry = parameters.named_parameters.find(name);
+    if (entry == parameters.named_parameters.end() || entry->second.IsNull()) {
+        return false;
+    }
+    return BooleanValue::Get(entry->second);
+}
+
 static QualifiedName GetQualifiedName(ClientContext &context, const std::string &qname_str) {
     auto qname = QualifiedName::Parse(qname_str);
     if (qname.schema == INVALID_SCHEMA) {
@@ -113,6 +383,264 @@ static QualifiedName GetQualifiedName(ClientContext &context, const std::string
     return qname;
 }
 
+/**
+ * Returns the fully qualified name of the table, quoted where needed, so that it identifies the table whatever
+ * name it was given by and can be used in queries.
+*/
+static string getQualifiedTableName(TableCatalogEntry &table) {
+    return KeywordHelper::WriteOptionallyQuoted(table.ParentCatalog().GetName()) + "." +
+           KeywordHelper::WriteOptionallyQuoted(table.ParentSchema().name) + "." +
+           KeywordHelper::WriteOptionallyQuoted(table.name);
+}
+
+static string getQualifiedTableName(ClientContext &context, const std::string &table_name) {
+    QualifiedName qname = GetQualifiedName(context, table_name);
+    return getQualifiedTableName(Catalog::GetEntry<TableCatalogEntry>(context, qname.catalog, qname.schema, qname.name));
+}
+
+/**
+ * Looks up the table and column the ALEX and PGM indexes of the key type belong to, returns false if none.
+*/
+static bool getIndexedTable(const std::string &key_type, std::pair<std::string, std::string> &table_column) {
+    std::lock_guard<std::mutex> guard(index_type_table_name_lock);
+    auto entry = index_type_table_name_map.find(key_type);
+    if (entry == index_type_table_name_map.end()) {
+        return false;
+    }
+    table_column = entry->second;
+    return true;
+}
+
+static void setIndexedTable(const std::string &key_type, const std::string &table_name, const std::string &column_name) {
+    std::lock_guard<std::mutex> guard(index_type_table_name_lock);
+    index_type_table_name_map[key_type] = {table_name, column_name};
+}
+
+/**
+ * Returns true if the ALEX and PGM indexes of the key type are on the column of the table.
+*/
+template<typename K>
+bool isIndexedColumn(ClientContext &context, const std::string &table_name, const std::string &column_name) {
+    std::pair<std::string, std::string> table_column;
+    return getIndexedTable(getKeyTypeName<K>(), table_column) &&
+           StringUtil::CIEquals(table_column.first, getQualifiedTableName(context, table_name)) &&
+           StringUtil::CIEquals(table_column.second, column_name);
+}
+
+/**
+ * Returns true if the table has a learned index on it: the ALEX and PGM indexes of a key type, or a RadixSpline.
+*/
+static bool hasLearnedIndex(TableCatalogEntry &table) {
+    string qualified_table = getQualifiedTableName(table);
+    {
+        std::lock_guard<std::mutex> guard(index_type_table_name_lock);
+        for (auto &entry : index_type_table_name_map) {
+            if (StringUtil::CIEquals(entry.second.first, qualified_table)) {
+                return true;
+            }
+        }
+    }
+    // RadixSpline map keys are catalog.schema.table.column
+    string radix_spline_prefix = table.ParentCatalog().GetName() + "." + table.ParentSchema().name + "." + table.name + ".";
+    auto starts_with_table = [&](const std::string &map_key) {
+        return StringUtil::StartsWith(map_key, radix_spline_prefix);
+    };
+    for (auto &entry : listRadixSplines(radix_spline_map_int64)) {
+        if (starts_with_table(entry.first)) {
+            return true;
+        }
+    }
+    for (auto &entry : listRadixSplines(radix_spline_map_int32)) {
+        if (starts_with_table(entry.first)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns the column of a RadixSpline index on the table, or an empty string if it has none.
+*/
+static string getRadixSplineColumn(ClientContext &context, const std::string &table_name) {
+    QualifiedName qname = GetQualifiedName(context, table_name);
+    // RadixSpline map keys are catalog.schema.table.column
+    string prefix = qname.catalog + "." + qname.schema + "." + qname.name + ".";
+    for (auto &entry : listRadixSplines(radix_spline_map_int64)) {
+        if (StringUtil::StartsWith(entry.first, prefix)) {
+            return entry.first.substr(prefix.size());
+        }
+    }
+    for (auto &entry : listRadixSplines(radix_spline_map_int32)) {
+        if (StringUtil::StartsWith(entry.first, prefix)) {
+            return entry.first.substr(prefix.size());
+        }
+    }
+    return "";
+}
+
+/**
+ * Returns the key column the mutation pragmas write keys of the key type to, and the value column after it that the
+ * learned indexes take their payloads from, as the builds do. The key column is the one the ALEX and PGM indexes of
+ * the key type are on if they belong to the table, else the one of a RadixSpline index on the table, else the first
+ * column.
+*/
+template<typename K>
+std::pair<std::string,std::string> getKeyValueColumns(ClientContext &context, const std::string &table_name){
+    QualifiedName qname = GetQualifiedName(context, table_name);
+    auto &table = Catalog::GetEntry<TableCatalogEntry>(context, qname.catalog, qname.schema, qname.name);
+    auto &columns = table.GetColumns();
+    std::pair<std::string, std::string> table_column;
+    string key_column;
+    if (getIndexedTable(getKeyTypeName<K>(), table_column) &&
+        StringUtil::CIEquals(table_column.first, getQualifiedTableName(table))) {
+        key_column = table_column.second;
+    } else if (std::is_same<K, UNSIGNED_INT64_KEY_TYPE>::value) {
+        key_column = getRadixSplineColumn(context, table_name);
+    }
+    if (key_column.empty()) {
+        key_column = columns.GetColumnNames()[0];
+    }
+    if (!columns.ColumnExists(key_column)) {
+        throw InvalidInputException("Column %s not found in table %s", key_column, table_name);
+    }
+    auto &key = columns.GetColumn(key_column);
+    idx_t value_index = key.Logical().index + 1;
+    if (value_index >= columns.LogicalColumnCount()) {
+        throw InvalidInputException("%s needs a value column after the key column %s", table_name, key.Name());
+    }
+    return {key.Name(), columns.GetColumn(LogicalIndex(value_index)).Name()};
+}
+
+// Set while the mutation pragmas run their own INSERT, DELETE or UPDATE, which they follow up in the indexes.
+static thread_local bool learned_index_write = false;
+
+struct LearnedIndexWriteScope {
+    LearnedIndexWriteScope() : previous(learned_index_write) {
+        learned_index_write = true;
+    }
+    ~LearnedIndexWriteScope() {
+        learned_index_write = previous;
+    }
+    bool previous;
+};
+
+// Defined next to clearLearnedIndexes below
+static void dropLearnedIndexes(TableCatalogEntry &table);
+
+/**
+ * Returns the learned_index_reject_plain_writes setting, see rejectUnindexedWrites.
+*/
+static bool rejectsPlainWrites(ClientContext &context) {
+    Value setting;
+    if (context.TryGetCurrentSetting("learned_index_reject_plain_writes", setting) && !setting.IsNull()) {
+        return BooleanValue::Get(setting);
+    }
+    return true;
+}
+
+/**
+ * Optimizer extension for plain INSERT, DELETE and UPDATE statements on tables with a learned index, including
+ * the ones that run inside other statements. The learned indexes live outside of DuckDB's storage and only see the
+ * changes made through insert_into_table, insert_batch_into_table, delete_from_table and update_table; any other
+ * write would leave them stale. So by default such a statement fails. With learned_index_reject_plain_writes
+ * disabled it runs, and drops the learned indexes of its table first, which have to be built again to be used.
+*/
+static void rejectUnindexedWrites(OptimizerExtensionInput &input, unique_ptr<LogicalOperator> &plan) {
+    if (learned_index_write) {
+        return;
+    }
+    const bool reject = rejectsPlainWrites(input.context);
+    std::function<void(LogicalOperator &)> visit = [&](LogicalOperator &op) {
+        optional_ptr<TableCatalogEntry> table;
+        const char *pragma = nullptr;
+        switch (op.type) {
+        case LogicalOperatorType::LOGICAL_INSERT:
+            table = &op.Cast<LogicalInsert>().table;
+            pragma = "insert_into_table or insert_batch_into_table";
+            break;
+        case LogicalOperatorType::LOGICAL_DELETE:
+            table = &op.Cast<LogicalDelete>().table;
+            pragma = "delete_from_table";
+            break;
+        case LogicalOperatorType::LOGICAL_UPDATE:
+            table = &op.Cast<LogicalUpdate>().table;
+            pragma = "update_table";
+            break;
+        default:
+            break;
+        }
+        if (table && hasLearnedIndex(*table)) {
+            if (reject) {
+                throw InvalidInputException("%s has a learned index, which only stays current if the table is changed through %s, "
+                                            "or drops it on plain writes with SET learned_index_reject_plain_writes = false",
+                                            table->name, pragma);
+            }
+            dropLearnedIndexes(*table);
+        }
+        for (auto &child : op.children) {
+            visit(*child);
+        }
+    };
+    visit(*plan);
+}
+
+/*
+* Progress of a learned index build. Builds started with background := true run as a task on the
+* DuckDB scheduler and can be followed with SELECT * FROM learned_index_builds().
+*/
+struct IndexBuildProgress {
+    std::string index_type;
+    std::string table_name;
+    // The table as getQualifiedTableName names it
+    std::string qualified_table_name;
+    std::string column_name;
+    std::string key_type;
+    bool background = false;
+    std::string phase = "queued";
+    double fraction = 0.0;
+    std::string error;
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point end_time;
+};
+
+std::mutex index_builds_lock;
+std::condition_variable index_builds_done;
+std::vector<std::shared_ptr<IndexBuildProgress>> index_builds;
+
+// Two builds of the same index would race on its rebuild, so only one build runs at a time.
+std::mutex index_build_execution_lock;
+
+void reportBuildProgress(IndexBuildProgress *progress, const std::string &phase, double fraction){
+    if(progress == nullptr){
+        return;
+    }
+    std::lock_guard<std::mutex> guard(index_builds_lock);
+    progress->phase = phase;
+    progress->fraction = fraction;
+    if(phase == "published" || phase == "failed"){
+        progress->end_time = std::chrono::steady_clock::now();
+        index_builds_done.notify_all();
+    }
+}
+
+// Blocks until no learned index build is queued or running anymore.
+void waitForIndexBuilds(){
+    std::unique_lock<std::mutex> guard(index_builds_lock);
+    index_builds_done.wait(guard, []() {
+        for(auto &build : index_builds){
+            if(build->phase != "published" && build->phase != "failed"){
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+// Returns the value of the optional background := <bool> parameter of the index creation pragmas.
+static bool GetBackgroundParameter(const FunctionParameters &parameters) {
+    return GetBooleanParameter(parameters, "background");
+}
+
 // Dummy function for testing
 inline void AlexDummy(DataChunk &args, ExpressionState &state, Vector &result) {
     std::cout << "Dummy function called\n";
@@ -147,27 +675,186 @@ void printElement(T t, const int& width){
     std::cout << std::setw(width) << std::setfill(separator) << t;
 }
 
-void display_row(int row_id,vector<string>columnNames){
-    const std::vector<unique_ptr<Base>>& vec = results.at(row_id);
+/**
+ * Prints the rows of table_name with the key in key_column, which can also be rowid, read from DuckDB storage.
+*/
+void display_row(duckdb::Connection &con,const std::string &table_name,const std::string &key_column,const Value &key){
+    auto result = con.Query("SELECT * FROM "+table_name+" WHERE \""+key_column+"\" = ?;", key);
+    if(result->HasError()){
+        std::cout<<"Reading the row failed: "<<result->GetError()<<"\n";
+        return;
+    }
     int num_width = 10;
 
-    for(string colName:columnNames){
+    for(auto &colName:result->names){
         printElement(colName,num_width);
     }
     std::cout<<"\n";
-    for(int i=0;i<vec.size();i++){
-        if (auto* intData = dynamic_cast<IntData*>(vec[i].get())) {
-            printElement(intData->value,num_width);
-        } else if (auto* doubleData = dynamic_cast<DoubleData*>(vec[i].get())) {
-            printElement(doubleData->value,num_width);
-        } else if (auto* stringData = dynamic_cast<StringData*>(vec[i].get())) {
-            printElement(stringData->value,num_width);
-        } else if (auto* boolData = dynamic_cast<BoolData*>(vec[i].get())) {
-            printElement(boolData->value,num_width);
+    for(idx_t row=0;row<result->RowCount();row++){
+        for(idx_t col=0;col<result->ColumnCount();col++){
+            printElement(result->GetValue(col,row).ToString(),num_width);
+        }
+        std::cout<<"\n";
+    }
+}
+
+/**
+ * Returns true if the learned indexes of the key type map keys to the row ids of their rows rather than to their
+ * values. The INTEGER indexes do, alex_find prints the row a key points to.
+*/
+template<typename K>
+constexpr bool usesRowIdPayloads(){
+    return std::is_same<K, INT_KEY_TYPE>::value;
+}
+
+/**
+ * The DuckDB type the columns of a key or payload type are read as.
+*/
+template<typename T>
+LogicalType getScanType(){
+    if constexpr (std::is_same<T, double>::value) {
+        return LogicalType::DOUBLE;
+    } else if constexpr (std::is_same<T, int64_t>::value) {
+        return LogicalType::BIGINT;
+    } else if constexpr (std::is_same<T, uint64_t>::value) {
+        return LogicalType::UBIGINT;
+    } else if constexpr (std::is_same<T, uint32_t>::value) {
+        return LogicalType::UINTEGER;
+    } else {
+        static_assert(std::is_same<T, int32_t>::value, "unsupported scan type");
+        return LogicalType::INTEGER;
+    }
+}
+
+/**
+ * A column of a scanned chunk read as T. Columns of another type are cast first.
+*/
+template<typename T>
+struct ChunkColumn {
+    ChunkColumn(DataChunk &chunk, idx_t column){
+        Vector *source = &chunk.data[column];
+        if(source->GetType() != getScanType<T>()){
+            cast = make_uniq<Vector>(getScanType<T>(), chunk.size());
+            VectorOperations::DefaultCast(*source, *cast, chunk.size());
+            source = cast.get();
+        }
+        source->ToUnifiedFormat(chunk.size(), format);
+        data = UnifiedVectorFormat::GetData<T>(format);
+    }
+
+    bool IsValid(idx_t row) const {
+        return format.validity.RowIsValid(format.sel->get_index(row));
+    }
+
+    T Get(idx_t row) const {
+        return data[format.sel->get_index(row)];
+    }
+
+    unique_ptr<Vector> cast;
+    UnifiedVectorFormat format;
+    const T *data;
+};
+
+/**
+ * Streams the rows of table_name to consume one DataChunk at a time, so the scan holds no more than a vector of
+ * rows in memory and builds no per-row objects. The chunks hold the columns of the select list.
+*/
+void scanTable(duckdb::Connection &con,const std::string &table_name,const std::function<void(DataChunk &)> &consume,
+               const std::string &select_list = "*"){
+    auto result = con.SendQuery("SELECT "+select_list+" FROM "+table_name+";");
+    if(result->HasError()){
+        throw InvalidInputException("Scanning %s failed: %s", table_name, result->GetError());
+    }
+    while(auto chunk = result->Fetch()){
+        if(chunk->size()==0){
+            break;
+        }
+        consume(*chunk);
+    }
+    // A scan that fails midway ends the stream early, the error is only on the result
+    if(result->HasError()){
+        throw InvalidInputException("Scanning %s failed: %s", table_name, result->GetError());
+    }
+}
+
+/**
+ * Returns the expression that hashes a row of table_name over all of its columns, as the content hash of the table
+ * adds it up, see getTableContentHash. Returns false if the table can not be read.
+*/
+static bool getRowHashExpression(duckdb::Connection &con, const std::string &table_name, std::string &expression){
+    auto result = con.Query("SELECT * FROM " + table_name + " LIMIT 0");
+    if(result->HasError()){
+        return false;
+    }
+    expression = "hash(";
+    for(idx_t i=0;i<result->names.size();i++){
+        expression += (i>0 ? ", " : "") + KeywordHelper::WriteOptionallyQuoted(result->names[i]);
+    }
+    expression += ")";
+    return true;
+}
+
+/**
+ * Counts the rows of a result whose only column holds row hashes, see getRowHashExpression, and adds up the hashes
+ * modulo 2^64.
+*/
+static void sumRowHashes(QueryResult &result, int64_t &rows, uint64_t &hash_sum){
+    rows = 0;
+    hash_sum = 0;
+    while(auto chunk = result.Fetch()){
+        if(chunk->size()==0){
+            break;
         }
+        ChunkColumn<uint64_t> hashes(*chunk,0);
+        for(idx_t row=0;row<chunk->size();row++){
+            hash_sum += hashes.Get(row);
+        }
+        rows += chunk->size();
     }
 }
 
+/**
+ * Reads the keys in the column at column_index of table_name, skipping NULLs.
+*/
+template<typename K>
+std::vector<K> scanKeys(duckdb::Connection &con,const std::string &table_name,int column_index){
+    std::vector<K> keys;
+    scanTable(con,table_name,[&](DataChunk &chunk){
+        ChunkColumn<K> key_column(chunk,column_index);
+        for(idx_t row=0;row<chunk.size();row++){
+            if(key_column.IsValid(row)){
+                keys.push_back(key_column.Get(row));
+            }
+        }
+    });
+    return keys;
+}
+
+/**
+ * Reads the (key, payload) pairs of the key column at column_index of table_name. The payload is the value column
+ * after the key, or the row id for INTEGER keys, see usesRowIdPayloads. Rows with a NULL key are skipped, a NULL
+ * value reads as 0.
+*/
+template<typename K>
+std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> scanKeyValuePairs(duckdb::Connection &con,const std::string &table_name,int column_index){
+    std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> pairs;
+    scanTable(con,table_name,[&](DataChunk &chunk){
+        // The row id is scanned after all columns of the table
+        const idx_t payload_index = usesRowIdPayloads<K>() ? chunk.ColumnCount()-1 : column_index+1;
+        if(payload_index >= chunk.ColumnCount()){
+            throw InvalidInputException("%s needs a value column after the key column", table_name);
+        }
+        ChunkColumn<K> keys(chunk,column_index);
+        ChunkColumn<INDEX_PAYLOAD_TYPE> payloads(chunk,payload_index);
+        for(idx_t row=0;row<chunk.size();row++){
+            if(keys.IsValid(row)){
+                pairs.emplace_back(keys.Get(row), payloads.IsValid(row) ? payloads.Get(row) : 0);
+            }
+        }
+    }, usesRowIdPayloads<K>() ? "*, rowid" : "*");
+    return pairs;
+}
+
 void executeQuery(duckdb::Connection& con,string QUERY){
     unique_ptr<MaterializedQueryResult> result = con.Query(QUERY);
     if(result->HasError()){
@@ -189,8 +876,8 @@ void load_benchmark_data_into_table(std::string benchmarkFile,std::string benchm
     int starting = 0;
     int ending = 0;
 
-    auto keys = new K[NUM_KEYS];
-    bool res = load_binary_data(keys,NUM_KEYS,benchmarkFile);
+    std::vector<K> keys(NUM_KEYS);
+    bool res = load_binary_data(keys.data(),NUM_KEYS,benchmarkFile);
 
     std::cout<<"Res of loading from benchmark file "<<res<<"\n"; 
 
@@ -208,7 +895,6 @@ void load_benchmark_data_into_table(std::string benchmarkFile,std::string benchm
 
         // std::cout<<"Starting "<<starting<<" Ending "<<ending<<"\n";
         
-        auto values = new std::pair<K, P>[per_batch];
         std::mt19937_64 gen_payload(std::random_device{}());
 
 
@@ -331,13 +1017,8 @@ void runLookupBenchmarkOneBatchAlex<INT64_KEY_TYPE>(duckdb::Connection& con,std:
     std::random_device rd;
     std::mt19937 g(rd());
 
-   vector<double> payloads;
-   vector<INT64_KEY_TYPE>keys;
-   for(int i=0;i<results.size();i++){
-        std::vector<duckdb::unique_ptr<duckdb::Base>>& vec = results.at(i);
-        keys.push_back(dynamic_cast<BigIntData*>(vec[0].get())->value);
-        payloads.push_back(dynamic_cast<DoubleData*>(vec[1].get())->value);
-    }
+   // The keys are the first column of the benchmark tables
+   vector<INT64_KEY_TYPE>keys = scanKeys<INT64_KEY_TYPE>(con,table_name,0);
     double sum = 0;
     // for(int i=0;i<payloads.size();i++){
     //     sum += payloads[i];
@@ -347,19 +1028,20 @@ void runLookupBenchmarkOneBatchAlex<INT64_KEY_TYPE>(duckdb::Connection& con,std:
 
     std::shuffle(keys.begin(), keys.end(), g);
     std::cout<<"Keys have been shuffled!\n";
+    auto index = big_int_alex_index.Load();
+    auto cache = big_int_alex_hot_key_cache.Load();
     auto start = std::chrono::high_resolution_clock::now();
     for(int i=0;i<keys.size();i++){
         auto key = keys[i];
-        auto it = big_int_alex_index.find(key);
-        if (it != big_int_alex_index.end()) {
-            double payload = it.payload();
+        INDEX_PAYLOAD_TYPE payload;
+        if (findInAlex(*index, *cache, key, &payload)) {
             sum+=payload;
         }
     }
     std::cout<<"Average : "<<sum/keys.size()<<"\n";
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed_seconds = end - start;
-    std::cout << "Time taken to lookup "<<results.size()<<" keys is "<< elapsed_seconds.count() << " seconds\n";
+    std::cout << "Time taken to lookup "<<keys.size()<<" keys is "<< elapsed_seconds.count() << " seconds\n";
     std::cout<<"Checking Correctness: \n";
     std::string query = "SELECT AVG(payload) FROM "+table_name+";";
 
@@ -370,7 +1052,7 @@ void runLookupBenchmarkOneBatchAlex<INT64_KEY_TYPE>(duckdb::Connection& con,std:
     }
     end = std::chrono::high_resolution_clock::now();
     elapsed_seconds = end - start;
-    std::cout << "Time taken to avg from DuckDB is "<<results.size()<<" keys is "<< elapsed_seconds.count() << " seconds\n";
+    std::cout << "Time taken to avg from DuckDB is "<<keys.size()<<" keys is "<< elapsed_seconds.count() << " seconds\n";
 }
 
 template<>
@@ -384,13 +1066,8 @@ void runLookupBenchmarkOneBatchAlex<DOUBLE_KEY_TYPE>(duckdb::Connection& con,std
     std::random_device rd;
     std::mt19937 g(rd());
 
-   vector<double> payloads;
-   vector<DOUBLE_KEY_TYPE>keys;
-   for(int i=0;i<results.size();i++){
-        std::vector<duckdb::unique_ptr<duckdb::Base>>& vec = results.at(i);
-        keys.push_back(dynamic_cast<DoubleData*>(vec[0].get())->value);
-        payloads.push_back(dynamic_cast<DoubleData*>(vec[1].get())->value);
-    }
+   // The keys are the first column of the benchmark tables
+   vector<DOUBLE_KEY_TYPE>keys = scanKeys<DOUBLE_KEY_TYPE>(con,table_name,0);
     double sum = 0;
     // for(int i=0;i<payloads.size();i++){
     //     sum += payloads[i];
@@ -400,19 +1077,20 @@ void runLookupBenchmarkOneBatchAlex<DOUBLE_KEY_TYPE>(duckdb::Connection& con,std
 
     std::shuffle(keys.begin(), keys.end(), g);
     std::cout<<"Keys have been shuffled!\n";
+    auto index = double_alex_index.Load();
+    auto cache = double_alex_hot_key_cache.Load();
     auto start = std::chrono::high_resolution_clock::now();
     for(int i=0;i<keys.size();i++){
         auto key = keys[i];
-        auto it = double_alex_index.find(key);
-        if (it != double_alex_index.end()) {
-            double payload = it.payload();
+        INDEX_PAYLOAD_TYPE payload;
+        if (findInAlex(*index, *cache, key, &payload)) {
             sum+=payload;
         }
     }
     std::cout<<"Average : "<<sum/keys.size()<<"\n";
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed_seconds = end - start;
-    std::cout << "Time taken to lookup "<<results.size()<<" keys is "<< elapsed_seconds.count() << " seconds\n";
+    std::cout << "Time taken to lookup "<<keys.size()<<" keys is "<< elapsed_seconds.count() << " seconds\n";
     std::cout<<"Checking Correctness: \n";
     std::string query = "SELECT AVG(payload) FROM "+table_name+";";
 
@@ -423,7 +1101,7 @@ void runLookupBenchmarkOneBatchAlex<DOUBLE_KEY_TYPE>(duckdb::Connection& con,std
     }
     end = std::chrono::high_resolution_clock::now();
     elapsed_seconds = end - start;
-    std::cout << "Time taken to avg from DuckDB is "<<results.size()<<" keys is "<< elapsed_seconds.count() << " seconds\n";
+    std::cout << "Time taken to avg from DuckDB is "<<keys.size()<<" keys is "<< elapsed_seconds.count() << " seconds\n";
 }
 
 template<>
@@ -437,13 +1115,8 @@ void runLookupBenchmarkOneBatchAlex<UNSIGNED_INT64_KEY_TYPE>(duckdb::Connection&
     std::random_device rd;
     std::mt19937 g(rd());
 
-   vector<double> payloads;
-   vector<UNSIGNED_INT64_KEY_TYPE>keys;
-   for(int i=0;i<results.size();i++){
-        std::vector<duckdb::unique_ptr<duckdb::Base>>& vec = results.at(i);
-        keys.push_back(dynamic_cast<UBigIntData*>(vec[0].get())->value);
-        payloads.push_back(dynamic_cast<DoubleData*>(vec[1].get())->value);
-    }
+   // The keys are the first column of the benchmark tables
+   vector<UNSIGNED_INT64_KEY_TYPE>keys = scanKeys<UNSIGNED_INT64_KEY_TYPE>(con,table_name,0);
     double sum = 0;
     // for(int i=0;i<payloads.size();i++){
     //     sum += payloads[i];
@@ -453,19 +1126,20 @@ void runLookupBenchmarkOneBatchAlex<UNSIGNED_INT64_KEY_TYPE>(duckdb::Connection&
 
     std::shuffle(keys.begin(), keys.end(), g);
     std::cout<<"Keys have been shuffled!\n";
+    auto index = unsigned_big_int_alex_index.Load();
+    auto cache = unsigned_big_int_alex_hot_key_cache.Load();
     auto start = std::chrono::high_resolution_clock::now();
     for(int i=0;i<keys.size();i++){
         auto key = keys[i];
-        auto it = unsigned_big_int_alex_index.find(key);
-        if (it != unsigned_big_int_alex_index.end()) {
-            double payload = it.payload();
+        INDEX_PAYLOAD_TYPE payload;
+        if (findInAlex(*index, *cache, key, &payload)) {
             sum+=payload;
         }
     }
     std::cout<<"Average : "<<sum/keys.size()<<"\n";
     auto end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed_seconds = end - start;
-    std::cout << "Time taken to lookup "<<results.size()<<" keys is "<< elapsed_seconds.count() << " seconds\n";
+    std::cout << "Time taken to lookup "<<keys.size()<<" keys is "<< elapsed_seconds.count() << " seconds\n";
     std::cout<<"Checking Correctness: \n";
     std::string query = "SELECT AVG(payload) FROM "+table_name+";";
 
@@ -476,94 +1150,206 @@ void runLookupBenchmarkOneBatchAlex<UNSIGNED_INT64_KEY_TYPE>(duckdb::Connection&
     }
     end = std::chrono::high_resolution_clock::now();
     elapsed_seconds = end - start;
-    std::cout << "Time taken to avg from DuckDB is "<<results.size()<<" keys is "<< elapsed_seconds.count() << " seconds\n";
+    std::cout << "Time taken to avg from DuckDB is "<<keys.size()<<" keys is "<< elapsed_seconds.count() << " seconds\n";
 }
 
+/**
+ * Looks up every key of the benchmark table through DuckDB, three ways, so that the time reflects the ART
+ * index rather than the SQL parser:
+ *  - one execution of a prepared point query per key, with the key as a bound parameter,
+ *  - one join of the table against a temporary table of the keys, as the optimizer plans it,
+ *  - the same join with force_index_join, which probes the ART index of the key column once per key.
+ * The keys table is filled before the timing starts. Run create_art_index on the key column first, else the
+ * point queries scan the table. force_index_join stays on for the connection, so that join runs last.
+*/
 template<typename K>
 void runLookupBenchmarkOneBatchART(duckdb::Connection& con,std::string benchmark_name){
-    std::cout<<"Running benchmark with one batch";
-    /*
-    My rationale here - I will run the benchmark for one batch - read a defined number of keys and count the time needed to do that.
-    */
+    std::cout<<"Running benchmark with one batch"<<"\n";
+    std::cout<<"benchmark name "<<benchmark_name<<"\n";
 
-   // Create a random number generator
+    // Create a random number generator
     std::random_device rd;
     std::mt19937 g(rd());
 
-   vector<double> payloads;
-   vector<K>keys;
-   std::cout<<"benchmark name "<<benchmark_name<<"\n";
-   
-   //std::string lookup_query = "SELECT key from "+benchmark_name+" where key = ";
-   vector<K>query_keys;
-   std::string in_clause = "";
-   for(int i=0;i<results.size();i++){
-        std::vector<duckdb::unique_ptr<duckdb::Base>>& vec = results.at(i);
-        if(typeid(K).name() == typeid(INT64_KEY_TYPE).name()){
-            auto key = dynamic_cast<BigIntData*>(vec[0].get())->value;
-            query_keys.push_back(key);
-        }
-        else if(typeid(K).name() == typeid(UNSIGNED_INT64_KEY_TYPE).name()){
-            auto key = dynamic_cast<UBigIntData*>(vec[0].get())->value;
-            query_keys.push_back(key);
+    vector<K>query_keys = scanKeys<K>(con,benchmark_name,0);
+    std::shuffle(query_keys.begin(), query_keys.end(), g);
+    std::cout<<"Keys have been shuffled!\n";
+
+    // Prepared point queries
+    std::unique_ptr<PreparedStatement> point = con.Prepare("SELECT payload FROM "+benchmark_name+" WHERE key = $1");
+    if(point->HasError()){
+        std::cout<<"Error preparing the point query: "<<point->GetError()<<"\n";
+        return;
+    }
+    double sum = 0;
+    idx_t found = 0;
+    vector<Value> parameters(1);
+    auto start = std::chrono::high_resolution_clock::now();
+    for(const K &key : query_keys){
+        parameters[0] = Value::CreateValue<K>(key);
+        auto res = point->Execute(parameters, false);
+        if(res->HasError()){
+            std::cout<<"Error in query "<<res->GetError()<<"\n";
+            return;
         }
-        else{
-            auto key = dynamic_cast<DoubleData*>(vec[0].get())->value;
-            query_keys.push_back(key);
+        auto &rows = res->Cast<MaterializedQueryResult>();
+        if(rows.RowCount() > 0){
+            sum += rows.GetValue(0,0).GetValue<double>();
+            found++;
         }
-        
-        // std::ostringstream stream;
-        // stream << key;
-        // std::string ressy = stream.str();
-        
     }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> elapsed_seconds = end - start;
+    std::cout << "Time taken to lookup "<<query_keys.size()<<" keys with prepared point queries is "<< elapsed_seconds.count() << " seconds ("<<found<<" found, sum "<<sum<<")\n";
 
-    //shuffle the query_key array
-    std::shuffle(query_keys.begin(), query_keys.end(), g);
-
-    for(int i=0;i<query_keys.size();i++){
-        //std::cout<<"Key "<<query_keys[i]<<"\n";
-        if(i!=0){
-            in_clause += ",";
+    // Joins against a table of the keys
+    string keys_table = benchmark_name+"_lookup_keys";
+    auto created = con.Query("CREATE OR REPLACE TEMP TABLE "+keys_table+" (key "+getKeyTypeName<K>()+")");
+    if(created->HasError()){
+        std::cout<<"Error creating the keys table: "<<created->GetError()<<"\n";
+        return;
+    }
+    {
+        Appender appender(con, keys_table);
+        for(const K &key : query_keys){
+            appender.AppendRow(key);
         }
-
-        in_clause += std::to_string(query_keys[i]);
+        appender.Close();
     }
-    double sum = 0;
-    std::unique_ptr<PreparedStatement> prepare = con.Prepare("SELECT payload FROM "+benchmark_name+" WHERE key IN (" + in_clause + ")");
-    // for(int i=0;i<payloads.size();i++){
-    //     sum += payloads[i];
-    // }
-    // std::cout<<"Sum of payloads "<<sum<<"\n";
-    // std::cout<<"Average "<<sum/payloads.size()<<"\n";
+    std::unique_ptr<PreparedStatement> join = con.Prepare("SELECT count(*), sum(t.payload) FROM "+benchmark_name+" t JOIN "+keys_table+" k ON t.key = k.key");
+    auto runJoin = [&](const string &name){
+        auto join_start = std::chrono::high_resolution_clock::now();
+        auto res = join->Execute();
+        auto join_end = std::chrono::high_resolution_clock::now();
+        if(res->HasError()){
+            std::cout<<"Error in query "<<res->GetError()<<"\n";
+            return;
+        }
+        auto &rows = res->Cast<MaterializedQueryResult>();
+        std::chrono::duration<double> join_seconds = join_end - join_start;
+        std::cout << "Time taken to lookup "<<query_keys.size()<<" keys with "<<name<<" is "<< join_seconds.count() << " seconds ("<<rows.GetValue(0,0).ToString()<<" found, sum "<<rows.GetValue(1,0).ToString()<<")\n";
+    };
+    runJoin("a join against the keys table");
+    auto forced = con.Query("PRAGMA force_index_join");
+    if(forced->HasError()){
+        std::cout<<"Index joins are not available: "<<forced->GetError()<<"\n";
+    }
+    else{
+        join = con.Prepare("SELECT count(*), sum(t.payload) FROM "+benchmark_name+" t JOIN "+keys_table+" k ON t.key = k.key");
+        runJoin("an index join probing the ART index");
+    }
+    con.Query("DROP TABLE IF EXISTS "+keys_table);
+}
 
 
-    //std::shuffle(keys.begin(), keys.end(), g);
-    std::cout<<"Keys have been shuffled!\n";
-    auto start = std::chrono::high_resolution_clock::now();
-    std::unique_ptr<QueryResult> res = prepare->Execute();
-    if(res->HasError()){
-        std::cout<<"Error in query "<<"\n";
+
+/*
+Hot-key cache helpers for the lookup benchmarks.
+*/
+
+struct HotKeyCacheBenchmarkStats {
+    long long hits = 0;
+    long long misses = 0;
+    double cache_time = 0;  // ns spent probing the cache
+    double index_time = 0;  // ns spent probing the index for cache misses
+};
+
+/**
+ * Runs one batch of lookups through the hot-key cache like cachedLookup, but batched: all keys probe the cache
+ * first, the misses are then resolved against the index and admitted into the cache. Both passes are timed
+ * separately so that the time saved by the cache can be estimated from the per-probe cost of the index.
+ */
+template <typename K, typename IndexLookup>
+INDEX_PAYLOAD_TYPE cachedLookupBatch(HotKeyCache<K, INDEX_PAYLOAD_TYPE> &cache, K *lookup_keys, int num_lookups,
+                                     IndexLookup index_lookup, HotKeyCacheBenchmarkStats &stats){
+    INDEX_PAYLOAD_TYPE sum = 0;
+    std::vector<K> missed_keys;
+    missed_keys.reserve(num_lookups);
+    const uint64_t invalidations = cache.GetInvalidations();
+
+    auto cache_start_time = std::chrono::high_resolution_clock::now();
+    for (int j = 0; j < num_lookups; j++) {
+        INDEX_PAYLOAD_TYPE payload;
+        if (cache.Lookup(lookup_keys[j], &payload)) {
+            sum += payload;
+        }
+        else{
+            missed_keys.push_back(lookup_keys[j]);
+        }
     }
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed_seconds = end - start;
-    std::cout << "Time taken to lookup "<<results.size()<<" keys is "<< elapsed_seconds.count() << " seconds\n";
-    
+    auto index_start_time = std::chrono::high_resolution_clock::now();
+    for (const K &key : missed_keys) {
+        INDEX_PAYLOAD_TYPE payload;
+        if (index_lookup(key, &payload)) {
+            sum += payload;
+            cache.Admit(key, payload, invalidations);
+        }
+    }
+    auto index_end_time = std::chrono::high_resolution_clock::now();
+
+    stats.cache_time += std::chrono::duration_cast<std::chrono::nanoseconds>(index_start_time - cache_start_time).count();
+    stats.index_time += std::chrono::duration_cast<std::chrono::nanoseconds>(index_end_time - index_start_time).count();
+    stats.hits += num_lookups - missed_keys.size();
+    stats.misses += missed_keys.size();
+    return sum;
 }
 
+void printHotKeyCacheStats(const HotKeyCacheBenchmarkStats &stats){
+    long long total = stats.hits + stats.misses;
+    if (total == 0) {
+        return;
+    }
+    // Every hit would otherwise have cost one index probe.
+    double index_time_per_probe = stats.misses > 0 ? stats.index_time / stats.misses : 0;
+    double saved_time = stats.hits * index_time_per_probe - stats.cache_time;
+    std::cout << "Hot-key cache stats: " << stats.hits << " hits, " << stats.misses << " misses"
+              << "\n\thit rate:\t" << 100.0 * stats.hits / total << " %"
+              << "\n\tcache probe time:\t" << stats.cache_time / total << " ns/lookup"
+              << "\n\tindex probe time:\t" << index_time_per_probe << " ns/lookup"
+              << "\n\testimated time saved:\t" << saved_time / 1e9 << " seconds" << std::endl;
+}
 
+void functionHotKeyCacheSize(ClientContext &context, const FunctionParameters &parameters){
+    int capacity = parameters.values[0].GetValue<int>();
+    if (capacity < 0) {
+        throw InvalidInputException("hot_key_cache_size expects a non-negative number of entries");
+    }
+    // Lookups may be probing the current caches, so they are replaced rather than resized in place
+    hot_key_cache_capacity = capacity;
+    publishHotKeyCache(double_alex_hot_key_cache, capacity);
+    publishHotKeyCache(big_int_alex_hot_key_cache, capacity);
+    publishHotKeyCache(unsigned_big_int_alex_hot_key_cache, capacity);
+    publishHotKeyCache(int_alex_hot_key_cache, capacity);
+    publishHotKeyCache(double_pgm_hot_key_cache, capacity);
+    publishHotKeyCache(big_int_pgm_hot_key_cache, capacity);
+    publishHotKeyCache(unsigned_big_int_pgm_hot_key_cache, capacity);
+    publishHotKeyCache(int_pgm_hot_key_cache, capacity);
+    for (auto &entry : listRadixSplines(radix_spline_map_int64)) {
+        publishHotKeyCache(entry.second->cache, capacity);
+    }
+    for (auto &entry : listRadixSplines(radix_spline_map_int32)) {
+        publishHotKeyCache(entry.second->cache, capacity);
+    }
+    if (capacity == 0) {
+        std::cout<<"Hot-key cache disabled\n";
+    }
+    else{
+        std::cout<<"Hot-key cache enabled with "<<capacity<<" entries per index ("<<double_alex_hot_key_cache->GetSize()<<" bytes)\n";
+    }
+}
 
 /*
 Run the Benchmarks on different indexes.
 */
 
-template <typename K>
-void runLookupBenchmarkAlex(K *keys);
-
-template <>
-void runLookupBenchmarkAlex(double *keys){
+/**
+ * Zipf lookup workload against one version of an ALEX index.
+*/
+template <typename Index>
+void runLookupBenchmarkAlexIndex(std::shared_ptr<Index> index, double *keys){
 
-    if(double_alex_index.size()==0){
+    // The benchmark keeps using this version even if a rebuild publishes a new one meanwhile
+    if(index->size()==0){
         std::cout<<"Index is empty. Please load the data into the index first."<<"\n";
         return;
     }
@@ -591,6 +1377,7 @@ void runLookupBenchmarkAlex(double *keys){
     INDEX_PAYLOAD_TYPE sum = 0;
     std::cout << std::scientific;
     std::cout << std::setprecision(3);
+    HotKeyCacheBenchmarkStats cache_stats;
 
     while (true) {
         batch_no++;
@@ -609,16 +1396,25 @@ void runLookupBenchmarkAlex(double *keys){
             //return 1;
         }
         auto lookups_start_time = std::chrono::high_resolution_clock::now();
-        for (int j = 0; j < num_lookups_per_batch; j++) {
-            double key = lookup_keys[j];
-            INDEX_PAYLOAD_TYPE* payload = double_alex_index.get_payload(key);
-            // std::cout<<"Key "<<key<<" Payload "<<*payload<<"\n";
-            if (payload) {
-                std::cout<<"Payload is there! "<<"\n";
-                sum += *payload;
-            }
-            else{
-                std::cout<<"Payload is not here!! "<<"\n";
+        auto cache = double_alex_hot_key_cache.Load();
+        if (cache->Enabled()) {
+            sum += cachedLookupBatch(*cache, lookup_keys, num_lookups_per_batch,
+                                     [&index](double key, INDEX_PAYLOAD_TYPE *payload) {
+                auto found = index->get_payload(key);
+                if (!found) {
+                    return false;
+                }
+                *payload = *found;
+                return true;
+            }, cache_stats);
+        }
+        else{
+            for (int j = 0; j < num_lookups_per_batch; j++) {
+                double key = lookup_keys[j];
+                INDEX_PAYLOAD_TYPE payload;
+                if (findInAlex(*index, *cache, key, &payload)) {
+                    sum += payload;
+                }
             }
         }
         auto lookups_end_time = std::chrono::high_resolution_clock::now();
@@ -665,16 +1461,17 @@ void runLookupBenchmarkAlex(double *keys){
                 << cumulative_operations / cumulative_time * 1e9 << " ops/sec"
                 << std::endl;
 
-    delete[] keys;
+    printHotKeyCacheStats(cache_stats);
 }
 
 
 
-template <>
-void runLookupBenchmarkAlex(INT64_KEY_TYPE *keys){
+template <typename Index>
+void runLookupBenchmarkAlexIndex(std::shared_ptr<Index> index, INT64_KEY_TYPE *keys){
 
 
-    if(big_int_alex_index.size()==0){
+    // The benchmark keeps using this version even if a rebuild publishes a new one meanwhile
+    if(index->size()==0){
         std::cout<<"Index is empty. Please load the data into the index first."<<"\n";
         return;
     }
@@ -703,6 +1500,7 @@ void runLookupBenchmarkAlex(INT64_KEY_TYPE *keys){
     INDEX_PAYLOAD_TYPE sum = 0;
     std::cout << std::scientific;
     std::cout << std::setprecision(3);
+    HotKeyCacheBenchmarkStats cache_stats;
 
     while (true) {
         batch_no++;
@@ -721,16 +1519,25 @@ void runLookupBenchmarkAlex(INT64_KEY_TYPE *keys){
             //return 1;
         }
         auto lookups_start_time = std::chrono::high_resolution_clock::now();
-        for (int j = 0; j < num_lookups_per_batch; j++) {
-            int64_t key = lookup_keys[j];
-            INDEX_PAYLOAD_TYPE* payload = big_int_alex_index.get_payload(key);
-            //std::cout<<"Key "<<key<<" Payload "<<*payload<<"\n";
-            if (payload) {
-                //std::cout<<"Payload is there! "<<"\n";
-                sum += *payload;
-            }
-            else{
-                std::cout<<"Payload is not here!! "<<"\n";
+        auto cache = big_int_alex_hot_key_cache.Load();
+        if (cache->Enabled()) {
+            sum += cachedLookupBatch(*cache, lookup_keys, num_lookups_per_batch,
+                                     [&index](int64_t key, INDEX_PAYLOAD_TYPE *payload) {
+                auto found = index->get_payload(key);
+                if (!found) {
+                    return false;
+                }
+                *payload = *found;
+                return true;
+            }, cache_stats);
+        }
+        else{
+            for (int j = 0; j < num_lookups_per_batch; j++) {
+                int64_t key = lookup_keys[j];
+                INDEX_PAYLOAD_TYPE payload;
+                if (findInAlex(*index, *cache, key, &payload)) {
+                    sum += payload;
+                }
             }
         }
         auto lookups_end_time = std::chrono::high_resolution_clock::now();
@@ -788,16 +1595,35 @@ void runLookupBenchmarkAlex(INT64_KEY_TYPE *keys){
     //             << cumulative_operations / cumulative_time * 1e9 << " ops/sec"
     //             << std::endl;
 
-    delete[] keys;
+    printHotKeyCacheStats(cache_stats);
 }
 
+/**
+ * Runs the lookup workload against the sharded ALEX index of the key type if one was built, else against
+ * the plain one.
+*/
 template <typename K>
-void runLookupBenchmarkPgm(K *keys);
+void runLookupBenchmarkAlex(K *keys);
 
 template <>
-void runLookupBenchmarkPgm(double *keys){
+void runLookupBenchmarkAlex(double *keys){
+    runLookupBenchmarkAlexIndex(double_alex_index.Load(),keys);
+}
+
+template <>
+void runLookupBenchmarkAlex(INT64_KEY_TYPE *keys){
+    runLookupBenchmarkAlexIndex(big_int_alex_index.Load(),keys);
+}
+
+template <typename K>
+void runLookupBenchmarkPgm(K *keys);
 
-    if(double_dynamic_index.size()==0){
+/**
+ * Zipf lookup workload against one version of a PGM index, either a DynamicPGMIndex or a read-only StaticPGMIndex.
+*/
+template <typename Index>
+void runLookupBenchmarkPgmIndex(std::shared_ptr<Index> index, double *keys){
+    if(index->size()==0){
         std::cout<<"Index is empty. Please load the data into the index first."<<"\n";
         return;
     }
@@ -825,6 +1651,7 @@ void runLookupBenchmarkPgm(double *keys){
     INDEX_PAYLOAD_TYPE sum = 0;
     std::cout << std::scientific;
     std::cout << std::setprecision(3);
+    HotKeyCacheBenchmarkStats cache_stats;
 
     while (true) {
         batch_no++;
@@ -843,17 +1670,25 @@ void runLookupBenchmarkPgm(double *keys){
             //return 1;
         }
         auto lookups_start_time = std::chrono::high_resolution_clock::now();
-        for (int j = 0; j < num_lookups_per_batch; j++) {
-            double key = lookup_keys[j];
-            // INDEX_PAYLOAD_TYPE* payload = double_index.get_payload(key); pointer returned
-            // INDEX_PAYLOAD_TYPE payload = double_dynamic_index.find(key)->second;
-            // std::cout<<"Key "<<key<<" Payload "<<*payload<<"\n";
-            if (double_dynamic_index.find(key) != double_dynamic_index.end()) {
-                std::cout<<"Payload is there! "<<"\n";
-                sum += double_dynamic_index.find(key)->second;
-            }
-            else{
-                std::cout<<"Payload is not here!! "<<"\n";
+        auto cache = double_pgm_hot_key_cache.Load();
+        if (cache->Enabled()) {
+            sum += cachedLookupBatch(*cache, lookup_keys, num_lookups_per_batch,
+                                     [&index](double key, INDEX_PAYLOAD_TYPE *payload) {
+                auto it = index->find(key);
+                if (it == index->end()) {
+                    return false;
+                }
+                *payload = it->second;
+                return true;
+            }, cache_stats);
+        }
+        else{
+            for (int j = 0; j < num_lookups_per_batch; j++) {
+                double key = lookup_keys[j];
+                INDEX_PAYLOAD_TYPE payload;
+                if (findInPgm(*index, *cache, key, &payload)) {
+                    sum += payload;
+                }
             }
         }
         auto lookups_end_time = std::chrono::high_resolution_clock::now();
@@ -900,14 +1735,13 @@ void runLookupBenchmarkPgm(double *keys){
                 << cumulative_operations / cumulative_time * 1e9 << " ops/sec"
                 << std::endl;
 
-    delete[] keys;
+    printHotKeyCacheStats(cache_stats);
 }
 
-template <>
-void runLookupBenchmarkPgm(INT64_KEY_TYPE *keys){
-
+template <typename Index>
+void runLookupBenchmarkPgmIndex(std::shared_ptr<Index> index, INT64_KEY_TYPE *keys){
 
-    if(big_int_dynamic_index.size()==0){
+    if(index->size()==0){
         std::cout<<"Index is empty. Please load the data into the index first."<<"\n";
         return;
     }
@@ -936,6 +1770,7 @@ void runLookupBenchmarkPgm(INT64_KEY_TYPE *keys){
     INDEX_PAYLOAD_TYPE sum = 0;
     std::cout << std::scientific;
     std::cout << std::setprecision(3);
+    HotKeyCacheBenchmarkStats cache_stats;
 
     while (true) {
         batch_no++;
@@ -954,16 +1789,25 @@ void runLookupBenchmarkPgm(INT64_KEY_TYPE *keys){
             //return 1;
         }
         auto lookups_start_time = std::chrono::high_resolution_clock::now();
-        for (int j = 0; j < num_lookups_per_batch; j++) {
-            int64_t key = lookup_keys[j];
-            // INDEX_PAYLOAD_TYPE* payload = big_int_dynamic_index.get_payload(key);
-            //std::cout<<"Key "<<key<<" Payload "<<*payload<<"\n";
-            if (big_int_dynamic_index.find(key) != big_int_dynamic_index.end())  {
-                //std::cout<<"Payload is there! "<<"\n";
-                sum += big_int_dynamic_index.find(key)->second;
-            }
-            else{
-                std::cout<<"Payload is not here!! "<<"\n";
+        auto cache = big_int_pgm_hot_key_cache.Load();
+        if (cache->Enabled()) {
+            sum += cachedLookupBatch(*cache, lookup_keys, num_lookups_per_batch,
+                                     [&index](int64_t key, INDEX_PAYLOAD_TYPE *payload) {
+                auto it = index->find(key);
+                if (it == index->end()) {
+                    return false;
+                }
+                *payload = it->second;
+                return true;
+            }, cache_stats);
+        }
+        else{
+            for (int j = 0; j < num_lookups_per_batch; j++) {
+                int64_t key = lookup_keys[j];
+                INDEX_PAYLOAD_TYPE payload;
+                if (findInPgm(*index, *cache, key, &payload)) {
+                    sum += payload;
+                }
             }
         }
         auto lookups_end_time = std::chrono::high_resolution_clock::now();
@@ -1021,11 +1865,36 @@ void runLookupBenchmarkPgm(INT64_KEY_TYPE *keys){
     //             << cumulative_operations / cumulative_time * 1e9 << " ops/sec"
     //             << std::endl;
 
-    delete[] keys;
+    printHotKeyCacheStats(cache_stats);
 }
 
 
 
+/**
+ * Runs the lookup workload against the read-only PGM index of the key type if one was built, else against the
+ * dynamic one. Either way the benchmark keeps using the version it started with, even if a rebuild publishes
+ * a new one meanwhile.
+*/
+template <>
+void runLookupBenchmarkPgm(double *keys){
+    auto static_index = double_static_pgm_index.Load();
+    if(static_index->size()>0){
+        runLookupBenchmarkPgmIndex(static_index,keys);
+        return;
+    }
+    runLookupBenchmarkPgmIndex(double_dynamic_index.Load(),keys);
+}
+
+template <>
+void runLookupBenchmarkPgm(INT64_KEY_TYPE *keys){
+    auto static_index = big_int_static_pgm_index.Load();
+    if(static_index->size()>0){
+        runLookupBenchmarkPgmIndex(static_index,keys);
+        return;
+    }
+    runLookupBenchmarkPgmIndex(big_int_dynamic_index.Load(),keys);
+}
+
 void functionRunLookupBenchmark(ClientContext &context, const FunctionParameters &parameters){
     std::cout<<"Running lookup benchmark"<<"\n";
     std::string benchmarkName = parameters.values[0].GetValue<string>();
@@ -1035,14 +1904,14 @@ void functionRunLookupBenchmark(ClientContext &context, const FunctionParameters
     std::string keys_file_path = "";
     if(benchmarkName == "lognormal"){
         keys_file_path = "/Users/jishnusm/Desktop/classes/AdvancedDataStores/Project/Project2/radix/test/lognormal-190M.bin";
-        auto keys = new INT64_KEY_TYPE[load_end_point];
+        std::vector<INT64_KEY_TYPE> keys(load_end_point);
         std::cout<<"Loading binary data "<<std::endl;
-        load_binary_data(keys, load_end_point, keys_file_path);
+        load_binary_data(keys.data(), load_end_point, keys_file_path);
         if(index == "alex"){
-            runLookupBenchmarkAlex<INT64_KEY_TYPE>(keys);
+            runLookupBenchmarkAlex<INT64_KEY_TYPE>(keys.data());
         }
         else if(index=="pgm"){
-            runLookupBenchmarkPgm<INT64_KEY_TYPE>(keys);
+            runLookupBenchmarkPgm<INT64_KEY_TYPE>(keys.data());
         }
         
         // else{
@@ -1051,14 +1920,14 @@ void functionRunLookupBenchmark(ClientContext &context, const FunctionParameters
     }
     else if(benchmarkName == "longlat"){
         keys_file_path = "/Users/jishnusm/Desktop/classes/AdvancedDataStores/Project/Project2/radix/test/longlat-200M.bin";
-        auto keys = new DOUBLE_KEY_TYPE[load_end_point];
+        std::vector<DOUBLE_KEY_TYPE> keys(load_end_point);
         std::cout<<"Loading binary data "<<std::endl;
-        load_binary_data(keys, load_end_point, keys_file_path);
+        load_binary_data(keys.data(), load_end_point, keys_file_path);
         if(index == "alex"){
-            runLookupBenchmarkAlex<DOUBLE_KEY_TYPE>(keys);
+            runLookupBenchmarkAlex<DOUBLE_KEY_TYPE>(keys.data());
         }
         else if(index=="pgm"){
-            runLookupBenchmarkPgm<DOUBLE_KEY_TYPE>(keys);
+            runLookupBenchmarkPgm<DOUBLE_KEY_TYPE>(keys.data());
         }
         // else{
         //     runLookupBenchmarkArt<DOUBLE_KEY_TYPE>(keys,con,benchmarkName);
@@ -1066,14 +1935,14 @@ void functionRunLookupBenchmark(ClientContext &context, const FunctionParameters
     }
     else if(benchmarkName=="ycsb"){
         keys_file_path = "/Users/jishnusm/Desktop/classes/AdvancedDataStores/Project/Project2/radix/test/ycsb-200M.bin";
-        auto keys = new INT64_KEY_TYPE[load_end_point];
+        std::vector<INT64_KEY_TYPE> keys(load_end_point);
         std::cout<<"Loading binary data "<<std::endl;
-        load_binary_data(keys, load_end_point, keys_file_path);
+        load_binary_data(keys.data(), load_end_point, keys_file_path);
         if(index == "alex"){
-            runLookupBenchmarkAlex<INT64_KEY_TYPE>(keys);
+            runLookupBenchmarkAlex<INT64_KEY_TYPE>(keys.data());
         }
         else if(index=="pgm"){
-            runLookupBenchmarkPgm<INT64_KEY_TYPE>(keys);
+            runLookupBenchmarkPgm<INT64_KEY_TYPE>(keys.data());
         }
         // else{
         //     runLookupBenchmarkArt<INT64_KEY_TYPE>(keys,con,benchmarkName);
@@ -1081,14 +1950,14 @@ void functionRunLookupBenchmark(ClientContext &context, const FunctionParameters
     }
     else if(benchmarkName == "longitudes"){
         keys_file_path = "/Users/jishnusm/Desktop/classes/AdvancedDataStores/Project/Project2/radix/test/longitudes-200M.bin";
-        auto keys = new DOUBLE_KEY_TYPE[load_end_point];
+        std::vector<DOUBLE_KEY_TYPE> keys(load_end_point);
         std::cout<<"Loading binary data "<<std::endl;
-        load_binary_data(keys, load_end_point, keys_file_path); 
+        load_binary_data(keys.data(), load_end_point, keys_file_path); 
         if(index == "alex"){
-            runLookupBenchmarkAlex<DOUBLE_KEY_TYPE>(keys);
+            runLookupBenchmarkAlex<DOUBLE_KEY_TYPE>(keys.data());
         }
         else if(index=="pgm"){
-            runLookupBenchmarkPgm<DOUBLE_KEY_TYPE>(keys);
+            runLookupBenchmarkPgm<DOUBLE_KEY_TYPE>(keys.data());
         }
         // else{
         //     runLookupBenchmarkArt<DOUBLE_KEY_TYPE>(keys,con,benchmarkName);
@@ -1099,248 +1968,283 @@ void functionRunLookupBenchmark(ClientContext &context, const FunctionParameters
 
 
 template <typename K>
-void print_stats(){
-    if(typeid(K)==typeid(DOUBLE_KEY_TYPE)){
-        auto stats = double_alex_index.get_stats();
-        std::cout<<"Stats about the index \n";
-        std::cout<<"***************************\n";
-        std::cout<<"Number of keys : "<<stats.num_keys<<"\n";
-        std::cout<<"Number of model nodes : "<<stats.num_model_nodes<<"\n";
-        std::cout<<"Number of data nodes: "<<stats.num_data_nodes<<"\n";
-    }
-    else if(typeid(K)==typeid(UNSIGNED_INT64_KEY_TYPE)){
-        auto stats = unsigned_big_int_alex_index.get_stats();
-        std::cout<<"Stats about the index \n";
-        std::cout<<"***************************\n";
-        std::cout<<"Number of keys : "<<stats.num_keys<<"\n";
-        std::cout<<"Number of model nodes : "<<stats.num_model_nodes<<"\n";
-        std::cout<<"Number of data nodes: "<<stats.num_data_nodes<<"\n";
-    }
-    else if(typeid(K)==typeid(INT_KEY_TYPE)){
-        auto stats = int_alex_index.get_stats();
-        std::cout<<"Stats about the index \n";
-        std::cout<<"***************************\n";
-        std::cout<<"Number of keys : "<<stats.num_keys<<"\n";
-        std::cout<<"Number of model nodes : "<<stats.num_model_nodes<<"\n";
-        std::cout<<"Number of data nodes: "<<stats.num_data_nodes<<"\n";
-    }
-    else{
-        auto stats = big_int_alex_index.get_stats();
-        std::cout<<"Stats about the index \n";
-        std::cout<<"***************************\n";
-        std::cout<<"Number of keys : "<<stats.num_keys<<"\n";
-        std::cout<<"Number of model nodes : "<<stats.num_model_nodes<<"\n";
-        std::cout<<"Number of data nodes: "<<stats.num_data_nodes<<"\n";
-    }
-
+void print_stats(const ShardedAlex<K,INDEX_PAYLOAD_TYPE> &index){
+    long long num_model_nodes = 0;
+    long long num_data_nodes = 0;
+    index.for_each_shard([&](const AlexIndex<K,INDEX_PAYLOAD_TYPE> &shard) {
+        num_model_nodes += shard.get_stats().num_model_nodes;
+        num_data_nodes += shard.get_stats().num_data_nodes;
+    });
+    std::cout<<"Stats about the index \n";
+    std::cout<<"***************************\n";
+    std::cout<<"Number of keys : "<<index.size()<<"\n";
+    std::cout<<"Number of model nodes : "<<num_model_nodes<<"\n";
+    std::cout<<"Number of data nodes: "<<num_data_nodes<<"\n";
 }
 
 /*
-Bulk Load into Index functions
+Memory accounting
 */
 
-template <typename K,typename P>
-void bulkLoadIntoIndex(duckdb::Connection & con,std::string table_name,int column_index){
-    std::cout<<"General Function with no consequence.\n"; 
+/**
+ * Reports the memory of the learned indexes to the buffer manager of the database, so that it counts against
+ * memory_limit next to the buffers of DuckDB and shows up with the EXTENSION tag in duckdb_memory(). The indexes are
+ * shared by every database of the process, so each one that loads the extension reserves all of it. When the buffer
+ * manager cannot make room, the allocation that needed it fails with an OutOfMemoryException before the pool takes
+ * the memory.
+*/
+void registerLearnedIndexMemory(DatabaseInstance &instance) {
+    weak_ptr<DatabaseInstance> db = instance.shared_from_this();
+    LearnedIndexMemoryPool::Get().AddMemoryReservation(
+        &instance,
+        [db](size_t bytes) {
+            auto database = db.lock();
+            if (!database) {
+                return false;
+            }
+            try {
+                BufferManager::GetBufferManager(*database).ReserveMemory(bytes);
+            } catch (OutOfMemoryException &e) {
+                throw OutOfMemoryException("Not enough memory for the learned indexes: %s", e.what());
+            }
+            return true;
+        },
+        [db](size_t bytes) {
+            auto database = db.lock();
+            if (database) {
+                BufferManager::GetBufferManager(*database).FreeReservedMemory(bytes);
+            }
+        });
 }
 
+/**
+ * The ALEX and PGM (dynamic or read-only) index of a key type together with their hot-key caches.
+*/
+template<typename K>
+struct LearnedIndexes {
+    PublishedIndex<ShardedAlex<K,INDEX_PAYLOAD_TYPE>> &alex_index;
+    PublishedIndex<HotKeyCache<K,INDEX_PAYLOAD_TYPE>> &alex_cache;
+    PublishedIndex<pgm::DynamicPGMIndex<K,INDEX_PAYLOAD_TYPE>> &pgm_index;
+    PublishedIndex<StaticPGMIndex<K,INDEX_PAYLOAD_TYPE>> &static_pgm_index;
+    PublishedIndex<HotKeyCache<K,INDEX_PAYLOAD_TYPE>> &pgm_cache;
+    LearnedIndexMemoryCharge &pgm_memory;
+};
+
+template<typename K>
+LearnedIndexes<K> getLearnedIndexes();
+
 template<>
-void bulkLoadIntoIndex<double,INDEX_PAYLOAD_TYPE>(duckdb::Connection & con,std::string table_name,int column_index){
-/*
-    Phase 1: Load the data from the table.
-    */
-    string query = "SELECT * FROM "+table_name+";";
-    unique_ptr<MaterializedQueryResult> result = con.Query(query);
-    results = result->getContents();
-    int num_keys = results.size();
-    //std::cout<<"Num Keys : "<<num_keys<<"\n";
-
-   /*
-    Phase 2: Bulk load the data from the results vector into the pair array that goes into the index.
-   */
-   std::pair<double,INDEX_PAYLOAD_TYPE>* bulk_load_values = new std::pair<double,INDEX_PAYLOAD_TYPE>[num_keys];  
-    int max_key = INT_MIN;
-    for (int i=0;i<results.size();i++){
-        int row_id = i;
-        //std::cout<<"before key"<<"\n";
-        auto rrr = results[i][column_index].get();
-        
-        double key_ = dynamic_cast<DoubleData*>(rrr)->value;
-        double value_ = dynamic_cast<DoubleData*>(results[i][column_index+1].get())->value;
-        
-        //std::cout<<"after key"<<"\n";
-        bulk_load_values[i] = {key_,value_};
-    }
-    /**
-     Phase 3: Sort the bulk load values array based on the key values.
-    */
+LearnedIndexes<DOUBLE_KEY_TYPE> getLearnedIndexes(){
+    return {double_alex_index,double_alex_hot_key_cache,double_dynamic_index,double_static_pgm_index,double_pgm_hot_key_cache,double_pgm_memory};
+}
 
-    auto start_time = std::chrono::high_resolution_clock::now();
-    std::sort(bulk_load_values,bulk_load_values+num_keys,[](auto const& a, auto const& b) { return a.first < b.first; });
+template<>
+LearnedIndexes<INT64_KEY_TYPE> getLearnedIndexes(){
+    return {big_int_alex_index,big_int_alex_hot_key_cache,big_int_dynamic_index,big_int_static_pgm_index,big_int_pgm_hot_key_cache,big_int_pgm_memory};
+}
 
-    /*
-    Phase 4: Bulk load the sorted values into the index.
-    */
-    
-    double_alex_index.bulk_load(bulk_load_values, num_keys);
-    auto end_time = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed_seconds = end_time - start_time;
-    std::cout << "Time taken to bulk load: " << elapsed_seconds.count() << " seconds\n\n\n";
-    print_stats<DOUBLE_KEY_TYPE>();
+template<>
+LearnedIndexes<UNSIGNED_INT64_KEY_TYPE> getLearnedIndexes(){
+    return {unsigned_big_int_alex_index,unsigned_big_int_alex_hot_key_cache,unsigned_big_int_dynamic_index,unsigned_big_int_static_pgm_index,unsigned_big_int_pgm_hot_key_cache,unsigned_big_int_pgm_memory};
 }
 
 template<>
-void bulkLoadIntoIndex<int64_t,INDEX_PAYLOAD_TYPE>(duckdb::Connection & con,std::string table_name,int column_index){
-/*
-    Phase 1: Load the data from the table.
-    */
-    string query = "SELECT * FROM "+table_name+";";
-    unique_ptr<MaterializedQueryResult> result = con.Query(query);
-    results = result->getContents();
-    int num_keys = results.size();
-    //std::cout<<"Num Keys : "<<num_keys<<"\n";
-
-   /*
-    Phase 2: Bulk load the data from the results vector into the pair array that goes into the index.
-   */
-   std::pair<int64_t,INDEX_PAYLOAD_TYPE>* bulk_load_values = new std::pair<int64_t,INDEX_PAYLOAD_TYPE>[num_keys];
-    //std::cout<<"Col index "<<column_index<<"\n";    
-    int max_key = INT_MIN;
-    for (int i=0;i<results.size();i++){
-        int row_id = i;
-        //std::cout<<"before key"<<"\n";
-        auto rrr = results[i][column_index].get();
-        
-        int64_t key_ = dynamic_cast<BigIntData*>(rrr)->value;
-        double value_ = dynamic_cast<DoubleData*>(results[i][column_index+1].get())->value;
-        
-        //std::cout<<"after key"<<"\n";
-        bulk_load_values[i] = {key_,value_};
+LearnedIndexes<INT_KEY_TYPE> getLearnedIndexes(){
+    return {int_alex_index,int_alex_hot_key_cache,int_dynamic_index,int_static_pgm_index,int_pgm_hot_key_cache,int_pgm_memory};
+}
+
+// The key types that have learned indexes, see getLearnedIndexes
+template<typename K>
+constexpr bool isLearnedIndexKeyType = std::is_same<K,DOUBLE_KEY_TYPE>::value || std::is_same<K,INT64_KEY_TYPE>::value ||
+                                       std::is_same<K,UNSIGNED_INT64_KEY_TYPE>::value || std::is_same<K,INT_KEY_TYPE>::value;
+
+/**
+ * Makes sure a learned index build over table_name fits into memory_limit before it starts, at bytes_per_row for
+ * the build buffers and the index. The buffer manager evicts what it can to make room; if that is not enough, the
+ * build fails with an OutOfMemoryException instead of overcommitting. Called before the rebuild begins, so a failed
+ * check leaves the current index as it is.
+*/
+void checkIndexBuildMemory(duckdb::Connection &con, const std::string &table_name, idx_t bytes_per_row){
+    auto count = con.Query("SELECT count(*) FROM "+table_name+";");
+    if(count->HasError() || count->RowCount()==0){
+        // The scan of the build reports the error
+        return;
     }
-    /**
-     Phase 3: Sort the bulk load values array based on the key values.
-    */
-   //Measure time 
-    
-    auto start_time = std::chrono::high_resolution_clock::now();
-    std::sort(bulk_load_values,bulk_load_values+num_keys,[](auto const& a, auto const& b) { return a.first < b.first; });
-    
-    /*
-    Phase 4: Bulk load the sorted values into the index.
-    */
-    
-    big_int_alex_index.bulk_load(bulk_load_values, num_keys);
-    auto end_time = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed_seconds = end_time - start_time;
-    std::cout << "Time taken to bulk load: " << elapsed_seconds.count() <<" seconds\n\n\n";
-    print_stats<INT64_KEY_TYPE>();
+    idx_t bytes = count->GetValue(0,0).GetValue<int64_t>() * bytes_per_row;
+    auto &buffer_manager = BufferManager::GetBufferManager(*con.context->db);
+    try{
+        buffer_manager.ReserveMemory(bytes);
+    }
+    catch(OutOfMemoryException &e){
+        throw OutOfMemoryException("Not enough memory to build a learned index on %s, which needs about %s: %s",
+                                   table_name, StringUtil::BytesToHumanReadableString(bytes), e.what());
+    }
+    buffer_manager.FreeReservedMemory(bytes);
 }
 
-template<>
-void bulkLoadIntoIndex<UNSIGNED_INT64_KEY_TYPE,INDEX_PAYLOAD_TYPE>(duckdb::Connection & con,std::string table_name,int column_index){
+// Per row: the pair in the sorted build buffer, and about two more in the data nodes of ALEX, which leave gaps for
+// inserts, or in the copy of the pairs and the keys a PGM index keeps
+#define INDEX_BUILD_PAIRS_PER_ROW 3
+// An ALEX index keeps two copies of every shard, see left_right.h
+#define ALEX_BUILD_PAIRS_PER_ROW (INDEX_BUILD_PAIRS_PER_ROW + 2)
+
 /*
-    Phase 1: Load the data from the table.
-    */
-    string query = "SELECT * FROM "+table_name+";";
-    unique_ptr<MaterializedQueryResult> result = con.Query(query);
-    results = result->getContents();
-    int num_keys = results.size();
-    //std::cout<<"Num Keys : "<<num_keys<<"\n";
-
-   /*
-    Phase 2: Bulk load the data from the results vector into the pair array that goes into the index.
-   */
-   std::pair<UNSIGNED_INT64_KEY_TYPE,INDEX_PAYLOAD_TYPE>* bulk_load_values = new std::pair<UNSIGNED_INT64_KEY_TYPE,INDEX_PAYLOAD_TYPE>[num_keys];
-    //std::cout<<"Col index "<<column_index<<"\n";    
-    int max_key = INT_MIN;
-    for (int i=0;i<results.size();i++){
-        int row_id = i;
-        //std::cout<<"before key"<<"\n";
-        auto rrr = results[i][column_index].get();
-        
-        UNSIGNED_INT64_KEY_TYPE key_ = dynamic_cast<UBigIntData*>(rrr)->value;
-        double value_ = dynamic_cast<DoubleData*>(results[i][column_index+1].get())->value;
-        
-        //std::cout<<"after key"<<"\n";
-        bulk_load_values[i] = {key_,value_};
+Bulk Load into Index functions
+*/
+
+/**
+ * Sorts the pairs scanned for a build by key and keeps one pair per key, that of the last row, like inserts of a key
+ * that is there already do.
+*/
+template <typename K>
+void sortUniqueKeyValuePairs(std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> &pairs){
+    std::stable_sort(pairs.begin(),pairs.end(),[](auto const& a, auto const& b) { return a.first < b.first; });
+    auto last = pairs.begin();
+    for(auto it = pairs.begin(); it != pairs.end(); ++it){
+        if(last != pairs.begin() && (last - 1)->first == it->first){
+            *(last - 1) = *it;
+        }
+        else{
+            *last++ = *it;
+        }
     }
-    /**
-     Phase 3: Sort the bulk load values array based on the key values.
-    */
-   //Measure time 
-    
-    auto start_time = std::chrono::high_resolution_clock::now();
-    std::sort(bulk_load_values,bulk_load_values+num_keys,[](auto const& a, auto const& b) { return a.first < b.first; });
-    
-    /*
-    Phase 4: Bulk load the sorted values into the index.
-    */
-    
-    unsigned_big_int_alex_index.bulk_load(bulk_load_values, num_keys);
-    auto end_time = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed_seconds = end_time - start_time;
-    std::cout << "Time taken to bulk load: " << elapsed_seconds.count() <<" seconds\n\n\n";
-    print_stats<UNSIGNED_INT64_KEY_TYPE>();
+    pairs.erase(last, pairs.end());
 }
 
-template<>
-void bulkLoadIntoIndex<INT_KEY_TYPE,INDEX_PAYLOAD_TYPE>(duckdb::Connection & con,std::string table_name,int column_index){
+/**
+ * Publishes the ALEX index built on the sorted values, split into num_shards key ranges if num_shards is
+ * not 0 and in a single shard otherwise.
+*/
+template <typename K>
+void publishAlexIndex(std::pair<K,INDEX_PAYLOAD_TYPE> *sorted_values,int num_keys,size_t num_shards,
+                      PublishedIndex<ShardedAlex<K,INDEX_PAYLOAD_TYPE>> &alex_index){
+    auto index = std::make_shared<ShardedAlex<K,INDEX_PAYLOAD_TYPE>>(sorted_values,num_keys,std::max<size_t>(num_shards,1));
+    alex_index.Publish(index);
+    if(num_shards>0){
+        std::cout<<"Sharded ALEX index with "<<index->num_shards()<<" shards and "<<index->size()<<" keys\n";
+    }
+}
+
+/**
+ * Builds the ALEX index of the key type on the column of the table, split into num_shards key ranges if num_shards is
+ * not 0, and publishes it.
+*/
+template <typename K>
+void bulkLoadIntoIndex(duckdb::Connection & con,std::string table_name,int column_index,size_t num_shards,IndexBuildProgress *progress){
+    static_assert(isLearnedIndexKeyType<K>, "ALEX indexes are built on DOUBLE, BIGINT, UBIGINT and INTEGER keys only");
+    auto indexes = getLearnedIndexes<K>();
 /*
-    Phase 1: Load the data from the table.
+    Phase 1 and 2: Scan the (key, value) pairs that go into the index out of the table.
     */
-    string query = "SELECT * FROM "+table_name+";";
-    unique_ptr<MaterializedQueryResult> result = con.Query(query);
-    results = result->getContents();
-    int num_keys = results.size();
-    //std::cout<<"Num Keys : "<<num_keys<<"\n";
-
-   /*
-    Phase 2: Bulk load the data from the results vector into the pair array that goes into the index.
-   */
-   std::pair<INT_KEY_TYPE,INDEX_PAYLOAD_TYPE>* bulk_load_values = new std::pair<INT_KEY_TYPE,INDEX_PAYLOAD_TYPE>[num_keys];
-    //std::cout<<"Col index "<<column_index<<"\n";    
-    int max_key = INT_MIN;
-    for (int i=0;i<results.size();i++){
-        int row_id = i;
-        //std::cout<<"before key"<<"\n";
-        auto rrr = results[i][column_index].get();
-        
-        INT_KEY_TYPE key_ = dynamic_cast<IntData*>(rrr)->value;
-        double value_ = dynamic_cast<DoubleData*>(results[i][column_index+1].get())->value;
-        
-        //std::cout<<"after key"<<"\n";
-        bulk_load_values[i] = {key_,i};
-    }
+    checkIndexBuildMemory(con,table_name,ALEX_BUILD_PAIRS_PER_ROW*sizeof(std::pair<K,INDEX_PAYLOAD_TYPE>));
+    typename PublishedIndex<ShardedAlex<K,INDEX_PAYLOAD_TYPE>>::ScopedRebuild rebuild(indexes.alex_index);
+    reportBuildProgress(progress,"scanning",0.0);
+    std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> bulk_load_values = scanKeyValuePairs<K>(con,table_name,column_index);
     /**
      Phase 3: Sort the bulk load values array based on the key values.
     */
-   //Measure time 
-    
+    reportBuildProgress(progress,"sorting",0.5);
+
     auto start_time = std::chrono::high_resolution_clock::now();
-    std::sort(bulk_load_values,bulk_load_values+num_keys,[](auto const& a, auto const& b) { return a.first < b.first; });
-    
+    sortUniqueKeyValuePairs(bulk_load_values);
+    int num_keys = bulk_load_values.size();
+
     /*
     Phase 4: Bulk load the sorted values into the index.
     */
-    
-    int_alex_index.bulk_load(bulk_load_values, num_keys);
+
+    reportBuildProgress(progress,"building",0.7);
+    publishAlexIndex(bulk_load_values.data(),num_keys,num_shards,indexes.alex_index);
+
+    indexes.alex_cache->Clear();
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed_seconds = end_time - start_time;
-    std::cout << "Time taken to bulk load: " << elapsed_seconds.count() <<" seconds\n\n\n";
-    print_stats<INT_KEY_TYPE>();
+    std::cout << "Time taken to bulk load: " << elapsed_seconds.count() << " seconds\n\n\n";
+    if(num_shards==0){
+        print_stats(*indexes.alex_index.Load());
+    }
 }
 
 /**
- * Index Creation
- * 
+ * Runs a learned index build on a scheduler thread. The build reads the table through its own
+ * connection and publishes the new index version when done; lookups keep using the previous one.
 */
+class LearnedIndexBuildTask : public Task {
+public:
+    LearnedIndexBuildTask(shared_ptr<DatabaseInstance> db, std::shared_ptr<IndexBuildProgress> progress,
+                          std::function<void(duckdb::Connection &, IndexBuildProgress *)> build)
+        : db(std::move(db)), progress(std::move(progress)), build(std::move(build)) {}
+
+    TaskExecutionResult Execute(TaskExecutionMode mode) override {
+        try{
+            std::lock_guard<std::mutex> guard(index_build_execution_lock);
+            duckdb::Connection con(*db);
+            build(con,progress.get());
+            reportBuildProgress(progress.get(),"published",1.0);
+        }
+        catch(std::exception &e){
+            {
+                std::lock_guard<std::mutex> guard(index_builds_lock);
+                progress->error = e.what();
+            }
+            reportBuildProgress(progress.get(),"failed",progress->fraction);
+        }
+        return TaskExecutionResult::TASK_FINISHED;
+    }
 
-void functionCreateARTIndex(ClientContext &context, const FunctionParameters &parameters){
+    string TaskType() const override {
+        return "LearnedIndexBuildTask";
+    }
 
-    std::string table_name = parameters.values[0].GetValue<string>();
-    std::string column_name = parameters.values[1].GetValue<string>();
+    unique_ptr<ProducerToken> producer;
 
-    QualifiedName qname = GetQualifiedName(context, table_name);
+private:
+    shared_ptr<DatabaseInstance> db;
+    std::shared_ptr<IndexBuildProgress> progress;
+    std::function<void(duckdb::Connection &, IndexBuildProgress *)> build;
+};
+
+/**
+ * Registers the build in learned_index_builds() and runs it, either right away or on the scheduler
+ * when a background build was requested. Falls back to a foreground build if DuckDB runs single threaded,
+ * as nobody would pick up the task otherwise.
+*/
+void runIndexBuild(ClientContext &context, std::shared_ptr<IndexBuildProgress> progress,
+                   std::function<void(duckdb::Connection &, IndexBuildProgress *)> build){
+    auto &scheduler = TaskScheduler::GetScheduler(*context.db);
+    if(progress->background && scheduler.NumberOfThreads() <= 1){
+        std::cout<<"Only one thread available, building the index in the foreground"<<"\n";
+        progress->background = false;
+    }
+    {
+        std::lock_guard<std::mutex> guard(index_builds_lock);
+        index_builds.push_back(progress);
+    }
+    auto task = make_shared_ptr<LearnedIndexBuildTask>(context.db, progress, std::move(build));
+    if(!progress->background){
+        task->Execute(TaskExecutionMode::PROCESS_ALL);
+        if(!progress->error.empty()){
+            throw InvalidInputException("Building the %s index failed: %s", progress->index_type, progress->error);
+        }
+        return;
+    }
+    // The task owns its producer token, so the token lives until the task has run.
+    task->producer = scheduler.CreateProducer();
+    scheduler.ScheduleTask(*task->producer, task);
+    std::cout<<"Building the "<<progress->index_type<<" index in the background, see learned_index_builds()"<<"\n";
+}
+
+/**
+ * Index Creation
+ * 
+*/
+
+void functionCreateARTIndex(ClientContext &context, const FunctionParameters &parameters){
+
+    std::string table_name = parameters.values[0].GetValue<string>();
+    std::string column_name = parameters.values[1].GetValue<string>();
+
+    QualifiedName qname = GetQualifiedName(context, table_name);
     //CheckIfTableExists(context, qname);
     auto &table = Catalog::GetEntry<TableCatalogEntry>(context, qname.catalog, qname.schema, qname.name);
     auto &columnList = table.GetColumns();
@@ -1373,6 +2277,11 @@ void functionCreateARTIndex(ClientContext &context, const FunctionParameters &pa
     }
 }
 
+// Defined next to getLearnedIndexes below
+template<typename K>
+std::function<void(duckdb::Connection &, IndexBuildProgress *)> buildForTable(const string &table_name, const string &column_name,
+                                                                            std::function<void(duckdb::Connection &, IndexBuildProgress *)> build);
+
 void createAlexIndexPragmaFunction(ClientContext &context, const FunctionParameters &parameters){
     string table_name = parameters.values[0].GetValue<string>();
     string column_name = parameters.values[1].GetValue<string>();
@@ -1402,28 +2311,49 @@ void createAlexIndexPragmaFunction(ClientContext &context, const FunctionParamet
         std::cout<<"Column not found "<<"\n";
     }
     else{
-        duckdb::Connection con(*context.db);
         // std::cout<<"Column found at index "<<column_index<<"\n";
         // std::cout<<"Creating an alex index for this column"<<"\n";
         // std::cout<<"Column Type "<<typeid(column_type).name()<<"\n";
         // std::cout<<"Column Type "<<typeid(double).name()<<"\n";
         // std::cout<<"Column type to string "<<column_type.ToString()<<"\n";
         std::string columnTypeName = column_type.ToString();
+        // shards := N splits the index into N key ranges that concurrent writers can update independently
+        size_t num_shards = 0;
+        auto shards_entry = parameters.named_parameters.find("shards");
+        if(shards_entry != parameters.named_parameters.end()){
+            int32_t shards = shards_entry->second.GetValue<int32_t>();
+            if(shards < 1){
+                throw InvalidInputException("shards must be at least 1");
+            }
+            num_shards = shards;
+        }
+        auto progress = std::make_shared<IndexBuildProgress>();
+        string qualified_table = getQualifiedTableName(context, table_name);
+        progress->index_type = num_shards>0 ? "alex (sharded)" : "alex";
+        progress->table_name = table_name;
+        progress->qualified_table_name = qualified_table;
+        progress->column_name = column_name;
+        progress->key_type = columnTypeName;
+        progress->background = GetBackgroundParameter(parameters);
         if(columnTypeName == "DOUBLE"){
-            bulkLoadIntoIndex<DOUBLE_KEY_TYPE,INDEX_PAYLOAD_TYPE>(con,table_name,column_index);
-            index_type_table_name_map.insert({"double",{table_name,column_name}});
+            runIndexBuild(context,progress,buildForTable<DOUBLE_KEY_TYPE>(qualified_table,column_name,[table_name,column_index,num_shards](duckdb::Connection &con,IndexBuildProgress *progress){
+                bulkLoadIntoIndex<DOUBLE_KEY_TYPE>(con,table_name,column_index,num_shards,progress);
+            }));
         }
         else if(columnTypeName == "BIGINT"){
-            bulkLoadIntoIndex<INT64_KEY_TYPE,INDEX_PAYLOAD_TYPE>(con,table_name,column_index);
-            index_type_table_name_map.insert({"bigint",{table_name,column_name}});
+            runIndexBuild(context,progress,buildForTable<INT64_KEY_TYPE>(qualified_table,column_name,[table_name,column_index,num_shards](duckdb::Connection &con,IndexBuildProgress *progress){
+                bulkLoadIntoIndex<INT64_KEY_TYPE>(con,table_name,column_index,num_shards,progress);
+            }));
         }
         else if(columnTypeName == "UBIGINT"){
-            bulkLoadIntoIndex<UNSIGNED_INT64_KEY_TYPE,INDEX_PAYLOAD_TYPE>(con,table_name,column_index);
-            index_type_table_name_map.insert({"ubigint",{table_name,column_name}});
+            runIndexBuild(context,progress,buildForTable<UNSIGNED_INT64_KEY_TYPE>(qualified_table,column_name,[table_name,column_index,num_shards](duckdb::Connection &con,IndexBuildProgress *progress){
+                bulkLoadIntoIndex<UNSIGNED_INT64_KEY_TYPE>(con,table_name,column_index,num_shards,progress);
+            }));
         }
         else if(columnTypeName == "INTEGER"){
-            bulkLoadIntoIndex<INT_KEY_TYPE,INDEX_PAYLOAD_TYPE>(con,table_name,column_index);
-            index_type_table_name_map.insert({"int",{table_name,column_name}});
+            runIndexBuild(context,progress,buildForTable<INT_KEY_TYPE>(qualified_table,column_name,[table_name,column_index,num_shards](duckdb::Connection &con,IndexBuildProgress *progress){
+                bulkLoadIntoIndex<INT_KEY_TYPE>(con,table_name,column_index,num_shards,progress);
+            }));
         }
         else{
             std::cout<<"Unsupported column type for alex indexing (for now) "<<"\n";
@@ -1432,111 +2362,269 @@ void createAlexIndexPragmaFunction(ClientContext &context, const FunctionParamet
     }
 }
 
-template<typename K>
-void functionInsertIntoTableAndIndex(duckdb::Connection &con,std::string table_name,K key,DOUBLE_KEY_TYPE value){
-    std::cout<<"General template function \n";
+/**
+ * Charges the current size of all RadixSpline indexes to the learned index memory. Their delta buffers and
+ * background merges change it without going through the pragmas, so it is refreshed whenever a pragma touched
+ * the indexes; a build in the background is picked up by the next one.
+*/
+void accountRadixSplineMemory(){
+    size_t bytes = 0;
+    for (auto &entry : listRadixSplines(radix_spline_map_int64)) {
+        bytes += entry.second->index.GetSize();
+    }
+    for (auto &entry : listRadixSplines(radix_spline_map_int32)) {
+        bytes += entry.second->index.GetSize();
+    }
+    radix_spline_memory.Set(bytes);
 }
 
-template<>
-void functionInsertIntoTableAndIndex<DOUBLE_KEY_TYPE>(duckdb::Connection &con,std::string table_name,DOUBLE_KEY_TYPE key,DOUBLE_KEY_TYPE value){
-    //std::cout<<"Insert into table and index for double key type"<<"\n";
-    // std::string query = "INSERT INTO "+table_name+" VALUES(";
-    // query+=std::to_string(key)+","+std::to_string(value)+");";
-
-    std::string query = "INSERT INTO " + table_name + " VALUES (?, ?)";
-    auto result = con.Query(query, key, value);
-    if(!result->HasError()){
-        //std::cout<<"Insertion successful "<<"\n";
-        if(double_alex_index.size()>0){
-            std::vector<unique_ptr<Base>> dataVector;
-            dataVector.push_back(make_uniq<DoubleData>(key));
-            dataVector.push_back(make_uniq<DoubleData>(value));
-            results.push_back(std::move(dataVector));
-            double_alex_index.insert({key,value});
-        }
-        else{
-            std::cout<<"Index is empty. So not updating it."<<"\n";
+/**
+ * Returns the RadixSpline index of type T on the column of the table, if there is one. Column names are matched
+ * without regard to case, as in the catalog.
+*/
+template <typename T>
+std::shared_ptr<RadixSplineEntry<T>> findRadixSplineOnColumn(ClientContext &context, const RadixSplineMap<T> &index_map,
+                                                             const std::string &table_name, const std::string &column_name) {
+    QualifiedName qname = GetQualifiedName(context, table_name);
+    string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + column_name;
+    for (auto &entry : listRadixSplines(index_map)) {
+        if (StringUtil::CIEquals(entry.first, map_key)) {
+            return entry.second;
         }
     }
-    else{
-        std::cout<<"Insertion failed "<<"\n";
+    return nullptr;
+}
+
+/**
+ * Adds keys that were just inserted into the key column of the table to the RadixSpline index on it, if there is
+ * one. The keys land in the delta buffer of the index, which is merged into the spline in the background.
+*/
+void insertIntoRadixSplineIndex(ClientContext &context, const std::string &table_name, const std::string &key_column,
+                                const std::vector<uint64_t> &keys){
+    restorePendingRadixSplines(context);
+    auto index64 = findRadixSplineOnColumn(context, radix_spline_map_int64, table_name, key_column);
+    auto index32 = findRadixSplineOnColumn(context, radix_spline_map_int32, table_name, key_column);
+    if (index64) {
+        index64->index.InsertBatch(keys);
+    } else if (index32) {
+        index32->index.InsertBatch(std::vector<uint32_t>(keys.begin(), keys.end()));
+    } else {
+        return;
     }
+    accountRadixSplineMemory();
 }
 
-template<>
-void functionInsertIntoTableAndIndex<INT64_KEY_TYPE>(duckdb::Connection &con,std::string table_name,INT64_KEY_TYPE key,DOUBLE_KEY_TYPE value){
-    std::cout<<"Insert into table and index for double key type"<<"\n";
-    // std::string query = "INSERT INTO "+table_name+" VALUES(";
-    // query+=std::to_string(key)+","+std::to_string(value)+");";
+/**
+ * Returns true if writes to the table have to go to the index: it holds keys, or a build that replays them
+ * onto the new version is running.
+*/
+template<typename Index>
+bool isMaintained(PublishedIndex<Index> &index){
+    return index.IsRebuilding() || index.ReadExclusive([](Index &current) { return current.size()>0; });
+}
 
-    std::string query = "INSERT INTO " + table_name + " VALUES (?, ?)";
-    auto result = con.Query(query, key, value);
-    if(!result->HasError()){
-        std::cout<<"Insertion successful "<<"\n";
-        if(big_int_alex_index.size()>0){
-            std::vector<unique_ptr<Base>> dataVector;
-            dataVector.push_back(make_uniq<BigIntData>(key));
-            dataVector.push_back(make_uniq<BigIntData>(value));
-            results.push_back(std::move(dataVector));
-            big_int_alex_index.insert({key,value});
+template<typename K>
+bool isMaintained(PublishedIndex<ShardedAlex<K,INDEX_PAYLOAD_TYPE>> &index){
+    return index.IsRebuilding() || index->num_shards()>0;
+}
+
+/**
+ * Replaces the ALEX and PGM indexes of the key type with empty ones.
+*/
+template<typename K>
+void clearLearnedIndexes(){
+    auto indexes = getLearnedIndexes<K>();
+    indexes.alex_index.Publish(std::make_shared<ShardedAlex<K,INDEX_PAYLOAD_TYPE>>());
+    indexes.pgm_index.Publish(std::make_shared<pgm::DynamicPGMIndex<K,INDEX_PAYLOAD_TYPE>>());
+    indexes.static_pgm_index.Publish(std::make_shared<StaticPGMIndex<K,INDEX_PAYLOAD_TYPE>>());
+    indexes.pgm_memory.Set(0);
+    indexes.alex_cache->Clear();
+    indexes.pgm_cache->Clear();
+}
+
+/**
+ * Drops the learned indexes of the table: the ALEX and PGM indexes of the key types that belong to it, which then
+ * belong to no table, and its RadixSpline indexes.
+*/
+static void dropLearnedIndexes(TableCatalogEntry &table) {
+    string qualified_table = getQualifiedTableName(table);
+    std::vector<string> key_types;
+    {
+        std::lock_guard<std::mutex> guard(index_type_table_name_lock);
+        for (auto entry = index_type_table_name_map.begin(); entry != index_type_table_name_map.end();) {
+            if (StringUtil::CIEquals(entry->second.first, qualified_table)) {
+                key_types.push_back(entry->first);
+                entry = index_type_table_name_map.erase(entry);
+            } else {
+                ++entry;
+            }
         }
-        else{
-            std::cout<<"Index is empty. So not updating it."<<"\n";
+    }
+    for (auto &key_type : key_types) {
+        if (key_type == "double") {
+            clearLearnedIndexes<DOUBLE_KEY_TYPE>();
+        } else if (key_type == "bigint") {
+            clearLearnedIndexes<INT64_KEY_TYPE>();
+        } else if (key_type == "ubigint") {
+            clearLearnedIndexes<UNSIGNED_INT64_KEY_TYPE>();
+        } else if (key_type == "int") {
+            clearLearnedIndexes<INT_KEY_TYPE>();
         }
     }
-    else{
-        std::cout<<"Insertion failed "<<"\n";
+    // RadixSpline map keys are catalog.schema.table.column
+    string radix_spline_prefix = table.ParentCatalog().GetName() + "." + table.ParentSchema().name + "." + table.name + ".";
+    for (auto &entry : listRadixSplines(radix_spline_map_int64)) {
+        if (StringUtil::StartsWith(entry.first, radix_spline_prefix)) {
+            eraseRadixSpline(radix_spline_map_int64, entry.first);
+        }
     }
+    for (auto &entry : listRadixSplines(radix_spline_map_int32)) {
+        if (StringUtil::StartsWith(entry.first, radix_spline_prefix)) {
+            eraseRadixSpline(radix_spline_map_int32, entry.first);
+        }
+    }
+    accountRadixSplineMemory();
 }
 
-template<>
-void functionInsertIntoTableAndIndex<UNSIGNED_INT64_KEY_TYPE>(duckdb::Connection &con,std::string table_name,UNSIGNED_INT64_KEY_TYPE key,DOUBLE_KEY_TYPE value){
-    // std::string query = "INSERT INTO "+table_name+" VALUES(";
-    // query+=std::to_string(key)+","+std::to_string(value)+");";
+/**
+ * Wraps the build of an ALEX or PGM index of the key type on the column of the table. All indexes of a key type
+ * belong to the same table, so a build on another column first empties the indexes of the previous one, which
+ * would go stale otherwise; they stay empty if the build then fails. Builds run one at a time, so none of them
+ * is being rebuilt meanwhile.
+*/
+template<typename K>
+std::function<void(duckdb::Connection &, IndexBuildProgress *)> buildForTable(const string &table_name, const string &column_name,
+                                                                            std::function<void(duckdb::Connection &, IndexBuildProgress *)> build){
+    return [table_name, column_name, build](duckdb::Connection &con, IndexBuildProgress *progress){
+        std::pair<string,string> table_column;
+        if(getIndexedTable(getKeyTypeName<K>(),table_column) &&
+           (!StringUtil::CIEquals(table_column.first,table_name) || !StringUtil::CIEquals(table_column.second,column_name))){
+            clearLearnedIndexes<K>();
+        }
+        setIndexedTable(getKeyTypeName<K>(),table_name,column_name);
+        build(con,progress);
+    };
+}
 
-    std::string query = "INSERT INTO " + table_name + " VALUES (?, ?)";
-    auto result = con.Query(query, key, value);
-    if(!result->HasError()){
-        std::cout<<"Insertion successful "<<"\n";
-        if(unsigned_big_int_alex_index.size()>0){
-            std::vector<unique_ptr<Base>> dataVector;
-            dataVector.push_back(make_uniq<UBigIntData>(key));
-            dataVector.push_back(make_uniq<UBigIntData>(value));
-            results.push_back(std::move(dataVector));
-            unsigned_big_int_alex_index.insert({key,value});
+/**
+ * Throws if the learned indexes on the key column of the table include a read-only PGM index. It can not take
+ * changes, and lookups go to it first, so it has to be replaced with a dynamic one before the table changes.
+*/
+template<typename K>
+void checkIndexesWritable(ClientContext &context, const std::string &table_name, const std::string &key_column){
+    if(isIndexedColumn<K>(context,table_name,key_column) && getLearnedIndexes<K>().static_pgm_index->size()>0){
+        throw InvalidInputException("%s.%s has a read-only PGM index, which can not take changes. Build a dynamic one "
+                                    "with create_pgm_index first", table_name, key_column);
+    }
+}
+
+/**
+ * Inserts a sorted batch into the ALEX and PGM index of the key type, if they were built. Each index is
+ * updated under a single write, and inserting in key order keeps consecutive keys in the same data node.
+ * All indexes take a key that is there already as an update: the payload of the last row with the key wins.
+*/
+template<typename K>
+void insertSortedBatchIntoIndexes(std::shared_ptr<const std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>>> batch){
+    auto indexes = getLearnedIndexes<K>();
+    if(isMaintained(indexes.alex_index)){
+        indexes.alex_index.ApplyConcurrentWrite([batch](auto &index) {
+            index.insert_batch(*batch);
+        });
+        auto cache = indexes.alex_cache.Load();
+        for(auto &row : *batch){
+            cache->Invalidate(row.first);
         }
-        else{
-            std::cout<<"Index is empty. So not updating it."<<"\n";
+    }
+    if(isMaintained(indexes.pgm_index)){
+        indexes.pgm_index.ApplyWrite([batch, memory = &indexes.pgm_memory](auto &index) {
+            for(auto &row : *batch){
+                index.insert_or_assign(row.first, row.second);
+            }
+            memory->Set(index.size_in_bytes());
+        });
+        auto cache = indexes.pgm_cache.Load();
+        for(auto &row : *batch){
+            cache->Invalidate(row.first);
         }
     }
-    else{
-        std::cout<<"Insertion failed "<<"\n";
+}
+
+/**
+ * Points the rows of a batch that was just inserted into the table at the row ids of the last rows with their keys,
+ * for the indexes of key types with row id payloads, see usesRowIdPayloads. Rows only get their final row ids when
+ * their transaction commits, so this runs after the commit.
+*/
+template<typename K>
+void setInsertedRowIds(duckdb::Connection &con,const std::string &table_name,const std::string &key_column,
+                       std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> &batch){
+    vector<Value> keys;
+    keys.reserve(batch.size());
+    for(auto &row : batch){
+        keys.push_back(Value::CreateValue(row.first));
+    }
+    std::string column = KeywordHelper::WriteOptionallyQuoted(key_column);
+    auto result = con.Query("SELECT " + column + ", max(rowid) FROM " + table_name + " WHERE " + column +
+                            " IN (SELECT unnest(?)) GROUP BY " + column, Value::LIST(getScanType<K>(), std::move(keys)));
+    if(result->HasError()){
+        throw InvalidInputException("Reading the row ids of the rows inserted into %s failed: %s", table_name,
+                                    result->GetError());
+    }
+    std::map<K,INDEX_PAYLOAD_TYPE> row_ids;
+    for(idx_t row=0;row<result->RowCount();row++){
+        row_ids[result->GetValue(0,row).GetValue<K>()] = result->GetValue(1,row).GetValue<INDEX_PAYLOAD_TYPE>();
+    }
+    for(auto &row : batch){
+        row.second = row_ids[row.first];
     }
 }
 
-template<>
-void functionInsertIntoTableAndIndex<int>(duckdb::Connection &con,std::string table_name,int key,DOUBLE_KEY_TYPE value){
-    // std::string query = "INSERT INTO "+table_name+" VALUES(";
-    // query+=std::to_string(key)+","+std::to_string(value)+");";
+/**
+ * Returns the expression that hashes the rows a mutation pragma changes, whose sum it logs, see
+ * getRowHashExpression.
+*/
+static std::string getMutatedRowHash(duckdb::Connection &con,const std::string &table_name){
+    std::string row_hash;
+    if(!getRowHashExpression(con,table_name,row_hash)){
+        throw InvalidInputException("Could not read the columns of %s", table_name);
+    }
+    return row_hash;
+}
 
-    std::string query = "INSERT INTO " + table_name + " VALUES (?, ?)";
+/**
+ * Inserts the row into the key and value column of the table, see getKeyValueColumns, and into the learned indexes
+ * on the key column. Returns true if the row made it into the table.
+*/
+template<typename K>
+bool functionInsertIntoTableAndIndex(ClientContext &context,duckdb::Connection &con,std::string table_name,K key,DOUBLE_KEY_TYPE value){
+    auto columns = getKeyValueColumns<K>(context,table_name);
+    checkIndexesWritable<K>(context,table_name,columns.first);
+    std::string query = "INSERT INTO " + table_name + " (" + KeywordHelper::WriteOptionallyQuoted(columns.first) + ", " +
+                        KeywordHelper::WriteOptionallyQuoted(columns.second) + ") VALUES (?, ?) RETURNING " +
+                        getMutatedRowHash(con,table_name);
+    LearnedIndexWriteScope write_scope;
+    con.BeginTransaction();
     auto result = con.Query(query, key, value);
-    if(!result->HasError()){
-        std::cout<<"Insertion successful "<<"\n";
-        if(int_alex_index.size()>0){
-            std::vector<unique_ptr<Base>> dataVector;
-            dataVector.push_back(make_uniq<IntData>(key));
-            dataVector.push_back(make_uniq<IntData>(value));
-            results.push_back(std::move(dataVector));
-            int_alex_index.insert({key,results.size()-1});
-        }
-        else{
-            std::cout<<"Index is empty. So not updating it."<<"\n";
+    if(result->HasError()){
+        con.Rollback();
+        std::cout<<"Insertion failed : "<<result->GetError()<<"\n";
+        return false;
+    }
+    int64_t inserted = 0;
+    uint64_t hash_delta = 0;
+    sumRowHashes(*result,inserted,hash_delta);
+    string qualified_table = getQualifiedTableName(context,table_name);
+    commitLoggedMutations(con,qualified_table,{makeMutationRecord<K>(LearnedIndexLog::Op::kInsert,qualified_table,key,value,inserted,hash_delta)});
+    if(isIndexedColumn<K>(context,table_name,columns.first)){
+        std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> batch(1,std::make_pair(key,value));
+        if constexpr (usesRowIdPayloads<K>()) {
+            setInsertedRowIds<K>(con,table_name,columns.first,batch);
         }
+        insertSortedBatchIntoIndexes<K>(std::make_shared<const std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>>>(std::move(batch)));
     }
-    else{
-        std::cout<<"Insertion failed "<<"\n";
+    if constexpr (std::is_same<K, UNSIGNED_INT64_KEY_TYPE>::value) {
+        insertIntoRadixSplineIndex(context,table_name,columns.first,{key});
     }
+    return true;
 }
 
 void functionInsertIntoTable(ClientContext &context, const FunctionParameters &parameters){
@@ -1548,27 +2636,331 @@ void functionInsertIntoTable(ClientContext &context, const FunctionParameters &p
     if(key_type=="double"){
         double dkey = std::stod(key);
         double dvalue = std::stod(value);
-        functionInsertIntoTableAndIndex<double>(con,table_name,dkey,dvalue);
+        functionInsertIntoTableAndIndex<double>(context,con,table_name,dkey,dvalue);
     }
     else if(key_type=="bigint"){
         INT64_KEY_TYPE bkey = std::stoll(key);
         double bvalue = std::stod(value);
-        functionInsertIntoTableAndIndex<INT64_KEY_TYPE>(con,table_name,bkey,bvalue);
+        functionInsertIntoTableAndIndex<INT64_KEY_TYPE>(context,con,table_name,bkey,bvalue);
     }
     else if(key_type =="int"){
         int ikey = std::stoi(key);
         double ivalue = std::stod(value);
-        functionInsertIntoTableAndIndex<int>(con,table_name,ikey,ivalue);
+        functionInsertIntoTableAndIndex<int>(context,con,table_name,ikey,ivalue);
     }
     else{
         UNSIGNED_INT64_KEY_TYPE ukey = std::stoull(key);
         double uvalue = std::stod(value);
-        functionInsertIntoTableAndIndex<UNSIGNED_INT64_KEY_TYPE>(con,table_name,ukey,uvalue);
+        functionInsertIntoTableAndIndex<UNSIGNED_INT64_KEY_TYPE>(context,con,table_name,ukey,uvalue);
     }
     
     //For double index:
 }
 
+/**
+ * Inserts a batch of (key, value) rows into the key and value column of the table, see getKeyValueColumns, with a
+ * single INSERT that unnests them, and into the learned indexes on the key column in one sorted pass. Other
+ * columns get their defaults, which the Appender could not leave out. Returns true if the rows made it into the
+ * table.
+*/
+template<typename K>
+bool insertBatchIntoTableAndIndex(ClientContext &context,duckdb::Connection &con,const std::string &table_name,std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> batch){
+    auto columns = getKeyValueColumns<K>(context,table_name);
+    checkIndexesWritable<K>(context,table_name,columns.first);
+    vector<Value> keys;
+    vector<Value> values;
+    keys.reserve(batch.size());
+    values.reserve(batch.size());
+    for(auto &row : batch){
+        keys.push_back(Value::CreateValue(row.first));
+        values.push_back(Value::CreateValue(row.second));
+    }
+    std::string query = "INSERT INTO " + table_name + " (" + KeywordHelper::WriteOptionallyQuoted(columns.first) + ", " +
+                        KeywordHelper::WriteOptionallyQuoted(columns.second) + ") SELECT unnest(?), unnest(?) RETURNING " +
+                        getMutatedRowHash(con,table_name);
+    LearnedIndexWriteScope write_scope;
+    con.BeginTransaction();
+    auto result = con.Query(query, Value::LIST(getScanType<K>(), std::move(keys)),
+                            Value::LIST(getScanType<INDEX_PAYLOAD_TYPE>(), std::move(values)));
+    if(result->HasError()){
+        con.Rollback();
+        std::cout<<"Insertion failed : "<<result->GetError()<<"\n";
+        return false;
+    }
+    int64_t inserted = 0;
+    uint64_t hash_delta = 0;
+    sumRowHashes(*result,inserted,hash_delta);
+    string qualified_table = getQualifiedTableName(context,table_name);
+    std::vector<LearnedIndexLog::Record> records;
+    records.reserve(batch.size());
+    for(auto &row : batch){
+        records.push_back(makeMutationRecord<K>(LearnedIndexLog::Op::kInsert,qualified_table,row.first,row.second,1,0));
+    }
+    // The rows come back in no particular order, the last record carries the hash of all of them
+    if(!records.empty()){
+        records.back().hash_delta = hash_delta;
+    }
+    commitLoggedMutations(con,qualified_table,records);
+    if constexpr (std::is_same<K, UNSIGNED_INT64_KEY_TYPE>::value) {
+        std::vector<UNSIGNED_INT64_KEY_TYPE> batch_keys;
+        for(auto &row : batch){
+            batch_keys.push_back(row.first);
+        }
+        insertIntoRadixSplineIndex(context,table_name,columns.first,batch_keys);
+    }
+    if(!isIndexedColumn<K>(context,table_name,columns.first)){
+        return true;
+    }
+    if constexpr (usesRowIdPayloads<K>()) {
+        setInsertedRowIds<K>(con,table_name,columns.first,batch);
+    }
+    // Rows with equal keys stay in their order, so the last one wins
+    std::stable_sort(batch.begin(),batch.end(),[](auto const& a, auto const& b) { return a.first < b.first; });
+    insertSortedBatchIntoIndexes<K>(std::make_shared<const std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>>>(std::move(batch)));
+    return true;
+}
+
+/**
+ * Reads the parallel key and value lists of insert_batch_into_table into (key, value) rows.
+*/
+template<typename K>
+std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> getBatchRows(const Value &keys, const Value &values){
+    auto &key_list = ListValue::GetChildren(keys);
+    auto &value_list = ListValue::GetChildren(values);
+    if(key_list.size() != value_list.size()){
+        throw InvalidInputException("insert_batch_into_table needs as many values as keys, got %llu keys and %llu values",
+                                    key_list.size(), value_list.size());
+    }
+    std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> batch;
+    batch.reserve(key_list.size());
+    for(idx_t i=0;i<key_list.size();i++){
+        batch.emplace_back(key_list[i].GetValue<K>(), value_list[i].GetValue<INDEX_PAYLOAD_TYPE>());
+    }
+    return batch;
+}
+
+/**
+ * PRAGMA insert_batch_into_table(table_name, key_type, [keys...], [values...])
+*/
+void functionInsertBatchIntoTable(ClientContext &context, const FunctionParameters &parameters){
+    std::string table_name = parameters.values[0].GetValue<string>();
+    std::string key_type = parameters.values[1].GetValue<string>();
+    auto &keys = parameters.values[2];
+    auto &values = parameters.values[3];
+    if(keys.type().id() != LogicalTypeId::LIST || values.type().id() != LogicalTypeId::LIST){
+        throw InvalidInputException("insert_batch_into_table expects the keys and values as lists");
+    }
+    duckdb::Connection con(*context.db);
+    if(key_type=="double"){
+        insertBatchIntoTableAndIndex<DOUBLE_KEY_TYPE>(context,con,table_name,getBatchRows<DOUBLE_KEY_TYPE>(keys,values));
+    }
+    else if(key_type=="bigint"){
+        insertBatchIntoTableAndIndex<INT64_KEY_TYPE>(context,con,table_name,getBatchRows<INT64_KEY_TYPE>(keys,values));
+    }
+    else if(key_type=="int"){
+        insertBatchIntoTableAndIndex<INT_KEY_TYPE>(context,con,table_name,getBatchRows<INT_KEY_TYPE>(keys,values));
+    }
+    else{
+        insertBatchIntoTableAndIndex<UNSIGNED_INT64_KEY_TYPE>(context,con,table_name,getBatchRows<UNSIGNED_INT64_KEY_TYPE>(keys,values));
+    }
+}
+
+/**
+ * Removes a key that was deleted from the key column of the table from the RadixSpline index on it, if there is
+ * one. Keys of the spline are tombstoned until the next merge rebuilds it.
+*/
+void eraseFromRadixSplineIndex(ClientContext &context, const std::string &table_name, const std::string &key_column, uint64_t key){
+    restorePendingRadixSplines(context);
+    auto index64 = findRadixSplineOnColumn(context, radix_spline_map_int64, table_name, key_column);
+    auto index32 = findRadixSplineOnColumn(context, radix_spline_map_int32, table_name, key_column);
+    if (index64) {
+        index64->index.Erase(key);
+        index64->cache->Invalidate(key);
+    } else if (index32) {
+        index32->index.Erase(static_cast<uint32_t>(key));
+        index32->cache->Invalidate(static_cast<uint32_t>(key));
+    } else {
+        return;
+    }
+    accountRadixSplineMemory();
+}
+
+/**
+ * Removes a key that was deleted from the table from the ALEX and PGM index of the key type.
+*/
+template<typename K>
+void eraseFromIndexes(K key){
+    auto indexes = getLearnedIndexes<K>();
+    if(isMaintained(indexes.alex_index)){
+        indexes.alex_index.ApplyConcurrentWrite([key](auto &index) {
+            index.erase(key);
+        });
+        indexes.alex_cache->Invalidate(key);
+    }
+    if(isMaintained(indexes.pgm_index)){
+        indexes.pgm_index.ApplyWrite([key, memory = &indexes.pgm_memory](auto &index) {
+            index.erase(key);
+            memory->Set(index.size_in_bytes());
+        });
+        indexes.pgm_cache->Invalidate(key);
+    }
+}
+
+/**
+ * Points the ALEX and PGM entries of an updated key at its new value. The INTEGER indexes map keys to row ids,
+ * which an update of the value column leaves as they are.
+*/
+template<typename K>
+void updateInIndexes(K key, INDEX_PAYLOAD_TYPE value){
+    if constexpr (usesRowIdPayloads<K>()) {
+        return;
+    }
+    auto indexes = getLearnedIndexes<K>();
+    if(isMaintained(indexes.alex_index)){
+        indexes.alex_index.ApplyConcurrentWrite([key, value](auto &index) {
+            index.update(key, value);
+        });
+        indexes.alex_cache->Invalidate(key);
+    }
+    if(isMaintained(indexes.pgm_index)){
+        indexes.pgm_index.ApplyWrite([key, value, memory = &indexes.pgm_memory](auto &index) {
+            if (index.find(key) != index.end()) {
+                index.insert_or_assign(key, value);
+                memory->Set(index.size_in_bytes());
+            }
+        });
+        indexes.pgm_cache->Invalidate(key);
+    }
+}
+
+/**
+ * Deletes the rows with the key from the table, and the key from the learned indexes of the key type if they
+ * belong to the table.
+*/
+template<typename K>
+void deleteFromTableAndIndex(ClientContext &context,duckdb::Connection &con,const std::string &table_name,K key){
+    auto columns = getKeyValueColumns<K>(context,table_name);
+    checkIndexesWritable<K>(context,table_name,columns.first);
+    std::string query = "DELETE FROM " + table_name + " WHERE " + KeywordHelper::WriteOptionallyQuoted(columns.first) +
+                        " = ? RETURNING " + getMutatedRowHash(con,table_name);
+    LearnedIndexWriteScope write_scope;
+    con.BeginTransaction();
+    auto result = con.Query(query, key);
+    if(result->HasError()){
+        con.Rollback();
+        std::cout<<"Deletion failed : "<<result->GetError()<<"\n";
+        return;
+    }
+    int64_t deleted = 0;
+    uint64_t deleted_hash = 0;
+    sumRowHashes(*result,deleted,deleted_hash);
+    std::cout<<"Deleted "<<deleted<<" rows"<<"\n";
+    if(deleted==0){
+        con.Rollback();
+        return;
+    }
+    string qualified_table = getQualifiedTableName(context,table_name);
+    commitLoggedMutations(con,qualified_table,{makeMutationRecord<K>(LearnedIndexLog::Op::kErase,qualified_table,key,0,-deleted,0-deleted_hash)});
+    if(isIndexedColumn<K>(context,table_name,columns.first)){
+        eraseFromIndexes<K>(key);
+    }
+    if constexpr (std::is_same<K, UNSIGNED_INT64_KEY_TYPE>::value) {
+        eraseFromRadixSplineIndex(context,table_name,columns.first,key);
+    }
+}
+
+/**
+ * Sets the value of the rows with the key in the table, and in the learned indexes of the key type if they
+ * belong to the table.
+*/
+template<typename K>
+void updateTableAndIndex(ClientContext &context,duckdb::Connection &con,const std::string &table_name,K key,INDEX_PAYLOAD_TYPE value){
+    auto columns = getKeyValueColumns<K>(context,table_name);
+    checkIndexesWritable<K>(context,table_name,columns.first);
+    std::string key_column = KeywordHelper::WriteOptionallyQuoted(columns.first);
+    std::string row_hash = getMutatedRowHash(con,table_name);
+    std::string query = "UPDATE " + table_name + " SET " + KeywordHelper::WriteOptionallyQuoted(columns.second) + " = ? WHERE " +
+                        key_column + " = ? RETURNING " + row_hash;
+    LearnedIndexWriteScope write_scope;
+    con.BeginTransaction();
+    // The hashes of the rows before the update, in the same transaction
+    auto previous = con.Query("SELECT " + row_hash + " FROM " + table_name + " WHERE " + key_column + " = ?", key);
+    if(previous->HasError()){
+        con.Rollback();
+        std::cout<<"Update failed : "<<previous->GetError()<<"\n";
+        return;
+    }
+    int64_t previous_rows = 0;
+    uint64_t previous_hash = 0;
+    sumRowHashes(*previous,previous_rows,previous_hash);
+    auto result = con.Query(query, value, key);
+    if(result->HasError()){
+        con.Rollback();
+        std::cout<<"Update failed : "<<result->GetError()<<"\n";
+        return;
+    }
+    int64_t updated = 0;
+    uint64_t updated_hash = 0;
+    sumRowHashes(*result,updated,updated_hash);
+    std::cout<<"Updated "<<updated<<" rows"<<"\n";
+    if(updated==0){
+        con.Rollback();
+        return;
+    }
+    string qualified_table = getQualifiedTableName(context,table_name);
+    commitLoggedMutations(con,qualified_table,{makeMutationRecord<K>(LearnedIndexLog::Op::kUpdate,qualified_table,key,value,0,updated_hash-previous_hash)});
+    if(isIndexedColumn<K>(context,table_name,columns.first)){
+        updateInIndexes<K>(key,value);
+    }
+}
+
+/**
+ * PRAGMA delete_from_table(table_name, key_type, key)
+ * Tables with a learned index reject plain DELETE statements, see rejectUnindexedWrites.
+*/
+void functionDeleteFromTable(ClientContext &context, const FunctionParameters &parameters){
+    std::string table_name = parameters.values[0].GetValue<string>();
+    std::string key_type = parameters.values[1].GetValue<string>();
+    std::string key = parameters.values[2].GetValue<string>();
+    duckdb::Connection con(*context.db);
+    if(key_type=="double"){
+        deleteFromTableAndIndex<DOUBLE_KEY_TYPE>(context,con,table_name,std::stod(key));
+    }
+    else if(key_type=="bigint"){
+        deleteFromTableAndIndex<INT64_KEY_TYPE>(context,con,table_name,std::stoll(key));
+    }
+    else if(key_type=="int"){
+        deleteFromTableAndIndex<INT_KEY_TYPE>(context,con,table_name,std::stoi(key));
+    }
+    else{
+        deleteFromTableAndIndex<UNSIGNED_INT64_KEY_TYPE>(context,con,table_name,std::stoull(key));
+    }
+}
+
+/**
+ * PRAGMA update_table(table_name, key_type, key, value)
+ * Tables with a learned index reject plain UPDATE statements, see rejectUnindexedWrites.
+*/
+void functionUpdateTable(ClientContext &context, const FunctionParameters &parameters){
+    std::string table_name = parameters.values[0].GetValue<string>();
+    std::string key_type = parameters.values[1].GetValue<string>();
+    std::string key = parameters.values[2].GetValue<string>();
+    double value = std::stod(parameters.values[3].GetValue<string>());
+    duckdb::Connection con(*context.db);
+    if(key_type=="double"){
+        updateTableAndIndex<DOUBLE_KEY_TYPE>(context,con,table_name,std::stod(key),value);
+    }
+    else if(key_type=="bigint"){
+        updateTableAndIndex<INT64_KEY_TYPE>(context,con,table_name,std::stoll(key),value);
+    }
+    else if(key_type=="int"){
+        updateTableAndIndex<INT_KEY_TYPE>(context,con,table_name,std::stoi(key),value);
+    }
+    else{
+        updateTableAndIndex<UNSIGNED_INT64_KEY_TYPE>(context,con,table_name,std::stoull(key),value);
+    }
+}
+
 void functionRunBenchmarkOneBatch(ClientContext &context, const FunctionParameters &parameters){
     std::string benchmark_name = parameters.values[0].GetValue<string>();
     std::string index = parameters.values[1].GetValue<string>();
@@ -1601,7 +2993,7 @@ void functionRunBenchmarkOneBatch(ClientContext &context, const FunctionParamete
 }
 
 template<typename K>
-void runInsertionBenchmarkWorkload(duckdb::Connection& con,std::string benchmarkName,std::string table_name,std::string data_type, int to_insert){
+void runInsertionBenchmarkWorkload(ClientContext &context,duckdb::Connection& con,std::string benchmarkName,std::string table_name,std::string data_type, int to_insert){
     /**
      * Load the keys into a vector based on the data_type
      * 
@@ -1628,20 +3020,20 @@ void runInsertionBenchmarkWorkload(duckdb::Connection& con,std::string benchmark
 
     int new_key_count = load_end_point + to_insert;
     std::cout<<"New key count "<<new_key_count<<"\n";
-    auto keys = new K[new_key_count];
+    std::vector<K> keys(new_key_count);
     std::string keys_file_type = "binary";
     if (keys_file_type == "binary") {
         std::cout<<"Loading binary data "<<std::endl;
-        load_binary_data(keys, new_key_count, benchmarkFile);
+        load_binary_data(keys.data(), new_key_count, benchmarkFile);
     } else if (keys_file_type == "text") {
-        load_text_data(keys, new_key_count, benchmarkFile);
+        load_text_data(keys.data(), new_key_count, benchmarkFile);
     } else {
         std::cerr << "--keys_file_type must be either 'binary' or 'text'"
                 << std::endl;
     }
 
     
-    auto values = new std::pair<K, double>[to_insert];
+    std::vector<std::pair<K, double>> values(to_insert);
     std::mt19937_64 gen_payload(std::random_device{}());
 
 
@@ -1653,21 +3045,15 @@ void runInsertionBenchmarkWorkload(duckdb::Connection& con,std::string benchmark
         values[vti] = {key,random_payload};
     }
 
+    // Insert in vector sized batches, so the time goes into appending and updating the index instead of
+    // parsing one INSERT statement per key.
     auto start_time = std::chrono::high_resolution_clock::now();
-    for(int i=0;i<to_insert;i++){
-        K key = values[i].first;
-        double value = values[i].second;
-        if(data_type == "double"){
-            functionInsertIntoTableAndIndex<double>(con,table_name,key,value);
-        }
-        else if(data_type == "bigint"){
-            functionInsertIntoTableAndIndex<int64_t>(con,table_name,key,value);
-        }
-        else{
-            functionInsertIntoTableAndIndex<uint64_t>(con,table_name,key,value);
-        }
+    for(int i=0;i<to_insert;i+=STANDARD_VECTOR_SIZE){
+        int batch_end = std::min<int>(i+STANDARD_VECTOR_SIZE,to_insert);
+        std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> batch(values.begin()+i,values.begin()+batch_end);
+        insertBatchIntoTableAndIndex<K>(context,con,table_name,std::move(batch));
     }
-    load_end_point = results.size();
+    load_end_point = new_key_count;
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed_seconds = end_time - start_time;
     std::cout<<"Time taken to insert "<<to_insert<<" keys" << elapsed_seconds.count() << " seconds\n";
@@ -1701,20 +3087,20 @@ void runInsertionBenchmarkWorkloadART(duckdb::Connection& con,std::string benchm
 
     int new_key_count = load_end_point + to_insert;
     std::cout<<"New key count "<<new_key_count<<"\n";
-    auto keys = new K[new_key_count];
+    std::vector<K> keys(new_key_count);
     std::string keys_file_type = "binary";
     if (keys_file_type == "binary") {
         std::cout<<"Loading binary data "<<std::endl;
-        load_binary_data(keys, new_key_count, benchmarkFile);
+        load_binary_data(keys.data(), new_key_count, benchmarkFile);
     } else if (keys_file_type == "text") {
-        load_text_data(keys, new_key_count, benchmarkFile);
+        load_text_data(keys.data(), new_key_count, benchmarkFile);
     } else {
         std::cerr << "--keys_file_type must be either 'binary' or 'text'"
                 << std::endl;
     }
 
     
-    auto values = new std::pair<K, double>[to_insert];
+    std::vector<std::pair<K, double>> values(to_insert);
     std::mt19937_64 gen_payload(std::random_device{}());
 
 
@@ -1725,27 +3111,22 @@ void runInsertionBenchmarkWorkloadART(duckdb::Connection& con,std::string benchm
         double random_payload = static_cast<double>(gen_payload());
         values[vti] = {key,random_payload};
     }
-    std::string query = "INSERT INTO " + table_name + " VALUES (?, ?)";
-    
+    // Same batching as the learned index workload, the ART index is maintained by the Appender.
     auto start_time = std::chrono::high_resolution_clock::now();
-    for(int i=0;i<to_insert;i++){
-        K key = values[i].first;
-        double value = values[i].second;
-        // if(data_type == "double"){
-        //     functionInsertIntoTableAndIndex<double>(con,table_name,key,value);
-        // }
-        // else if(data_type == "bigint"){
-        //     functionInsertIntoTableAndIndex<int64_t>(con,table_name,key,value);
-        // }
-        // else{
-        //     functionInsertIntoTableAndIndex<uint64_t>(con,table_name,key,value);
-        // }
-        auto result = con.Query(query, key, value);
-        if(result->HasError()){
-            std::cout<<"Insertion failed "<<"\n";
+    for(int i=0;i<to_insert;i+=STANDARD_VECTOR_SIZE){
+        int batch_end = std::min<int>(i+STANDARD_VECTOR_SIZE,to_insert);
+        try{
+            Appender appender(con, table_name);
+            for(int j=i;j<batch_end;j++){
+                appender.AppendRow(values[j].first, values[j].second);
+            }
+            appender.Close();
+        }
+        catch(std::exception &e){
+            std::cout<<"Insertion failed : "<<e.what()<<"\n";
         }
     }
-    load_end_point = results.size();
+    load_end_point = new_key_count;
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed_seconds = end_time - start_time;
     std::cout<<"Time taken to insert "<<to_insert<<" keys" << elapsed_seconds.count() << " seconds\n";
@@ -1766,13 +3147,13 @@ void functionRunInsertionBenchmark(ClientContext &context, const FunctionParamet
 
     if(index == "alex"){
         if(data_type=="double"){
-            runInsertionBenchmarkWorkload<double>(con,benchmark_name,table_name,data_type,to_insert);
+            runInsertionBenchmarkWorkload<double>(context,con,benchmark_name,table_name,data_type,to_insert);
         }
         else if(data_type=="bigint"){
-            runInsertionBenchmarkWorkload<int64_t>(con,benchmark_name,table_name,data_type,to_insert);
+            runInsertionBenchmarkWorkload<int64_t>(context,con,benchmark_name,table_name,data_type,to_insert);
         }
         else{
-            runInsertionBenchmarkWorkload<uint64_t>(con,benchmark_name,table_name,data_type,to_insert);
+            runInsertionBenchmarkWorkload<uint64_t>(context,con,benchmark_name,table_name,data_type,to_insert);
         }
     }
     else{
@@ -1788,6 +3169,19 @@ void functionRunInsertionBenchmark(ClientContext &context, const FunctionParamet
     }
 }
 
+/**
+ * Looks the key up in the ALEX index of the key type, through its hot-key cache.
+*/
+template<typename K>
+std::optional<INDEX_PAYLOAD_TYPE> findAlexPayload(K key){
+    auto indexes = getLearnedIndexes<K>();
+    INDEX_PAYLOAD_TYPE payload;
+    if (!findInAlex(*indexes.alex_index.Load(), *indexes.alex_cache.Load(), key, &payload)) {
+        return std::nullopt;
+    }
+    return payload;
+}
+
 void functionAlexFind(ClientContext &context, const FunctionParameters &parameters){
     std::string index_type = parameters.values[0].GetValue<string>();
     std::string key = parameters.values[1].GetValue<string>();
@@ -1795,7 +3189,7 @@ void functionAlexFind(ClientContext &context, const FunctionParameters &paramete
     if(index_type == "double"){
         double key_ = std::stod(key);
         auto time_start = std::chrono::high_resolution_clock::now();
-        auto payload = double_alex_index.get_payload(key_);
+        auto payload = findAlexPayload(key_);
         auto time_end = std::chrono::high_resolution_clock::now();
         if(payload){
             std::chrono::duration<double> elapsed_seconds = time_end - time_start;
@@ -1809,7 +3203,7 @@ void functionAlexFind(ClientContext &context, const FunctionParameters &paramete
     else if(index_type=="bigint"){
         int64_t key_ = std::stoll(key);
         auto time_start = std::chrono::high_resolution_clock::now();
-        auto payload = big_int_alex_index.get_payload(key_);
+        auto payload = findAlexPayload(key_);
         auto time_end = std::chrono::high_resolution_clock::now();
         if(payload){
             std::chrono::duration<double> elapsed_seconds = time_end - time_start;
@@ -1823,17 +3217,15 @@ void functionAlexFind(ClientContext &context, const FunctionParameters &paramete
     else if(index_type=="int"){
         int key_ = std::stoi(key);
         auto time_start = std::chrono::high_resolution_clock::now();
-        auto payload = int_alex_index.get_payload(key_);
+        auto payload = findAlexPayload(key_);
         auto time_end = std::chrono::high_resolution_clock::now();
         if(payload){
-            std::cout<<"Payload found \n";
-            pair<string,string>tab_col = index_type_table_name_map["int"];
-            std::string table_name = tab_col.first;
-            QualifiedName name = GetQualifiedName(context,table_name);
-            auto &table = Catalog::GetEntry<TableCatalogEntry>(context, name.catalog, name.schema, name.name);
-            auto &columnList = table.GetColumns();
-            vector<string>columnNames = columnList.GetColumnNames();
-            display_row(*payload,columnNames);
+            std::cout<<"Payload found "<<*payload<<"\n";
+            pair<string,string>tab_col;
+            getIndexedTable("int",tab_col);
+            duckdb::Connection con(*context.db);
+            // The payload is the row id of the row, see usesRowIdPayloads
+            display_row(con,tab_col.first,"rowid",Value::BIGINT(static_cast<int64_t>(*payload)));
             std::chrono::duration<double> elapsed_seconds = time_end - time_start;
             std::cout<<"\nTime taken : "<< elapsed_seconds.count()<<" seconds \n";
         }
@@ -1845,7 +3237,7 @@ void functionAlexFind(ClientContext &context, const FunctionParameters &paramete
     else{
         uint64_t key_ = std::stoull(key);
         auto time_start = std::chrono::high_resolution_clock::now();
-        auto payload = unsigned_big_int_alex_index.get_payload(key_);
+        auto payload = findAlexPayload(key_);
         auto time_end = std::chrono::high_resolution_clock::now();
         if(payload){
             std::cout<<"Payload found "<<*payload<<"\n";
@@ -1864,23 +3256,23 @@ void functionAlexSize(ClientContext &context, const FunctionParameters &paramete
     long long model_size = 0;
     long long data_size = 0;
     if(index_type == "double"){
-        model_size = double_alex_index.model_size();
-        data_size = double_alex_index.data_size();
+        model_size = double_alex_index->model_size();
+        data_size = double_alex_index->data_size();
         //std::cout<<"Model size "<<model_size<<"\n";
         //std::cout<<"Data size "<<data_size<<"\n";
         total_size = model_size + data_size;
 
     }
     else if(index_type == "bigint"){
-        model_size = big_int_alex_index.model_size();
-        data_size = big_int_alex_index.data_size();
+        model_size = big_int_alex_index->model_size();
+        data_size = big_int_alex_index->data_size();
         //std::cout<<"Model size "<<model_size<<"\n";
         //std::cout<<"Data size "<<data_size<<"\n";
         total_size = model_size + data_size;
     }
     else{
-        model_size = unsigned_big_int_alex_index.model_size();
-        data_size = unsigned_big_int_alex_index.data_size();
+        model_size = unsigned_big_int_alex_index->model_size();
+        data_size = unsigned_big_int_alex_index->data_size();
         //std::cout<<"Model size "<<model_size<<"\n";
         //std::cout<<"Data size "<<data_size<<"\n";
         total_size = model_size + data_size;
@@ -1892,286 +3284,116 @@ void functionAlexSize(ClientContext &context, const FunctionParameters &paramete
     std::cout<<"Data size "<<data_size_in_mb<<" MB\n";
     double total_size_in_mb = static_cast<double>(total_size) / (1024 * 1024);
     std::cout<<"Size of the Indexing structure "<<total_size_in_mb<<" MB\n";
+    auto &pool = LearnedIndexMemoryPool::Get();
+    std::cout<<"Memory of all learned indexes "<<static_cast<double>(pool.GetReservedBytes() + pool.GetChargedBytes()) / (1024 * 1024)<<" MB, "
+             <<static_cast<double>(pool.GetAccountedBytes()) / (1024 * 1024)<<" MB of it counted against memory_limit\n";
 }
 
-void functionAuxStorage(ClientContext &context, const FunctionParameters &parameters){
-    std::string index_type = parameters.values[0].GetValue<string>();
-    long long total_size = 0;
-    for(const auto& inner_vector:results){
-        total_size+=inner_vector.size()*sizeof(inner_vector[0]);
-    }
-    double total_size_in_mb = static_cast<double>(total_size) / (1024 * 1024);
-    std::cout<<"Auxillary storage size "<<total_size_in_mb<<" MB\n";
+/**
+ * Prints the stats of a read-only PGM index.
+*/
+template <typename K>
+void print_stats_static_pgm(const StaticPGMIndex<K,INDEX_PAYLOAD_TYPE> &index){
+    std::cout << "Read-only index with epsilon " << index.epsilon() << " and " << index.segments_count() << " segments\n";
+    std::cout << "Total size in bytes: " << index.size_in_bytes() << " bytes\n";
+    std::cout << "Index size in bytes: " << index.index_size_in_bytes() << " bytes\n";
+    std::cout << "Number of elements: " << index.size() << "\n";
 }
+
 template <typename K>
 void print_stats_pgm(){
-    if(typeid(K)==typeid(DOUBLE_KEY_TYPE)){
-        std::cout << "Total size in bytes: " << double_dynamic_index.size_in_bytes() << " bytes\n";
-        std::cout << "Index size in bytes: " << double_dynamic_index.index_size_in_bytes() << " bytes\n";
-        std::cout << "Number of elements: " << double_dynamic_index.size() << "\n";
+    if(typeid(K)==typeid(DOUBLE_KEY_TYPE) && double_static_pgm_index->size()>0){
+        print_stats_static_pgm(*double_static_pgm_index.Load());
+    }
+    else if(typeid(K)==typeid(UNSIGNED_INT64_KEY_TYPE) && unsigned_big_int_static_pgm_index->size()>0){
+        print_stats_static_pgm(*unsigned_big_int_static_pgm_index.Load());
+    }
+    else if(typeid(K)==typeid(INT_KEY_TYPE) && int_static_pgm_index->size()>0){
+        print_stats_static_pgm(*int_static_pgm_index.Load());
+    }
+    else if(typeid(K)==typeid(INT64_KEY_TYPE) && big_int_static_pgm_index->size()>0){
+        print_stats_static_pgm(*big_int_static_pgm_index.Load());
+    }
+    else if(typeid(K)==typeid(DOUBLE_KEY_TYPE)){
+        std::cout << "Total size in bytes: " << double_dynamic_index->size_in_bytes() << " bytes\n";
+        std::cout << "Index size in bytes: " << double_dynamic_index->index_size_in_bytes() << " bytes\n";
+        std::cout << "Number of elements: " << double_dynamic_index->size() << "\n";
 
     }
     else if(typeid(K)==typeid(UNSIGNED_INT64_KEY_TYPE)){
-        std::cout << "Total size in bytes: " << unsigned_big_int_dynamic_index.size_in_bytes() << " bytes\n";
-        std::cout << "Index size in bytes: " << unsigned_big_int_dynamic_index.index_size_in_bytes() << " bytes\n";
-        std::cout << "Number of elements: " << unsigned_big_int_dynamic_index.size() << "\n";
+        std::cout << "Total size in bytes: " << unsigned_big_int_dynamic_index->size_in_bytes() << " bytes\n";
+        std::cout << "Index size in bytes: " << unsigned_big_int_dynamic_index->index_size_in_bytes() << " bytes\n";
+        std::cout << "Number of elements: " << unsigned_big_int_dynamic_index->size() << "\n";
     }
     else if(typeid(K)==typeid(INT_KEY_TYPE)){
-        std::cout << "Total size in bytes: " << int_dynamic_index.size_in_bytes() << " bytes\n";
-        std::cout << "Index size in bytes: " << int_dynamic_index.index_size_in_bytes() << " bytes\n";
-        std::cout << "Number of elements: " << int_dynamic_index.size() << "\n";
+        std::cout << "Total size in bytes: " << int_dynamic_index->size_in_bytes() << " bytes\n";
+        std::cout << "Index size in bytes: " << int_dynamic_index->index_size_in_bytes() << " bytes\n";
+        std::cout << "Number of elements: " << int_dynamic_index->size() << "\n";
     }
     else{ //big int
-        std::cout << "Total size in bytes: " << big_int_dynamic_index.size_in_bytes() << " bytes\n";
-        std::cout << "Big Int Dynamic Index size in bytes: " << big_int_dynamic_index.index_size_in_bytes() << " bytes\n";
-        std::cout << "Number of elements: " << big_int_dynamic_index.size() << "\n";
+        std::cout << "Total size in bytes: " << big_int_dynamic_index->size_in_bytes() << " bytes\n";
+        std::cout << "Big Int Dynamic Index size in bytes: " << big_int_dynamic_index->index_size_in_bytes() << " bytes\n";
+        std::cout << "Number of elements: " << big_int_dynamic_index->size() << "\n";
     }
 
 }
-template <typename K,typename P>
-void bulkLoadIntoIndexPGM(duckdb::Connection & con,std::string table_name,int column_index){
-    std::cout<<"General Function with no consequence.\n"; 
-}
-
-template<>
-void bulkLoadIntoIndexPGM<double,INDEX_PAYLOAD_TYPE>(duckdb::Connection & con,std::string table_name,int column_index){
-/*
-    Phase 1: Load the data from the table.
-    */
-    string query = "SELECT * FROM "+table_name+";";
-    unique_ptr<MaterializedQueryResult> result = con.Query(query);
-    results = result->getContents();
-    int num_keys = results.size();
-    //std::cout<<"Num Keys : "<<num_keys<<"\n";
-
-   /*
-    Phase 2: Bulk load the data from the results vector into the pair array that goes into the index.
-   */
-   std::vector<std::pair<double,INDEX_PAYLOAD_TYPE>> bulk_load_values;
-   bulk_load_values.reserve(num_keys);
-
- 
-    int max_key = INT_MIN;
-    for (int i=0;i<results.size();i++){
-        int row_id = i;
-        //std::cout<<"before key"<<"\n";
-        auto *data = dynamic_cast<Base *>(results[i][column_index].get());
-        auto *data1 = dynamic_cast<Base *>(results[i][column_index + 1].get());
-        
-        double key_ = static_cast<double_t>(static_cast<DoubleData *>(data)->value);
-        double value_ = static_cast<double_t>(static_cast<DoubleData *>(data1)->value);
-        
-        //std::cout<<"after key"<<"\n";
-        bulk_load_values.emplace_back(key_,value_);
+/**
+ * Publishes the PGM index built from the sorted pairs. With a read_only_epsilon it is a StaticPGMIndex with that error
+ * bound, otherwise a DynamicPGMIndex constructed from the range in one pass. Only one of the two is kept per key type,
+ * the other one is reset.
+*/
+template<typename K>
+void publishPGMIndex(const std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> &sorted_values,size_t read_only_epsilon,
+                     PublishedIndex<pgm::DynamicPGMIndex<K,INDEX_PAYLOAD_TYPE>> &dynamic_index,
+                     PublishedIndex<StaticPGMIndex<K,INDEX_PAYLOAD_TYPE>> &static_index){
+    if(read_only_epsilon>0){
+        auto index = std::make_shared<StaticPGMIndex<K,INDEX_PAYLOAD_TYPE>>(sorted_values.begin(),sorted_values.end(),read_only_epsilon);
+        static_index.Publish(index);
+        dynamic_index.Publish(std::make_shared<pgm::DynamicPGMIndex<K,INDEX_PAYLOAD_TYPE>>());
+        std::cout<<"Read-only PGM index with epsilon "<<index->epsilon()<<" and "<<index->segments_count()<<" segments\n";
     }
-    /**
-     Phase 3: Sort the bulk load values array based on the key values.
-    */
-
-    auto start_time = std::chrono::high_resolution_clock::now();
-    std::sort(bulk_load_values.begin(),bulk_load_values.end(),[](auto const& a, auto const& b) { return a.first < b.first; });
-
-    /*
-    Phase 4: Bulk load the sorted values into the index.
-    */
-
-
-     for (const auto &pair : bulk_load_values) {
-        double_dynamic_index.insert_or_assign(pair.first, pair.second);
+    else{
+        dynamic_index.Publish(std::make_shared<pgm::DynamicPGMIndex<K,INDEX_PAYLOAD_TYPE>>(sorted_values.begin(),sorted_values.end()));
+        static_index.Publish(std::make_shared<StaticPGMIndex<K,INDEX_PAYLOAD_TYPE>>());
     }
-    
-    auto end_time = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed_seconds = end_time - start_time;
-    std::cout << "Time taken to bulk load: " << elapsed_seconds.count() << " seconds\n\n\n";
-    print_stats_pgm<DOUBLE_KEY_TYPE>();
+    getLearnedIndexes<K>().pgm_memory.Set(dynamic_index->size_in_bytes());
 }
 
-template<>
-void bulkLoadIntoIndexPGM<int64_t,INDEX_PAYLOAD_TYPE>(duckdb::Connection & con,std::string table_name,int column_index){
+/**
+ * Builds the PGM index of the key type on the column of the table, a read-only one if read_only_epsilon is not 0, and
+ * publishes it.
+*/
+template <typename K>
+void bulkLoadIntoIndexPGM(duckdb::Connection & con,std::string table_name,int column_index,size_t read_only_epsilon,IndexBuildProgress *progress){
+    static_assert(isLearnedIndexKeyType<K>, "PGM indexes are built on DOUBLE, BIGINT, UBIGINT and INTEGER keys only");
+    auto indexes = getLearnedIndexes<K>();
 /*
-    Phase 1: Load the data from the table.
+    Phase 1 and 2: Scan the (key, value) pairs that go into the index out of the table.
     */
-    string query = "SELECT * FROM "+table_name+";";
-    unique_ptr<MaterializedQueryResult> result = con.Query(query);
-    results = result->getContents();
-    int num_keys = results.size();
-    std::cout<<"Num Keys : "<<num_keys<<"\n";
-
-   /*
-    Phase 2: Bulk load the data from the results vector into the pair array that goes into the index.
-   */
-//    std::pair<int64_t,INDEX_PAYLOAD_TYPE>* bulk_load_values = new std::pair<int64_t,INDEX_PAYLOAD_TYPE>[num_keys];
-
-   std::vector<std::pair<double,INDEX_PAYLOAD_TYPE>> bulk_load_values;
-   bulk_load_values.reserve(num_keys);
-
-    std::cout<<"Col index "<<column_index<<"\n";    
-    int max_key = INT_MIN;
-    for (int i=0;i<results.size();i++){
-        int row_id = i;
-        std::cout<<"before key"<<"\n";
-        auto *data = dynamic_cast<Base *>(results[i][column_index].get());
-        auto *data1 = dynamic_cast<Base *>(results[i][column_index + 1].get());
-        
-        int64_t key_ = static_cast<int64_t>(static_cast<BigIntData *>(data)->value);
-        double value_ = static_cast<double_t>(static_cast<DoubleData *>(data1)->value);
-        
-        // std::cout<<"after key: "<<key_<<" Value: "<<value_<<"\n";
-
-        bulk_load_values.emplace_back(key_,value_);
-
-        std::cout<<"Bulk Load values : "<<bulk_load_values[i].first<<" "<<bulk_load_values[i].second<<"\n";
-    }
-
-    std::cout<<"Bulk Load Values Size Before Sort: "<<bulk_load_values.size()<<"\n";
-
+    checkIndexBuildMemory(con,table_name,INDEX_BUILD_PAIRS_PER_ROW*sizeof(std::pair<K,INDEX_PAYLOAD_TYPE>));
+    typename PublishedIndex<pgm::DynamicPGMIndex<K,INDEX_PAYLOAD_TYPE>>::ScopedRebuild rebuild(indexes.pgm_index);
+    reportBuildProgress(progress,"scanning",0.0);
+    std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> bulk_load_values = scanKeyValuePairs<K>(con,table_name,column_index);
     /**
      Phase 3: Sort the bulk load values array based on the key values.
     */
-   //Measure time 
-    
-    auto start_time = std::chrono::high_resolution_clock::now();
-    std::sort(bulk_load_values.begin(),bulk_load_values.end(),[](auto const& a, auto const& b) { return a.first < b.first; });
-    
-    /*
-    Phase 4: Bulk load the sorted values into the index.
-    */
-
-    std::cout<<"Bulk Load Values Size : "<<bulk_load_values.size()<<"\n";
-    
-    // big_int_dynamic_index.bulk_load(bulk_load_values, num_keys);
-
-    for (const auto &pair : bulk_load_values) {
-        std::cout<<"Key : "<<pair.first<<" Value : "<<pair.second<<"\n";
-        big_int_dynamic_index.insert_or_assign(pair.first, pair.second);
-        std::cout<<"Index Size : "<<big_int_dynamic_index.size()<<"\n";
-    }
-
-    auto end_time = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed_seconds = end_time - start_time;
-    std::cout << "Time taken to bulk load: " << elapsed_seconds.count() <<" seconds\n\n\n";
-    print_stats_pgm<INT64_KEY_TYPE>();
-}
+    reportBuildProgress(progress,"sorting",0.5);
 
-template<>
-void bulkLoadIntoIndexPGM<UNSIGNED_INT64_KEY_TYPE,INDEX_PAYLOAD_TYPE>(duckdb::Connection & con,std::string table_name,int column_index){
-/*
-    Phase 1: Load the data from the table.
-    */
-    string query = "SELECT * FROM "+table_name+";";
-    unique_ptr<MaterializedQueryResult> result = con.Query(query);
-    results = result->getContents();
-    int num_keys = results.size();
-    //std::cout<<"Num Keys : "<<num_keys<<"\n";
-
-   /*
-    Phase 2: Bulk load the data from the results vector into the pair array that goes into the index.
-   */
-//    std::pair<UNSIGNED_INT64_KEY_TYPE,INDEX_PAYLOAD_TYPE>* bulk_load_values = new std::pair<UNSIGNED_INT64_KEY_TYPE,INDEX_PAYLOAD_TYPE>[num_keys];
-    //std::cout<<"Col index "<<column_index<<"\n";    
-    std::vector<std::pair<double,INDEX_PAYLOAD_TYPE>> bulk_load_values;
-    bulk_load_values.reserve(num_keys);
-
-    int max_key = INT_MIN;
-    for (int i=0;i<results.size();i++){
-        int row_id = i;
-        //std::cout<<"before key"<<"\n";
-        auto *data = dynamic_cast<Base *>(results[i][column_index].get());
-        auto *data1 = dynamic_cast<Base *>(results[i][column_index + 1].get());
-        
-        UNSIGNED_INT64_KEY_TYPE key_ = static_cast<u_int64_t>(static_cast<UBigIntData *>(data)->value);
-        double value_ = static_cast<double_t>(static_cast<DoubleData *>(data1)->value);
-        
-        //std::cout<<"after key"<<"\n";
-        bulk_load_values.emplace_back(key_,value_);
-    }
-    /**
-     Phase 3: Sort the bulk load values array based on the key values.
-    */
-   //Measure time 
-    
     auto start_time = std::chrono::high_resolution_clock::now();
-    std::sort(bulk_load_values.begin(),bulk_load_values.end(),[](auto const& a, auto const& b) { return a.first < b.first; });
-    
-    /*
-    Phase 4: Bulk load the sorted values into the index.
-    */
-    
-    // unsigned_big_int_dynamic_index.bulk_load(bulk_load_values, num_keys);
-
-    for (const auto &pair : bulk_load_values) {
-        unsigned_big_int_dynamic_index.insert_or_assign(pair.first, pair.second);
-    }
-
-
-    auto end_time = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> elapsed_seconds = end_time - start_time;
-    std::cout << "Time taken to bulk load: " << elapsed_seconds.count() <<" seconds\n\n\n";
-    print_stats_pgm<UNSIGNED_INT64_KEY_TYPE>();
-}
-
-template<>
-void bulkLoadIntoIndexPGM<INT_KEY_TYPE,INDEX_PAYLOAD_TYPE>(duckdb::Connection & con,std::string table_name,int column_index){
-/*
-    Phase 1: Load the data from the table.
-    */
-    string query = "SELECT * FROM "+table_name+";";
-    unique_ptr<MaterializedQueryResult> result = con.Query(query);
-    results = result->getContents();
-    int num_keys = results.size();
-    std::cout<<"Num Keys : "<<num_keys<<"\n";
-
-   /*
-    Phase 2: Bulk load the data from the results vector into the pair array that goes into the index.
-   */
-//    std::pair<INT_KEY_TYPE,INDEX_PAYLOAD_TYPE>* bulk_load_values = new std::pair<INT_KEY_TYPE,INDEX_PAYLOAD_TYPE>[num_keys];
-    std::cout<<"Col index "<<column_index<<"\n";    
-    std::vector<std::pair<INT_KEY_TYPE,INDEX_PAYLOAD_TYPE>> bulk_load_values;
-    bulk_load_values.reserve(num_keys);
-
-
-    int max_key = INT_MIN;
-    for (int i=0;i<results.size();i++){
-        int row_id = i;
-        if(results[i][column_index]) {
-        std::cout<<"before key"<<"\n";
-        auto *data = dynamic_cast<Base *>(results[i][column_index].get());
-        auto *data1 = dynamic_cast<Base *>(results[i][column_index + 1].get());
-        //auto rrr = results[i][column_index].get();
-        
-        INT_KEY_TYPE key_ = static_cast<int32_t>(static_cast<IntData *>(data)->value);
-        double value_ = static_cast<double_t>(static_cast<DoubleData *>(data1)->value);
+    sortUniqueKeyValuePairs(bulk_load_values);
 
-        std::cout<<"after key"<<"\n";
-        bulk_load_values.emplace_back(key_,  static_cast<INDEX_PAYLOAD_TYPE>(i));
-        std::cout<<"Key : "<<key_<<" Value : "<<value_<<"\n";
-        }
-    }
-    /**
-     Phase 3: Sort the bulk load values array based on the key values.
-    */
-   //Measure time 
-    
-    auto start_time = std::chrono::high_resolution_clock::now();
-    std::sort(bulk_load_values.begin(),bulk_load_values.end(),[](auto const& a, auto const& b) { return a.first < b.first; });
-    
     /*
     Phase 4: Bulk load the sorted values into the index.
     */
-    
-    // index.bulk_load(bulk_load_values, num_keys);
-
-     for (const auto &pair : bulk_load_values) {
-        std::cout<<"Key : "<<pair.first<<" Value : "<<pair.second<<"\n";
-        int_dynamic_index.insert_or_assign(pair.first, pair.second);
-    }
-
 
+    reportBuildProgress(progress,"building",0.7);
+    publishPGMIndex(bulk_load_values,read_only_epsilon,indexes.pgm_index,indexes.static_pgm_index);
+    indexes.pgm_cache->Clear();
 
     auto end_time = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> elapsed_seconds = end_time - start_time;
-    std::cout << "Time taken to bulk load: " << elapsed_seconds.count() <<" seconds\n\n\n";
-    print_stats_pgm<INT_KEY_TYPE>();
+    std::cout << "Time taken to bulk load: " << elapsed_seconds.count() << " seconds\n\n\n";
+    print_stats_pgm<K>();
 }
 
 void createPGMIndexPragmaFunction(ClientContext &context, const FunctionParameters &parameters){
@@ -2203,28 +3425,52 @@ void createPGMIndexPragmaFunction(ClientContext &context, const FunctionParamete
         std::cout<<"Column not found "<<"\n";
     }
     else{
-        duckdb::Connection con(*context.db);
         std::cout<<"Column found at index "<<column_index<<"\n";
         std::cout<<"Creating an pgm index for this column"<<"\n";
         // std::cout<<"Column Type "<<typeid(column_type).name()<<"\n";
         // std::cout<<"Column Type "<<typeid(double).name()<<"\n";
         std::cout<<"Column type to string "<<column_type.ToString()<<"\n";
         std::string columnTypeName = column_type.ToString();
+        // read_only := true builds a static PGM index for columns that do not change anymore
+        size_t read_only_epsilon = 0;
+        auto read_only_entry = parameters.named_parameters.find("read_only");
+        if(read_only_entry != parameters.named_parameters.end() && BooleanValue::Get(read_only_entry->second)){
+            read_only_epsilon = StaticPGMIndex<DOUBLE_KEY_TYPE,INDEX_PAYLOAD_TYPE>::kDefaultEpsilon;
+            auto epsilon_entry = parameters.named_parameters.find("epsilon");
+            if(epsilon_entry != parameters.named_parameters.end()){
+                read_only_epsilon = epsilon_entry->second.GetValue<int32_t>();
+            }
+            if(!StaticPGMIndex<DOUBLE_KEY_TYPE,INDEX_PAYLOAD_TYPE>::IsSupportedEpsilon(read_only_epsilon)){
+                throw InvalidInputException("epsilon of a read-only PGM index must be one of 16, 32, 64, 128 or 256");
+            }
+        }
+        auto progress = std::make_shared<IndexBuildProgress>();
+        string qualified_table = getQualifiedTableName(context, table_name);
+        progress->index_type = read_only_epsilon>0 ? "pgm (read-only)" : "pgm";
+        progress->table_name = table_name;
+        progress->qualified_table_name = qualified_table;
+        progress->column_name = column_name;
+        progress->key_type = columnTypeName;
+        progress->background = GetBackgroundParameter(parameters);
         if(columnTypeName == "DOUBLE"){
-            bulkLoadIntoIndexPGM<DOUBLE_KEY_TYPE,INDEX_PAYLOAD_TYPE>(con,table_name,column_index);
-            index_type_table_name_map.insert({"double",{table_name,column_name}});
+            runIndexBuild(context,progress,buildForTable<DOUBLE_KEY_TYPE>(qualified_table,column_name,[table_name,column_index,read_only_epsilon](duckdb::Connection &con,IndexBuildProgress *progress){
+                bulkLoadIntoIndexPGM<DOUBLE_KEY_TYPE>(con,table_name,column_index,read_only_epsilon,progress);
+            }));
         }
         else if(columnTypeName == "BIGINT"){
-            bulkLoadIntoIndexPGM<INT64_KEY_TYPE,INDEX_PAYLOAD_TYPE>(con,table_name,column_index);
-            index_type_table_name_map.insert({"bigint",{table_name,column_name}});
+            runIndexBuild(context,progress,buildForTable<INT64_KEY_TYPE>(qualified_table,column_name,[table_name,column_index,read_only_epsilon](duckdb::Connection &con,IndexBuildProgress *progress){
+                bulkLoadIntoIndexPGM<INT64_KEY_TYPE>(con,table_name,column_index,read_only_epsilon,progress);
+            }));
         }
         else if(columnTypeName == "UBIGINT"){
-            bulkLoadIntoIndexPGM<UNSIGNED_INT64_KEY_TYPE,INDEX_PAYLOAD_TYPE>(con,table_name,column_index);
-            index_type_table_name_map.insert({"ubigint",{table_name,column_name}});
+            runIndexBuild(context,progress,buildForTable<UNSIGNED_INT64_KEY_TYPE>(qualified_table,column_name,[table_name,column_index,read_only_epsilon](duckdb::Connection &con,IndexBuildProgress *progress){
+                bulkLoadIntoIndexPGM<UNSIGNED_INT64_KEY_TYPE>(con,table_name,column_index,read_only_epsilon,progress);
+            }));
         }
         else if(columnTypeName == "INTEGER"){
-            bulkLoadIntoIndexPGM<INT_KEY_TYPE,INDEX_PAYLOAD_TYPE>(con,table_name,column_index);
-            index_type_table_name_map.insert({"int",{table_name,column_name}});
+            runIndexBuild(context,progress,buildForTable<INT_KEY_TYPE>(qualified_table,column_name,[table_name,column_index,read_only_epsilon](duckdb::Connection &con,IndexBuildProgress *progress){
+                bulkLoadIntoIndexPGM<INT_KEY_TYPE>(con,table_name,column_index,read_only_epsilon,progress);
+            }));
         }
         else{
             std::cout<<"Unsupported column type for alex indexing (for now) "<<"\n";
@@ -2257,53 +3503,31 @@ inline void RadixOpenSSLVersionScalarFun(DataChunk &args, ExpressionState &state
 Bulk Load into Index functions
 */
 template <typename T>
-void BulkLoadRadixSpline(duckdb::Connection &con, const std::string &table_name, int column_index, const std::string &map_key) {
+void BulkLoadRadixSpline(duckdb::Connection &con, const std::string &table_name, int column_index, const std::string &map_key,
+                         bool compressed, bool two_level, RadixSplineEntry<T> &entry, IndexBuildProgress *progress) {
     // Ensure T is one of the allowed types
     static_assert(std::is_same<T, uint32_t>::value || std::is_same<T, uint64_t>::value,
                   "BulkLoadRadixSpline only supports uint32_t and uint64_t.");
 
-    // Query the table
-    std::string query = "SELECT * FROM " + table_name + ";";
-    unique_ptr<MaterializedQueryResult> res = con.Query(query);
+    // The index keeps the sorted keys next to the spline, which the build sorts in a buffer of its own
+    checkIndexBuildMemory(con, table_name, 3 * sizeof(T));
 
-    if (!res || res->HasError()) {
-        throw std::runtime_error("Failed to fetch data from table: " + table_name);
-    }
-
-    // Fetch results
-    auto result = res->getContents();
-
-    // Pre-allocate keys
+    auto &index = entry.index;
+    // Query the table, updates made meanwhile stay in the delta buffer of the index
+    index.BeginBuild();
     std::vector<T> keys;
-    keys.reserve(result.size());
-
-    for (size_t i = 0; i < result.size(); i++) {
-        if (result[i][column_index]) {
-            auto *data = dynamic_cast<Base *>(result[i][column_index].get());
-            int id1 = static_cast<int>(static_cast<UIntData *>(data)->id);
-            int id2 = static_cast<int>(static_cast<UBigIntData *>(data)->id);
-
-            if (id1 == 30 || id2 == 30) {
-                keys.push_back(static_cast<uint32_t>(static_cast<UIntData *>(data)->value));
-            } else if (id1 == 31 || id2 == 31) {
-                keys.push_back(static_cast<uint64_t>(static_cast<UBigIntData *>(data)->value));
-            }
-        }
-    }
-
-    // Ensure keys are sorted
-    std::sort(keys.begin(), keys.end());
-
-    // Build RadixSpline
-    rs::Builder<T> builder(keys.front(), keys.back(), kNumRadixBits, kMaxError);
-    int num = 0;
-    for (const auto &key : keys) {
-        builder.AddKey(key);
-        num++;
+    try {
+        reportBuildProgress(progress, "scanning", 0.0);
+        keys = scanKeys<T>(con, table_name, column_index);
+
+        // Ensure keys are sorted
+        reportBuildProgress(progress, "sorting", 0.5);
+        std::sort(keys.begin(), keys.end());
+    } catch (...) {
+        index.AbortBuild();
+        throw;
     }
 
-    auto finalized_spline = builder.Finalize();
-
     // Collect statistics
     RadixSplineStats stats;
     stats.num_keys = keys.size();
@@ -2313,14 +3537,15 @@ void BulkLoadRadixSpline(duckdb::Connection &con, const std::string &table_name,
         stats.average_gap = (keys.size() > 1) ? static_cast<double>(keys.back() - keys.front()) / (keys.size() - 1) : 0.0;
     }
 
-    // Store in the appropriate map
-    if constexpr (std::is_same<T, uint32_t>::value) {
-        radix_spline_map_int32[map_key] = std::move(finalized_spline);
-        radix_spline_stats_map_int32[map_key] = stats;
-    } else if constexpr (std::is_same<T, uint64_t>::value) {
-        radix_spline_map_int64[map_key] = std::move(finalized_spline);
-        radix_spline_stats_map_int64[map_key] = stats;
-    }
+    // Build the RadixSpline into the map entry the caller created up front, the maps themselves
+    // are not safe to modify from a background build
+    reportBuildProgress(progress, "building", 0.7);
+    size_t num = keys.size();
+    index.SetCompressed(compressed);
+    index.SetTwoLevelRadixTable(two_level);
+    index.Build(std::move(keys), kNumRadixBits, kMaxError);
+    entry.cache->Clear();
+    setRadixSplineStats(entry, stats);
 
     std::cout << "RadixSpline successfully created for " << map_key << " Total Keys Added : "<< num << ".\n";
 }
@@ -2329,6 +3554,7 @@ void BulkLoadRadixSpline(duckdb::Connection &con, const std::string &table_name,
  * PragmaFunction to Load the data
 */
 void createRadixSplineIndexPragmaFunction(ClientContext &context, const FunctionParameters &parameters) {
+    restorePendingRadixSplines(context);
     string table_name = parameters.values[0].GetValue<string>();
     string column_name = parameters.values[1].GetValue<string>();
 
@@ -2359,189 +3585,998 @@ void createRadixSplineIndexPragmaFunction(ClientContext &context, const Function
         return;
     }
 
-    duckdb::Connection con(*context.db);
-
     // Determine column type and build RadixSpline
     string columnTypeName = column_type.ToString();
+    string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + column_name;
+    string scan_table = qname.name;
+    auto progress = std::make_shared<IndexBuildProgress>();
+    progress->index_type = "radixspline";
+    progress->table_name = table_name;
+    progress->qualified_table_name = getQualifiedTableName(context, table_name);
+    progress->column_name = column_name;
+    progress->key_type = columnTypeName;
+    progress->background = GetBackgroundParameter(parameters);
+    // A compressed spline is several times smaller and estimates the same positions, at a few
+    // nanoseconds per lookup
+    bool compressed = GetBooleanParameter(parameters, "compressed");
+    // A second radix table level keeps lookups on skewed keys, such as lognormal ones, from binary
+    // searching the few prefixes that hold most of the spline
+    bool two_level = GetBooleanParameter(parameters, "two_level");
+    if (compressed) {
+        progress->index_type = "radixspline (compressed)";
+    }
     if (columnTypeName == "UBIGINT") {
-        BulkLoadRadixSpline<uint64_t>(con, qname.name, column_index, qname.catalog + "." + qname.schema + "." + qname.name + "." + column_name);
+        auto entry = findOrAddRadixSpline(radix_spline_map_int64, map_key);
+        runIndexBuild(context, progress, [scan_table, column_index, map_key, compressed, two_level, entry](duckdb::Connection &con, IndexBuildProgress *progress) {
+            BulkLoadRadixSpline<uint64_t>(con, scan_table, column_index, map_key, compressed, two_level, *entry, progress);
+        });
     } else if (columnTypeName == "UINTEGER") {
-        BulkLoadRadixSpline<uint32_t>(con, qname.name, column_index, qname.catalog + "." + qname.schema + "." + qname.name + "." + column_name);
+        auto entry = findOrAddRadixSpline(radix_spline_map_int32, map_key);
+        runIndexBuild(context, progress, [scan_table, column_index, map_key, compressed, two_level, entry](duckdb::Connection &con, IndexBuildProgress *progress) {
+            BulkLoadRadixSpline<uint32_t>(con, scan_table, column_index, map_key, compressed, two_level, *entry, progress);
+        });
     } else {
         std::cout << "Unsupported column type '" << columnTypeName << "' for RadixSpline indexing.\n";
     }
+    accountRadixSplineMemory();
 }
 
 /**
- * Function to lookup a value using the RadixSpline index
+ * Returns the column type of column_name in table_name, or an empty string if there is no such column.
 */
-void RadixSplineLookupPragmaFunction(ClientContext &context, const FunctionParameters &parameters) {
-    string table_name = parameters.values[0].GetValue<string>();
-    string column_name = parameters.values[1].GetValue<string>();
-    string lookup_key_str = parameters.values[2].GetValue<string>();
-
-    // Parse the lookup key
-    uint64_t lookup_key = std::stoull(lookup_key_str);
-
-    // Create the map key
-    QualifiedName qname = GetQualifiedName(context, table_name);
-    string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + column_name;
-
-    // Determine which RadixSpline map to use
-    if (radix_spline_map_int64.find(map_key) != radix_spline_map_int64.end()) {
-        // Lookup in the uint64_t RadixSpline map
-        const auto &radix_spline = radix_spline_map_int64[map_key];
-        size_t estimated_position = radix_spline.GetEstimatedPosition(lookup_key);
-        std::cout << "Estimated position for key " << lookup_key << " is: " << estimated_position << std::endl;
-    } else if (radix_spline_map_int32.find(map_key) != radix_spline_map_int32.end()) {
-        // Lookup in the uint32_t RadixSpline map
-        uint32_t lookup_key_32 = static_cast<uint32_t>(lookup_key);
-        const auto &radix_spline = radix_spline_map_int32[map_key];
-        size_t estimated_position = radix_spline.GetEstimatedPosition(lookup_key_32);
-        std::cout << "Estimated position for key " << lookup_key_32 << " is: " << estimated_position << std::endl;
-    } else {
-        std::cout << "RadixSpline index not found for " << map_key << ". Please ensure you have created the index first." << std::endl;
+static string getColumnTypeName(ClientContext &context, const QualifiedName &qname, const string &column_name) {
+    auto &table = Catalog::GetEntry<TableCatalogEntry>(context, qname.catalog, qname.schema, qname.name);
+    auto &columnList = table.GetColumns();
+    if (!columnList.ColumnExists(column_name)) {
+        return "";
     }
+    return columnList.GetColumn(column_name).GetType().ToString();
 }
 
 /**
- * Function to delete a RadixSpline index
+ * Writes the RadixSpline index on a column to a file that load_radixspline_index can map and use in place.
 */
-void DeleteRadixSplineIndexPragmaFunction(ClientContext &context, const FunctionParameters &parameters) {
+void SaveRadixSplineIndexPragmaFunction(ClientContext &context, const FunctionParameters &parameters) {
+    restorePendingRadixSplines(context);
     string table_name = parameters.values[0].GetValue<string>();
     string column_name = parameters.values[1].GetValue<string>();
+    string path = parameters.values[2].GetValue<string>();
 
-    // Create the map key
     QualifiedName qname = GetQualifiedName(context, table_name);
     string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + column_name;
 
-    // Determine which RadixSpline map to delete from
-    if (radix_spline_map_int64.find(map_key) != radix_spline_map_int64.end()) {
-        radix_spline_map_int64.erase(map_key);
-        std::cout << "RadixSpline index deleted for " << map_key << ".\n";
-    } else if (radix_spline_map_int32.find(map_key) != radix_spline_map_int32.end()) {
-        radix_spline_map_int32.erase(map_key);
-        std::cout << "RadixSpline index deleted for " << map_key << ".\n";
+    bool saved = false;
+    string error;
+    auto index64 = findRadixSpline(radix_spline_map_int64, map_key);
+    auto index32 = findRadixSpline(radix_spline_map_int32, map_key);
+    if (index64) {
+        saved = index64->index.Save(path, &error);
+    } else if (index32) {
+        saved = index32->index.Save(path, &error);
     } else {
-        std::cout << "RadixSpline index not found for " << map_key << ".\n";
+        std::cout << "RadixSpline index not found for " << map_key << ". Please ensure you have created the index first.\n";
+        return;
+    }
+    if (!saved) {
+        throw IOException("Saving the RadixSpline index failed: %s", error);
     }
+    std::cout << "RadixSpline index for " << map_key << " saved to " << path << ".\n";
 }
 
 /**
- * Function to lookup range values using the RadixSpline index
+ * Replaces the RadixSpline index of the map key with the one saved to path. The file is mapped and used in
+ * place, so this takes milliseconds even for large indexes. Returns false and sets error if the file can
+ * not be used.
 */
-void RadixSplineRangeLookupPragmaFunction(ClientContext &context, const FunctionParameters &parameters) {
-    string table_name = parameters.values[0].GetValue<string>();
-    string column_name = parameters.values[1].GetValue<string>();
-    string start_key_str = parameters.values[2].GetValue<string>();
-    string end_key_str = parameters.values[3].GetValue<string>();
-
-    // Parse the range keys
-    uint64_t start_key = std::stoull(start_key_str);
-    uint64_t end_key = std::stoull(end_key_str);
-
-    // Create the map key
-    QualifiedName qname = GetQualifiedName(context, table_name);
-    string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + column_name;
+template <typename T>
+bool LoadRadixSpline(const string &path, RadixSplineEntry<T> &entry, string *error) {
+    auto &index = entry.index;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    if (!index.Load(path, error)) {
+        return false;
+    }
+    entry.cache->Clear();
+    auto end_time = std::chrono::high_resolution_clock::now();
 
-    // Perform range lookup in the appropriate RadixSpline map
-    if (radix_spline_map_int64.find(map_key) != radix_spline_map_int64.end()) {
-        const auto &radix_spline = radix_spline_map_int64[map_key];
-        size_t start_position = radix_spline.GetEstimatedPosition(start_key);
-        size_t end_position = radix_spline.GetEstimatedPosition(end_key);
-        std::cout << "Estimated positions for range (" << start_key << " - " << end_key << ") are: "
-                  << "start: " << start_position << ", end: " << end_position << std::endl;
-    } else if (radix_spline_map_int32.find(map_key) != radix_spline_map_int32.end()) {
-        uint32_t start_key_32 = static_cast<uint32_t>(start_key);
-        uint32_t end_key_32 = static_cast<uint32_t>(end_key);
-        const auto &radix_spline = radix_spline_map_int32[map_key];
-        size_t start_position = radix_spline.GetEstimatedPosition(start_key_32);
-        size_t end_position = radix_spline.GetEstimatedPosition(end_key_32);
-        std::cout << "Estimated positions for range (" << start_key_32 << " - " << end_key_32 << ") are: "
-                  << "start: " << start_position << ", end: " << end_position << std::endl;
-    } else {
-        std::cout << "RadixSpline index not found for " << map_key << ". Please ensure you have created the index first." << std::endl;
+    RadixSplineStats stats;
+    stats.num_keys = index.GetNumKeys();
+    T min_key, max_key;
+    if (index.GetBaseKeyRange(&min_key, &max_key)) {
+        stats.min_key = min_key;
+        stats.max_key = max_key;
+        stats.average_gap = (stats.num_keys > 1) ? static_cast<double>(max_key - min_key) / (stats.num_keys - 1) : 0.0;
     }
+    setRadixSplineStats(entry, stats);
+
+    std::chrono::duration<double> elapsed_seconds = end_time - start_time;
+    std::cout << "RadixSpline index with " << stats.num_keys << " keys loaded from " << path << " in "
+              << elapsed_seconds.count() << " seconds.\n";
+    return true;
 }
 
 /**
- * Function for collecting the stats.
+ * Learned index persistence. PRAGMA checkpoint_learned_indexes writes the learned indexes to the sidecar
+ * directory of the database file, see learned_index_sidecar.h. When the extension is loaded, the indexes listed
+ * there are registered for restoring: each one is checked against its table and bulk loaded from its file when
+ * it is first used, so startup does not pay for it and no index is rebuilt from the table.
+ * Between checkpoints the insert, delete and update pragmas log their mutations, see learned_index_log.h, and
+ * a restored index replays the ones of its table, so recovery only redoes the changes since the checkpoint.
 */
-void RadixSplineStatsPragmaFunction(ClientContext &context, const FunctionParameters &parameters) {
-    string table_name = parameters.values[0].GetValue<string>();
-    string column_name = parameters.values[1].GetValue<string>();
 
-    // Create the map key
-    QualifiedName qname = GetQualifiedName(context, table_name);
-    string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + column_name;
+// Checkpoints run one at a time, as each one removes the files the others would list
+std::mutex learned_index_checkpoint_lock;
 
-    // Determine which RadixSpline stats map to use
-    if (radix_spline_stats_map_int64.find(map_key) != radix_spline_stats_map_int64.end()) {
-        const auto &stats = radix_spline_stats_map_int64[map_key];
-        std::cout << "Statistics for RadixSpline index '" << map_key << "':\n";
-        std::cout << " - Number of keys: " << stats.num_keys << "\n";
-        std::cout << " - Minimum key: " << stats.min_key << "\n";
-        std::cout << " - Maximum key: " << stats.max_key << "\n";
-        std::cout << " - Average gap between keys: " << stats.average_gap << "\n";
-    } else if (radix_spline_stats_map_int32.find(map_key) != radix_spline_stats_map_int32.end()) {
-        const auto &stats = radix_spline_stats_map_int32[map_key];
-        std::cout << "Statistics for RadixSpline index '" << map_key << "':\n";
-        std::cout << " - Number of keys: " << stats.num_keys << "\n";
-        std::cout << " - Minimum key: " << stats.min_key << "\n";
-        std::cout << " - Maximum key: " << stats.max_key << "\n";
-        std::cout << " - Average gap between keys: " << stats.average_gap << "\n";
-    } else {
-        std::cout << "RadixSpline index not found for " << map_key << ". Please ensure you have created the index first.\n";
-    }
-}
+// RadixSpline indexes of the sidecar that were not used yet
+std::mutex radix_spline_restores_lock;
+std::vector<LearnedIndexManifestEntry> pending_radix_spline_restores;
+std::string radix_spline_restores_directory;
 
 /**
- * Load Benchmark Data into Table with Batching
- * 
- * Template function to load key-value pairs into DuckDB in batches.
- * 
- * @param keys - The keys to insert into the table.
- * @param con - Connection to DuckDB.
- * @param tableName - Name of the table to insert the data into.
- * @param NUM_KEYS - Total number of keys.
- * @param num_batches_insert - Number of batches.
- * @param per_batch - Number of records per batch.
- */
-template <typename K, typename P>
-void load_benchmark_data_into_table(const std::vector<K> &keys, duckdb::Connection &con, std::string tableName, int NUM_KEYS, int num_batches_insert, int per_batch) {
-    // This function will load key-value pairs into the table in batches
-    int starting = 0;
-    int ending = 0;
-
-    std::string query_prefix = "INSERT INTO " + tableName + " VALUES ";
-
-    for (int i = 0; i < num_batches_insert; i++) {
-        std::cout << "Inserting batch " << i << "\n";
-        
-        starting = i * per_batch;
-        ending = std::min(starting + per_batch, NUM_KEYS);
-        std::ostringstream tuple_stream;
+ * What became of a saved index when it was first used, see learned_index_stats. Restores run from whichever query
+ * first uses an index, so they record their outcome here rather than failing or printing from that query.
+*/
+struct LearnedIndexRestore {
+    // As learned_index_stats names the index type
+    string index_type;
+    string table_name;
+    string column_name;
+    bool restored = false;
+    // Why the index was not restored
+    string reason;
+    idx_t replayed_changes = 0;
+};
 
-        // Generate batch insertion tuples
-        std::mt19937_64 gen_payload(std::random_device{}());
+// The restores since the extension was loaded
+std::mutex learned_index_restores_lock;
+std::vector<LearnedIndexRestore> learned_index_restores;
 
-        for (int vti = starting; vti < ending; vti++) {
-            K key = keys[vti];
-            P random_payload = static_cast<P>(gen_payload());
+static string getRestoredIndexType(const LearnedIndexManifestEntry &entry) {
+    return entry.kind == "pgm" && entry.option > 0 ? "pgm_static" : entry.kind;
+}
 
-            tuple_stream << "(" << key << ", " << random_payload << ")";
-            if (vti != ending - 1) {
-                tuple_stream << ",";
-            }
+static void recordRestore(const LearnedIndexManifestEntry &entry, bool restored, const string &reason,
+                          idx_t replayed_changes = 0) {
+    LearnedIndexRestore restore {getRestoredIndexType(entry), entry.table_name, entry.column_name, restored, reason,
+                                 replayed_changes};
+    std::lock_guard<std::mutex> guard(learned_index_restores_lock);
+    for (auto &existing : learned_index_restores) {
+        if (existing.index_type == restore.index_type && StringUtil::CIEquals(existing.table_name, restore.table_name) &&
+            StringUtil::CIEquals(existing.column_name, restore.column_name)) {
+            existing = std::move(restore);
+            return;
         }
+    }
+    learned_index_restores.push_back(std::move(restore));
+}
 
-        std::string to_execute_query = query_prefix + tuple_stream.str() + ";";
-        auto res = con.Query(to_execute_query);
-
-        if (!res->HasError()) {
-            std::cout << "Batch " << i << " inserted successfully.\n";
-        } else {
-            std::cerr << "Error inserting batch " << i << ": " << res->GetError() << "\n";
+static std::vector<LearnedIndexRestore> getRestores(const string &qualified_table, const string &column_name) {
+    std::vector<LearnedIndexRestore> restores;
+    std::lock_guard<std::mutex> guard(learned_index_restores_lock);
+    for (auto &restore : learned_index_restores) {
+        if (StringUtil::CIEquals(restore.table_name, qualified_table) &&
+            StringUtil::CIEquals(restore.column_name, column_name)) {
+            restores.push_back(restore);
+        }
+    }
+    return restores;
+}
+
+static string getSidecarDirectory(DatabaseInstance &db) {
+    return LearnedIndexSidecar::DirectoryFor(DBConfig::GetConfig(db).options.database_path);
+}
+
+/**
+ * Fingerprint of a table: its row count, and a hash of the metadata of its storage segments. Taken when an index
+ * is written and compared when it is restored, so an index of a table that changed since is not used.
+ * Neither reads column data, so both cost O(row groups) rather than O(rows). Any change to the table, an UPDATE
+ * made around the extension included, marks its segments as updated until the next DuckDB checkpoint, which
+ * writes them to new blocks with new statistics. checkpoint_learned_indexes runs a checkpoint first, so the
+ * segments of an unchanged table stay as they are across restarts.
+ * Returns false if the table can not be read.
+*/
+static bool getTableFingerprint(duckdb::Connection &con, const string &table_name, uint64_t &row_count, uint64_t &fingerprint) {
+    auto count = con.Query("SELECT count(*)::UBIGINT FROM " + table_name);
+    auto storage = con.Query("SELECT coalesce(bit_xor(hash(row_group_id, column_id, segment_id, start, count, stats, has_updates, "
+                             "persistent, block_id, block_offset)), 0)::UBIGINT FROM pragma_storage_info(" +
+                             KeywordHelper::WriteQuoted(table_name, '\'') + ")");
+    if (count->HasError() || count->RowCount() != 1 || storage->HasError() || storage->RowCount() != 1) {
+        return false;
+    }
+    row_count = count->GetValue(0, 0).GetValue<uint64_t>();
+    fingerprint = storage->GetValue(0, 0).GetValue<uint64_t>();
+    return true;
+}
+
+/**
+ * Content hash of a table: its row count, and the sum modulo 2^64 of the hashes of its rows over all columns, see
+ * getRowHashExpression. Unlike the fingerprint it reads every row, but it does not depend on how the rows are
+ * stored, and the mutation pragmas log how each of their changes moves it, so it can still be checked once the
+ * table changed. Returns false if the table can not be read.
+*/
+static bool getTableContentHash(duckdb::Connection &con, const string &table_name, uint64_t &row_count, uint64_t &content_hash) {
+    string row_hash;
+    if (!getRowHashExpression(con, table_name, row_hash)) {
+        return false;
+    }
+    auto result = con.Query("SELECT count(*)::UBIGINT, coalesce(sum(" + row_hash + "::HUGEINT), 0)::HUGEINT FROM " + table_name);
+    if (result->HasError() || result->RowCount() != 1) {
+        return false;
+    }
+    row_count = result->GetValue(0, 0).GetValue<uint64_t>();
+    // The low 64 bits of the sum are the sum modulo 2^64
+    content_hash = result->GetValue(1, 0).GetValue<hugeint_t>().lower;
+    return true;
+}
+
+/**
+ * Returns true if the two names, both as getQualifiedTableName names tables, refer to the same table. The log,
+ * the manifest and the builds all record tables by their qualified names, so tables of the same name in another
+ * schema or catalog are told apart.
+*/
+static bool isSameTable(const string &a, const string &b) {
+    return StringUtil::CIEquals(a, b);
+}
+
+/**
+ * Collects the logged mutations of the table of the manifest entry, in the order they happened.
+*/
+static bool getLoggedMutations(const LearnedIndexManifestEntry &entry, std::vector<LearnedIndexLog::Record> &mutations,
+                               string &error) {
+    std::vector<LearnedIndexLog::Record> records;
+    if (!learned_index_log.ReadRecords(&records, &error)) {
+        error = "could not read the learned index log: " + error;
+        return false;
+    }
+    for (auto &record : records) {
+        if (isSameTable(record.table_name, entry.table_name)) {
+            mutations.push_back(std::move(record));
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns true if the table of the manifest entry is in the state the saved index plus the logged mutations
+ * describe. Without mutations the fingerprint has to match, which reads no rows. With mutations the content hash
+ * of the table has to be the saved one moved by what the mutations logged, which reads the table once. Either
+ * catches changes made around the extension; the content hash also catches logged changes that never committed.
+*/
+static bool isRestoredIndexCurrent(duckdb::Connection &con, const LearnedIndexManifestEntry &entry,
+                                   const std::vector<LearnedIndexLog::Record> &mutations) {
+    uint64_t row_count = 0;
+    int64_t row_delta = 0;
+    uint64_t hash_delta = 0;
+    for (auto &mutation : mutations) {
+        row_delta += mutation.row_delta;
+        hash_delta += mutation.hash_delta;
+    }
+    bool current;
+    if (mutations.empty()) {
+        uint64_t fingerprint = 0;
+        current = getTableFingerprint(con, entry.table_name, row_count, fingerprint) && row_count == entry.row_count &&
+                  fingerprint == entry.fingerprint;
+    } else {
+        uint64_t content_hash = 0;
+        current = getTableContentHash(con, entry.table_name, row_count, content_hash) &&
+                  static_cast<int64_t>(row_count) == static_cast<int64_t>(entry.row_count) + row_delta &&
+                  content_hash == entry.content_hash + hash_delta;
+    }
+    return current;
+}
+
+/**
+ * Applies the logged mutations to the sorted pairs of a saved index, in one merge pass. Inserts keep the
+ * payload of a present key like the ALEX inserts do, unless assign_on_insert is set as for PGM.
+*/
+template<typename K>
+void replayLoggedMutations(std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> &pairs, const std::vector<LearnedIndexLog::Record> &mutations,
+                           bool assign_on_insert) {
+    // The entries the mutations leave for the keys they touch, nullopt for erased keys
+    std::map<K, std::optional<INDEX_PAYLOAD_TYPE>> changes;
+    auto is_present = [&](K key) {
+        auto change = changes.find(key);
+        if (change != changes.end()) {
+            return change->second.has_value();
+        }
+        return std::binary_search(pairs.begin(), pairs.end(), std::make_pair(key, INDEX_PAYLOAD_TYPE()),
+                                  [](auto const& a, auto const& b) { return a.first < b.first; });
+    };
+    for (auto &mutation : mutations) {
+        K key = LearnedIndexLog::DecodeKey<K>(mutation.key);
+        if (mutation.op == LearnedIndexLog::Op::kErase) {
+            changes[key] = std::nullopt;
+        } else if (mutation.op == LearnedIndexLog::Op::kUpdate || !assign_on_insert) {
+            if (is_present(key) == (mutation.op == LearnedIndexLog::Op::kUpdate)) {
+                changes[key] = mutation.payload;
+            }
+        } else {
+            changes[key] = mutation.payload;
+        }
+    }
+    if (changes.empty()) {
+        return;
+    }
+
+    std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> merged;
+    merged.reserve(pairs.size() + changes.size());
+    auto change = changes.begin();
+    for (auto &pair : pairs) {
+        for (; change != changes.end() && change->first < pair.first; change++) {
+            if (change->second) {
+                merged.emplace_back(change->first, *change->second);
+            }
+        }
+        // All entries of a changed key give way to its single new entry, which the loops emit in order
+        if (change != changes.end() && change->first == pair.first) {
+            continue;
+        }
+        merged.push_back(pair);
+    }
+    for (; change != changes.end(); change++) {
+        if (change->second) {
+            merged.emplace_back(change->first, *change->second);
+        }
+    }
+    pairs = std::move(merged);
+}
+
+/**
+ * Reads the pairs of a saved ALEX or PGM index and replays the logged mutations of its table onto them, if the
+ * table has not changed otherwise. Runs on the first use of the index, so it records the outcome, see recordRestore,
+ * instead of throwing. A read-only PGM index takes no mutations, and the log holds values rather than the row ids
+ * the INTEGER indexes map keys to, so these are only restored if their table has not changed at all.
+*/
+template<typename K>
+bool readRestoredPairs(weak_ptr<DatabaseInstance> db, const string &directory, const LearnedIndexManifestEntry &entry,
+                       std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> &pairs) {
+    auto instance = db.lock();
+    if (!instance) {
+        return false;
+    }
+    bool read_only = entry.kind == "pgm" && entry.option > 0;
+    idx_t replayed_changes = 0;
+    try {
+        duckdb::Connection con(*instance);
+        std::vector<LearnedIndexLog::Record> mutations;
+        string error;
+        if (!getLoggedMutations(entry, mutations, error)) {
+            recordRestore(entry, false, error);
+            return false;
+        }
+        if (!isRestoredIndexCurrent(con, entry, mutations)) {
+            recordRestore(entry, false, "the table changed since the index was saved, please create it again");
+            return false;
+        }
+        if (!mutations.empty() && read_only) {
+            recordRestore(entry, false, "a read-only PGM index can not take the changes made since it was saved, "
+                                        "please create it again");
+            return false;
+        }
+        if (!mutations.empty() && entry.key_type == "int") {
+            recordRestore(entry, false, "the log holds no row ids for the INTEGER changes made since the index was "
+                                        "saved, please create it again");
+            return false;
+        }
+        if (!LearnedIndexSidecar::ReadPairs(directory + "/" + entry.file_name, &pairs, &error)) {
+            recordRestore(entry, false, error);
+            return false;
+        }
+        mutations.erase(std::remove_if(mutations.begin(), mutations.end(),
+                                       [&entry](auto const& mutation) { return mutation.key_type != entry.key_type; }),
+                        mutations.end());
+        replayLoggedMutations<K>(pairs, mutations, entry.kind == "pgm");
+        replayed_changes = mutations.size();
+    } catch (std::exception &e) {
+        recordRestore(entry, false, e.what());
+        return false;
+    }
+    recordRestore(entry, true, "", replayed_changes);
+    return true;
+}
+
+/**
+ * Makes the ALEX or PGM index of the manifest entry load itself from the sidecar on first use.
+*/
+template<typename K>
+void registerLearnedIndexRestore(weak_ptr<DatabaseInstance> db, const string &directory, const LearnedIndexManifestEntry &entry) {
+    auto indexes = getLearnedIndexes<K>();
+    setIndexedTable(entry.key_type,entry.table_name,entry.column_name);
+    if (entry.kind == "alex") {
+        indexes.alex_index.SetLoader([db, directory, entry]() -> std::shared_ptr<ShardedAlex<K,INDEX_PAYLOAD_TYPE>> {
+            std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> pairs;
+            if (!readRestoredPairs<K>(db, directory, entry, pairs)) {
+                return nullptr;
+            }
+            // The option is the number of shards, 0 for indexes saved before every ALEX index had one
+            return std::make_shared<ShardedAlex<K,INDEX_PAYLOAD_TYPE>>(pairs.data(), pairs.size(),
+                                                                      std::max<uint64_t>(entry.option, 1));
+        });
+    } else if (entry.kind == "pgm" && entry.option > 0) {
+        indexes.static_pgm_index.SetLoader([db, directory, entry]() -> std::shared_ptr<StaticPGMIndex<K,INDEX_PAYLOAD_TYPE>> {
+            std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> pairs;
+            if (!readRestoredPairs<K>(db, directory, entry, pairs)) {
+                return nullptr;
+            }
+            return std::make_shared<StaticPGMIndex<K,INDEX_PAYLOAD_TYPE>>(pairs.begin(), pairs.end(), entry.option);
+        });
+    } else if (entry.kind == "pgm") {
+        indexes.pgm_index.SetLoader([db, directory, entry]() -> std::shared_ptr<pgm::DynamicPGMIndex<K,INDEX_PAYLOAD_TYPE>> {
+            std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> pairs;
+            if (!readRestoredPairs<K>(db, directory, entry, pairs)) {
+                return nullptr;
+            }
+            auto index = std::make_shared<pgm::DynamicPGMIndex<K,INDEX_PAYLOAD_TYPE>>(pairs.begin(), pairs.end());
+            getLearnedIndexes<K>().pgm_memory.Set(index->size_in_bytes());
+            return index;
+        });
+    }
+}
+
+/**
+ * Reads the manifest of the sidecar of the database and registers its indexes for restoring on first use.
+ * Called when the extension is loaded.
+*/
+void registerLearnedIndexRestores(DatabaseInstance &instance) {
+    string directory = getSidecarDirectory(instance);
+    if (directory.empty()) {
+        return;
+    }
+    std::vector<LearnedIndexManifestEntry> entries;
+    uint64_t generation = 0;
+    string error;
+    if (!LearnedIndexSidecar::ReadManifest(directory, &generation, &entries, &error)) {
+        std::cout << "Not restoring learned indexes: " << error << "\n";
+        return;
+    }
+    // Without a checkpoint there is nothing to replay mutations onto
+    if (generation == 0) {
+        return;
+    }
+    if (!learned_index_log.Open(directory, generation, &error)) {
+        std::cout << "Not logging learned index mutations: " << error << "\n";
+    }
+    weak_ptr<DatabaseInstance> db = instance.shared_from_this();
+    {
+        std::lock_guard<std::mutex> restores_guard(learned_index_restores_lock);
+        learned_index_restores.clear();
+    }
+    std::lock_guard<std::mutex> guard(radix_spline_restores_lock);
+    radix_spline_restores_directory = directory;
+    // The indexes of a key type that is restored start out empty, whatever another database left in them, so
+    // an index that turns out to be out of date is not replaced by a stale one
+    std::set<string> restored_key_types;
+    for (auto &entry : entries) {
+        if (entry.kind == "radixspline") {
+            pending_radix_spline_restores.push_back(entry);
+            continue;
+        }
+        bool first = restored_key_types.insert(entry.key_type).second;
+        if (entry.key_type == "double") {
+            if (first) {
+                clearLearnedIndexes<DOUBLE_KEY_TYPE>();
+            }
+            registerLearnedIndexRestore<DOUBLE_KEY_TYPE>(db, directory, entry);
+        } else if (entry.key_type == "bigint") {
+            if (first) {
+                clearLearnedIndexes<INT64_KEY_TYPE>();
+            }
+            registerLearnedIndexRestore<INT64_KEY_TYPE>(db, directory, entry);
+        } else if (entry.key_type == "ubigint") {
+            if (first) {
+                clearLearnedIndexes<UNSIGNED_INT64_KEY_TYPE>();
+            }
+            registerLearnedIndexRestore<UNSIGNED_INT64_KEY_TYPE>(db, directory, entry);
+        } else if (entry.key_type == "int") {
+            if (first) {
+                clearLearnedIndexes<INT_KEY_TYPE>();
+            }
+            registerLearnedIndexRestore<INT_KEY_TYPE>(db, directory, entry);
+        }
+    }
+}
+
+/**
+ * Applies the logged inserts and deletes of unsigned keys to a restored RadixSpline index, the way
+ * insert_into_table and delete_from_table maintain it.
+*/
+template <typename T>
+void replayLoggedMutations(rs::UpdatableRadixSpline<T> &index, const std::vector<LearnedIndexLog::Record> &mutations) {
+    for (auto &mutation : mutations) {
+        if (mutation.key_type != "ubigint") {
+            continue;
+        }
+        auto key = static_cast<T>(LearnedIndexLog::DecodeKey<UNSIGNED_INT64_KEY_TYPE>(mutation.key));
+        if (mutation.op == LearnedIndexLog::Op::kInsert) {
+            index.Insert(key);
+        } else if (mutation.op == LearnedIndexLog::Op::kErase) {
+            index.Erase(key);
+        }
+    }
+}
+
+void restorePendingRadixSplines(ClientContext &context) {
+    std::lock_guard<std::mutex> guard(radix_spline_restores_lock);
+    if (pending_radix_spline_restores.empty()) {
+        return;
+    }
+    auto entries = std::move(pending_radix_spline_restores);
+    pending_radix_spline_restores.clear();
+    duckdb::Connection con(*context.db);
+    for (auto &entry : entries) {
+        auto qname = QualifiedName::Parse(entry.table_name);
+        string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + entry.column_name;
+        // Indexes created since the start win over the saved ones
+        if (findRadixSpline(radix_spline_map_int64, map_key) || findRadixSpline(radix_spline_map_int32, map_key)) {
+            continue;
+        }
+        std::vector<LearnedIndexLog::Record> mutations;
+        string error;
+        if (!getLoggedMutations(entry, mutations, error)) {
+            recordRestore(entry, false, error);
+            continue;
+        }
+        if (!isRestoredIndexCurrent(con, entry, mutations)) {
+            recordRestore(entry, false, "the table changed since the index was saved, please create it again");
+            continue;
+        }
+        string path = radix_spline_restores_directory + "/" + entry.file_name;
+        bool loaded = false;
+        // The index is loaded on the side, so other connections never see it half restored
+        if (entry.key_type == "ubigint") {
+            auto restored = std::make_shared<RadixSplineEntry<uint64_t>>();
+            loaded = LoadRadixSpline<uint64_t>(path, *restored, &error);
+            if (loaded) {
+                replayLoggedMutations(restored->index, mutations);
+                addRadixSpline(radix_spline_map_int64, map_key, std::move(restored));
+            }
+        } else if (entry.key_type == "uinteger") {
+            auto restored = std::make_shared<RadixSplineEntry<uint32_t>>();
+            loaded = LoadRadixSpline<uint32_t>(path, *restored, &error);
+            if (loaded) {
+                replayLoggedMutations(restored->index, mutations);
+                addRadixSpline(radix_spline_map_int32, map_key, std::move(restored));
+            }
+        }
+        idx_t replayed_changes = std::count_if(mutations.begin(), mutations.end(),
+                                               [](auto const& mutation) {
+            return mutation.key_type == "ubigint" && mutation.op != LearnedIndexLog::Op::kUpdate;
+        });
+        recordRestore(entry, loaded, error, loaded ? replayed_changes : 0);
+    }
+    accountRadixSplineMemory();
+}
+
+/**
+ * Writes the pairs of an ALEX or PGM index to the sidecar and adds it to the manifest entries.
+*/
+template<typename K>
+void checkpointIndexPairs(const string &directory, uint64_t generation, LearnedIndexManifestEntry entry,
+                          const std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> &pairs,
+                          std::vector<LearnedIndexManifestEntry> &entries) {
+    if (pairs.empty()) {
+        return;
+    }
+    entry.file_name = LearnedIndexSidecar::DataFileName(entry.kind + "_" + entry.key_type, generation, ".lidx");
+    string error;
+    if (!LearnedIndexSidecar::WritePairs(directory + "/" + entry.file_name, pairs, &error)) {
+        throw IOException("Saving the %s index failed: %s", entry.kind, error);
+    }
+    std::cout << "Saved the " << entry.kind << " index on " << entry.table_name << "." << entry.column_name
+              << " with " << pairs.size() << " keys\n";
+    entries.push_back(entry);
+}
+
+/**
+ * Writes the ALEX and PGM index of a key type to the sidecar.
+*/
+template<typename K>
+void checkpointLearnedIndexes(duckdb::Connection &con, const string &directory, uint64_t generation, const string &key_type,
+                              std::vector<LearnedIndexManifestEntry> &entries) {
+    std::pair<string, string> table_column;
+    if (!getIndexedTable(key_type, table_column)) {
+        return;
+    }
+    LearnedIndexManifestEntry entry;
+    entry.key_type = key_type;
+    entry.table_name = table_column.first;
+    entry.column_name = table_column.second;
+    if (!getTableFingerprint(con, entry.table_name, entry.row_count, entry.fingerprint) ||
+        !getTableContentHash(con, entry.table_name, entry.row_count, entry.content_hash)) {
+        std::cout << "Table " << entry.table_name << " not found, not saving its learned indexes\n";
+        return;
+    }
+    auto indexes = getLearnedIndexes<K>();
+
+    std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> alex_pairs;
+    entry.kind = "alex";
+    entry.option = indexes.alex_index->num_shards();
+    indexes.alex_index.ReadExclusive([&alex_pairs](ShardedAlex<K,INDEX_PAYLOAD_TYPE> &index) {
+        index.for_each([&alex_pairs](const K &key, const INDEX_PAYLOAD_TYPE &payload) {
+            alex_pairs.emplace_back(key, payload);
+        });
+    });
+    checkpointIndexPairs(directory, generation, entry, alex_pairs, entries);
+
+    std::vector<std::pair<K,INDEX_PAYLOAD_TYPE>> pgm_pairs;
+    entry.kind = "pgm";
+    entry.option = indexes.static_pgm_index->epsilon();
+    if (entry.option > 0) {
+        auto index = indexes.static_pgm_index.Load();
+        pgm_pairs.assign(index->begin(), index->end());
+    } else {
+        indexes.pgm_index.ReadExclusive([&pgm_pairs](pgm::DynamicPGMIndex<K,INDEX_PAYLOAD_TYPE> &index) {
+            for (auto it = index.begin(); it != index.end(); ++it) {
+                pgm_pairs.emplace_back(it->first, it->second);
+            }
+        });
+    }
+    checkpointIndexPairs(directory, generation, entry, pgm_pairs, entries);
+}
+
+/**
+ * Writes a RadixSpline index to the sidecar and adds it to the manifest entries.
+*/
+template <typename T>
+void checkpointRadixSpline(duckdb::Connection &con, const string &directory, uint64_t generation, const string &key_type,
+                           const string &map_key, const rs::UpdatableRadixSpline<T> &index,
+                           std::vector<LearnedIndexManifestEntry> &entries) {
+    // The map key is catalog.schema.table.column
+    LearnedIndexManifestEntry entry;
+    entry.kind = "radixspline";
+    entry.key_type = key_type;
+    entry.column_name = map_key.substr(map_key.rfind('.') + 1);
+    string table_name = map_key.substr(0, map_key.rfind('.'));
+    try {
+        entry.table_name = getQualifiedTableName(*con.context, table_name);
+    } catch (CatalogException &e) {
+        std::cout << "Table " << table_name << " not found, not saving its RadixSpline index\n";
+        return;
+    }
+    if (!getTableFingerprint(con, entry.table_name, entry.row_count, entry.fingerprint) ||
+        !getTableContentHash(con, entry.table_name, entry.row_count, entry.content_hash)) {
+        std::cout << "Table " << entry.table_name << " not found, not saving its RadixSpline index\n";
+        return;
+    }
+    entry.file_name = LearnedIndexSidecar::DataFileName("radixspline_" + key_type + "_" + std::to_string(entries.size()),
+                                                        generation, ".rs");
+    string error;
+    if (!index.Save(directory + "/" + entry.file_name, &error)) {
+        throw IOException("Saving the RadixSpline index failed: %s", error);
+    }
+    std::cout << "Saved the RadixSpline index on " << map_key << "\n";
+    entries.push_back(entry);
+}
+
+/**
+ * Removes the index files of the sidecar that the manifest does not list: those of previous checkpoints, and
+ * those a checkpoint that crashed before its manifest was in place left behind.
+*/
+static void removeUnlistedSidecarFiles(FileSystem &fs, const string &directory, const std::vector<LearnedIndexManifestEntry> &entries) {
+    std::set<string> listed;
+    for (auto &entry : entries) {
+        listed.insert(entry.file_name);
+    }
+    std::vector<string> unlisted;
+    fs.ListFiles(directory, [&](const string &name, bool is_directory) {
+        if (!is_directory && LearnedIndexSidecar::IsDataFileName(name) && listed.find(name) == listed.end()) {
+            unlisted.push_back(name);
+        }
+    });
+    for (auto &name : unlisted) {
+        try {
+            fs.RemoveFile(fs.JoinPath(directory, name));
+        } catch (std::exception &e) {
+            std::cout << "Could not remove " << name << " from " << directory << ": " << e.what() << "\n";
+        }
+    }
+}
+
+/**
+ * PRAGMA checkpoint_learned_indexes writes all learned indexes to the sidecar directory next to the database
+ * file, from where they are restored after a restart. Run it while no writes are in flight: the tables and
+ * their learned indexes are not updated atomically.
+ * It reads every indexed table once, for the content hash that logged changes are checked against.
+ * Every checkpoint writes its index files under new names, then renames the manifest that lists them into place,
+ * and only then removes the files of the previous one. A crash at any point leaves the previous or the new
+ * manifest with all of its files.
+*/
+void functionCheckpointLearnedIndexes(ClientContext &context, const FunctionParameters &parameters) {
+    string directory = getSidecarDirectory(*context.db);
+    if (directory.empty()) {
+        throw InvalidInputException("Learned indexes of in-memory databases can not be saved");
+    }
+    std::lock_guard<std::mutex> guard(learned_index_checkpoint_lock);
+    waitForIndexBuilds();
+    restorePendingRadixSplines(context);
+    auto &fs = FileSystem::GetFileSystem(context);
+    if (!fs.DirectoryExists(directory)) {
+        fs.CreateDirectory(directory);
+    }
+
+    duckdb::Connection con(*context.db);
+    // Writes the tables to their final blocks, so that their fingerprints hold until they change again
+    auto checkpoint = con.Query("CHECKPOINT");
+    if (checkpoint->HasError()) {
+        std::cout << "Could not checkpoint the database, the saved indexes may not be restored: " << checkpoint->GetError()
+                  << "\n";
+    }
+
+    std::vector<LearnedIndexManifestEntry> previous_entries;
+    uint64_t generation = 0;
+    string error;
+    if (!LearnedIndexSidecar::ReadManifest(directory, &generation, &previous_entries, &error)) {
+        generation = 0;
+    }
+    generation = std::max(generation, learned_index_log.generation()) + 1;
+
+    std::vector<LearnedIndexManifestEntry> entries;
+    checkpointLearnedIndexes<DOUBLE_KEY_TYPE>(con, directory, generation, "double", entries);
+    checkpointLearnedIndexes<INT64_KEY_TYPE>(con, directory, generation, "bigint", entries);
+    checkpointLearnedIndexes<UNSIGNED_INT64_KEY_TYPE>(con, directory, generation, "ubigint", entries);
+    checkpointLearnedIndexes<INT_KEY_TYPE>(con, directory, generation, "int", entries);
+    for (auto &radix_spline : listRadixSplines(radix_spline_map_int64)) {
+        checkpointRadixSpline<uint64_t>(con, directory, generation, "ubigint", radix_spline.first, radix_spline.second->index,
+                                        entries);
+    }
+    for (auto &radix_spline : listRadixSplines(radix_spline_map_int32)) {
+        checkpointRadixSpline<uint32_t>(con, directory, generation, "uinteger", radix_spline.first, radix_spline.second->index,
+                                        entries);
+    }
+
+    // The new manifest makes the logged mutations part of the saved indexes, so the log starts over. A crash
+    // before the log is reset leaves a log of the previous generation behind, which is then ignored.
+    if (!LearnedIndexSidecar::WriteManifest(directory, generation, entries, &error)) {
+        throw IOException("Saving the learned index manifest failed: %s", error);
+    }
+    if (!learned_index_log.Reset(directory, generation, &error)) {
+        throw IOException("Resetting the learned index log failed: %s", error);
+    }
+    removeUnlistedSidecarFiles(fs, directory, entries);
+    std::cout << "Saved " << entries.size() << " learned indexes to " << directory << "\n";
+}
+
+void LoadRadixSplineIndexPragmaFunction(ClientContext &context, const FunctionParameters &parameters) {
+    restorePendingRadixSplines(context);
+    string table_name = parameters.values[0].GetValue<string>();
+    string column_name = parameters.values[1].GetValue<string>();
+    string path = parameters.values[2].GetValue<string>();
+
+    QualifiedName qname = GetQualifiedName(context, table_name);
+    string columnTypeName = getColumnTypeName(context, qname, column_name);
+    if (columnTypeName.empty()) {
+        std::cout << "Column '" << column_name << "' not found in table '" << table_name << "'.\n";
+        return;
+    }
+    string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + column_name;
+
+    // A background build may still write into the map entry
+    waitForIndexBuilds();
+
+    bool loaded = false;
+    string error;
+    // An existing index is replaced in place, a new one only added once it loaded
+    if (columnTypeName == "UBIGINT") {
+        auto existing = findRadixSpline(radix_spline_map_int64, map_key);
+        auto entry = existing ? existing : std::make_shared<RadixSplineEntry<uint64_t>>();
+        loaded = LoadRadixSpline<uint64_t>(path, *entry, &error);
+        if (loaded && !existing) {
+            addRadixSpline(radix_spline_map_int64, map_key, std::move(entry));
+        }
+    } else if (columnTypeName == "UINTEGER") {
+        auto existing = findRadixSpline(radix_spline_map_int32, map_key);
+        auto entry = existing ? existing : std::make_shared<RadixSplineEntry<uint32_t>>();
+        loaded = LoadRadixSpline<uint32_t>(path, *entry, &error);
+        if (loaded && !existing) {
+            addRadixSpline(radix_spline_map_int32, map_key, std::move(entry));
+        }
+    } else {
+        std::cout << "Unsupported column type '" << columnTypeName << "' for RadixSpline indexing.\n";
+        return;
+    }
+    accountRadixSplineMemory();
+    if (!loaded) {
+        throw IOException("Loading the RadixSpline index failed: %s", error);
+    }
+}
+
+/**
+ * Function to lookup a value using the RadixSpline index
+*/
+void RadixSplineLookupPragmaFunction(ClientContext &context, const FunctionParameters &parameters) {
+    restorePendingRadixSplines(context);
+    string table_name = parameters.values[0].GetValue<string>();
+    string column_name = parameters.values[1].GetValue<string>();
+    string lookup_key_str = parameters.values[2].GetValue<string>();
+
+    // Parse the lookup key
+    uint64_t lookup_key = std::stoull(lookup_key_str);
+
+    // Create the map key
+    QualifiedName qname = GetQualifiedName(context, table_name);
+    string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + column_name;
+
+    // Determine which RadixSpline map to use
+    auto index64 = findRadixSpline(radix_spline_map_int64, map_key);
+    auto index32 = findRadixSpline(radix_spline_map_int32, map_key);
+    if (index64) {
+        // Lookup in the uint64_t RadixSpline map
+        const auto &radix_spline = index64->index;
+        size_t estimated_position = radix_spline.GetEstimatedPosition(lookup_key);
+        std::cout << "Estimated position for key " << lookup_key << " is: " << estimated_position << std::endl;
+        std::cout << "Key " << lookup_key << (findInRadixSpline(radix_spline, *index64->cache.Load(), lookup_key) ? " found" : " not found") << " in the index" << std::endl;
+    } else if (index32) {
+        // Lookup in the uint32_t RadixSpline map
+        uint32_t lookup_key_32 = static_cast<uint32_t>(lookup_key);
+        const auto &radix_spline = index32->index;
+        size_t estimated_position = radix_spline.GetEstimatedPosition(lookup_key_32);
+        std::cout << "Estimated position for key " << lookup_key_32 << " is: " << estimated_position << std::endl;
+        std::cout << "Key " << lookup_key_32 << (findInRadixSpline(radix_spline, *index32->cache.Load(), lookup_key_32) ? " found" : " not found") << " in the index" << std::endl;
+    } else {
+        std::cout << "RadixSpline index not found for " << map_key << ". Please ensure you have created the index first." << std::endl;
+    }
+}
+
+/**
+ * Function to delete a RadixSpline index
+*/
+void DeleteRadixSplineIndexPragmaFunction(ClientContext &context, const FunctionParameters &parameters) {
+    restorePendingRadixSplines(context);
+    string table_name = parameters.values[0].GetValue<string>();
+    string column_name = parameters.values[1].GetValue<string>();
+
+    // Create the map key
+    QualifiedName qname = GetQualifiedName(context, table_name);
+    string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + column_name;
+
+    // A background build may still write into the map entry
+    waitForIndexBuilds();
+
+    // Determine which RadixSpline map to delete from
+    if (eraseRadixSpline(radix_spline_map_int64, map_key)) {
+        std::cout << "RadixSpline index deleted for " << map_key << ".\n";
+    } else if (eraseRadixSpline(radix_spline_map_int32, map_key)) {
+        std::cout << "RadixSpline index deleted for " << map_key << ".\n";
+    } else {
+        std::cout << "RadixSpline index not found for " << map_key << ".\n";
+    }
+    accountRadixSplineMemory();
+}
+
+/**
+ * Function to lookup range values using the RadixSpline index
+*/
+void RadixSplineRangeLookupPragmaFunction(ClientContext &context, const FunctionParameters &parameters) {
+    restorePendingRadixSplines(context);
+    string table_name = parameters.values[0].GetValue<string>();
+    string column_name = parameters.values[1].GetValue<string>();
+    string start_key_str = parameters.values[2].GetValue<string>();
+    string end_key_str = parameters.values[3].GetValue<string>();
+
+    // Parse the range keys
+    uint64_t start_key = std::stoull(start_key_str);
+    uint64_t end_key = std::stoull(end_key_str);
+
+    // Create the map key
+    QualifiedName qname = GetQualifiedName(context, table_name);
+    string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + column_name;
+
+    // Perform range lookup in the appropriate RadixSpline map
+    auto index64 = findRadixSpline(radix_spline_map_int64, map_key);
+    auto index32 = findRadixSpline(radix_spline_map_int32, map_key);
+    if (index64) {
+        const auto &radix_spline = index64->index;
+        size_t start_position = radix_spline.GetEstimatedPosition(start_key);
+        size_t end_position = radix_spline.GetEstimatedPosition(end_key);
+        std::cout << "Estimated positions for range (" << start_key << " - " << end_key << ") are: "
+                  << "start: " << start_position << ", end: " << end_position << std::endl;
+    } else if (index32) {
+        uint32_t start_key_32 = static_cast<uint32_t>(start_key);
+        uint32_t end_key_32 = static_cast<uint32_t>(end_key);
+        const auto &radix_spline = index32->index;
+        size_t start_position = radix_spline.GetEstimatedPosition(start_key_32);
+        size_t end_position = radix_spline.GetEstimatedPosition(end_key_32);
+        std::cout << "Estimated positions for range (" << start_key_32 << " - " << end_key_32 << ") are: "
+                  << "start: " << start_position << ", end: " << end_position << std::endl;
+    } else {
+        std::cout << "RadixSpline index not found for " << map_key << ". Please ensure you have created the index first." << std::endl;
+    }
+}
+
+/**
+ * Function for collecting the stats.
+*/
+void RadixSplineStatsPragmaFunction(ClientContext &context, const FunctionParameters &parameters) {
+    restorePendingRadixSplines(context);
+    string table_name = parameters.values[0].GetValue<string>();
+    string column_name = parameters.values[1].GetValue<string>();
+
+    // Create the map key
+    QualifiedName qname = GetQualifiedName(context, table_name);
+    string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + column_name;
+
+    // Determine which RadixSpline map to use
+    auto index64 = findRadixSpline(radix_spline_map_int64, map_key);
+    auto index32 = findRadixSpline(radix_spline_map_int32, map_key);
+    if (index64) {
+        const auto stats = getRadixSplineStats(*index64);
+        const auto &radix_spline = index64->index;
+        std::cout << "Statistics for RadixSpline index '" << map_key << "':\n";
+        std::cout << " - Number of keys: " << radix_spline.GetNumKeys() << " (" << stats.num_keys << " at build time)\n";
+        std::cout << " - Keys waiting in the delta buffer: " << radix_spline.GetDeltaSize() << "\n";
+        std::cout << " - Erased keys waiting for the next merge: " << radix_spline.GetTombstoneCount() << "\n";
+        std::cout << " - Size: " << radix_spline.GetSize() << " bytes" << (radix_spline.IsCompressed() ? " (compressed)" : "") << "\n";
+        if (radix_spline.IsTwoLevelRadixTable()) {
+            std::cout << " - Radix table prefixes with a second level: " << radix_spline.GetNumRefinedPrefixes() << "\n";
+        }
+        std::cout << " - Minimum key: " << stats.min_key << "\n";
+        std::cout << " - Maximum key: " << stats.max_key << "\n";
+        std::cout << " - Average gap between keys: " << stats.average_gap << "\n";
+    } else if (index32) {
+        const auto stats = getRadixSplineStats(*index32);
+        const auto &radix_spline = index32->index;
+        std::cout << "Statistics for RadixSpline index '" << map_key << "':\n";
+        std::cout << " - Number of keys: " << radix_spline.GetNumKeys() << " (" << stats.num_keys << " at build time)\n";
+        std::cout << " - Keys waiting in the delta buffer: " << radix_spline.GetDeltaSize() << "\n";
+        std::cout << " - Erased keys waiting for the next merge: " << radix_spline.GetTombstoneCount() << "\n";
+        std::cout << " - Size: " << radix_spline.GetSize() << " bytes" << (radix_spline.IsCompressed() ? " (compressed)" : "") << "\n";
+        if (radix_spline.IsTwoLevelRadixTable()) {
+            std::cout << " - Radix table prefixes with a second level: " << radix_spline.GetNumRefinedPrefixes() << "\n";
+        }
+        std::cout << " - Minimum key: " << stats.min_key << "\n";
+        std::cout << " - Maximum key: " << stats.max_key << "\n";
+        std::cout << " - Average gap between keys: " << stats.average_gap << "\n";
+    } else {
+        std::cout << "RadixSpline index not found for " << map_key << ". Please ensure you have created the index first.\n";
+    }
+}
+
+/**
+ * Load Benchmark Data into Table with Batching
+ * 
+ * Template function to load key-value pairs into DuckDB in batches.
+ * 
+ * @param keys - The keys to insert into the table.
+ * @param con - Connection to DuckDB.
+ * @param tableName - Name of the table to insert the data into.
+ * @param NUM_KEYS - Total number of keys.
+ * @param num_batches_insert - Number of batches.
+ * @param per_batch - Number of records per batch.
+ */
+template <typename K, typename P>
+void load_benchmark_data_into_table(const std::vector<K> &keys, duckdb::Connection &con, std::string tableName, int NUM_KEYS, int num_batches_insert, int per_batch) {
+    // This function will load key-value pairs into the table in batches
+    int starting = 0;
+    int ending = 0;
+
+    std::string query_prefix = "INSERT INTO " + tableName + " VALUES ";
+
+    for (int i = 0; i < num_batches_insert; i++) {
+        std::cout << "Inserting batch " << i << "\n";
+        
+        starting = i * per_batch;
+        ending = std::min(starting + per_batch, NUM_KEYS);
+        std::ostringstream tuple_stream;
+
+        // Generate batch insertion tuples
+        std::mt19937_64 gen_payload(std::random_device{}());
+
+        for (int vti = starting; vti < ending; vti++) {
+            K key = keys[vti];
+            P random_payload = static_cast<P>(gen_payload());
+
+            tuple_stream << "(" << key << ", " << random_payload << ")";
+            if (vti != ending - 1) {
+                tuple_stream << ",";
+            }
+        }
+
+        std::string to_execute_query = query_prefix + tuple_stream.str() + ";";
+        auto res = con.Query(to_execute_query);
+
+        if (!res->HasError()) {
+            std::cout << "Batch " << i << " inserted successfully.\n";
+        } else {
+            std::cerr << "Error inserting batch " << i << ": " << res->GetError() << "\n";
         }
     }
 
@@ -2549,122 +4584,1116 @@ void load_benchmark_data_into_table(const std::vector<K> &keys, duckdb::Connecti
 }
 
 /**
- * LoadBenchmarkFromFile - Loads data from a fixed binary file path into DuckDB and inserts in batches.
+ * LoadBenchmarkFromFile - Loads data from a fixed binary file path into DuckDB and inserts in batches.
+ *
+ * @param context - The ClientContext of the current DuckDB connection.
+ */
+void LoadBenchmarkFromFile(ClientContext &context, const FunctionParameters &parameters) {
+    // Fixed file path from which the data will be loaded
+    std::string file_path = "/Users/jishnusm/Desktop/classes/AdvancedDataStores/Project/Project2/radix/test/ycsb-200M.bin";
+
+    // Open the file for reading
+    std::ifstream infile(file_path, std::ios::binary);
+    if (!infile.is_open()) {
+        throw std::runtime_error("Failed to open file: " + file_path);
+    }
+
+    // Vector to hold the keys read from the binary file
+    std::vector<uint64_t> keys;
+
+    // Read the file content into the vector
+    uint64_t value;
+    while (infile.read(reinterpret_cast<char *>(&value), sizeof(uint64_t))) {
+        keys.push_back(value);
+    }
+
+    infile.close();
+
+    if (keys.empty()) {
+        throw std::runtime_error("The file is empty or there was an issue reading the file: " + file_path);
+    }
+
+    // Step to create a table in DuckDB and insert benchmark data
+    // Define the table name
+    std::string table_name = "benchmark_table_ycsb_200M";
+
+    // Create a connection using the ClientContext
+    duckdb::Connection con(*context.db);
+
+    // SQL query to create the table with two columns: 'key' and 'payload'
+    std::string create_query = "CREATE TABLE " + table_name + " (key UBIGINT, payload DOUBLE);";
+    con.Query(create_query);
+
+    // Load data into the table using batch insertion
+    int num_batches_insert = 1000; // Number of batches to insert
+    int per_batch = 1000; // Number of records per batch
+    int NUM_KEYS = keys.size();
+
+    load_benchmark_data_into_table<uint64_t, double>(keys, con, table_name, NUM_KEYS, num_batches_insert, per_batch);
+}
+
+/**
+ * Compares searching random keys in the RadixSpline index of a UBIGINT or UINTEGER column with searching them
+ * through DuckDB. The RadixSpline is probed directly. DuckDB runs a prepared point query per key with the key
+ * as a bound parameter, and, for every batch size, one prepared join per batch against the batch of keys bound
+ * as a list, so that neither includes parsing SQL.
+*/
+void functionSearchBenchmarkRadixSpline(ClientContext &context, const FunctionParameters &parameters) {
+    restorePendingRadixSplines(context);
+    std::string table_name = parameters.values[0].GetValue<string>();
+    std::string column_name = parameters.values[1].GetValue<string>();
+    int num_keys_to_search = parameters.values[2].GetValue<int>();
+    std::vector<int> batch_sizes = {100, 1000, 5000, 10000, 100000}; // Predefined batch sizes
+
+    duckdb::Connection con(*context.db);
+
+    QualifiedName qname = GetQualifiedName(context, table_name);
+    string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + column_name;
+    auto int64_spline = findRadixSpline(radix_spline_map_int64, map_key);
+    auto int32_spline = findRadixSpline(radix_spline_map_int32, map_key);
+    if (!int64_spline && !int32_spline) {
+        std::cout << "RadixSpline index not found for " << map_key << ". Please ensure you have created the index first." << std::endl;
+        return;
+    }
+
+    // Generate random keys to search
+    std::vector<uint64_t> keys(num_keys_to_search);
+    std::random_device rd;
+    std::mt19937_64 gen(rd()); // 64-bit random number generator
+    std::uniform_int_distribution<uint64_t> dist(1, UINT64_MAX); // Full uint64_t range
+    for (int i = 0; i < num_keys_to_search; ++i) {
+        keys[i] = dist(gen);
+    }
+
+    // Search keys using the RadixSpline index
+    idx_t radix_found = 0;
+    auto start_radix_search_time = std::chrono::high_resolution_clock::now();
+    if (int64_spline) {
+        auto cache = int64_spline->cache.Load();
+        for (uint64_t key : keys) {
+            radix_found += findInRadixSpline(int64_spline->index, *cache, key);
+        }
+    } else {
+        auto cache = int32_spline->cache.Load();
+        for (uint64_t key : keys) {
+            radix_found += key <= NumericLimits<uint32_t>::Maximum() &&
+                           findInRadixSpline(int32_spline->index, *cache, static_cast<uint32_t>(key));
+        }
+    }
+    auto end_radix_search_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> radix_search_duration = end_radix_search_time - start_radix_search_time;
+    std::cout << "RadixSpline search time: " << radix_search_duration.count() << " seconds (" << radix_found << " found)\n";
+
+    // Search keys in DuckDB, one prepared point query per key
+    auto point = con.Prepare("SELECT " + column_name + " FROM " + table_name + " WHERE " + column_name + " = $1");
+    if (point->HasError()) {
+        std::cerr << "Error preparing the DuckDB query: " << point->GetError() << "\n";
+        return;
+    }
+    idx_t duckdb_found = 0;
+    vector<Value> point_parameters(1);
+    auto start_duckdb_search_time = std::chrono::high_resolution_clock::now();
+    for (uint64_t key : keys) {
+        point_parameters[0] = Value::UBIGINT(key);
+        auto res = point->Execute(point_parameters, false);
+        if (res->HasError()) {
+            std::cerr << "Error querying DuckDB: " << res->GetError() << "\n";
+            return;
+        }
+        duckdb_found += res->Cast<MaterializedQueryResult>().RowCount() > 0;
+    }
+    auto end_duckdb_search_time = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> duckdb_search_duration = end_duckdb_search_time - start_duckdb_search_time;
+    std::cout << "DuckDB point query search time: " << duckdb_search_duration.count() << " seconds (" << duckdb_found << " found)\n\n";
+
+    // Search keys in DuckDB, one join per batch of keys
+    auto join = con.Prepare("SELECT count(*) FROM " + table_name + " JOIN (SELECT unnest($1::UBIGINT[]) AS search_key) ON " + column_name + " = search_key");
+    if (join->HasError()) {
+        std::cerr << "Error preparing the DuckDB query: " << join->GetError() << "\n";
+        return;
+    }
+    for (int batch_size : batch_sizes) {
+        std::cout << "Benchmarking batch size: " << batch_size << "\n";
+
+        // The lists of keys are made before the timing starts
+        std::vector<vector<Value>> batches;
+        for (int i = 0; i < num_keys_to_search; i += batch_size) {
+            vector<Value> batch_keys;
+            for (int j = i; j < std::min(i + batch_size, num_keys_to_search); ++j) {
+                batch_keys.push_back(Value::UBIGINT(keys[j]));
+            }
+            batches.push_back({Value::LIST(LogicalType::UBIGINT, std::move(batch_keys))});
+        }
+
+        idx_t batch_found = 0;
+        auto start_batch_search_time = std::chrono::high_resolution_clock::now();
+        for (auto &batch : batches) {
+            auto res = join->Execute(batch, false);
+            if (res->HasError()) {
+                std::cerr << "Error querying DuckDB: " << res->GetError() << "\n";
+                return;
+            }
+            batch_found += res->Cast<MaterializedQueryResult>().GetValue(0, 0).GetValue<int64_t>();
+        }
+        auto end_batch_search_time = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> batch_search_duration = end_batch_search_time - start_batch_search_time;
+
+        // Compare performance
+        std::cout << "Performance comparison for batch size " << batch_size << ":\n";
+        std::cout << " - DuckDB batched join search time: " << batch_search_duration.count() << " seconds (" << batch_found << " found)\n";
+        std::cout << " - DuckDB point query search time: " << duckdb_search_duration.count() << " seconds\n";
+        std::cout << " - RadixSpline search time: " << radix_search_duration.count() << " seconds\n";
+        std::cout << "\n";
+    }
+}
+
+/**
+ * Load Functions: 
+ * 
+*/
+/**
+ * learned_index_builds() lists the learned index builds of this session with their current phase and progress.
+*/
+struct LearnedIndexBuildsData : public GlobalTableFunctionState {
+    std::vector<IndexBuildProgress> builds;
+    idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> LearnedIndexBuildsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                       vector<LogicalType> &return_types, vector<string> &names) {
+    names = {"index_type", "table_name", "column_name", "key_type", "background", "phase", "progress", "elapsed_seconds", "error"};
+    return_types = {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::BOOLEAN,
+                    LogicalType::VARCHAR, LogicalType::DOUBLE, LogicalType::DOUBLE, LogicalType::VARCHAR};
+    return nullptr;
+}
+
+static unique_ptr<GlobalTableFunctionState> LearnedIndexBuildsInit(ClientContext &context, TableFunctionInitInput &input) {
+    auto state = make_uniq<LearnedIndexBuildsData>();
+    std::lock_guard<std::mutex> guard(index_builds_lock);
+    for (auto &build : index_builds) {
+        state->builds.push_back(*build);
+    }
+    return std::move(state);
+}
+
+static void LearnedIndexBuildsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &state = data_p.global_state->Cast<LearnedIndexBuildsData>();
+    auto now = std::chrono::steady_clock::now();
+    idx_t count = 0;
+    while (state.offset < state.builds.size() && count < STANDARD_VECTOR_SIZE) {
+        auto &build = state.builds[state.offset++];
+        bool finished = build.phase == "published" || build.phase == "failed";
+        std::chrono::duration<double> elapsed = (finished ? build.end_time : now) - build.start_time;
+        output.SetValue(0, count, Value(build.index_type));
+        output.SetValue(1, count, Value(build.table_name));
+        output.SetValue(2, count, Value(build.column_name));
+        output.SetValue(3, count, Value(build.key_type));
+        output.SetValue(4, count, Value::BOOLEAN(build.background));
+        output.SetValue(5, count, Value(build.phase));
+        output.SetValue(6, count, Value::DOUBLE(build.fraction));
+        output.SetValue(7, count, Value::DOUBLE(elapsed.count()));
+        output.SetValue(8, count, build.error.empty() ? Value() : Value(build.error));
+        count++;
+    }
+    output.SetCardinality(count);
+}
+
+/**
+ * PRAGMA wait_learned_index_builds blocks until all background index builds have been published.
+*/
+void functionWaitLearnedIndexBuilds(ClientContext &context, const FunctionParameters &parameters){
+    waitForIndexBuilds();
+}
+
+/**
+ * learned_index_lookup(table, column, key) looks a key up in every learned index on a column and returns a row per
+ * index: whether it holds the key, and the payload it returns. RadixSpline indexes only hold keys, so their payload
+ * is NULL. Unlike the lookup pragmas it returns its result, e.g. to check indexes against the table with SQL.
+*/
+struct LearnedIndexLookupBindData : public TableFunctionData {
+    string table_name;
+    string column_name;
+    string column_type;
+    Value key;
+};
+
+struct LearnedIndexLookupRow {
+    string index_type;
+    bool found;
+    Value payload;
+};
+
+struct LearnedIndexLookupData : public GlobalTableFunctionState {
+    std::vector<LearnedIndexLookupRow> rows;
+    idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> LearnedIndexLookupBind(ClientContext &context, TableFunctionBindInput &input,
+                                                       vector<LogicalType> &return_types, vector<string> &names) {
+    auto bind_data = make_uniq<LearnedIndexLookupBindData>();
+    bind_data->table_name = input.inputs[0].GetValue<string>();
+    bind_data->column_name = input.inputs[1].GetValue<string>();
+    QualifiedName qname = GetQualifiedName(context, bind_data->table_name);
+    auto &table = Catalog::GetEntry<TableCatalogEntry>(context, qname.catalog, qname.schema, qname.name);
+    auto &columns = table.GetColumns();
+    if (!columns.ColumnExists(bind_data->column_name)) {
+        throw InvalidInputException("Column %s not found in table %s", bind_data->column_name, bind_data->table_name);
+    }
+    auto &column_type = columns.GetColumn(bind_data->column_name).Type();
+    bind_data->column_type = column_type.ToString();
+    bind_data->key = input.inputs[2].DefaultCastAs(column_type);
+    names = {"index_type", "found", "payload"};
+    return_types = {LogicalType::VARCHAR, LogicalType::BOOLEAN, LogicalType::DOUBLE};
+    return std::move(bind_data);
+}
+
+static void addLookupRow(LearnedIndexLookupData &state, const string &index_type, const INDEX_PAYLOAD_TYPE *payload){
+    state.rows.push_back({index_type, payload != nullptr, payload ? Value::DOUBLE(*payload) : Value()});
+}
+
+template<typename K>
+void lookupInLearnedIndexes(ClientContext &context, const LearnedIndexLookupBindData &bind_data, LearnedIndexLookupData &state){
+    if(!isIndexedColumn<K>(context, bind_data.table_name, bind_data.column_name)){
+        return;
+    }
+    K key = bind_data.key.GetValue<K>();
+    auto indexes = getLearnedIndexes<K>();
+    INDEX_PAYLOAD_TYPE payload;
+    auto alex_index = indexes.alex_index.Load();
+    if (alex_index->num_shards() > 0) {
+        bool found = findInAlex(*alex_index, *indexes.alex_cache.Load(), key, &payload);
+        addLookupRow(state, "alex", found ? &payload : nullptr);
+    }
+    auto static_index = indexes.static_pgm_index.Load();
+    auto dynamic_index = indexes.pgm_index.Load();
+    if (static_index->size() > 0) {
+        bool found = findInPgm(*static_index, *indexes.pgm_cache.Load(), key, &payload);
+        addLookupRow(state, "pgm_static", found ? &payload : nullptr);
+    } else if (dynamic_index->size() > 0) {
+        bool found = findInPgm(*dynamic_index, *indexes.pgm_cache.Load(), key, &payload);
+        addLookupRow(state, "pgm", found ? &payload : nullptr);
+    }
+}
+
+template<typename T>
+void lookupInRadixSpline(const string &map_key, const RadixSplineMap<T> &index_map, T key, LearnedIndexLookupData &state){
+    auto entry = findRadixSpline(index_map, map_key);
+    if (entry) {
+        state.rows.push_back({"radixspline", findInRadixSpline(entry->index, *entry->cache.Load(), key), Value()});
+    }
+}
+
+static unique_ptr<GlobalTableFunctionState> LearnedIndexLookupInit(ClientContext &context, TableFunctionInitInput &input) {
+    auto &bind_data = input.bind_data->Cast<LearnedIndexLookupBindData>();
+    auto state = make_uniq<LearnedIndexLookupData>();
+    const string &type = bind_data.column_type;
+    if (type == "DOUBLE") {
+        lookupInLearnedIndexes<DOUBLE_KEY_TYPE>(context, bind_data, *state);
+    } else if (type == "BIGINT") {
+        lookupInLearnedIndexes<INT64_KEY_TYPE>(context, bind_data, *state);
+    } else if (type == "UBIGINT") {
+        lookupInLearnedIndexes<UNSIGNED_INT64_KEY_TYPE>(context, bind_data, *state);
+    } else if (type == "INTEGER") {
+        lookupInLearnedIndexes<INT_KEY_TYPE>(context, bind_data, *state);
+    }
+    if (type == "UBIGINT" || type == "UINTEGER") {
+        restorePendingRadixSplines(context);
+        QualifiedName qname = GetQualifiedName(context, bind_data.table_name);
+        string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + bind_data.column_name;
+        if (type == "UBIGINT") {
+            lookupInRadixSpline<uint64_t>(map_key, radix_spline_map_int64, bind_data.key.GetValue<uint64_t>(), *state);
+        } else {
+            lookupInRadixSpline<uint32_t>(map_key, radix_spline_map_int32, bind_data.key.GetValue<uint32_t>(), *state);
+        }
+    }
+    if (state->rows.empty()) {
+        throw InvalidInputException("There is no learned index on %s.%s, please create it first", bind_data.table_name,
+                                    bind_data.column_name);
+    }
+    return std::move(state);
+}
+
+static void LearnedIndexLookupFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &state = data_p.global_state->Cast<LearnedIndexLookupData>();
+    idx_t count = 0;
+    while (state.offset < state.rows.size() && count < STANDARD_VECTOR_SIZE) {
+        auto &row = state.rows[state.offset++];
+        output.SetValue(0, count, Value(row.index_type));
+        output.SetValue(1, count, Value::BOOLEAN(row.found));
+        output.SetValue(2, count, row.payload);
+        count++;
+    }
+    output.SetCardinality(count);
+}
+
+/**
+ * learned_index_benchmark(table, column) runs batches of point lookups against the learned index of the column and
+ * returns a row per batch, plus a row with a NULL batch over all of them, so that runs can be stored and compared
+ * with SQL. Named parameters: index := 'alex' (default), 'pgm' or 'radixspline', batches := N, batch_size := N and
+ * distribution := 'uniform' (default) or 'zipf' for the lookup keys, which are drawn from the column.
  *
- * @param context - The ClientContext of the current DuckDB connection.
- */
-void LoadBenchmarkFromFile(ClientContext &context, const FunctionParameters &parameters) {
-    // Fixed file path from which the data will be loaded
-    std::string file_path = "/Users/jishnusm/Desktop/classes/AdvancedDataStores/Project/Project2/radix/test/ycsb-200M.bin";
+ * The throughput comes from a pass over the batch as a whole, the latency percentiles from a second pass that
+ * times every lookup on its own into a LatencyHistogram, which adds the cost of reading the clock to them. Where
+ * perf events are available, the first pass also counts cycles, instructions, LLC, dTLB and branch misses per
+ * lookup, see perf_counters.h; perf_counters := false turns that off, and the counts are NULL without them.
+*/
+struct LearnedIndexBenchmarkBindData : public TableFunctionData {
+    string table_name;
+    string column_name;
+    idx_t column_index = 0;
+    string column_type;
+    string index = "alex";
+    idx_t batches = 10;
+    idx_t batch_size = 100000;
+    string distribution = "uniform";
+    bool perf_counters = true;
+};
 
-    // Open the file for reading
-    std::ifstream infile(file_path, std::ios::binary);
-    if (!infile.is_open()) {
-        throw std::runtime_error("Failed to open file: " + file_path);
+struct LearnedIndexBenchmarkBatch {
+    Value batch;
+    idx_t lookups = 0;
+    idx_t found = 0;
+    double seconds = 0;
+    LatencyHistogram latencies;
+    PerfCounters::Sample counters;
+};
+
+struct LearnedIndexBenchmarkData : public GlobalTableFunctionState {
+    std::vector<LearnedIndexBenchmarkBatch> batches;
+    idx_t index_size = 0;
+    Value build_seconds;
+    idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> LearnedIndexBenchmarkBind(ClientContext &context, TableFunctionBindInput &input,
+                                                          vector<LogicalType> &return_types, vector<string> &names) {
+    auto bind_data = make_uniq<LearnedIndexBenchmarkBindData>();
+    bind_data->table_name = input.inputs[0].GetValue<string>();
+    bind_data->column_name = input.inputs[1].GetValue<string>();
+    for (auto &entry : input.named_parameters) {
+        if (entry.first == "index") {
+            bind_data->index = StringUtil::Lower(entry.second.GetValue<string>());
+        } else if (entry.first == "batches") {
+            bind_data->batches = entry.second.GetValue<idx_t>();
+        } else if (entry.first == "batch_size") {
+            bind_data->batch_size = entry.second.GetValue<idx_t>();
+        } else if (entry.first == "distribution") {
+            bind_data->distribution = StringUtil::Lower(entry.second.GetValue<string>());
+        } else if (entry.first == "perf_counters") {
+            bind_data->perf_counters = BooleanValue::Get(entry.second);
+        }
+    }
+    if (bind_data->index != "alex" && bind_data->index != "pgm" && bind_data->index != "radixspline") {
+        throw InvalidInputException("index must be 'alex', 'pgm' or 'radixspline'");
+    }
+    if (bind_data->distribution != "uniform" && bind_data->distribution != "zipf") {
+        throw InvalidInputException("distribution must be 'uniform' or 'zipf'");
+    }
+    if (bind_data->batches == 0 || bind_data->batch_size == 0 || bind_data->batch_size > NumericLimits<int32_t>::Maximum()) {
+        throw InvalidInputException("batches and batch_size must be positive, and batch_size fit an INTEGER");
     }
 
-    // Vector to hold the keys read from the binary file
-    std::vector<uint64_t> keys;
+    QualifiedName qname = GetQualifiedName(context, bind_data->table_name);
+    auto &table = Catalog::GetEntry<TableCatalogEntry>(context, qname.catalog, qname.schema, qname.name);
+    auto &columns = table.GetColumns();
+    if (!columns.ColumnExists(bind_data->column_name)) {
+        throw InvalidInputException("Column %s not found in table %s", bind_data->column_name, bind_data->table_name);
+    }
+    auto &column = columns.GetColumn(bind_data->column_name);
+    bind_data->column_index = column.Logical().index;
+    bind_data->column_type = column.Type().ToString();
+
+    names = {"index_type", "table_name", "column_name", "key_type", "batch", "lookups", "found", "seconds",
+             "lookups_per_second", "mean_ns", "p50_ns", "p90_ns", "p99_ns", "p999_ns", "max_ns", "index_size_bytes",
+             "build_seconds"};
+    for (int event = 0; event < PerfCounters::kNumEvents; event++) {
+        names.push_back(string(PerfCounters::GetName(static_cast<PerfCounters::Event>(event))) + "_per_lookup");
+    }
+    return_types = {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR,
+                    LogicalType::BIGINT,  LogicalType::BIGINT,  LogicalType::BIGINT,  LogicalType::DOUBLE,
+                    LogicalType::DOUBLE,  LogicalType::DOUBLE,  LogicalType::UBIGINT, LogicalType::UBIGINT,
+                    LogicalType::UBIGINT, LogicalType::UBIGINT, LogicalType::UBIGINT, LogicalType::UBIGINT,
+                    LogicalType::DOUBLE};
+    return_types.resize(names.size(), LogicalType::DOUBLE);
+    return std::move(bind_data);
+}
 
-    // Read the file content into the vector
-    uint64_t value;
-    while (infile.read(reinterpret_cast<char *>(&value), sizeof(uint64_t))) {
-        keys.push_back(value);
+/**
+ * Runs the lookup batches of the benchmark with lookup(key) returning whether the key was found. The lookup keys
+ * of a batch are drawn before it is timed, with get_search_keys or get_search_keys_zipf.
+*/
+template<typename K, typename Lookup>
+void runLookupBatches(const LearnedIndexBenchmarkBindData &bind_data, std::vector<K> &keys, Lookup lookup,
+                              LearnedIndexBenchmarkData &state){
+    if(keys.empty()){
+        throw InvalidInputException("%s has no keys to look up", bind_data.table_name);
+    }
+    int num_keys = static_cast<int>(std::min<size_t>(keys.size(), NumericLimits<int32_t>::Maximum()));
+    int batch_size = static_cast<int>(bind_data.batch_size);
+    PerfCounters counters(bind_data.perf_counters);
+    LearnedIndexBenchmarkBatch total;
+    total.counters = PerfCounters::Sample::Total();
+    for(idx_t batch_no=0;batch_no<bind_data.batches;batch_no++){
+        std::unique_ptr<K[]> lookup_keys(bind_data.distribution == "zipf" ? get_search_keys_zipf(keys.data(), num_keys, batch_size)
+                                                                          : get_search_keys(keys.data(), num_keys, batch_size));
+        LearnedIndexBenchmarkBatch batch;
+        batch.batch = Value::BIGINT(batch_no);
+        batch.lookups = batch_size;
+        counters.Start();
+        auto start = std::chrono::steady_clock::now();
+        for(int i=0;i<batch_size;i++){
+            batch.found += lookup(lookup_keys[i]);
+        }
+        batch.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        batch.counters = counters.Stop();
+        for(int i=0;i<batch_size;i++){
+            auto lookup_start = std::chrono::steady_clock::now();
+            lookup(lookup_keys[i]);
+            auto lookup_end = std::chrono::steady_clock::now();
+            batch.latencies.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(lookup_end - lookup_start).count());
+        }
+        total.lookups += batch.lookups;
+        total.found += batch.found;
+        total.seconds += batch.seconds;
+        total.latencies.Merge(batch.latencies);
+        total.counters.Add(batch.counters);
+        state.batches.push_back(std::move(batch));
     }
+    state.batches.push_back(std::move(total));
+}
 
-    infile.close();
+/**
+ * Benchmarks the ALEX or PGM index of the key type, which has to be built on the benchmarked column.
+*/
+template<typename K>
+void runLearnedIndexBenchmark(ClientContext &context, duckdb::Connection &con, const LearnedIndexBenchmarkBindData &bind_data,
+                              LearnedIndexBenchmarkData &state){
+    if(!isIndexedColumn<K>(context, bind_data.table_name, bind_data.column_name)){
+        throw InvalidInputException("There is no learned index on %s.%s, please create it first", bind_data.table_name,
+                                    bind_data.column_name);
+    }
+    std::vector<K> keys = scanKeys<K>(con, bind_data.table_name, bind_data.column_index);
+    auto indexes = getLearnedIndexes<K>();
+    if(bind_data.index == "alex"){
+        // Hold on to the version of the index measured, even if a rebuild publishes a new one meanwhile
+        auto alex_index = indexes.alex_index.Load();
+        auto cache = indexes.alex_cache.Load();
+        state.index_size = alex_index->model_size() + alex_index->data_size();
+        runLookupBatches(bind_data, keys, [&alex_index, &cache](K key) {
+            INDEX_PAYLOAD_TYPE payload;
+            return findInAlex(*alex_index, *cache, key, &payload);
+        }, state);
+    } else {
+        auto static_index = indexes.static_pgm_index.Load();
+        auto dynamic_index = indexes.pgm_index.Load();
+        auto cache = indexes.pgm_cache.Load();
+        if(static_index->size()>0){
+            state.index_size = static_index->size_in_bytes();
+            runLookupBatches(bind_data, keys, [&static_index, &cache](K key) {
+                INDEX_PAYLOAD_TYPE payload;
+                return findInPgm(*static_index, *cache, key, &payload);
+            }, state);
+        } else {
+            state.index_size = dynamic_index->size_in_bytes();
+            runLookupBatches(bind_data, keys, [&dynamic_index, &cache](K key) {
+                INDEX_PAYLOAD_TYPE payload;
+                return findInPgm(*dynamic_index, *cache, key, &payload);
+            }, state);
+        }
+    }
+}
 
-    if (keys.empty()) {
-        throw std::runtime_error("The file is empty or there was an issue reading the file: " + file_path);
+/**
+ * Benchmarks the RadixSpline index of the benchmarked column.
+*/
+template<typename T>
+void runRadixSplineBenchmark(duckdb::Connection &con, const LearnedIndexBenchmarkBindData &bind_data, const string &map_key,
+                             const RadixSplineMap<T> &index_map, LearnedIndexBenchmarkData &state){
+    auto entry = findRadixSpline(index_map, map_key);
+    if(!entry){
+        throw InvalidInputException("There is no RadixSpline index on %s.%s, please create it first", bind_data.table_name,
+                                    bind_data.column_name);
     }
+    auto &index = entry->index;
+    auto cache = entry->cache.Load();
+    std::vector<T> keys = scanKeys<T>(con, bind_data.table_name, bind_data.column_index);
+    state.index_size = index.GetSize();
+    runLookupBatches(bind_data, keys, [&index, &cache](T key) {
+        return findInRadixSpline(index, *cache, key);
+    }, state);
+}
 
-    // Step to create a table in DuckDB and insert benchmark data
-    // Define the table name
-    std::string table_name = "benchmark_table_ycsb_200M";
+/**
+ * Returns how long the last finished build of the index type on the column took, or NULL if it was not built in
+ * this session, e.g. because it was restored.
+*/
+static Value getLastBuildSeconds(ClientContext &context, const string &index_type, const string &table_name, const string &column_name){
+    string qualified_table = getQualifiedTableName(context, table_name);
+    std::lock_guard<std::mutex> guard(index_builds_lock);
+    for(auto it = index_builds.rbegin(); it != index_builds.rend(); ++it){
+        auto &build = **it;
+        if(build.phase == "published" && StringUtil::StartsWith(build.index_type, index_type) &&
+           isSameTable(build.qualified_table_name, qualified_table) && StringUtil::CIEquals(build.column_name, column_name)){
+            return Value::DOUBLE(std::chrono::duration<double>(build.end_time - build.start_time).count());
+        }
+    }
+    return Value();
+}
 
-    // Create a connection using the ClientContext
+static unique_ptr<GlobalTableFunctionState> LearnedIndexBenchmarkInit(ClientContext &context, TableFunctionInitInput &input) {
+    auto &bind_data = input.bind_data->Cast<LearnedIndexBenchmarkBindData>();
+    auto state = make_uniq<LearnedIndexBenchmarkData>();
     duckdb::Connection con(*context.db);
+    const string &type = bind_data.column_type;
+    if (bind_data.index == "radixspline") {
+        restorePendingRadixSplines(context);
+        QualifiedName qname = GetQualifiedName(context, bind_data.table_name);
+        string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + bind_data.column_name;
+        if (type == "UBIGINT") {
+            runRadixSplineBenchmark<uint64_t>(con, bind_data, map_key, radix_spline_map_int64, *state);
+        } else if (type == "UINTEGER") {
+            runRadixSplineBenchmark<uint32_t>(con, bind_data, map_key, radix_spline_map_int32, *state);
+        } else {
+            throw InvalidInputException("Unsupported column type %s for RadixSpline indexing", type);
+        }
+    } else if (type == "DOUBLE") {
+        runLearnedIndexBenchmark<DOUBLE_KEY_TYPE>(context, con, bind_data, *state);
+    } else if (type == "BIGINT") {
+        runLearnedIndexBenchmark<INT64_KEY_TYPE>(context, con, bind_data, *state);
+    } else if (type == "UBIGINT") {
+        runLearnedIndexBenchmark<UNSIGNED_INT64_KEY_TYPE>(context, con, bind_data, *state);
+    } else if (type == "INTEGER") {
+        runLearnedIndexBenchmark<INT_KEY_TYPE>(context, con, bind_data, *state);
+    } else {
+        throw InvalidInputException("Unsupported column type %s for %s indexing", type, bind_data.index);
+    }
+    state->build_seconds = getLastBuildSeconds(context, bind_data.index, bind_data.table_name, bind_data.column_name);
+    return std::move(state);
+}
 
-    // SQL query to create the table with two columns: 'key' and 'payload'
-    std::string create_query = "CREATE TABLE " + table_name + " (key UBIGINT, payload DOUBLE);";
-    con.Query(create_query);
+static void LearnedIndexBenchmarkFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &bind_data = data_p.bind_data->Cast<LearnedIndexBenchmarkBindData>();
+    auto &state = data_p.global_state->Cast<LearnedIndexBenchmarkData>();
+    idx_t count = 0;
+    while (state.offset < state.batches.size() && count < STANDARD_VECTOR_SIZE) {
+        auto &batch = state.batches[state.offset++];
+        output.SetValue(0, count, Value(bind_data.index));
+        output.SetValue(1, count, Value(bind_data.table_name));
+        output.SetValue(2, count, Value(bind_data.column_name));
+        output.SetValue(3, count, Value(bind_data.column_type));
+        output.SetValue(4, count, batch.batch);
+        output.SetValue(5, count, Value::BIGINT(batch.lookups));
+        output.SetValue(6, count, Value::BIGINT(batch.found));
+        output.SetValue(7, count, Value::DOUBLE(batch.seconds));
+        output.SetValue(8, count, batch.seconds > 0 ? Value::DOUBLE(batch.lookups / batch.seconds) : Value());
+        output.SetValue(9, count, Value::DOUBLE(batch.latencies.mean()));
+        output.SetValue(10, count, Value::UBIGINT(batch.latencies.Percentile(50)));
+        output.SetValue(11, count, Value::UBIGINT(batch.latencies.Percentile(90)));
+        output.SetValue(12, count, Value::UBIGINT(batch.latencies.Percentile(99)));
+        output.SetValue(13, count, Value::UBIGINT(batch.latencies.Percentile(99.9)));
+        output.SetValue(14, count, Value::UBIGINT(batch.latencies.max()));
+        output.SetValue(15, count, Value::UBIGINT(state.index_size));
+        output.SetValue(16, count, state.build_seconds);
+        for (int event = 0; event < PerfCounters::kNumEvents; event++) {
+            auto counter = static_cast<PerfCounters::Event>(event);
+            output.SetValue(17 + event, count, batch.counters.Has(counter) && batch.lookups > 0
+                                                   ? Value::DOUBLE(batch.counters.Get(counter) / batch.lookups)
+                                                   : Value());
+        }
+        count++;
+    }
+    output.SetCardinality(count);
+}
 
-    // Load data into the table using batch insertion
-    int num_batches_insert = 1000; // Number of batches to insert
-    int per_batch = 1000; // Number of records per batch
-    int NUM_KEYS = keys.size();
+/**
+ * learned_index_stats(table, column) describes the structure of the learned indexes on a column, to tune them with.
+ * Every row is one statistic of one index; histograms are one row per bucket, with the bucket as [low, high):
+ *  - ALEX: the counters of get_stats, including the node expansions and splits, and from a walk over the keys, the
+ *    depth, fill factor and number of keys of the data nodes, and how far the model of a data node predicts its keys
+ *    from their slots, on average and per node at most. Empty data nodes are only part of num_data_nodes. Sharded
+ *    indexes add up their shards.
+ *  - PGM: the levels and segments of a static index. A dynamic index does not expose its levels, only its sizes.
+ *  - RadixSpline: the spline points and how many prefixes of the radix table hold one, of the base spline, and the
+ *    keys in the delta buffers.
+ * ALEX and PGM indexes that hold no keys have no rows.
+ * An index saved by checkpoint_learned_indexes also has a row restored, 1 if it was restored when it was first used
+ * and 0 with the reason in bucket if not, and when it was restored, restored_changes with the number of logged
+ * changes replayed onto it.
+*/
+struct LearnedIndexStatsBindData : public TableFunctionData {
+    string table_name;
+    string column_name;
+    string column_type;
+};
 
-    load_benchmark_data_into_table<uint64_t, double>(keys, con, table_name, NUM_KEYS, num_batches_insert, per_batch);
+struct LearnedIndexStat {
+    string index_type;
+    string statistic;
+    Value bucket;
+    double value;
+};
+
+struct LearnedIndexStatsData : public GlobalTableFunctionState {
+    std::vector<LearnedIndexStat> stats;
+    // Whether the column has a learned index, which may hold no keys
+    bool indexed = false;
+    idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> LearnedIndexStatsBind(ClientContext &context, TableFunctionBindInput &input,
+                                                      vector<LogicalType> &return_types, vector<string> &names) {
+    auto bind_data = make_uniq<LearnedIndexStatsBindData>();
+    bind_data->table_name = input.inputs[0].GetValue<string>();
+    bind_data->column_name = input.inputs[1].GetValue<string>();
+    QualifiedName qname = GetQualifiedName(context, bind_data->table_name);
+    auto &table = Catalog::GetEntry<TableCatalogEntry>(context, qname.catalog, qname.schema, qname.name);
+    auto &columns = table.GetColumns();
+    if (!columns.ColumnExists(bind_data->column_name)) {
+        throw InvalidInputException("Column %s not found in table %s", bind_data->column_name, bind_data->table_name);
+    }
+    bind_data->column_type = columns.GetColumn(bind_data->column_name).Type().ToString();
+    names = {"index_type", "statistic", "bucket", "value"};
+    return_types = {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::DOUBLE};
+    return std::move(bind_data);
 }
 
 /**
- * Function to check the insertion and compare with DuckDB
+ * Histogram bucket labels: [2^(i-1), 2^i) for power of two buckets, with 0 in a bucket of its own, and tenths for
+ * fractions.
 */
-void functionSearchBenchmarkRadixSpline(ClientContext &context, const FunctionParameters &parameters) {
-    std::string table_name = parameters.values[0].GetValue<string>();
-    std::string column_name = parameters.values[1].GetValue<string>();
-    int num_keys_to_search = parameters.values[2].GetValue<int>();
-    std::vector<int> batch_sizes = {100, 1000, 5000, 10000, 100000}; // Predefined batch sizes
+static idx_t powerOfTwoBucket(double value){
+    idx_t bucket = 0;
+    while (value >= 1 && bucket < 64) {
+        value /= 2;
+        bucket++;
+    }
+    return bucket;
+}
 
-    duckdb::Connection con(*context.db);
+static string powerOfTwoBucketLabel(idx_t bucket){
+    if (bucket == 0) {
+        return "[0, 1)";
+    }
+    return "[" + std::to_string(1ULL << (bucket - 1)) + ", " + std::to_string(1ULL << std::min<idx_t>(bucket, 63)) + ")";
+}
 
-    // Generate random keys to search
-    std::vector<uint64_t> keys(num_keys_to_search);
-    std::random_device rd;
-    std::mt19937_64 gen(rd()); // 64-bit random number generator
-    std::uniform_int_distribution<uint64_t> dist(1, UINT64_MAX); // Full uint64_t range
-    for (int i = 0; i < num_keys_to_search; ++i) {
-        keys[i] = dist(gen);
+static string tenthBucketLabel(idx_t bucket){
+    return StringUtil::Format("[%.1f, %.1f)", bucket / 10.0, (bucket + 1) / 10.0);
+}
+
+static void addStat(LearnedIndexStatsData &state, const string &index_type, const string &statistic, double value,
+                    Value bucket = Value()){
+    state.stats.push_back({index_type, statistic, std::move(bucket), value});
+}
+
+template <typename Label>
+static void addHistogram(LearnedIndexStatsData &state, const string &index_type, const string &statistic,
+                         const std::map<idx_t, idx_t> &histogram, Label label){
+    for (auto &entry : histogram) {
+        addStat(state, index_type, statistic, static_cast<double>(entry.second), Value(label(entry.first)));
     }
+}
 
-    // Iterate over batch sizes
-    for (int batch_size : batch_sizes) {
-        std::cout << "Benchmarking batch size: " << batch_size << "\n";
+/**
+ * What a walk over the keys of ALEX indexes finds out about their data nodes.
+*/
+struct AlexNodeStats {
+    idx_t data_nodes = 0;
+    idx_t keys = 0;
+    double error_sum = 0;
+    idx_t max_error = 0;
+    std::map<idx_t, idx_t> depths;
+    std::map<idx_t, idx_t> fill_factors;
+    std::map<idx_t, idx_t> sizes;
+    std::map<idx_t, idx_t> node_errors;
+};
 
-        // Search keys in DuckDB
-        auto start_duckdb_search_time = std::chrono::high_resolution_clock::now();
-        for (int i = 0; i < num_keys_to_search; i += batch_size) {
-            for (int j = i; j < std::min(i + batch_size, num_keys_to_search); ++j) {
-                std::string search_query =
-                    "SELECT " + column_name + " FROM " + table_name + " WHERE " + column_name + " = " + std::to_string(keys[j]) + ";";
-                auto res = con.Query(search_query);
-                if (res->HasError()) {
-                    std::cerr << "Error querying DuckDB: " << res->GetError() << "\n";
-                }
-            }
+template <typename Index>
+void addAlexNodeStats(const Index &index, AlexNodeStats &stats){
+    const void *leaf = nullptr;
+    idx_t node_max_error = 0;
+    auto finishNode = [&]() {
+        if (leaf) {
+            stats.node_errors[powerOfTwoBucket(node_max_error)]++;
+        }
+    };
+    for (auto it = index.cbegin(); it != index.cend(); it++) {
+        auto node = it.cur_leaf_;
+        if (node != leaf) {
+            finishNode();
+            leaf = node;
+            node_max_error = 0;
+            stats.data_nodes++;
+            stats.depths[node->level_]++;
+            stats.fill_factors[std::min<idx_t>(9, static_cast<idx_t>(10.0 * node->num_keys_ / node->data_capacity_))]++;
+            stats.sizes[powerOfTwoBucket(node->num_keys_)]++;
         }
-        auto end_duckdb_search_time = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> duckdb_search_duration = end_duckdb_search_time - start_duckdb_search_time;
-        std::cout << "DuckDB search time for batch size " << batch_size << ": " << duckdb_search_duration.count() << " seconds\n";
+        int predicted = node->predict_position(it.key());
+        idx_t error = static_cast<idx_t>(std::abs(predicted - it.cur_idx_));
+        node_max_error = std::max(node_max_error, error);
+        stats.max_error = std::max(stats.max_error, error);
+        stats.error_sum += error;
+        stats.keys++;
+    }
+    finishNode();
+}
 
-        // Search keys using RadixSpline index
-        auto start_radix_search_time = std::chrono::high_resolution_clock::now();
-        for (int i = 0; i < num_keys_to_search; i += batch_size) {
-            for (int j = i; j < std::min(i + batch_size, num_keys_to_search); ++j) {
-                std::string pragma_search_index = "PRAGMA lookup_radixspline_index('" + table_name + "', '" + column_name + "', '" +
-                                                  std::to_string(keys[j]) + "');";
-                auto res = con.Query(pragma_search_index);
-                if (res->HasError()) {
-                    std::cerr << "Error querying RadixSpline index: " << res->GetError() << "\n";
-                }
+template <typename Stats>
+void addAlexCounters(const Stats &from, std::map<string, double> &counters){
+    counters["num_keys"] += from.num_keys;
+    counters["num_model_nodes"] += from.num_model_nodes;
+    counters["num_data_nodes"] += from.num_data_nodes;
+    counters["num_expand_and_scales"] += from.num_expand_and_scales;
+    counters["num_expand_and_retrains"] += from.num_expand_and_retrains;
+    counters["num_downward_splits"] += from.num_downward_splits;
+    counters["num_sideways_splits"] += from.num_sideways_splits;
+    counters["num_model_node_expansions"] += from.num_model_node_expansions;
+    counters["num_model_node_splits"] += from.num_model_node_splits;
+}
+
+template<typename K>
+void addLearnedIndexStats(ClientContext &context, const LearnedIndexStatsBindData &bind_data, LearnedIndexStatsData &state){
+    if(!isIndexedColumn<K>(context, bind_data.table_name, bind_data.column_name)){
+        return;
+    }
+    state.indexed = true;
+    auto indexes = getLearnedIndexes<K>();
+
+    // Hold on to the versions of the indexes described, even if a rebuild publishes a new one meanwhile
+    auto alex_index = indexes.alex_index.Load();
+    std::map<string, double> counters;
+    AlexNodeStats node_stats;
+    double size_bytes = 0;
+    if (alex_index->size() > 0) {
+        alex_index->for_each_shard([&](const AlexIndex<K,INDEX_PAYLOAD_TYPE> &index) {
+            addAlexCounters(index.get_stats(), counters);
+            addAlexNodeStats(index, node_stats);
+        });
+        counters["num_shards"] = alex_index->num_shards();
+        size_bytes = alex_index->model_size() + alex_index->data_size();
+    }
+    if (!counters.empty()) {
+        const string type = "alex";
+        for (auto &counter : counters) {
+            addStat(state, type, counter.first, counter.second);
+        }
+        addStat(state, type, "size_bytes", size_bytes);
+        addStat(state, type, "mean_model_error", node_stats.keys > 0 ? node_stats.error_sum / node_stats.keys : 0);
+        addStat(state, type, "max_model_error", static_cast<double>(node_stats.max_error));
+        addHistogram(state, type, "data_node_depth", node_stats.depths, [](idx_t depth) { return std::to_string(depth); });
+        addHistogram(state, type, "data_node_fill_factor", node_stats.fill_factors, tenthBucketLabel);
+        addHistogram(state, type, "data_node_keys", node_stats.sizes, powerOfTwoBucketLabel);
+        addHistogram(state, type, "data_node_max_model_error", node_stats.node_errors, powerOfTwoBucketLabel);
+    }
+
+    auto static_index = indexes.static_pgm_index.Load();
+    auto dynamic_index = indexes.pgm_index.Load();
+    if (static_index->size() > 0) {
+        const string type = "pgm_static";
+        addStat(state, type, "num_keys", static_index->size());
+        addStat(state, type, "epsilon", static_index->epsilon());
+        addStat(state, type, "levels", static_index->height());
+        addStat(state, type, "segments", static_index->segments_count());
+        addStat(state, type, "index_size_bytes", static_index->index_size_in_bytes());
+        addStat(state, type, "size_bytes", static_index->size_in_bytes());
+    } else if (dynamic_index->size() > 0) {
+        const string type = "pgm";
+        addStat(state, type, "num_keys", dynamic_index->size());
+        addStat(state, type, "index_size_bytes", dynamic_index->index_size_in_bytes());
+        addStat(state, type, "size_bytes", dynamic_index->size_in_bytes());
+    }
+}
+
+template<typename T>
+void addRadixSplineStats(const string &map_key, const RadixSplineMap<T> &index_map, LearnedIndexStatsData &state){
+    auto entry = findRadixSpline(index_map, map_key);
+    if (!entry) {
+        return;
+    }
+    state.indexed = true;
+    auto &index = entry->index;
+    rs::SplineStats stats = index.GetStats();
+    const string type = "radixspline";
+    addStat(state, type, "num_keys", index.GetNumKeys());
+    addStat(state, type, "base_keys", stats.num_keys);
+    addStat(state, type, "delta_keys", index.GetDeltaSize());
+    addStat(state, type, "tombstones", index.GetTombstoneCount());
+    addStat(state, type, "spline_points", stats.num_spline_points);
+    addStat(state, type, "max_error", stats.max_error);
+    addStat(state, type, "radix_bits", stats.num_radix_bits);
+    addStat(state, type, "radix_slots", stats.num_radix_slots);
+    addStat(state, type, "used_radix_slots", stats.num_used_radix_slots);
+    addStat(state, type, "radix_table_occupancy",
+            stats.num_radix_slots > 1 ? static_cast<double>(stats.num_used_radix_slots) / (stats.num_radix_slots - 1) : 0);
+    addStat(state, type, "max_points_per_radix_slot", stats.max_points_per_radix_slot);
+    addStat(state, type, "refined_prefixes", index.GetNumRefinedPrefixes());
+    addStat(state, type, "compressed", index.IsCompressed() ? 1 : 0);
+    addStat(state, type, "size_bytes", index.GetSize());
+}
+
+static unique_ptr<GlobalTableFunctionState> LearnedIndexStatsInit(ClientContext &context, TableFunctionInitInput &input) {
+    auto &bind_data = input.bind_data->Cast<LearnedIndexStatsBindData>();
+    auto state = make_uniq<LearnedIndexStatsData>();
+    const string &type = bind_data.column_type;
+    if (type == "DOUBLE") {
+        addLearnedIndexStats<DOUBLE_KEY_TYPE>(context, bind_data, *state);
+    } else if (type == "BIGINT") {
+        addLearnedIndexStats<INT64_KEY_TYPE>(context, bind_data, *state);
+    } else if (type == "UBIGINT") {
+        addLearnedIndexStats<UNSIGNED_INT64_KEY_TYPE>(context, bind_data, *state);
+    } else if (type == "INTEGER") {
+        addLearnedIndexStats<INT_KEY_TYPE>(context, bind_data, *state);
+    }
+    if (type == "UBIGINT" || type == "UINTEGER") {
+        restorePendingRadixSplines(context);
+        // A background build may still write into the map entry
+        waitForIndexBuilds();
+        QualifiedName qname = GetQualifiedName(context, bind_data.table_name);
+        string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + bind_data.column_name;
+        if (type == "UBIGINT") {
+            addRadixSplineStats<uint64_t>(map_key, radix_spline_map_int64, *state);
+        } else {
+            addRadixSplineStats<uint32_t>(map_key, radix_spline_map_int32, *state);
+        }
+    }
+    // The stats above loaded the saved indexes of the column, if there are any
+    for (auto &restore : getRestores(getQualifiedTableName(context, bind_data.table_name), bind_data.column_name)) {
+        state->indexed = true;
+        addStat(*state, restore.index_type, "restored", restore.restored ? 1 : 0,
+                restore.restored ? Value() : Value(restore.reason));
+        if (restore.restored) {
+            addStat(*state, restore.index_type, "restored_changes", static_cast<double>(restore.replayed_changes));
+        }
+    }
+    if (!state->indexed) {
+        throw InvalidInputException("There is no learned index on %s.%s, please create it first", bind_data.table_name,
+                                    bind_data.column_name);
+    }
+    return std::move(state);
+}
+
+static void LearnedIndexStatsFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &state = data_p.global_state->Cast<LearnedIndexStatsData>();
+    idx_t count = 0;
+    while (state.offset < state.stats.size() && count < STANDARD_VECTOR_SIZE) {
+        auto &stat = state.stats[state.offset++];
+        output.SetValue(0, count, Value(stat.index_type));
+        output.SetValue(1, count, Value(stat.statistic));
+        output.SetValue(2, count, stat.bucket);
+        output.SetValue(3, count, Value::DOUBLE(stat.value));
+        count++;
+    }
+    output.SetCardinality(count);
+}
+
+/**
+ * learned_index_model_error(table, column, index := ..., sample := ...) compares the positions the models of the
+ * learned indexes on a column predict for their keys with the actual positions, to tell where tighter error bounds
+ * or another epsilon would pay off. Every row is either a bucket of the error histogram of an index, with segment
+ * NULL, or a segment of its model, with error_bucket NULL:
+ *  - RadixSpline: GetEstimatedPosition against the position in the base keys, per spline segment. error_bound is the
+ *    error the spline was built with, which every search bound widens by.
+ *  - ALEX: the predicted slot of a key in its data node against its slot, per data node. Searches in a data node are
+ *    exponential from the prediction, so there is no error_bound.
+ *  - PGM: the estimate of a static index against the position, with epsilon as error_bound. The library keeps the
+ *    segment of a key private, so there is only the histogram.
+ * sample profiles every (1 / sample)-th key only, for large indexes. Indexes that hold no keys have no rows.
+*/
+struct LearnedIndexModelErrorBindData : public TableFunctionData {
+    string table_name;
+    string column_name;
+    string column_type;
+    string index_type;
+    idx_t step = 1;
+};
+
+struct LearnedIndexModelErrorRow {
+    string index_type;
+    Value segment;
+    Value error_bucket;
+    idx_t keys;
+    Value max_error;
+    Value error_bound;
+};
+
+struct LearnedIndexModelErrorData : public GlobalTableFunctionState {
+    std::vector<LearnedIndexModelErrorRow> rows;
+    // Whether the column has a learned index, which may hold no keys
+    bool indexed = false;
+    idx_t offset = 0;
+};
+
+static unique_ptr<FunctionData> LearnedIndexModelErrorBind(ClientContext &context, TableFunctionBindInput &input,
+                                                           vector<LogicalType> &return_types, vector<string> &names) {
+    auto bind_data = make_uniq<LearnedIndexModelErrorBindData>();
+    bind_data->table_name = input.inputs[0].GetValue<string>();
+    bind_data->column_name = input.inputs[1].GetValue<string>();
+    double sample = 1;
+    for (auto &kv : input.named_parameters) {
+        if (kv.first == "index") {
+            bind_data->index_type = StringUtil::Lower(kv.second.GetValue<string>());
+            if (bind_data->index_type != "alex" && bind_data->index_type != "pgm" &&
+                bind_data->index_type != "radixspline") {
+                throw InvalidInputException("index must be one of alex, pgm or radixspline");
+            }
+        } else if (kv.first == "sample") {
+            sample = kv.second.GetValue<double>();
+            if (!(sample > 0 && sample <= 1)) {
+                throw InvalidInputException("sample must be in (0, 1]");
             }
         }
-        auto end_radix_search_time = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> radix_search_duration = end_radix_search_time - start_radix_search_time;
-        std::cout << "RadixSpline search time for batch size " << batch_size << ": " << radix_search_duration.count() << " seconds\n";
+    }
+    bind_data->step = std::max<idx_t>(1, static_cast<idx_t>(std::llround(1 / sample)));
+    QualifiedName qname = GetQualifiedName(context, bind_data->table_name);
+    auto &table = Catalog::GetEntry<TableCatalogEntry>(context, qname.catalog, qname.schema, qname.name);
+    auto &columns = table.GetColumns();
+    if (!columns.ColumnExists(bind_data->column_name)) {
+        throw InvalidInputException("Column %s not found in table %s", bind_data->column_name, bind_data->table_name);
+    }
+    bind_data->column_type = columns.GetColumn(bind_data->column_name).Type().ToString();
+    names = {"index_type", "segment", "error_bucket", "keys", "max_error", "error_bound"};
+    return_types = {LogicalType::VARCHAR, LogicalType::UBIGINT, LogicalType::VARCHAR, LogicalType::UBIGINT,
+                    LogicalType::UBIGINT, LogicalType::UBIGINT};
+    return std::move(bind_data);
+}
 
-        // Compare performance
-        std::cout << "Performance comparison for batch size " << batch_size << ":\n";
-        std::cout << " - DuckDB search time: " << duckdb_search_duration.count() << " seconds\n";
-        std::cout << " - RadixSpline search time: " << radix_search_duration.count() << " seconds\n";
-        std::cout << "\n";
+static bool profilesIndex(const LearnedIndexModelErrorBindData &bind_data, const string &index_type){
+    return bind_data.index_type.empty() || bind_data.index_type == index_type;
+}
+
+static void addModelErrorRows(LearnedIndexModelErrorData &state, const string &index_type, const rs::ErrorProfile &profile,
+                              Value error_bound, bool per_segment = true){
+    for (idx_t bucket = 0; bucket < profile.histogram.size(); bucket++) {
+        if (profile.histogram[bucket] > 0) {
+            state.rows.push_back({index_type, Value(), Value(powerOfTwoBucketLabel(bucket)), profile.histogram[bucket],
+                                  Value(), error_bound});
+        }
+    }
+    for (idx_t segment = 0; per_segment && segment < profile.segment_keys.size(); segment++) {
+        if (profile.segment_keys[segment] > 0) {
+            state.rows.push_back({index_type, Value::UBIGINT(segment), Value(), profile.segment_keys[segment],
+                                  Value::UBIGINT(profile.segment_max_errors[segment]), error_bound});
+        }
     }
 }
 
 /**
- * Load Functions: 
- * 
+ * Profiles the data nodes of an ALEX index, numbered on from `first_node` in key order.
 */
+template <typename Index>
+void profileAlexErrors(const Index &index, idx_t step, idx_t &first_node, rs::ErrorProfile &profile){
+    const void *leaf = nullptr;
+    idx_t node_number = first_node;
+    idx_t i = 0;
+    for (auto it = index.cbegin(); it != index.cend(); it++, i++) {
+        auto node = it.cur_leaf_;
+        if (node != leaf) {
+            node_number += leaf ? 1 : 0;
+            leaf = node;
+        }
+        if (i % step != 0) {
+            continue;
+        }
+        int predicted = node->predict_position(it.key());
+        profile.Add(node_number, static_cast<size_t>(std::abs(predicted - it.cur_idx_)));
+    }
+    first_node = leaf ? node_number + 1 : node_number;
+}
+
+template<typename K>
+void addLearnedIndexModelErrors(ClientContext &context, const LearnedIndexModelErrorBindData &bind_data, LearnedIndexModelErrorData &state){
+    if(!isIndexedColumn<K>(context, bind_data.table_name, bind_data.column_name)){
+        return;
+    }
+    state.indexed = true;
+    auto indexes = getLearnedIndexes<K>();
+
+    if (profilesIndex(bind_data, "alex")) {
+        auto alex_index = indexes.alex_index.Load();
+        rs::ErrorProfile profile;
+        idx_t first_node = 0;
+        alex_index->for_each_shard([&](const AlexIndex<K,INDEX_PAYLOAD_TYPE> &index) {
+            profileAlexErrors(index, bind_data.step, first_node, profile);
+        });
+        addModelErrorRows(state, "alex", profile, Value());
+    }
+
+    if (profilesIndex(bind_data, "pgm")) {
+        auto static_index = indexes.static_pgm_index.Load();
+        rs::ErrorProfile profile;
+        profile.max_error = static_index->epsilon();
+        idx_t position = 0;
+        for (auto it = static_index->begin(); it != static_index->end(); ++it, position++) {
+            if (position % bind_data.step != 0) {
+                continue;
+            }
+            size_t estimate = static_index->estimate_position(it->first);
+            profile.Add(0, estimate > position ? estimate - position : position - estimate);
+        }
+        addModelErrorRows(state, "pgm_static", profile, Value::UBIGINT(profile.max_error), false);
+    }
+}
+
+template<typename T>
+void addRadixSplineModelErrors(const string &map_key, const RadixSplineMap<T> &index_map, idx_t step,
+                               LearnedIndexModelErrorData &state){
+    auto entry = findRadixSpline(index_map, map_key);
+    if (!entry) {
+        return;
+    }
+    state.indexed = true;
+    rs::ErrorProfile profile = entry->index.ProfileErrors(step);
+    addModelErrorRows(state, "radixspline", profile, Value::UBIGINT(profile.max_error));
+}
+
+static unique_ptr<GlobalTableFunctionState> LearnedIndexModelErrorInit(ClientContext &context,
+                                                                       TableFunctionInitInput &input) {
+    auto &bind_data = input.bind_data->Cast<LearnedIndexModelErrorBindData>();
+    auto state = make_uniq<LearnedIndexModelErrorData>();
+    const string &type = bind_data.column_type;
+    if (type == "DOUBLE") {
+        addLearnedIndexModelErrors<DOUBLE_KEY_TYPE>(context, bind_data, *state);
+    } else if (type == "BIGINT") {
+        addLearnedIndexModelErrors<INT64_KEY_TYPE>(context, bind_data, *state);
+    } else if (type == "UBIGINT") {
+        addLearnedIndexModelErrors<UNSIGNED_INT64_KEY_TYPE>(context, bind_data, *state);
+    } else if (type == "INTEGER") {
+        addLearnedIndexModelErrors<INT_KEY_TYPE>(context, bind_data, *state);
+    }
+    if ((type == "UBIGINT" || type == "UINTEGER") && profilesIndex(bind_data, "radixspline")) {
+        restorePendingRadixSplines(context);
+        waitForIndexBuilds();
+        QualifiedName qname = GetQualifiedName(context, bind_data.table_name);
+        string map_key = qname.catalog + "." + qname.schema + "." + qname.name + "." + bind_data.column_name;
+        if (type == "UBIGINT") {
+            addRadixSplineModelErrors<uint64_t>(map_key, radix_spline_map_int64, bind_data.step, *state);
+        } else {
+            addRadixSplineModelErrors<uint32_t>(map_key, radix_spline_map_int32, bind_data.step, *state);
+        }
+    }
+    if (!state->indexed) {
+        throw InvalidInputException("There is no learned index on %s.%s, please create it first", bind_data.table_name,
+                                    bind_data.column_name);
+    }
+    return std::move(state);
+}
+
+static void LearnedIndexModelErrorFunction(ClientContext &context, TableFunctionInput &data_p, DataChunk &output) {
+    auto &state = data_p.global_state->Cast<LearnedIndexModelErrorData>();
+    idx_t count = 0;
+    while (state.offset < state.rows.size() && count < STANDARD_VECTOR_SIZE) {
+        auto &row = state.rows[state.offset++];
+        output.SetValue(0, count, Value(row.index_type));
+        output.SetValue(1, count, row.segment);
+        output.SetValue(2, count, row.error_bucket);
+        output.SetValue(3, count, Value::UBIGINT(row.keys));
+        output.SetValue(4, count, row.max_error);
+        output.SetValue(5, count, row.error_bound);
+        count++;
+    }
+    output.SetCardinality(count);
+}
+
 static void LoadInternal(DatabaseInstance &instance) {
     // Register a scalar function
     auto alex_scalar_function = ScalarFunction("alex", {LogicalType::VARCHAR}, LogicalType::VARCHAR, AlexScalarFun);
@@ -2675,10 +5704,69 @@ static void LoadInternal(DatabaseInstance &instance) {
                                                 LogicalType::VARCHAR, AlexOpenSSLVersionScalarFun);
     ExtensionUtil::RegisterFunction(instance, alex_openssl_version_scalar_function);
 
+    // background := true builds the index on a scheduler thread and returns right away.
     auto create_alex_index_function = PragmaFunction::PragmaCall("create_alex_index", createAlexIndexPragmaFunction, {LogicalType::VARCHAR, LogicalType::VARCHAR},{});
+    create_alex_index_function.named_parameters["background"] = LogicalType::BOOLEAN;
+    create_alex_index_function.named_parameters["shards"] = LogicalType::INTEGER;
     ExtensionUtil::RegisterFunction(instance, create_alex_index_function);
     auto create_pgm_index_function = PragmaFunction::PragmaCall("create_pgm_index", createPGMIndexPragmaFunction, {LogicalType::VARCHAR, LogicalType::VARCHAR},{});
+    create_pgm_index_function.named_parameters["background"] = LogicalType::BOOLEAN;
+    create_pgm_index_function.named_parameters["read_only"] = LogicalType::BOOLEAN;
+    create_pgm_index_function.named_parameters["epsilon"] = LogicalType::INTEGER;
     ExtensionUtil::RegisterFunction(instance, create_pgm_index_function);
+
+    // Progress of the learned index builds, and a pragma to wait for the background ones.
+    TableFunction learned_index_builds_function("learned_index_builds", {}, LearnedIndexBuildsFunction, LearnedIndexBuildsBind, LearnedIndexBuildsInit);
+    ExtensionUtil::RegisterFunction(instance, learned_index_builds_function);
+    auto wait_learned_index_builds = PragmaFunction::PragmaStatement("wait_learned_index_builds", functionWaitLearnedIndexBuilds);
+    ExtensionUtil::RegisterFunction(instance, wait_learned_index_builds);
+
+    // Looks a key up in the learned indexes on a column and returns what they hold for it.
+    TableFunction learned_index_lookup_function("learned_index_lookup",
+                                                {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::ANY},
+                                                LearnedIndexLookupFunction, LearnedIndexLookupBind, LearnedIndexLookupInit);
+    ExtensionUtil::RegisterFunction(instance, learned_index_lookup_function);
+
+    // Lookup benchmark of a learned index with a row per batch, see LearnedIndexBenchmarkBindData.
+    TableFunction learned_index_benchmark_function("learned_index_benchmark", {LogicalType::VARCHAR, LogicalType::VARCHAR},
+                                                   LearnedIndexBenchmarkFunction, LearnedIndexBenchmarkBind, LearnedIndexBenchmarkInit);
+    learned_index_benchmark_function.named_parameters["index"] = LogicalType::VARCHAR;
+    learned_index_benchmark_function.named_parameters["batches"] = LogicalType::UBIGINT;
+    learned_index_benchmark_function.named_parameters["batch_size"] = LogicalType::UBIGINT;
+    learned_index_benchmark_function.named_parameters["distribution"] = LogicalType::VARCHAR;
+    learned_index_benchmark_function.named_parameters["perf_counters"] = LogicalType::BOOLEAN;
+    ExtensionUtil::RegisterFunction(instance, learned_index_benchmark_function);
+
+    // Structure of the learned indexes on a column: ALEX nodes, PGM levels and segments, RadixSpline radix table
+    TableFunction learned_index_stats_function("learned_index_stats", {LogicalType::VARCHAR, LogicalType::VARCHAR},
+                                               LearnedIndexStatsFunction, LearnedIndexStatsBind, LearnedIndexStatsInit);
+    ExtensionUtil::RegisterFunction(instance, learned_index_stats_function);
+
+    // Predicted against actual positions of the keys of the learned indexes on a column
+    TableFunction learned_index_model_error_function("learned_index_model_error",
+                                                     {LogicalType::VARCHAR, LogicalType::VARCHAR},
+                                                     LearnedIndexModelErrorFunction, LearnedIndexModelErrorBind,
+                                                     LearnedIndexModelErrorInit);
+    learned_index_model_error_function.named_parameters["index"] = LogicalType::VARCHAR;
+    learned_index_model_error_function.named_parameters["sample"] = LogicalType::DOUBLE;
+    ExtensionUtil::RegisterFunction(instance, learned_index_model_error_function);
+
+    // Learned indexes saved with checkpoint_learned_indexes are restored on their first use
+    auto checkpoint_learned_indexes = PragmaFunction::PragmaStatement("checkpoint_learned_indexes", functionCheckpointLearnedIndexes);
+    ExtensionUtil::RegisterFunction(instance, checkpoint_learned_indexes);
+    // The memory of the learned indexes counts against memory_limit, see duckdb_memory()
+    registerLearnedIndexMemory(instance);
+    // Tables with a learned index are only changed through the pragmas below, which keep the indexes current,
+    // unless plain writes are allowed to drop the indexes instead
+    DBConfig::GetConfig(instance).AddExtensionOption(
+        "learned_index_reject_plain_writes",
+        "Reject plain INSERT, DELETE and UPDATE statements on tables with a learned index; if disabled, they drop the "
+        "learned indexes of the table",
+        LogicalType::BOOLEAN, Value::BOOLEAN(true));
+    OptimizerExtension reject_unindexed_writes;
+    reject_unindexed_writes.optimize_function = rejectUnindexedWrites;
+    DBConfig::GetConfig(instance).optimizer_extensions.push_back(reject_unindexed_writes);
+    registerLearnedIndexRestores(instance);
     
     // The arguments for the load benchmark data function are the table name, benchmark name and the number of elements to bulk load.
     auto loadBenchmarkData = PragmaFunction::PragmaCall("load_benchmark",functionLoadBenchmark,{LogicalType::VARCHAR,LogicalType::VARCHAR,LogicalType::INTEGER,LogicalType::INTEGER},{});
@@ -2687,12 +5775,26 @@ static void LoadInternal(DatabaseInstance &instance) {
     auto runBenchmarkWorkload = PragmaFunction::PragmaCall("run_lookup_benchmark",functionRunLookupBenchmark,{LogicalType::VARCHAR,LogicalType::VARCHAR},{});
     ExtensionUtil::RegisterFunction(instance,runBenchmarkWorkload);
 
+    // Number of entries of the hot-key cache in front of each learned index, 0 disables it.
+    auto hotKeyCacheSize = PragmaFunction::PragmaCall("hot_key_cache_size",functionHotKeyCacheSize,{LogicalType::INTEGER},{});
+    ExtensionUtil::RegisterFunction(instance,hotKeyCacheSize);
+
     auto create_art_index_function = PragmaFunction::PragmaCall("create_art_index",functionCreateARTIndex,{LogicalType::VARCHAR,LogicalType::VARCHAR},LogicalType::INVALID); 
     ExtensionUtil::RegisterFunction(instance,create_art_index_function);
     
     auto insert_into_table_function = PragmaFunction::PragmaCall("insert_into_table",functionInsertIntoTable,{LogicalType::VARCHAR,LogicalType::VARCHAR,LogicalType::VARCHAR,LogicalType::VARCHAR},{});
     ExtensionUtil::RegisterFunction(instance,insert_into_table_function);
 
+    // Table name, key type, list of keys, list of values.
+    auto insert_batch_into_table_function = PragmaFunction::PragmaCall("insert_batch_into_table",functionInsertBatchIntoTable,{LogicalType::VARCHAR,LogicalType::VARCHAR,LogicalType::ANY,LogicalType::ANY},{});
+    ExtensionUtil::RegisterFunction(instance,insert_batch_into_table_function);
+
+    // Table name, key type, key (and new value) - keep the learned indexes in sync with the table.
+    auto delete_from_table_function = PragmaFunction::PragmaCall("delete_from_table",functionDeleteFromTable,{LogicalType::VARCHAR,LogicalType::VARCHAR,LogicalType::VARCHAR},{});
+    ExtensionUtil::RegisterFunction(instance,delete_from_table_function);
+    auto update_table_function = PragmaFunction::PragmaCall("update_table",functionUpdateTable,{LogicalType::VARCHAR,LogicalType::VARCHAR,LogicalType::VARCHAR,LogicalType::VARCHAR},{});
+    ExtensionUtil::RegisterFunction(instance,update_table_function);
+
     //Benchmark name,index.
     auto runBenchmarkOneBatch = PragmaFunction::PragmaCall("run_benchmark_one_batch",functionRunBenchmarkOneBatch,{LogicalType::VARCHAR,LogicalType::VARCHAR,LogicalType::VARCHAR},{});
     ExtensionUtil::RegisterFunction(instance,runBenchmarkOneBatch);
@@ -2703,8 +5805,6 @@ static void LoadInternal(DatabaseInstance &instance) {
     auto findSize = PragmaFunction::PragmaCall("alex_size",functionAlexSize,{LogicalType::VARCHAR},{});
     ExtensionUtil::RegisterFunction(instance,findSize);
 
-    auto auxillaryStorageSizes = PragmaFunction::PragmaCall("auxillary_storage_size",functionAuxStorage,{LogicalType::VARCHAR},{});
-    ExtensionUtil::RegisterFunction(instance,auxillaryStorageSizes);
 
     auto runInsertionBenchmark = PragmaFunction::PragmaCall("run_insertion_benchmark",functionRunInsertionBenchmark,{LogicalType::VARCHAR,LogicalType::VARCHAR,LogicalType::VARCHAR, LogicalType::INTEGER},{});
     ExtensionUtil::RegisterFunction(instance,runInsertionBenchmark);
@@ -2716,6 +5816,9 @@ static void LoadInternal(DatabaseInstance &instance) {
         {LogicalType::VARCHAR, LogicalType::VARCHAR},          // Expected argument types (table name, column name)
         {}
     );
+    create_radixspline_index_function.named_parameters["background"] = LogicalType::BOOLEAN;
+    create_radixspline_index_function.named_parameters["compressed"] = LogicalType::BOOLEAN;
+    create_radixspline_index_function.named_parameters["two_level"] = LogicalType::BOOLEAN;
     ExtensionUtil::RegisterFunction(instance, create_radixspline_index_function);
 
     // Register the lookup_radixspline pragma
@@ -2754,6 +5857,23 @@ static void LoadInternal(DatabaseInstance &instance) {
     );
     ExtensionUtil::RegisterFunction(instance, stats_radixspline_function);
 
+    // Save a RadixSpline index to a file and map it back in, e.g. after a restart
+    auto save_radixspline_function = PragmaFunction::PragmaCall(
+        "save_radixspline_index",                        // Name of the pragma
+        SaveRadixSplineIndexPragmaFunction,              // Function to call
+        {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR}, // Expected argument types (table name, column name, file path)
+        {}
+    );
+    ExtensionUtil::RegisterFunction(instance, save_radixspline_function);
+
+    auto load_radixspline_function = PragmaFunction::PragmaCall(
+        "load_radixspline_index",                        // Name of the pragma
+        LoadRadixSplineIndexPragmaFunction,              // Function to call
+        {LogicalType::VARCHAR, LogicalType::VARCHAR, LogicalType::VARCHAR}, // Expected argument types (table name, column name, file path)
+        {}
+    );
+    ExtensionUtil::RegisterFunction(instance, load_radixspline_function);
+
     // Register the LoadBenchmarkFromFile function as a pragma
     auto load_benchmark_function = PragmaFunction::PragmaCall(
         "load_benchmark_from_file",   // Name of the pragma
@@ -59,14 +59,17 @@ class Builder {
 
  private:
   // Returns the number of shift bits based on the `diff` between the largest
-  // and the smallest key. KeyType == uint32_t.
+  // and the smallest key, which is 0 if all keys are equal. KeyType ==
+  // uint32_t.
   static size_t GetNumShiftBits(uint32_t diff, size_t num_radix_bits) {
+    if (diff == 0) return 0;
     const uint32_t clz = __builtin_clz(diff);
     if ((32 - clz) < num_radix_bits) return 0;
     return 32 - num_radix_bits - clz;
   }
   // KeyType == uint64_t.
   static size_t GetNumShiftBits(uint64_t diff, size_t num_radix_bits) {
+    if (diff == 0) return 0;
     const uint32_t clzl = __builtin_clzl(diff);
     if ((64 - clzl) < num_radix_bits) return 0;
     return 64 - num_radix_bits - clzl;
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <vector>
 
 namespace rs {
 
@@ -17,4 +19,100 @@ struct SearchBound {
   size_t end;  // Exclusive.
 };
 
+// Shape of a spline and its radix table, to choose the number of radix bits
+// and the error with.
+struct SplineStats {
+  size_t num_keys = 0;
+  size_t num_spline_points = 0;
+  size_t num_radix_bits = 0;
+  size_t max_error = 0;
+  // Entries of the radix table: one per prefix, and one past the last.
+  size_t num_radix_slots = 0;
+  // Prefixes with at least one spline point.
+  size_t num_used_radix_slots = 0;
+  // Most spline points of one prefix, which a lookup may have to search.
+  size_t max_points_per_radix_slot = 0;
+};
+
+// Fills in the radix table part of `stats` from the `num_slots` entries of a
+// radix table, read with `slot(i)`. Entry `i` is the first spline point whose
+// prefix is at least `i`.
+template <class Slot>
+void AddRadixTableStats(size_t num_slots, Slot slot, SplineStats* stats) {
+  stats->num_radix_slots = num_slots;
+  stats->num_used_radix_slots = 0;
+  stats->max_points_per_radix_slot = 0;
+  for (size_t i = 0; i + 1 < num_slots; ++i) {
+    const size_t points = slot(i + 1) - slot(i);
+    if (points > 0) ++stats->num_used_radix_slots;
+    if (points > stats->max_points_per_radix_slot)
+      stats->max_points_per_radix_slot = points;
+  }
+}
+
+// How far the estimated positions of keys are from their actual positions,
+// to tell how much of the error bound lookups need, overall and per segment
+// of the model. The error of a key is the distance between its position and
+// the estimate truncated to a position, which the search bound is built
+// around.
+struct ErrorProfile {
+  // The bound the model was built with.
+  size_t max_error = 0;
+  size_t num_keys = 0;
+  double sum_errors = 0;
+  size_t max_measured_error = 0;
+  // Keys by error: bucket 0 holds the exact estimates, bucket i > 0 the
+  // errors in [2^(i - 1), 2^i).
+  std::vector<size_t> histogram;
+  // Keys and largest error per segment.
+  std::vector<size_t> segment_keys;
+  std::vector<size_t> segment_max_errors;
+
+  static size_t GetBucket(size_t error) {
+    size_t bucket = 0;
+    for (; error > 0; error >>= 1) ++bucket;
+    return bucket;
+  }
+
+  void Add(size_t segment, size_t error) {
+    const size_t bucket = GetBucket(error);
+    if (bucket >= histogram.size()) histogram.resize(bucket + 1);
+    ++histogram[bucket];
+    if (segment >= segment_keys.size()) {
+      segment_keys.resize(segment + 1);
+      segment_max_errors.resize(segment + 1);
+    }
+    ++segment_keys[segment];
+    if (error > segment_max_errors[segment])
+      segment_max_errors[segment] = error;
+    ++num_keys;
+    sum_errors += error;
+    if (error > max_measured_error) max_measured_error = error;
+  }
+
+  double GetMeanError() const {
+    return num_keys == 0 ? 0 : sum_errors / num_keys;
+  }
+};
+
+// Profiles the estimates of `spline` for every `step`-th of the `num_keys`
+// sorted keys it was built on. A key's position is the one of its first
+// occurrence, where a lower bound search ends.
+template <class KeyType, class Spline>
+ErrorProfile ProfileErrors(const Spline& spline, const KeyType* keys,
+                           size_t num_keys, size_t max_error, size_t step) {
+  ErrorProfile profile;
+  profile.max_error = max_error;
+  if (step == 0) step = 1;
+  for (size_t i = 0; i < num_keys; i += step) {
+    const KeyType key = keys[i];
+    const size_t position = std::lower_bound(keys, keys + i, key) - keys;
+    const size_t estimate = spline.GetEstimatedPosition(key);
+    profile.Add(spline.GetSegment(key), estimate > position
+                                            ? estimate - position
+                                            : position - estimate);
+  }
+  return profile;
+}
+
 }  // namespace rs
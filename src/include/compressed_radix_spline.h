@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "common.h"
+#include "radix_spline.h"
+
+namespace rs {
+
+// A sorted array of unsigned integers, compressed with frame of reference
+// (FOR) encoding: the values are split into blocks of `kBlockSize`, and every
+// block stores its first value plus the bit-packed differences of the others
+// to it, using just as many bits as the largest difference in the block
+// needs. Runs of equal values, like the unused prefixes of a radix table, take
+// no bits at all. Any value is decoded in O(1) with two word reads.
+template <class T>
+class ForPackedArray {
+ public:
+  static constexpr size_t kBlockSize = 64;
+
+  ForPackedArray() = default;
+
+  template <class Get>
+  ForPackedArray(size_t size, Get&& get) : size_(size) {
+    for (size_t begin = 0; begin < size; begin += kBlockSize) {
+      const size_t end = std::min(size, begin + kBlockSize);
+      Block block;
+      block.base = get(begin);
+      block.bit_offset = num_bits_;
+      block.width = BitWidth(get(end - 1) - block.base);
+      blocks_.push_back(block);
+      num_bits_ += block.width * (end - begin);
+    }
+    // One extra word, so that decoding may always read two words.
+    words_.resize(num_bits_ / 64 + 2, 0);
+    for (size_t i = 0; i < size; ++i) {
+      const Block& block = blocks_[i / kBlockSize];
+      Put(block.bit_offset + (i % kBlockSize) * block.width, block.width,
+          get(i) - block.base);
+    }
+  }
+
+  T operator[](size_t i) const {
+    const Block& block = blocks_[i / kBlockSize];
+    return block.base +
+           static_cast<T>(Extract(
+               block.bit_offset + (i % kBlockSize) * block.width, block.width));
+  }
+
+  size_t size() const { return size_; }
+
+  // Returns the size in bytes.
+  size_t GetSize() const {
+    return blocks_.size() * sizeof(Block) + words_.size() * sizeof(uint64_t);
+  }
+
+ private:
+  struct Block {
+    T base;
+    uint8_t width;
+    uint64_t bit_offset;
+  };
+
+  static uint8_t BitWidth(uint64_t value) {
+    uint8_t width = 0;
+    while (value != 0) {
+      ++width;
+      value >>= 1;
+    }
+    return width;
+  }
+
+  void Put(uint64_t bit, uint8_t width, uint64_t value) {
+    if (width == 0) return;
+    const uint64_t word = bit / 64;
+    const uint64_t shift = bit % 64;
+    words_[word] |= value << shift;
+    if (shift + width > 64) words_[word + 1] |= value >> (64 - shift);
+  }
+
+  // Branch-free: the second word contributes nothing if the value does not
+  // cross into it, and the double shift stays defined for `shift` == 0.
+  uint64_t Extract(uint64_t bit, uint8_t width) const {
+    const uint64_t word = bit / 64;
+    const uint64_t shift = bit % 64;
+    const uint64_t mask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+    const uint64_t value =
+        (words_[word] >> shift) | ((words_[word + 1] << 1) << (63 - shift));
+    return value & mask;
+  }
+
+  size_t size_ = 0;
+  uint64_t num_bits_ = 0;
+  std::vector<Block> blocks_;
+  std::vector<uint64_t> words_;
+};
+
+// A compressed copy of a `RadixSpline` for when many indexes have to fit in
+// memory at once. The radix table and the x coordinates of the spline points
+// are FOR-encoded `ForPackedArray`s, and the y coordinates, which are
+// positions of keys, are stored as 32-bit integers instead of doubles.
+// Estimates are exactly the ones of the original spline; a lookup pays for a
+// few bit extractions per touched entry instead of plain loads. A second
+// radix table level of the spline is kept as it is.
+//
+// Requires fewer than 2^32 keys, like the radix table of `RadixSpline`.
+template <class KeyType>
+class CompressedRadixSpline {
+ public:
+  CompressedRadixSpline() = default;
+
+  explicit CompressedRadixSpline(const RadixSpline<KeyType>& spline)
+      : min_key_(spline.min_key_),
+        max_key_(spline.max_key_),
+        num_keys_(spline.num_keys_),
+        num_radix_bits_(spline.num_radix_bits_),
+        num_shift_bits_(spline.num_shift_bits_),
+        max_error_(spline.max_error_),
+        radix_table_(spline.radix_table_.size(),
+                     [&spline](size_t i) { return spline.radix_table_[i]; }),
+        spline_x_(spline.spline_points_.size(),
+                  [&spline](size_t i) { return spline.spline_points_[i].x; }),
+        dense_prefixes_(spline.dense_prefixes_) {
+    assert(num_keys_ <= std::numeric_limits<uint32_t>::max());
+    spline_y_.reserve(spline.spline_points_.size());
+    for (const auto& point : spline.spline_points_)
+      spline_y_.push_back(static_cast<uint32_t>(point.y));
+  }
+
+  // Returns the estimated position of `key`.
+  double GetEstimatedPosition(const KeyType key) const {
+    if (key <= min_key_) return 0;
+    if (key >= max_key_) return num_keys_ - 1;
+
+    const size_t index = GetSplineSegment(key);
+    const KeyType down_x = spline_x_[index - 1];
+    const double down_y = spline_y_[index - 1];
+    const double x_diff = spline_x_[index] - down_x;
+    const double y_diff = spline_y_[index] - down_y;
+    const double slope = y_diff / x_diff;
+    const double key_diff = key - down_x;
+    return std::fma(key_diff, slope, down_y);
+  }
+
+  // Returns a search bound [begin, end) around the estimated position.
+  SearchBound GetSearchBound(const KeyType key) const {
+    const size_t estimate = GetEstimatedPosition(key);
+    const size_t begin = (estimate < max_error_) ? 0 : (estimate - max_error_);
+    const size_t end = (estimate + max_error_ + 2 > num_keys_)
+                           ? num_keys_
+                           : (estimate + max_error_ + 2);
+    return SearchBound{begin, end};
+  }
+
+  // Returns the spline segment `key` is estimated in, numbered from 0 in key
+  // order. Keys outside of the spline count to the first or last segment.
+  size_t GetSegment(const KeyType key) const {
+    if (key <= min_key_ || spline_y_.size() < 2) return 0;
+    if (key >= max_key_) return spline_y_.size() - 2;
+    return GetSplineSegment(key) - 1;
+  }
+
+  SplineStats GetStats() const {
+    SplineStats stats;
+    stats.num_keys = num_keys_;
+    stats.num_spline_points = spline_y_.size();
+    stats.num_radix_bits = num_radix_bits_;
+    stats.max_error = max_error_;
+    AddRadixTableStats(radix_table_.size(),
+                       [this](size_t i) { return radix_table_[i]; }, &stats);
+    return stats;
+  }
+
+  // Returns the size in bytes.
+  size_t GetSize() const {
+    return sizeof(*this) + radix_table_.GetSize() + spline_x_.GetSize() +
+           spline_y_.size() * sizeof(uint32_t) + dense_prefixes_.GetSize();
+  }
+
+ private:
+  size_t GetSplineSegment(const KeyType key) const {
+    const KeyType prefix = (key - min_key_) >> num_shift_bits_;
+    assert(prefix + 1 < radix_table_.size());
+    uint32_t begin = radix_table_[prefix];
+    uint32_t end = radix_table_[prefix + 1];
+    if (end - begin >= 32)
+      dense_prefixes_.Narrow(prefix, key - min_key_, &begin, &end);
+
+    if (end - begin < 32) {
+      while (spline_x_[begin] < key) ++begin;
+      return begin;
+    }
+
+    while (begin < end) {
+      const uint32_t middle = begin + (end - begin) / 2;
+      if (spline_x_[middle] < key)
+        begin = middle + 1;
+      else
+        end = middle;
+    }
+    return begin;
+  }
+
+  KeyType min_key_ = 0;
+  KeyType max_key_ = 0;
+  size_t num_keys_ = 0;
+  size_t num_radix_bits_ = 0;
+  size_t num_shift_bits_ = 0;
+  size_t max_error_ = 0;
+
+  ForPackedArray<uint32_t> radix_table_;
+  ForPackedArray<KeyType> spline_x_;
+  std::vector<uint32_t> spline_y_;
+  DensePrefixTable dense_prefixes_;
+};
+
+}  // namespace rs
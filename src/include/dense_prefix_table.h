@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rs {
+
+// Second level of a radix table for skewed keys. A flat radix table with
+// `num_shift_bits` shift bits maps all keys of a prefix to the same range of
+// spline points; with skewed keys a few prefixes end up with most of the
+// points, and lookups in them fall back to a binary search over large ranges.
+// This table subdivides every prefix with more than `max_points` spline
+// points by the next bits of the key, as many as needed to leave about
+// `kPointsPerSlot` points per slot. Lookups thus stay at two table hops plus
+// a short search.
+//
+// Which prefixes are refined is kept in a bitmap with a rank per word, so the
+// table of a prefix is found in O(1) without an entry for every prefix.
+class DensePrefixTable {
+ public:
+  static constexpr size_t kPointsPerSlot = 8;
+  static constexpr size_t kMaxChildBits = 16;
+
+  DensePrefixTable() = default;
+
+  // `radix_table` is the flat table, `get_x(i)` returns the key of spline
+  // point `i` minus the smallest key.
+  template <class GetX>
+  DensePrefixTable(const std::vector<uint32_t>& radix_table,
+                   size_t num_shift_bits, size_t max_points, GetX&& get_x)
+      : num_shift_bits_(num_shift_bits) {
+    if (radix_table.size() < 2 || num_shift_bits == 0) return;
+    const size_t num_prefixes = radix_table.size() - 1;
+    dense_.resize(num_prefixes / 64 + 1, 0);
+    rank_.resize(dense_.size(), 0);
+    for (size_t prefix = 0; prefix < num_prefixes; ++prefix) {
+      const uint32_t begin = radix_table[prefix];
+      const uint32_t end = radix_table[prefix + 1];
+      if (end - begin <= max_points) continue;
+
+      Child child;
+      child.offset = entries_.size();
+      child.bits = 0;
+      while (child.bits < kMaxChildBits && child.bits < num_shift_bits &&
+             (size_t(end - begin) >> child.bits) > kPointsPerSlot)
+        ++child.bits;
+      const size_t child_shift = num_shift_bits - child.bits;
+      const uint64_t mask = (uint64_t(1) << child.bits) - 1;
+      // Slot q starts at the first point whose slot is not less than q.
+      uint32_t current = begin;
+      for (uint64_t slot = 0; slot <= mask; ++slot) {
+        while (current < end && ((get_x(current) >> child_shift) & mask) < slot)
+          ++current;
+        entries_.push_back(current);
+      }
+      entries_.push_back(end);
+      dense_[prefix / 64] |= uint64_t(1) << (prefix % 64);
+      children_.push_back(child);
+    }
+    for (size_t word = 1; word < dense_.size(); ++word)
+      rank_[word] = rank_[word - 1] + __builtin_popcountll(dense_[word - 1]);
+    if (children_.empty()) {
+      dense_.clear();
+      rank_.clear();
+    }
+  }
+
+  bool empty() const { return children_.empty(); }
+
+  // Narrows the range [`*begin`, `*end`] of spline points of `prefix` to the
+  // slot of a key `key_offset` above the smallest key, if the prefix is
+  // refined.
+  void Narrow(size_t prefix, uint64_t key_offset, uint32_t* begin,
+              uint32_t* end) const {
+    if (children_.empty()) return;
+    const uint64_t word = dense_[prefix / 64];
+    const uint64_t bit = uint64_t(1) << (prefix % 64);
+    if (!(word & bit)) return;
+    const Child& child =
+        children_[rank_[prefix / 64] + __builtin_popcountll(word & (bit - 1))];
+    const uint64_t slot = (key_offset >> (num_shift_bits_ - child.bits)) &
+                          ((uint64_t(1) << child.bits) - 1);
+    *begin = entries_[child.offset + slot];
+    *end = entries_[child.offset + slot + 1];
+  }
+
+  size_t num_refined_prefixes() const { return children_.size(); }
+
+  // Returns the size in bytes.
+  size_t GetSize() const {
+    return (dense_.size() * sizeof(uint64_t)) +
+           (rank_.size() * sizeof(uint32_t)) +
+           (children_.size() * sizeof(Child)) +
+           (entries_.size() * sizeof(uint32_t));
+  }
+
+ private:
+  struct Child {
+    uint32_t offset;
+    uint32_t bits;
+  };
+
+  size_t num_shift_bits_ = 0;
+  std::vector<uint64_t> dense_;
+  std::vector<uint32_t> rank_;
+  std::vector<Child> children_;
+  std::vector<uint32_t> entries_;
+};
+
+}  // namespace rs
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace duckdb {
+
+// Small, cache-resident map from hot keys to their payloads that sits in front
+// of a learned index. Slots are grouped into buckets of `kBucketSize` entries
+// that share one cache line pair; replacement inside a bucket follows the
+// CLOCK policy. Lookups never block: every bucket is guarded by a sequence
+// counter and a lookup that races with a writer is reported as a miss.
+template <class KeyType, class PayloadType>
+class HotKeyCache {
+  static_assert(sizeof(KeyType) <= sizeof(uint64_t) &&
+                    std::is_trivially_copyable<KeyType>::value,
+                "HotKeyCache keys must fit into 64 bits.");
+  static_assert(sizeof(PayloadType) <= sizeof(uint64_t) &&
+                    std::is_trivially_copyable<PayloadType>::value,
+                "HotKeyCache payloads must fit into 64 bits.");
+
+ public:
+  static constexpr size_t kBucketSize = 8;
+
+  HotKeyCache() = default;
+  explicit HotKeyCache(size_t capacity) { Resize(capacity); }
+
+  // (Re)allocates the cache for at least `capacity` entries, dropping all
+  // cached keys. A capacity of 0 disables the cache. Must not run concurrently
+  // with lookups.
+  void Resize(size_t capacity) {
+    num_buckets_ = 0;
+    buckets_.reset();
+    if (capacity == 0) return;
+    size_t num_buckets = 1;
+    while (num_buckets * kBucketSize < capacity) num_buckets <<= 1;
+    buckets_.reset(new Bucket[num_buckets]);
+    num_buckets_ = num_buckets;
+    ResetStats();
+  }
+
+  bool Enabled() const { return num_buckets_ > 0; }
+
+  // Returns true and sets `payload` if `key` is cached. Always a miss, and
+  // not counted, if the cache is disabled.
+  bool Lookup(KeyType key, PayloadType* payload) {
+    if (!Enabled()) return false;
+    const uint64_t key_bits = ToBits(key);
+    Bucket& bucket = GetBucket(key_bits);
+    const uint32_t version = bucket.version.load(std::memory_order_acquire);
+    if (version & 1) {
+      misses_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    const uint8_t occupied = bucket.occupied.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kBucketSize; ++i) {
+      if (!(occupied & (1u << i)) ||
+          bucket.keys[i].load(std::memory_order_relaxed) != key_bits)
+        continue;
+      const uint64_t payload_bits =
+          bucket.payloads[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (bucket.version.load(std::memory_order_relaxed) != version) break;
+      bucket.referenced.fetch_or(1u << i, std::memory_order_relaxed);
+      FromBits(payload_bits, payload);
+      hits_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // Returns the number of `Invalidate` and `Clear` calls so far. A lookup
+  // that misses reads it before probing the index and passes it to `Admit`.
+  uint64_t GetInvalidations() const {
+    return invalidations_.load(std::memory_order_acquire);
+  }
+
+  // Caches `key` -> `payload`, evicting a cold entry of the same bucket if
+  // needed. Admission is best effort: it is skipped if another writer holds
+  // the bucket, or if any key was invalidated since `GetInvalidations`
+  // returned `invalidations`, as `payload` may be what a write just replaced.
+  void Admit(KeyType key, PayloadType payload, uint64_t invalidations) {
+    if (!Enabled()) return;
+    const uint64_t key_bits = ToBits(key);
+    Bucket& bucket = GetBucket(key_bits);
+    if (!TryLockBucket(bucket)) return;
+    // Invalidations count under the bucket lock, so one that is not seen here
+    // drops the entry once this admission unlocks the bucket.
+    if (invalidations_.load(std::memory_order_acquire) != invalidations) {
+      UnlockBucket(bucket);
+      return;
+    }
+    const uint8_t occupied = bucket.occupied.load(std::memory_order_relaxed);
+    size_t slot = kBucketSize;
+    for (size_t i = 0; i < kBucketSize; ++i) {
+      if ((occupied & (1u << i)) &&
+          bucket.keys[i].load(std::memory_order_relaxed) == key_bits) {
+        slot = i;
+        break;
+      }
+      if (slot == kBucketSize && !(occupied & (1u << i))) slot = i;
+    }
+    if (slot == kBucketSize) slot = EvictWithClock(bucket);
+    bucket.keys[slot].store(key_bits, std::memory_order_relaxed);
+    bucket.payloads[slot].store(ToBits(payload), std::memory_order_relaxed);
+    bucket.occupied.store(occupied | (1u << slot), std::memory_order_relaxed);
+    bucket.referenced.fetch_and(~(1u << slot), std::memory_order_relaxed);
+    UnlockBucket(bucket);
+  }
+
+  // Caches `key` -> `payload` as above, for callers that know no write races
+  // with them.
+  void Admit(KeyType key, PayloadType payload) {
+    Admit(key, payload, GetInvalidations());
+  }
+
+  // Drops `key` from the cache. Must be called whenever the index entry of
+  // `key` is inserted, updated or deleted.
+  void Invalidate(KeyType key) {
+    if (!Enabled()) return;
+    const uint64_t key_bits = ToBits(key);
+    Bucket& bucket = GetBucket(key_bits);
+    while (!TryLockBucket(bucket)) {
+    }
+    invalidations_.fetch_add(1, std::memory_order_acq_rel);
+    uint8_t occupied = bucket.occupied.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < kBucketSize; ++i) {
+      if ((occupied & (1u << i)) &&
+          bucket.keys[i].load(std::memory_order_relaxed) == key_bits)
+        occupied &= ~(1u << i);
+    }
+    bucket.occupied.store(occupied, std::memory_order_relaxed);
+    UnlockBucket(bucket);
+  }
+
+  // Drops all cached keys, e.g. after the index was rebuilt.
+  void Clear() {
+    invalidations_.fetch_add(1, std::memory_order_acq_rel);
+    for (size_t b = 0; b < num_buckets_; ++b) {
+      Bucket& bucket = buckets_[b];
+      while (!TryLockBucket(bucket)) {
+      }
+      bucket.occupied.store(0, std::memory_order_relaxed);
+      bucket.referenced.store(0, std::memory_order_relaxed);
+      UnlockBucket(bucket);
+    }
+  }
+
+  uint64_t GetHits() const { return hits_.load(std::memory_order_relaxed); }
+  uint64_t GetMisses() const {
+    return misses_.load(std::memory_order_relaxed);
+  }
+  void ResetStats() {
+    hits_.store(0, std::memory_order_relaxed);
+    misses_.store(0, std::memory_order_relaxed);
+  }
+
+  // Returns the size in bytes.
+  size_t GetSize() const { return sizeof(*this) + num_buckets_ * sizeof(Bucket); }
+
+ private:
+  struct alignas(64) Bucket {
+    // Odd while a writer modifies the bucket.
+    std::atomic<uint32_t> version{0};
+    std::atomic<uint8_t> occupied{0};
+    std::atomic<uint8_t> referenced{0};
+    uint8_t hand = 0;
+    std::atomic<uint64_t> keys[kBucketSize];
+    std::atomic<uint64_t> payloads[kBucketSize];
+  };
+
+  template <class T>
+  static uint64_t ToBits(T value) {
+    if constexpr (std::is_floating_point<T>::value) {
+      // -0.0 and 0.0 compare equal in the index, so they share one entry.
+      if (value == 0) value = 0;
+    }
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(T));
+    return bits;
+  }
+
+  static void FromBits(uint64_t bits, PayloadType* value) {
+    std::memcpy(value, &bits, sizeof(PayloadType));
+  }
+
+  Bucket& GetBucket(uint64_t key_bits) const {
+    // Finalizer of MurmurHash3.
+    key_bits ^= key_bits >> 33;
+    key_bits *= 0xff51afd7ed558ccdULL;
+    key_bits ^= key_bits >> 33;
+    key_bits *= 0xc4ceb9fe1a85ec53ULL;
+    key_bits ^= key_bits >> 33;
+    return buckets_[key_bits & (num_buckets_ - 1)];
+  }
+
+  static bool TryLockBucket(Bucket& bucket) {
+    uint32_t version = bucket.version.load(std::memory_order_relaxed);
+    if (version & 1) return false;
+    if (!bucket.version.compare_exchange_strong(version, version + 1,
+                                                std::memory_order_acquire))
+      return false;
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+  }
+
+  static void UnlockBucket(Bucket& bucket) {
+    bucket.version.fetch_add(1, std::memory_order_release);
+  }
+
+  // Advances the clock hand of a full bucket until it finds a slot whose
+  // reference bit is not set, clearing reference bits on the way.
+  static size_t EvictWithClock(Bucket& bucket) {
+    while (true) {
+      const size_t slot = bucket.hand;
+      bucket.hand = (bucket.hand + 1) % kBucketSize;
+      const uint8_t mask = 1u << slot;
+      if (!(bucket.referenced.fetch_and(~mask, std::memory_order_relaxed) &
+            mask))
+        return slot;
+    }
+  }
+
+  std::unique_ptr<Bucket[]> buckets_;
+  size_t num_buckets_ = 0;
+
+  std::atomic<uint64_t> invalidations_{0};
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+};
+
+}  // namespace duckdb
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace duckdb {
+
+// Histogram of latencies in the style of HdrHistogram: every power of two is
+// split into `kSubBuckets` linear sub-buckets, so a recorded value is kept
+// with a relative error below 1 / `kSubBuckets` over the whole range of
+// uint64, in a fixed number of counters. Values below `kSubBuckets` are kept
+// exactly. Recording is a count increment, so a benchmark can record every
+// operation and still ask for p99.9 afterwards without keeping the samples.
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 7;
+  static constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+
+  LatencyHistogram() : counts_((64 - kSubBucketBits + 1) * kSubBuckets, 0) {}
+
+  void Record(uint64_t value) {
+    ++counts_[GetIndex(value)];
+    ++count_;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    sum_ += static_cast<double>(value);
+  }
+
+  void Merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < counts_.size(); ++i) counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+  }
+
+  uint64_t count() const { return count_; }
+  uint64_t min() const { return count_ == 0 ? 0 : min_; }
+  uint64_t max() const { return max_; }
+  double mean() const { return count_ == 0 ? 0 : sum_ / count_; }
+
+  // Returns the value that `percentile` percent of the recorded values are
+  // less than or equal to, as the highest value of its sub-bucket, but not
+  // more than the largest recorded value. 0 if nothing was recorded.
+  uint64_t Percentile(double percentile) const {
+    if (count_ == 0) return 0;
+    const double fraction = std::min(std::max(percentile, 0.0), 100.0) / 100;
+    const uint64_t rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(fraction * count_)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+      seen += counts_[i];
+      if (seen >= rank) return std::min(GetHighestValue(i), max_);
+    }
+    return max_;
+  }
+
+ private:
+  // Values in [2^m, 2^(m+1)) with m >= `kSubBucketBits` go to sub-buckets of
+  // width 2^(m - `kSubBucketBits`).
+  static size_t GetIndex(uint64_t value) {
+    if (value < kSubBuckets) return value;
+    const int m = 63 - __builtin_clzll(value);
+    const int shift = m - kSubBucketBits;
+    return static_cast<size_t>(shift) * kSubBuckets + (value >> shift);
+  }
+
+  static uint64_t GetHighestValue(size_t index) {
+    if (index < kSubBuckets) return index;
+    const int shift = static_cast<int>(index / kSubBuckets) - 1;
+    const uint64_t sub_bucket = index % kSubBuckets + kSubBuckets;
+    const uint64_t lowest = sub_bucket << shift;
+    const uint64_t width = uint64_t(1) << shift;
+    return lowest + (width - 1);
+  }
+
+  std::vector<uint64_t> counts_;
+  uint64_t count_ = 0;
+  uint64_t min_ = std::numeric_limits<uint64_t>::max();
+  uint64_t max_ = 0;
+  double sum_ = 0;
+};
+
+}  // namespace duckdb
@@ -0,0 +1,418 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "duckdb/common/allocator.hpp"
+
+namespace duckdb {
+
+// Memory pool for the nodes of the learned indexes. ALEX allocates and frees
+// nodes and their key, payload and bitmap arrays all the time while inserts
+// split and expand nodes; from the global allocator that fragments the heap
+// and shows up in profiles. The pool serves requests up to `kMaxPooledSize`
+// bytes from per-size-class free lists that are refilled from 1 MiB slabs, so
+// freed blocks are reused for the next node of the same size class. Larger
+// requests, like the data arrays of big data nodes, go straight to the
+// allocator.
+//
+// Slabs and large blocks come from DuckDB's default `Allocator`. Once a size
+// class has more than two slabs' worth of free blocks, slabs whose blocks are
+// all free go back to the allocator, except one kept for the next refill.
+//
+// The pool counts the bytes it holds, see `GetReservedBytes`, and reserves
+// them with the memory manager of every database, see `AddMemoryReservation`,
+// together with the memory of indexes that do not allocate from the pool, see
+// `LearnedIndexMemoryCharge`. The pool is shared by the whole process and so
+// are the indexes, so each database counts all of them against its limit.
+class LearnedIndexMemoryPool {
+ public:
+  // Reserves bytes with a memory manager. Throws `OutOfMemoryException` if it
+  // refuses them, returns false if it is gone, which drops it from the pool.
+  using ReserveFunction = std::function<bool(size_t)>;
+  using ReleaseFunction = std::function<void(size_t)>;
+
+  static constexpr size_t kMinBlockSize = 16;
+  static constexpr size_t kMaxPooledSize = 4096;
+  static constexpr size_t kSlabSize = size_t(1) << 20;
+
+  static LearnedIndexMemoryPool& Get() {
+    // Never destroyed, indexes in static storage may free into it at exit.
+    static LearnedIndexMemoryPool* pool = new LearnedIndexMemoryPool();
+    return *pool;
+  }
+
+  LearnedIndexMemoryPool(const LearnedIndexMemoryPool&) = delete;
+  LearnedIndexMemoryPool& operator=(const LearnedIndexMemoryPool&) = delete;
+
+  // Throws `OutOfMemoryException` if a memory manager refuses the bytes the
+  // pool has to take from the allocator, before taking them.
+  void* Allocate(size_t size) {
+    if (size == 0) size = 1;
+    if (size > kMaxPooledSize) {
+      Reserve(size);
+      data_ptr_t data;
+      try {
+        data = Allocator::DefaultAllocator().AllocateData(size);
+      } catch (...) {
+        Unreserve(size);
+        throw;
+      }
+      in_use_bytes_.fetch_add(size);
+      return data;
+    }
+    SizeClass& size_class = size_classes_[GetSizeClass(size)];
+    FreeBlock* block;
+    {
+      std::lock_guard<std::mutex> guard(size_class.mutex);
+      if (!size_class.free_list) Refill(size_class);
+      block = size_class.free_list;
+      size_class.free_list = block->next;
+      --size_class.free_blocks;
+    }
+    in_use_bytes_.fetch_add(size_class.block_size);
+    return block;
+  }
+
+  // `size` has to be the size the block was allocated with.
+  void Free(void* pointer, size_t size) {
+    if (!pointer) return;
+    if (size == 0) size = 1;
+    if (size > kMaxPooledSize) {
+      Allocator::DefaultAllocator().FreeData(static_cast<data_ptr_t>(pointer),
+                                             size);
+      in_use_bytes_.fetch_sub(size);
+      Unreserve(size);
+      return;
+    }
+    SizeClass& size_class = size_classes_[GetSizeClass(size)];
+    std::lock_guard<std::mutex> guard(size_class.mutex);
+    FreeBlock* block = static_cast<FreeBlock*>(pointer);
+    block->next = size_class.free_list;
+    size_class.free_list = block;
+    ++size_class.free_blocks;
+    in_use_bytes_.fetch_sub(size_class.block_size);
+    if (size_class.free_blocks < size_class.trim_at) return;
+    try {
+      Trim(size_class);
+    } catch (...) {
+      // Trimming only allocates before it changes anything, and is best effort.
+    }
+  }
+
+  // Bytes held from the allocator: the slabs plus the large blocks in use.
+  size_t GetReservedBytes() const { return reserved_bytes_.load(); }
+
+  // Bytes handed out to the indexes, rounded up to the size classes.
+  size_t GetInUseBytes() const { return in_use_bytes_.load(); }
+
+  // Bytes of indexes outside the pool, see `LearnedIndexMemoryCharge`.
+  size_t GetChargedBytes() const { return charged_bytes_.load(); }
+
+  // The fewest bytes a memory manager granted. Less than the reserved plus the
+  // charged bytes while one refuses to grant charges, see `Charge`.
+  size_t GetAccountedBytes() const {
+    std::lock_guard<std::mutex> guard(accounting_mutex_);
+    if (reservations_.empty()) return 0;
+    size_t accounted = std::numeric_limits<size_t>::max();
+    for (auto& reservation : reservations_)
+      accounted = std::min(accounted, reservation.accounted_bytes);
+    return accounted;
+  }
+
+  // Reserves the reserved and the charged bytes with the memory manager of
+  // `owner` from now on, the bytes held so far right away. Replaces an earlier
+  // memory manager of the same owner, which gets back what it granted; the
+  // ones of other owners keep their reservations. Throws like `Allocate` if
+  // the memory manager refuses the bytes held so far, without adding it.
+  void AddMemoryReservation(const void* owner, ReserveFunction reserve,
+                            ReleaseFunction release) {
+    std::lock_guard<std::mutex> guard(accounting_mutex_);
+    for (auto it = reservations_.begin(); it != reservations_.end(); ++it) {
+      if (it->owner != owner) continue;
+      if (it->accounted_bytes > 0) it->release(it->accounted_bytes);
+      reservations_.erase(it);
+      break;
+    }
+    Reservation reservation{owner, std::move(reserve), std::move(release), 0};
+    const size_t held = reserved_bytes_.load() + charged_bytes_.load();
+    if (held > 0 && !reservation.reserve(held)) return;
+    reservation.accounted_bytes = held;
+    reservations_.push_back(std::move(reservation));
+    has_reservation_.store(true);
+  }
+
+  // Charges the memory of an index that exists already. A memory manager that
+  // refuses it is asked again when the pool grows; failing the change to the
+  // index after the fact would not give the memory back.
+  void Charge(size_t size) {
+    charged_bytes_.fetch_add(size);
+    Reconcile(false);
+  }
+
+  void Uncharge(size_t size) {
+    charged_bytes_.fetch_sub(size);
+    Reconcile(false);
+  }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct SizeClass {
+    std::mutex mutex;
+    size_t block_size = 0;
+    FreeBlock* free_list = nullptr;
+    size_t free_blocks = 0;
+    // Number of free blocks at which `Free` looks for empty slabs next.
+    size_t trim_at = 0;
+    // Start addresses of the slabs carved into the size class.
+    std::set<uintptr_t> slabs;
+  };
+
+  struct Reservation {
+    const void* owner;
+    ReserveFunction reserve;
+    ReleaseFunction release;
+    size_t accounted_bytes;
+  };
+
+  // Power-of-two size classes from `kMinBlockSize` to `kMaxPooledSize`.
+  static constexpr size_t kNumSizeClasses = 9;
+
+  LearnedIndexMemoryPool() {
+    for (size_t i = 0; i < kNumSizeClasses; ++i) {
+      size_classes_[i].block_size = kMinBlockSize << i;
+      size_classes_[i].trim_at = 2 * BlocksPerSlab(size_classes_[i]);
+    }
+  }
+
+  static size_t BlocksPerSlab(const SizeClass& size_class) {
+    return kSlabSize / size_class.block_size;
+  }
+
+  // Counts `bytes` more as held by the pool, throwing if a memory manager
+  // refuses them.
+  void Reserve(size_t bytes) {
+    reserved_bytes_.fetch_add(bytes);
+    try {
+      Reconcile(true);
+    } catch (...) {
+      reserved_bytes_.fetch_sub(bytes);
+      throw;
+    }
+  }
+
+  void Unreserve(size_t bytes) {
+    reserved_bytes_.fetch_sub(bytes);
+    Reconcile(false);
+  }
+
+  // Brings the bytes granted by each memory manager up to the held ones, or
+  // gives back surplus of more than a slab, so that freeing and allocating
+  // around a boundary does not call the memory managers every time. A refusal
+  // is thrown if `throw_on_refusal`, and retried on the next growth if not.
+  void Reconcile(bool throw_on_refusal) {
+    if (!has_reservation_.load(std::memory_order_relaxed)) return;
+    std::lock_guard<std::mutex> guard(accounting_mutex_);
+    const size_t held = reserved_bytes_.load() + charged_bytes_.load();
+    for (size_t i = 0; i < reservations_.size();) {
+      Reservation& reservation = reservations_[i];
+      if (held > reservation.accounted_bytes) {
+        bool granted;
+        try {
+          granted = reservation.reserve(held - reservation.accounted_bytes);
+        } catch (...) {
+          if (throw_on_refusal) throw;
+          ++i;
+          continue;
+        }
+        if (!granted) {
+          reservations_.erase(reservations_.begin() + i);
+          continue;
+        }
+        reservation.accounted_bytes = held;
+      } else if (reservation.accounted_bytes - held > kSlabSize) {
+        reservation.release(reservation.accounted_bytes - held);
+        reservation.accounted_bytes = held;
+      }
+      ++i;
+    }
+    has_reservation_.store(!reservations_.empty());
+  }
+
+  static size_t GetSizeClass(size_t size) {
+    size_t size_class = 0;
+    while ((kMinBlockSize << size_class) < size) ++size_class;
+    return size_class;
+  }
+
+  // Carves a fresh slab into blocks of the size class. Requires the lock of
+  // the size class.
+  void Refill(SizeClass& size_class) {
+    Reserve(kSlabSize);
+    data_ptr_t slab;
+    try {
+      slab = Allocator::DefaultAllocator().AllocateData(kSlabSize);
+      size_class.slabs.insert(reinterpret_cast<uintptr_t>(slab));
+    } catch (...) {
+      Unreserve(kSlabSize);
+      throw;
+    }
+    for (size_t offset = kSlabSize; offset >= size_class.block_size;) {
+      offset -= size_class.block_size;
+      FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + offset);
+      block->next = size_class.free_list;
+      size_class.free_list = block;
+    }
+    size_class.free_blocks += BlocksPerSlab(size_class);
+  }
+
+  static uintptr_t SlabOf(const SizeClass& size_class, const FreeBlock* block) {
+    return *--size_class.slabs.upper_bound(reinterpret_cast<uintptr_t>(block));
+  }
+
+  // Gives the slabs whose blocks are all free back to the allocator but one.
+  // Looks again once another slab's worth of blocks is freed, so that a size
+  // class with scattered free blocks is not scanned on every `Free`. Requires
+  // the lock of the size class.
+  void Trim(SizeClass& size_class) {
+    const size_t blocks_per_slab = BlocksPerSlab(size_class);
+    std::unordered_map<uintptr_t, size_t> free_blocks;
+    for (FreeBlock* block = size_class.free_list; block; block = block->next)
+      ++free_blocks[SlabOf(size_class, block)];
+    std::unordered_set<uintptr_t> empty_slabs;
+    bool kept_one = false;
+    for (auto& slab : free_blocks) {
+      if (slab.second != blocks_per_slab) continue;
+      if (!kept_one) {
+        kept_one = true;
+        continue;
+      }
+      empty_slabs.insert(slab.first);
+    }
+    if (!empty_slabs.empty()) {
+      for (FreeBlock** link = &size_class.free_list; *link;) {
+        if (empty_slabs.count(SlabOf(size_class, *link)))
+          *link = (*link)->next;
+        else
+          link = &(*link)->next;
+      }
+      for (uintptr_t slab : empty_slabs) {
+        size_class.slabs.erase(slab);
+        Allocator::DefaultAllocator().FreeData(reinterpret_cast<data_ptr_t>(slab),
+                                               kSlabSize);
+      }
+      size_class.free_blocks -= empty_slabs.size() * blocks_per_slab;
+      Unreserve(empty_slabs.size() * kSlabSize);
+    }
+    size_class.trim_at = std::max(2 * blocks_per_slab,
+                                  size_class.free_blocks + blocks_per_slab);
+  }
+
+  std::array<SizeClass, kNumSizeClasses> size_classes_;
+  std::atomic<size_t> reserved_bytes_{0};
+  std::atomic<size_t> in_use_bytes_{0};
+  std::atomic<size_t> charged_bytes_{0};
+
+  mutable std::mutex accounting_mutex_;
+  std::atomic<bool> has_reservation_{false};
+  std::vector<Reservation> reservations_;
+};
+
+// The memory of an index that allocates outside the pool, like the PGM and
+// RadixSpline indexes, charged to the pool so that it is reported to the
+// memory manager along with the pooled memory.
+class LearnedIndexMemoryCharge {
+ public:
+  LearnedIndexMemoryCharge() = default;
+  ~LearnedIndexMemoryCharge() { Set(0); }
+
+  LearnedIndexMemoryCharge(const LearnedIndexMemoryCharge&) = delete;
+  LearnedIndexMemoryCharge& operator=(const LearnedIndexMemoryCharge&) = delete;
+
+  // Replaces the charged size with `bytes`, the current size of the index.
+  void Set(size_t bytes) {
+    const size_t previous = bytes_.exchange(bytes);
+    if (bytes > previous)
+      LearnedIndexMemoryPool::Get().Charge(bytes - previous);
+    else if (bytes < previous)
+      LearnedIndexMemoryPool::Get().Uncharge(previous - bytes);
+  }
+
+  size_t Get() const { return bytes_.load(); }
+
+ private:
+  std::atomic<size_t> bytes_{0};
+};
+
+// Allocator that serves a container or an ALEX index from the
+// `LearnedIndexMemoryPool`. Stateless, so all instances are interchangeable.
+template <class T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using reference = T&;
+  using const_reference = const T&;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+
+  // ALEX rebinds its allocator to its node and array types.
+  template <class U>
+  struct rebind {
+    using other = PoolAllocator<U>;
+  };
+
+  PoolAllocator() = default;
+  template <class U>
+  PoolAllocator(const PoolAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    static_assert(alignof(T) <= LearnedIndexMemoryPool::kMinBlockSize,
+                  "the pool aligns blocks to 16 bytes");
+    if (n > max_size()) throw std::bad_alloc();
+    return static_cast<T*>(LearnedIndexMemoryPool::Get().Allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* pointer, size_t n) {
+    LearnedIndexMemoryPool::Get().Free(pointer, n * sizeof(T));
+  }
+
+  size_t max_size() const { return std::numeric_limits<size_t>::max() / sizeof(T); }
+
+  template <class U, class... Args>
+  void construct(U* pointer, Args&&... args) {
+    ::new (static_cast<void*>(pointer)) U(std::forward<Args>(args)...);
+  }
+
+  template <class U>
+  void destroy(U* pointer) {
+    pointer->~U();
+  }
+
+  template <class U>
+  bool operator==(const PoolAllocator<U>&) const {
+    return true;
+  }
+  template <class U>
+  bool operator!=(const PoolAllocator<U>&) const {
+    return false;
+  }
+};
+
+}  // namespace duckdb
@@ -0,0 +1,353 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <system_error>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace duckdb {
+
+// Append-only log of the table mutations made through the extension since the
+// last checkpoint of the learned indexes, kept next to the manifest in the
+// sidecar. A restored index replays the records of its table onto the image
+// of the checkpoint, so recovery costs O(changes since the checkpoint) rather
+// than a rebuild from the table.
+//
+// The log starts with the generation of the manifest it continues. A log of
+// another generation, left behind by a crash during a checkpoint, holds
+// mutations the manifest already contains and is ignored.
+//
+// Every record carries a checksum. A crash in the middle of an append leaves a
+// torn record at the end, which reading stops at, and which `Open` cuts off
+// so that the next append does not land behind it. Appends are synced to disk
+// before they return, and the extension appends the records of a change
+// before it commits the change, so a committed change is never missing from
+// the log. A crash in between leaves records of a change that did not commit,
+// which the restore notices as the table not matching the log.
+class LearnedIndexLog {
+ public:
+  static constexpr const char* kLogName = "mutations.log";
+  static constexpr uint32_t kVersion = 2;
+
+  enum class Op : uint8_t { kInsert = 1, kErase = 2, kUpdate = 3 };
+
+  struct Record {
+    Op op;
+    // Key type as in `index_type_table_name_map`.
+    std::string key_type;
+    std::string table_name;
+    // The key, bit-copied into the low bytes; see `EncodeKey`.
+    uint64_t key = 0;
+    double payload = 0;
+    // Rows the mutation added to (or, if negative, removed from) the table.
+    int64_t row_delta = 0;
+    // What the mutation added to the content hash of the table, modulo 2^64;
+    // see `LearnedIndexManifestEntry::content_hash`. A batch may carry the
+    // change of all of its rows on one of its records.
+    uint64_t hash_delta = 0;
+  };
+
+  LearnedIndexLog() = default;
+  ~LearnedIndexLog() { Close(); }
+
+  LearnedIndexLog(const LearnedIndexLog&) = delete;
+  LearnedIndexLog& operator=(const LearnedIndexLog&) = delete;
+
+  template <class K>
+  static uint64_t EncodeKey(K key) {
+    static_assert(sizeof(K) <= sizeof(uint64_t), "keys are at most 8 bytes");
+    uint64_t bits = 0;
+    std::memcpy(&bits, &key, sizeof(K));
+    return bits;
+  }
+
+  template <class K>
+  static K DecodeKey(uint64_t bits) {
+    K key;
+    std::memcpy(&key, &bits, sizeof(K));
+    return key;
+  }
+
+  // Starts appending to the log of `directory` for the checkpoint
+  // `generation`. The log is emptied unless it already continues that
+  // checkpoint, in which case it is truncated after its last valid record.
+  bool Open(const std::string& directory, uint64_t generation,
+            std::string* error) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    CloseLocked();
+    path_ = directory + "/" + kLogName;
+    uint64_t current_generation = 0;
+    if (!ReadHeader(path_, &current_generation) ||
+        current_generation != generation) {
+      if (!WriteHeader(path_, generation, error)) return false;
+    } else if (!TruncateAfterValidRecords(path_, error)) {
+      return false;
+    }
+    file_ = std::fopen(path_.c_str(), "ab");
+    if (!file_) {
+      *error = "could not open " + path_;
+      return false;
+    }
+    generation_ = generation;
+    return true;
+  }
+
+  // Empties the log after a checkpoint with `generation`.
+  bool Reset(const std::string& directory, uint64_t generation,
+             std::string* error) {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      CloseLocked();
+      if (!WriteHeader(directory + "/" + kLogName, generation, error))
+        return false;
+    }
+    return Open(directory, generation, error);
+  }
+
+  void Close() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    CloseLocked();
+  }
+
+  bool IsOpen() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return file_ != nullptr;
+  }
+
+  uint64_t generation() const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return generation_;
+  }
+
+  // Appends `record` and syncs it to disk. Does nothing unless the log is
+  // open.
+  bool Append(const Record& record) { return Append(std::vector<Record>{record}); }
+
+  // Appends `records` and syncs them to disk once. Does nothing unless the
+  // log is open. If it fails, some of the records may have been written.
+  bool Append(const std::vector<Record>& records) {
+    std::vector<char> bytes;
+    std::vector<char> body;
+    for (const auto& record : records) {
+      body.clear();
+      Put(body, static_cast<uint8_t>(record.op));
+      Put(body, static_cast<uint16_t>(record.key_type.size()));
+      Put(body, static_cast<uint16_t>(record.table_name.size()));
+      Put(body, record.key);
+      Put(body, record.payload);
+      Put(body, record.row_delta);
+      Put(body, record.hash_delta);
+      body.insert(body.end(), record.key_type.begin(), record.key_type.end());
+      body.insert(body.end(), record.table_name.begin(),
+                  record.table_name.end());
+      const RecordHeader header = {static_cast<uint32_t>(body.size()),
+                                   Checksum(body.data(), body.size())};
+      Put(bytes, header);
+      bytes.insert(bytes.end(), body.begin(), body.end());
+    }
+
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!file_ || bytes.empty()) return true;
+    return std::fwrite(bytes.data(), bytes.size(), 1, file_) == 1 &&
+           Sync(file_);
+  }
+
+  // Reads the records of the open log. A torn record at the end is dropped.
+  bool ReadRecords(std::vector<Record>* records, std::string* error) const {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (!file_) return true;
+    std::error_code file_error;
+    const uint64_t file_size = std::filesystem::file_size(path_, file_error);
+    std::FILE* in = std::fopen(path_.c_str(), "rb");
+    if (file_error || !in) {
+      if (in) std::fclose(in);
+      *error = "could not open " + path_;
+      return false;
+    }
+    LogHeader log_header;
+    if (std::fread(&log_header, sizeof(log_header), 1, in) != 1 ||
+        !IsValid(log_header) || log_header.generation != generation_) {
+      std::fclose(in);
+      *error = path_ + " is not the mutation log of the last checkpoint";
+      return false;
+    }
+    ReadValidRecords(in, file_size, records);
+    std::fclose(in);
+    return true;
+  }
+
+ private:
+  struct LogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t generation;
+  };
+
+  struct RecordHeader {
+    uint32_t size;
+    uint32_t checksum;
+  };
+
+  // op, the two name sizes, key, payload, row delta and hash delta.
+  static constexpr size_t kFixedBodySize = 1 + 2 + 2 + 8 + 8 + 8 + 8;
+
+  static bool IsValid(const LogHeader& header) {
+    return std::memcmp(header.magic, "LIDXLOG", 8) == 0 &&
+           header.version == kVersion;
+  }
+
+  // Reads the records that follow the log header in `in`, a file of
+  // `file_size` bytes, up to the first torn or corrupt one, and returns the
+  // offset right after the last valid record. `records` may be null.
+  static uint64_t ReadValidRecords(std::FILE* in, uint64_t file_size,
+                                   std::vector<Record>* records) {
+    uint64_t valid_end = sizeof(LogHeader);
+    RecordHeader header;
+    std::vector<char> body;
+    while (file_size - valid_end >= sizeof(header) &&
+           std::fread(&header, sizeof(header), 1, in) == 1) {
+      // A torn size field could ask for gigabytes, no record is longer than
+      // the rest of the file.
+      const uint64_t remaining = file_size - valid_end - sizeof(header);
+      if (header.size < kFixedBodySize || header.size > remaining) break;
+      body.resize(header.size);
+      if (std::fread(body.data(), header.size, 1, in) != 1 ||
+          Checksum(body.data(), body.size()) != header.checksum)
+        break;
+      Record record;
+      size_t offset = 0;
+      uint8_t op;
+      uint16_t key_type_size, table_name_size;
+      Get(body, offset, op);
+      Get(body, offset, key_type_size);
+      Get(body, offset, table_name_size);
+      Get(body, offset, record.key);
+      Get(body, offset, record.payload);
+      Get(body, offset, record.row_delta);
+      Get(body, offset, record.hash_delta);
+      if (offset + key_type_size + table_name_size != body.size() ||
+          op < static_cast<uint8_t>(Op::kInsert) ||
+          op > static_cast<uint8_t>(Op::kUpdate))
+        break;
+      valid_end += sizeof(header) + header.size;
+      if (!records) continue;
+      record.op = static_cast<Op>(op);
+      record.key_type.assign(body.data() + offset, key_type_size);
+      record.table_name.assign(body.data() + offset + key_type_size,
+                               table_name_size);
+      records->push_back(std::move(record));
+    }
+    return valid_end;
+  }
+
+  // Cuts off what follows the last valid record of the log at `path`, whose
+  // header was checked already.
+  static bool TruncateAfterValidRecords(const std::string& path,
+                                        std::string* error) {
+    std::error_code file_error;
+    const uint64_t file_size = std::filesystem::file_size(path, file_error);
+    std::FILE* in = std::fopen(path.c_str(), "rb");
+    if (file_error || !in ||
+        std::fseek(in, sizeof(LogHeader), SEEK_SET) != 0) {
+      if (in) std::fclose(in);
+      *error = "could not read " + path;
+      return false;
+    }
+    const uint64_t valid_end = ReadValidRecords(in, file_size, nullptr);
+    std::fclose(in);
+    if (valid_end == file_size) return true;
+    std::filesystem::resize_file(path, valid_end, file_error);
+    if (file_error) {
+      *error = "could not truncate the torn end of " + path;
+      return false;
+    }
+    return true;
+  }
+
+  static bool ReadHeader(const std::string& path, uint64_t* generation) {
+    std::FILE* in = std::fopen(path.c_str(), "rb");
+    if (!in) return false;
+    LogHeader header;
+    const bool ok =
+        std::fread(&header, sizeof(header), 1, in) == 1 && IsValid(header);
+    std::fclose(in);
+    if (ok) *generation = header.generation;
+    return ok;
+  }
+
+  // Replaces the log at `path` with an empty one of `generation`.
+  static bool WriteHeader(const std::string& path, uint64_t generation,
+                          std::string* error) {
+    LogHeader header = {};
+    std::memcpy(header.magic, "LIDXLOG", 8);
+    header.version = kVersion;
+    header.generation = generation;
+    const std::string tmp_path = path + ".tmp";
+    std::FILE* out = std::fopen(tmp_path.c_str(), "wb");
+    const bool written = out &&
+                         std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+                         Sync(out);
+    if (out) std::fclose(out);
+    if (!written || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+      *error = "could not write " + path;
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  // Flushes `file` and waits until the OS wrote it to disk.
+  static bool Sync(std::FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+  }
+
+  // FNV-1a.
+  static uint32_t Checksum(const char* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+      hash ^= static_cast<uint8_t>(data[i]);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  template <class T>
+  static void Put(std::vector<char>& out, const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+  }
+
+  template <class T>
+  static void Get(const std::vector<char>& in, size_t& offset, T& value) {
+    std::memcpy(&value, in.data() + offset, sizeof(T));
+    offset += sizeof(T);
+  }
+
+  void CloseLocked() {
+    if (file_) std::fclose(file_);
+    file_ = nullptr;
+  }
+
+  mutable std::mutex mutex_;
+  std::string path_;
+  std::FILE* file_ = nullptr;
+  uint64_t generation_ = 0;
+};
+
+}  // namespace duckdb
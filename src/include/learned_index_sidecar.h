@@ -0,0 +1,248 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace duckdb {
+
+// Learned indexes are stored in a directory next to the database file, the
+// sidecar. A manifest lists one entry per index with the table and column it
+// was built on and fingerprints of the table at the time it was written, so
+// that a stale index is never restored. The index data itself lives in one
+// file per index: the sorted (key, payload) pairs for ALEX and PGM, which
+// bulk load without touching the table, and the mapped RadixSpline format.
+//
+// The data files carry the generation of the manifest that lists them in
+// their names, so a checkpoint never overwrites the files of the manifest in
+// place: it writes new files, then the manifest, and removes the old files
+// last.
+struct LearnedIndexManifestEntry {
+  // "alex", "pgm" or "radixspline".
+  std::string kind;
+  // Key type as in `index_type_table_name_map`, or "ubigint" / "uinteger" for
+  // RadixSpline indexes.
+  std::string key_type;
+  std::string table_name;
+  std::string column_name;
+  // Shards of a sharded ALEX index, epsilon of a read-only PGM index, 0
+  // otherwise.
+  uint64_t option = 0;
+  uint64_t row_count = 0;
+  // Hash of the storage metadata of the table, which reads no rows but only
+  // holds while the table does not change.
+  uint64_t fingerprint = 0;
+  // Sum of the hashes of the rows of the table, modulo 2^64. The mutation
+  // log records how every logged change moves it, so it can be checked
+  // against a table that changed since.
+  uint64_t content_hash = 0;
+  // Relative to the sidecar directory.
+  std::string file_name;
+};
+
+class LearnedIndexSidecar {
+ public:
+  static constexpr const char* kManifestName = "manifest";
+  static constexpr uint32_t kVersion = 3;
+
+  // Returns the sidecar directory of the database at `database_path`, or an
+  // empty string for in-memory databases.
+  static std::string DirectoryFor(const std::string& database_path) {
+    if (database_path.empty() || database_path.rfind(":memory:", 0) == 0)
+      return "";
+    return database_path + ".learned_indexes";
+  }
+
+  // Name of the data file `base` of the checkpoint `generation`.
+  static std::string DataFileName(const std::string& base, uint64_t generation,
+                                  const std::string& extension) {
+    return base + "." + std::to_string(generation) + extension;
+  }
+
+  // Returns whether `name` is the name of a data file or of a temporary file
+  // left behind by a write that crashed.
+  static bool IsDataFileName(const std::string& name) {
+    for (const char* extension : {".lidx", ".rs", ".tmp"}) {
+      const size_t length = std::strlen(extension);
+      if (name.size() > length &&
+          name.compare(name.size() - length, length, extension) == 0)
+        return true;
+    }
+    return false;
+  }
+
+  // `generation` numbers the checkpoints; the mutation log of the sidecar
+  // records which one it continues, see learned_index_log.h.
+  static bool WriteManifest(const std::string& directory, uint64_t generation,
+                            const std::vector<LearnedIndexManifestEntry>& entries,
+                            std::string* error) {
+    std::ostringstream out;
+    out << "learned_index_manifest\t" << kVersion << '\t' << generation
+        << "\n";
+    for (const auto& entry : entries) {
+      out << entry.kind << '\t' << entry.key_type << '\t' << entry.table_name
+          << '\t' << entry.column_name << '\t' << entry.option << '\t'
+          << entry.row_count << '\t' << entry.fingerprint << '\t'
+          << entry.content_hash << '\t' << entry.file_name << '\n';
+    }
+    const std::string contents = out.str();
+    return WriteFile(directory + "/" + kManifestName,
+                     {{contents.data(), contents.size()}}, error);
+  }
+
+  // Reads the manifest of `directory`. A missing manifest is not an error and
+  // yields no entries and generation 0. Never throws, a damaged manifest is
+  // reported through `error`.
+  static bool ReadManifest(const std::string& directory, uint64_t* generation,
+                           std::vector<LearnedIndexManifestEntry>* entries,
+                           std::string* error) {
+    *generation = 0;
+    std::ifstream in(directory + "/" + kManifestName);
+    if (!in) return true;
+    std::string line;
+    std::getline(in, line);
+    const std::string header =
+        "learned_index_manifest\t" + std::to_string(kVersion) + "\t";
+    if (line.compare(0, header.size(), header) != 0 ||
+        line.size() == header.size()) {
+      *error = "unsupported learned index manifest in " + directory;
+      return false;
+    }
+    if (!ParseNumber(line.substr(header.size()), generation)) {
+      *error = "corrupt learned index manifest in " + directory;
+      return false;
+    }
+    while (std::getline(in, line)) {
+      if (line.empty()) continue;
+      std::vector<std::string> fields;
+      std::istringstream fields_in(line);
+      std::string field;
+      while (std::getline(fields_in, field, '\t')) fields.push_back(field);
+      LearnedIndexManifestEntry entry;
+      if (fields.size() != 9 || !ParseNumber(fields[4], &entry.option) ||
+          !ParseNumber(fields[5], &entry.row_count) ||
+          !ParseNumber(fields[6], &entry.fingerprint) ||
+          !ParseNumber(fields[7], &entry.content_hash)) {
+        *error = "corrupt learned index manifest in " + directory;
+        return false;
+      }
+      entry.kind = fields[0];
+      entry.key_type = fields[1];
+      entry.table_name = fields[2];
+      entry.column_name = fields[3];
+      entry.file_name = fields[8];
+      entries->push_back(std::move(entry));
+    }
+    return true;
+  }
+
+  // Writes the sorted pairs of an ALEX or PGM index in one piece.
+  template <class K, class P>
+  static bool WritePairs(const std::string& path,
+                         const std::vector<std::pair<K, P>>& pairs,
+                         std::string* error) {
+    const PairsHeader header = MakePairsHeader<K, P>(pairs.size());
+    return WriteFile(path,
+                     {{reinterpret_cast<const char*>(&header), sizeof(header)},
+                      {reinterpret_cast<const char*>(pairs.data()),
+                       pairs.size() * sizeof(std::pair<K, P>)}},
+                     error);
+  }
+
+  // Reads the pairs `WritePairs` wrote to `path`. The count of the header is
+  // checked against the size of the file before anything is allocated.
+  template <class K, class P>
+  static bool ReadPairs(const std::string& path,
+                        std::vector<std::pair<K, P>>* pairs,
+                        std::string* error) {
+    std::error_code file_error;
+    const uint64_t file_size = std::filesystem::file_size(path, file_error);
+    std::ifstream in(path, std::ios::binary);
+    PairsHeader header;
+    if (file_error || !in ||
+        !in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+      *error = "could not read " + path;
+      return false;
+    }
+    const PairsHeader expected = MakePairsHeader<K, P>(header.count);
+    if (std::memcmp(&header, &expected, sizeof(header)) != 0) {
+      *error = path + " does not hold pairs of the expected type";
+      return false;
+    }
+    if (header.count > (file_size - sizeof(header)) / sizeof(std::pair<K, P>)) {
+      *error = path + " is truncated";
+      return false;
+    }
+    pairs->resize(header.count);
+    if (!in.read(reinterpret_cast<char*>(pairs->data()),
+                 header.count * sizeof(std::pair<K, P>))) {
+      *error = path + " is truncated";
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  struct PairsHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t key_size;
+    uint32_t payload_size;
+    uint32_t pair_size;
+    uint64_t count;
+  };
+
+  // Parses a decimal number without throwing, unlike `std::stoull`.
+  static bool ParseNumber(const std::string& text, uint64_t* value) {
+    const char* end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, *value);
+    return result.ec == std::errc() && result.ptr == end;
+  }
+
+  template <class K, class P>
+  static PairsHeader MakePairsHeader(uint64_t count) {
+    PairsHeader header = {};
+    std::memcpy(header.magic, "LIDXPAIR", sizeof(header.magic));
+    header.version = kVersion;
+    header.key_size = sizeof(K);
+    header.payload_size = sizeof(P);
+    header.pair_size = sizeof(std::pair<K, P>);
+    header.count = count;
+    return header;
+  }
+
+  // Writes the `chunks` next to `path` and renames the file into place, so a
+  // crash never leaves a partial file behind.
+  static bool WriteFile(
+      const std::string& path,
+      const std::vector<std::pair<const char*, size_t>>& chunks,
+      std::string* error) {
+    const std::string tmp_path = path + ".tmp";
+    {
+      std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+      for (const auto& chunk : chunks) out.write(chunk.first, chunk.second);
+      out.flush();
+      if (!out) {
+        *error = "could not write " + tmp_path;
+        std::remove(tmp_path.c_str());
+        return false;
+      }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+      *error = "could not rename " + tmp_path + " to " + path;
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+    return true;
+  }
+};
+
+}  // namespace duckdb
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace duckdb {
+
+// Keeps two copies of a data structure so that readers never wait for
+// writers. Readers use the active copy. A writer applies its change to the
+// inactive copy, makes that one the active copy, waits until the readers of
+// the previous copy have left and then applies the change there as well.
+//
+// Readers announce themselves on a counter of the copy they enter, similar to
+// the epochs of epoch-based reclamation: a writer only touches a copy, and
+// with it releases nodes the copy retires, once every reader that could
+// still see it has left. Reads cost two atomic increments and never block;
+// writers are serialized among each other.
+//
+// The price is twice the memory, and every write is applied twice, so writes
+// must be deterministic and leave both copies in the same state.
+template <class T>
+class LeftRight {
+ public:
+  static constexpr size_t kNumCopies = 2;
+
+  LeftRight() = default;
+
+  LeftRight(const LeftRight&) = delete;
+  LeftRight& operator=(const LeftRight&) = delete;
+
+  // Calls `function` on the active copy and returns its result. `function`
+  // must not modify the structure of the copy and must not call `Write`.
+  template <class Function>
+  auto Read(Function&& function) const
+      -> decltype(function(std::declval<T&>())) {
+    while (true) {
+      const size_t copy = active_.load();
+      readers_[copy].count.fetch_add(1);
+      // A writer may have switched copies between the two loads. It does not
+      // wait for readers it did not see yet, so back off and retry.
+      if (active_.load() == copy) {
+        ReaderGuard guard(readers_[copy].count);
+        return function(copies_[copy]);
+      }
+      readers_[copy].count.fetch_sub(1);
+    }
+  }
+
+  // Applies `function` to both copies and returns its result on the first
+  // one.
+  template <class Function>
+  auto Write(Function&& function) -> decltype(function(std::declval<T&>())) {
+    std::lock_guard<std::mutex> guard(write_mutex_);
+    const size_t previous = active_.load();
+    const size_t next = 1 - previous;
+    // Readers left `next` before the previous write returned, so it can be
+    // modified right away.
+    if constexpr (std::is_void<decltype(function(copies_[next]))>::value) {
+      function(copies_[next]);
+      SwitchTo(next);
+      function(copies_[previous]);
+    } else {
+      auto result = function(copies_[next]);
+      SwitchTo(next);
+      function(copies_[previous]);
+      return result;
+    }
+  }
+
+ private:
+  struct alignas(64) ReaderCount {
+    std::atomic<size_t> count{0};
+  };
+
+  struct ReaderGuard {
+    explicit ReaderGuard(std::atomic<size_t>& count) : count(count) {}
+    ~ReaderGuard() { count.fetch_sub(1); }
+    std::atomic<size_t>& count;
+  };
+
+  // Makes `next` the active copy and waits until the readers of the other
+  // copy are gone.
+  void SwitchTo(size_t next) {
+    active_.store(next);
+    while (readers_[1 - next].count.load() != 0) std::this_thread::yield();
+  }
+
+  mutable T copies_[kNumCopies];
+  std::atomic<size_t> active_{0};
+  mutable ReaderCount readers_[kNumCopies];
+  std::mutex write_mutex_;
+};
+
+}  // namespace duckdb
@@ -0,0 +1,294 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "common.h"
+
+namespace rs {
+
+// On-disk layout of a RadixSpline together with the sorted keys it was built
+// on. The file starts with this header, followed by the radix table, the x and
+// the y coordinates of the spline points as separate arrays, and the keys.
+// Every section starts at a multiple of `kAlignment`, so all of them can be
+// used in place once the file is mapped. Integers are stored in the byte
+// order of the machine that wrote the file, which `byte_order` records.
+struct RadixSplineFileHeader {
+  static constexpr char kMagic[8] = {'R', 'S', 'P', 'L', 'I', 'N', 'E', '\0'};
+  static constexpr uint32_t kVersion = 1;
+  static constexpr uint32_t kByteOrder = 0x01020304;
+  static constexpr uint64_t kAlignment = 64;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t key_size;
+  uint32_t reserved;
+  uint64_t min_key;
+  uint64_t max_key;
+  uint64_t num_keys;
+  uint64_t num_radix_bits;
+  uint64_t num_shift_bits;
+  uint64_t max_error;
+  uint64_t radix_table_size;
+  uint64_t num_spline_points;
+  uint64_t radix_table_offset;
+  uint64_t spline_x_offset;
+  uint64_t spline_y_offset;
+  uint64_t keys_offset;
+  uint64_t file_size;
+
+  static uint64_t Align(uint64_t offset) {
+    return (offset + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+  // Fills in the section offsets and the file size from the counts.
+  template <class KeyType>
+  void Layout() {
+    radix_table_offset = Align(sizeof(RadixSplineFileHeader));
+    spline_x_offset =
+        Align(radix_table_offset + radix_table_size * sizeof(uint32_t));
+    spline_y_offset =
+        Align(spline_x_offset + num_spline_points * sizeof(KeyType));
+    keys_offset = Align(spline_y_offset + num_spline_points * sizeof(double));
+    file_size = keys_offset + num_keys * sizeof(KeyType);
+  }
+};
+
+// A RadixSpline that is used straight from a file written by
+// `Serializer::ToFile`, without deserializing it. The file is mapped read-only
+// and the lookups run on the mapped sections, so opening it only costs the
+// validation of the header; the pages are faulted in by the first lookups
+// that touch them.
+template <class KeyType>
+class MappedRadixSpline {
+ public:
+  ~MappedRadixSpline() {
+#ifndef _WIN32
+    if (data_) munmap(const_cast<char*>(data_), size_);
+#endif
+  }
+
+  MappedRadixSpline(const MappedRadixSpline&) = delete;
+  MappedRadixSpline& operator=(const MappedRadixSpline&) = delete;
+
+  // Maps the file at `path`. Returns nullptr and sets `error` if the file can
+  // not be read or is not a RadixSpline file for `KeyType` of this version.
+  static std::shared_ptr<const MappedRadixSpline> Open(const std::string& path,
+                                                       std::string* error) {
+    std::shared_ptr<MappedRadixSpline> spline(new MappedRadixSpline());
+    if (!spline->Map(path, error) || !spline->Validate(error)) return nullptr;
+    return spline;
+  }
+
+  // Returns the estimated position of `key`.
+  double GetEstimatedPosition(const KeyType key) const {
+    if (key <= min_key_) return 0;
+    if (key >= max_key_) return num_keys_ - 1;
+
+    const size_t index = GetSplineSegment(key);
+    const double x_diff = spline_x_[index] - spline_x_[index - 1];
+    const double y_diff = spline_y_[index] - spline_y_[index - 1];
+    const double slope = y_diff / x_diff;
+    const double key_diff = key - spline_x_[index - 1];
+    return std::fma(key_diff, slope, spline_y_[index - 1]);
+  }
+
+  // Returns a search bound [begin, end) around the estimated position.
+  SearchBound GetSearchBound(const KeyType key) const {
+    const size_t estimate = GetEstimatedPosition(key);
+    const size_t begin = (estimate < max_error_) ? 0 : (estimate - max_error_);
+    const size_t end = (estimate + max_error_ + 2 > num_keys_)
+                           ? num_keys_
+                           : (estimate + max_error_ + 2);
+    return SearchBound{begin, end};
+  }
+
+  // The sorted keys the spline was built on.
+  const KeyType* keys() const { return keys_; }
+  size_t num_keys() const { return num_keys_; }
+
+  size_t num_radix_bits() const { return num_radix_bits_; }
+  size_t max_error() const { return max_error_; }
+
+  // Returns the spline segment `key` is estimated in, numbered from 0 in key
+  // order. Keys outside of the spline count to the first or last segment.
+  size_t GetSegment(const KeyType key) const {
+    if (key <= min_key_ || num_spline_points_ < 2) return 0;
+    if (key >= max_key_) return num_spline_points_ - 2;
+    return GetSplineSegment(key) - 1;
+  }
+
+  SplineStats GetStats() const {
+    SplineStats stats;
+    stats.num_keys = num_keys_;
+    stats.num_spline_points = num_spline_points_;
+    stats.num_radix_bits = num_radix_bits_;
+    stats.max_error = max_error_;
+    AddRadixTableStats(radix_table_size_,
+                       [this](size_t i) { return radix_table_[i]; }, &stats);
+    return stats;
+  }
+
+  // Returns the size of the mapping in bytes.
+  size_t GetSize() const { return size_; }
+
+ private:
+  MappedRadixSpline() = default;
+
+  bool Map(const std::string& path, std::string* error) {
+#ifndef _WIN32
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      *error = "could not open " + path + ": " + std::strerror(errno);
+      return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+      *error = "could not read " + path;
+      close(fd);
+      return false;
+    }
+    size_ = info.st_size;
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+      *error = "could not map " + path + ": " + std::strerror(errno);
+      size_ = 0;
+      return false;
+    }
+    data_ = static_cast<const char*>(data);
+#else
+    // Without mmap the file is read into memory in one go.
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+      *error = "could not open " + path;
+      return false;
+    }
+    size_ = in.tellg();
+    buffer_.resize((size_ + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(buffer_.data()), size_)) {
+      *error = "could not read " + path;
+      return false;
+    }
+    data_ = reinterpret_cast<const char*>(buffer_.data());
+#endif
+    return true;
+  }
+
+  bool Validate(std::string* error) {
+    RadixSplineFileHeader header;
+    if (size_ < sizeof(header)) {
+      *error = "file is too small for a RadixSpline file";
+      return false;
+    }
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, RadixSplineFileHeader::kMagic,
+                    sizeof(header.magic)) != 0) {
+      *error = "not a RadixSpline file";
+      return false;
+    }
+    if (header.version != RadixSplineFileHeader::kVersion) {
+      *error = "unsupported RadixSpline file version " +
+               std::to_string(header.version);
+      return false;
+    }
+    if (header.byte_order != RadixSplineFileHeader::kByteOrder) {
+      *error = "RadixSpline file was written with a different byte order";
+      return false;
+    }
+    if (header.key_size != sizeof(KeyType)) {
+      *error = "RadixSpline file has " + std::to_string(header.key_size * 8) +
+               "-bit keys, expected " + std::to_string(sizeof(KeyType) * 8);
+      return false;
+    }
+    // Recompute the layout from the counts rather than trusting the offsets.
+    RadixSplineFileHeader expected = header;
+    expected.Layout<KeyType>();
+    if (std::memcmp(&expected, &header, sizeof(header)) != 0 ||
+        header.file_size != size_) {
+      *error = "RadixSpline file is truncated or corrupt";
+      return false;
+    }
+    // The lookups index the radix table with key prefixes and the spline
+    // points with radix table entries, so their shapes have to match.
+    if (header.num_keys > 0 &&
+        (header.min_key > header.max_key || header.num_shift_bits >= 64 ||
+         // A spline over a single distinct key is a single point.
+         header.num_spline_points <
+             (header.min_key == header.max_key ? 1u : 2u) ||
+         header.radix_table_size !=
+             static_cast<uint32_t>((header.max_key - header.min_key) >>
+                                   header.num_shift_bits) +
+                 2ull)) {
+      *error = "RadixSpline file is corrupt";
+      return false;
+    }
+
+    min_key_ = static_cast<KeyType>(header.min_key);
+    max_key_ = static_cast<KeyType>(header.max_key);
+    num_keys_ = header.num_keys;
+    num_radix_bits_ = header.num_radix_bits;
+    num_shift_bits_ = header.num_shift_bits;
+    max_error_ = header.max_error;
+    num_spline_points_ = header.num_spline_points;
+    radix_table_size_ = header.radix_table_size;
+    radix_table_ =
+        reinterpret_cast<const uint32_t*>(data_ + header.radix_table_offset);
+    spline_x_ = reinterpret_cast<const KeyType*>(data_ + header.spline_x_offset);
+    spline_y_ = reinterpret_cast<const double*>(data_ + header.spline_y_offset);
+    keys_ = reinterpret_cast<const KeyType*>(data_ + header.keys_offset);
+    return true;
+  }
+
+  size_t GetSplineSegment(const KeyType key) const {
+    const KeyType prefix = (key - min_key_) >> num_shift_bits_;
+    const uint32_t begin = radix_table_[prefix];
+    const uint32_t end = radix_table_[prefix + 1];
+
+    if (end - begin < 32) {
+      uint32_t current = begin;
+      while (spline_x_[current] < key) ++current;
+      return current;
+    }
+    return std::lower_bound(spline_x_ + begin, spline_x_ + end, key) -
+           spline_x_;
+  }
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+#ifdef _WIN32
+  std::vector<uint64_t> buffer_;
+#endif
+
+  KeyType min_key_ = 0;
+  KeyType max_key_ = 0;
+  size_t num_keys_ = 0;
+  size_t num_radix_bits_ = 0;
+  size_t num_shift_bits_ = 0;
+  size_t max_error_ = 0;
+  size_t num_spline_points_ = 0;
+  size_t radix_table_size_ = 0;
+
+  const uint32_t* radix_table_ = nullptr;
+  const KeyType* spline_x_ = nullptr;
+  const double* spline_y_ = nullptr;
+  const KeyType* keys_ = nullptr;
+};
+
+}  // namespace rs
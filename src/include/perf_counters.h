@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace duckdb {
+
+// Hardware performance counters of the calling thread, read with
+// perf_event_open(2), to tell whether cache, TLB or branch misses make an
+// index slower on some data. Only user space is counted, which
+// `perf_event_paranoid` up to 2 allows without privileges.
+//
+// Every event is opened on its own, so that a machine without one of them,
+// like a VM without a PMU or a CPU without a dTLB event, still gets the
+// others. If the kernel multiplexes the counters, the values are scaled up
+// to the time the events were enabled. Where no counter can be opened, e.g.
+// on other systems or in containers without perf events, `available()` is
+// false and `Stop` returns a sample without values, so callers fall back to
+// timing only.
+//
+// Not thread-safe; counts the thread that constructed it.
+class PerfCounters {
+ public:
+  enum Event {
+    kCycles,
+    kInstructions,
+    kLLCMisses,
+    kDTLBMisses,
+    kBranchMisses,
+    kNumEvents
+  };
+
+  static const char* GetName(Event event) {
+    static const char* const kNames[kNumEvents] = {
+        "cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses"};
+    return kNames[event];
+  }
+
+  // Counts of a measured region. Events that could not be counted have no
+  // value.
+  struct Sample {
+    bool valid[kNumEvents] = {};
+    double values[kNumEvents] = {};
+
+    bool Has(Event event) const { return valid[event]; }
+    double Get(Event event) const { return values[event]; }
+
+    // Adds the counts of `other`. An event stays valid only if it was counted
+    // in both, as a partial sum would be misleading.
+    void Add(const Sample& other) {
+      for (int i = 0; i < kNumEvents; ++i) {
+        valid[i] = valid[i] && other.valid[i];
+        values[i] += other.values[i];
+      }
+    }
+
+    // Returns a sample to sum others into with `Add`.
+    static Sample Total() {
+      Sample sample;
+      for (int i = 0; i < kNumEvents; ++i) sample.valid[i] = true;
+      return sample;
+    }
+  };
+
+  explicit PerfCounters(bool enabled = true) {
+    for (int i = 0; i < kNumEvents; ++i) fds_[i] = -1;
+    if (enabled) Open();
+  }
+
+  ~PerfCounters() { Close(); }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  bool available() const {
+    for (int i = 0; i < kNumEvents; ++i)
+      if (fds_[i] >= 0) return true;
+    return false;
+  }
+
+  void Start() {
+#ifdef __linux__
+    for (int i = 0; i < kNumEvents; ++i) {
+      if (fds_[i] < 0) continue;
+      ioctl(fds_[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl(fds_[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  Sample Stop() {
+    Sample sample;
+#ifdef __linux__
+    for (int i = 0; i < kNumEvents; ++i)
+      if (fds_[i] >= 0) ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+    for (int i = 0; i < kNumEvents; ++i) {
+      if (fds_[i] < 0) continue;
+      // The value, then the times enabled and running.
+      uint64_t data[3];
+      if (read(fds_[i], data, sizeof(data)) != sizeof(data) || data[2] == 0)
+        continue;
+      double value = static_cast<double>(data[0]);
+      if (data[2] < data[1]) value *= static_cast<double>(data[1]) / data[2];
+      sample.valid[i] = true;
+      sample.values[i] = value;
+    }
+#endif
+    return sample;
+  }
+
+ private:
+  void Open() {
+#ifdef __linux__
+    const uint64_t kReadMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    const struct {
+      uint32_t type;
+      uint64_t config;
+    } kEvents[kNumEvents] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | kReadMiss},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | kReadMiss},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    };
+    for (int i = 0; i < kNumEvents; ++i) {
+      struct perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = kEvents[i].type;
+      attr.config = kEvents[i].config;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format =
+          PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      fds_[i] = static_cast<int>(
+          syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+  }
+
+  void Close() {
+#ifdef __linux__
+    for (int i = 0; i < kNumEvents; ++i)
+      if (fds_[i] >= 0) close(fds_[i]);
+#endif
+    for (int i = 0; i < kNumEvents; ++i) fds_[i] = -1;
+  }
+
+  int fds_[kNumEvents];
+};
+
+}  // namespace duckdb
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include <vector>
+
+namespace duckdb {
+
+// Holds the version of an index that lookups currently use. Rebuilds create a
+// new version off to the side and publish it with a single atomic pointer
+// swap; lookups that still hold the previous version keep it alive until they
+// are done with it.
+//
+// Mutations go through `ApplyWrite`, or `ApplyConcurrentWrite` for indexes that
+// synchronize concurrent writers themselves. While a rebuild is running they
+// are also queued and replayed onto the new version right before it is
+// published, so writes that race with a rebuild are not lost.
+//
+// An index restored from disk can be given a loader instead of a first
+// version; it runs on first access, so restoring costs nothing until the index
+// is used.
+template <class Index>
+class PublishedIndex {
+ public:
+  using Write = std::function<void(Index&)>;
+
+  PublishedIndex() : current_(std::make_shared<Index>()) {}
+
+  PublishedIndex(const PublishedIndex&) = delete;
+  PublishedIndex& operator=(const PublishedIndex&) = delete;
+
+  // Returns the current version. Hot loops should load it once and reuse it.
+  std::shared_ptr<Index> Load() const {
+    RunPendingLoader();
+    return std::atomic_load(&current_);
+  }
+
+  // Convenience accessor for one-off calls. The returned pointer keeps the
+  // version alive until the end of the full expression.
+  std::shared_ptr<Index> operator->() const { return Load(); }
+
+  // Makes `loader` produce the first version when the index is first
+  // accessed. The index stays empty if `loader` returns nullptr. A rebuild or
+  // publish before the first access drops the loader.
+  void SetLoader(std::function<std::shared_ptr<Index>()> loader) {
+    std::lock_guard<std::mutex> guard(loader_mutex_);
+    loader_ = std::move(loader);
+    loader_pending_.store(true);
+  }
+
+  // Starts recording writes for a rebuild that scans the base table from now.
+  // Every rebuild ends with either `Publish` or `AbortRebuild`, see
+  // `ScopedRebuild`.
+  void BeginRebuild() {
+    DropLoader();
+    std::unique_lock<std::shared_mutex> guard(write_mutex_);
+    rebuilding_ = true;
+    pending_writes_.clear();
+  }
+
+  // Ends a rebuild that will not publish, e.g. because its table scan threw.
+  // The recorded writes are dropped, the current version already has them.
+  void AbortRebuild() {
+    std::unique_lock<std::shared_mutex> guard(write_mutex_);
+    rebuilding_ = false;
+    pending_writes_.clear();
+    pending_writes_.shrink_to_fit();
+  }
+
+  // Replays the writes that happened since `BeginRebuild` onto `next` and
+  // makes it the current version.
+  void Publish(std::shared_ptr<Index> next) {
+    DropLoader();
+    std::unique_lock<std::shared_mutex> guard(write_mutex_);
+    for (auto& write : pending_writes_) write(*next);
+    pending_writes_.clear();
+    rebuilding_ = false;
+    std::atomic_store(&current_, std::move(next));
+  }
+
+  // Applies `write` to the current version. Writers are serialized. `write`
+  // must not capture by reference and should be idempotent, as it may be
+  // replayed onto a version whose table scan already saw its effect.
+  void ApplyWrite(Write write) {
+    RunPendingLoader();
+    std::unique_lock<std::shared_mutex> guard(write_mutex_);
+    write(*current_);
+    if (rebuilding_) pending_writes_.push_back(std::move(write));
+  }
+
+  // Like `ApplyWrite`, but runs concurrently with other concurrent writes. Only
+  // for indexes that are safe to modify from several threads at once. Racing
+  // writes to the same key may be replayed in either order.
+  void ApplyConcurrentWrite(Write write) {
+    RunPendingLoader();
+    std::shared_lock<std::shared_mutex> guard(write_mutex_);
+    write(*current_);
+    if (rebuilding_) {
+      std::lock_guard<std::mutex> pending_guard(pending_mutex_);
+      pending_writes_.push_back(std::move(write));
+    }
+  }
+
+  // Calls `read` on the current version while no write or other exclusive
+  // read runs and returns its result, e.g. to copy a consistent image of it,
+  // or to look up keys in an index whose lookups update it, like the cost
+  // counters of ALEX.
+  template <class Read>
+  auto ReadExclusive(Read&& read) -> decltype(read(std::declval<Index&>())) {
+    RunPendingLoader();
+    std::unique_lock<std::shared_mutex> guard(write_mutex_);
+    return read(*current_);
+  }
+
+  bool IsRebuilding() const {
+    std::shared_lock<std::shared_mutex> guard(write_mutex_);
+    return rebuilding_;
+  }
+
+  // Begins a rebuild and aborts it when it goes out of scope before the new
+  // version was published, so that a build that throws half way does not
+  // leave the index recording writes forever. Builds of one index must not
+  // overlap.
+  class ScopedRebuild {
+   public:
+    explicit ScopedRebuild(PublishedIndex& index) : index_(index) {
+      index_.BeginRebuild();
+    }
+    ~ScopedRebuild() {
+      if (index_.IsRebuilding()) index_.AbortRebuild();
+    }
+
+    ScopedRebuild(const ScopedRebuild&) = delete;
+    ScopedRebuild& operator=(const ScopedRebuild&) = delete;
+
+   private:
+    PublishedIndex& index_;
+  };
+
+ private:
+  void RunPendingLoader() const {
+    if (!loader_pending_.load(std::memory_order_acquire)) return;
+    // Callers that race with the loader wait for its version.
+    std::lock_guard<std::mutex> guard(loader_mutex_);
+    if (!loader_pending_.load()) return;
+    auto loaded = loader_();
+    loader_ = nullptr;
+    if (loaded) {
+      std::unique_lock<std::shared_mutex> write_guard(write_mutex_);
+      std::atomic_store(&current_, std::move(loaded));
+    }
+    loader_pending_.store(false, std::memory_order_release);
+  }
+
+  void DropLoader() {
+    std::lock_guard<std::mutex> guard(loader_mutex_);
+    loader_ = nullptr;
+    loader_pending_.store(false);
+  }
+
+  mutable std::shared_ptr<Index> current_;
+
+  mutable std::shared_mutex write_mutex_;
+  bool rebuilding_ = false;
+  // Guards `pending_writes_` among concurrent writers.
+  std::mutex pending_mutex_;
+  std::vector<Write> pending_writes_;
+
+  mutable std::mutex loader_mutex_;
+  mutable std::function<std::shared_ptr<Index>()> loader_;
+  mutable std::atomic<bool> loader_pending_{false};
+};
+
+}  // namespace duckdb
@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "common.h"
+#include "dense_prefix_table.h"
 
 namespace rs {
 
@@ -61,10 +62,44 @@ class RadixSpline {
     return SearchBound{begin, end};
   }
 
+  // Adds a second radix table level under the prefixes that span more than
+  // `max_points` spline points, see `DensePrefixTable`. Pays off for skewed
+  // keys, where a few prefixes hold most of the spline.
+  void RefineDensePrefixes(size_t max_points = 32) {
+    dense_prefixes_ = DensePrefixTable(
+        radix_table_, num_shift_bits_, max_points, [this](size_t i) {
+          return static_cast<uint64_t>(spline_points_[i].x - min_key_);
+        });
+  }
+
+  size_t GetNumRefinedPrefixes() const {
+    return dense_prefixes_.num_refined_prefixes();
+  }
+
+  // Returns the spline segment `key` is estimated in, numbered from 0 in key
+  // order. Keys outside of the spline count to the first or last segment.
+  size_t GetSegment(const KeyType key) const {
+    if (key <= min_key_ || spline_points_.size() < 2) return 0;
+    if (key >= max_key_) return spline_points_.size() - 2;
+    return GetSplineSegment(key) - 1;
+  }
+
+  SplineStats GetStats() const {
+    SplineStats stats;
+    stats.num_keys = num_keys_;
+    stats.num_spline_points = spline_points_.size();
+    stats.num_radix_bits = num_radix_bits_;
+    stats.max_error = max_error_;
+    AddRadixTableStats(radix_table_.size(),
+                       [this](size_t i) { return radix_table_[i]; }, &stats);
+    return stats;
+  }
+
   // Returns the size in bytes.
   size_t GetSize() const {
     return sizeof(*this) + radix_table_.size() * sizeof(uint32_t) +
-           spline_points_.size() * sizeof(Coord<KeyType>);
+           spline_points_.size() * sizeof(Coord<KeyType>) +
+           dense_prefixes_.GetSize();
   }
 
  private:
@@ -74,8 +109,10 @@ class RadixSpline {
     // Narrow search range using radix table.
     const KeyType prefix = (key - min_key_) >> num_shift_bits_;
     assert(prefix + 1 < radix_table_.size());
-    const uint32_t begin = radix_table_[prefix];
-    const uint32_t end = radix_table_[prefix + 1];
+    uint32_t begin = radix_table_[prefix];
+    uint32_t end = radix_table_[prefix + 1];
+    if (end - begin >= 32)
+      dense_prefixes_.Narrow(prefix, key - min_key_, &begin, &end);
 
     if (end - begin < 32) {
       // Do linear search over narrowed range.
@@ -102,9 +139,13 @@ class RadixSpline {
 
   std::vector<uint32_t> radix_table_;
   std::vector<rs::Coord<KeyType>> spline_points_;
+  // Empty unless `RefineDensePrefixes` was called.
+  DensePrefixTable dense_prefixes_;
 
   template <typename>
   friend class Serializer;
+  template <typename>
+  friend class CompressedRadixSpline;
 };
 
 }  // namespace rs
\ No newline at end of file
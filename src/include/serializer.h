@@ -1,7 +1,12 @@
 #pragma once
 
-#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
 
+#include "mapped_radix_spline.h"
 #include "radix_spline.h"
 
 namespace rs {
@@ -11,74 +16,142 @@ class Serializer {
  public:
   // Serializes the `rs` model and appends it to `bytes`.
   static void ToBytes(const RadixSpline<KeyType>& rs, std::string* bytes) {
-    std::stringstream buffer;
+    // Size the output once and copy the members in place instead of streaming
+    // them entry by entry.
+    const size_t radix_table_size = rs.radix_table_.size();
+    const size_t spline_points_size = rs.spline_points_.size();
+    size_t offset = bytes->size();
+    bytes->resize(offset + 2 * sizeof(KeyType) + 7 * sizeof(size_t) +
+                  radix_table_size * sizeof(uint32_t) +
+                  spline_points_size * (sizeof(KeyType) + sizeof(double)));
+    char* out = &(*bytes)[0];
+    const auto append = [out, &offset](const void* data, size_t size) {
+      std::memcpy(out + offset, data, size);
+      offset += size;
+    };
 
     // Scalar members.
-    buffer.write(reinterpret_cast<const char*>(&rs.min_key_), sizeof(KeyType));
-    buffer.write(reinterpret_cast<const char*>(&rs.max_key_), sizeof(KeyType));
-    buffer.write(reinterpret_cast<const char*>(&rs.num_keys_), sizeof(size_t));
-    buffer.write(reinterpret_cast<const char*>(&rs.num_radix_bits_),
-                 sizeof(size_t));
-    buffer.write(reinterpret_cast<const char*>(&rs.num_shift_bits_),
-                 sizeof(size_t));
-    buffer.write(reinterpret_cast<const char*>(&rs.max_error_), sizeof(size_t));
+    append(&rs.min_key_, sizeof(KeyType));
+    append(&rs.max_key_, sizeof(KeyType));
+    append(&rs.num_keys_, sizeof(size_t));
+    append(&rs.num_radix_bits_, sizeof(size_t));
+    append(&rs.num_shift_bits_, sizeof(size_t));
+    append(&rs.max_error_, sizeof(size_t));
 
     // Radix table.
-    const size_t radix_table_size = rs.radix_table_.size();
-    buffer.write(reinterpret_cast<const char*>(&radix_table_size),
-                 sizeof(size_t));
-    for (size_t i = 0; i < rs.radix_table_.size(); ++i) {
-      buffer.write(reinterpret_cast<const char*>(&rs.radix_table_[i]),
-                   sizeof(uint32_t));
-    }
+    append(&radix_table_size, sizeof(size_t));
+    append(rs.radix_table_.data(), radix_table_size * sizeof(uint32_t));
 
-    // Spline points.
-    const size_t spline_points_size = rs.spline_points_.size();
-    buffer.write(reinterpret_cast<const char*>(&spline_points_size),
-                 sizeof(size_t));
-    for (size_t i = 0; i < rs.spline_points_.size(); ++i) {
-      buffer.write(reinterpret_cast<const char*>(&rs.spline_points_[i].x),
-                   sizeof(KeyType));
-      buffer.write(reinterpret_cast<const char*>(&rs.spline_points_[i].y),
-                   sizeof(double));
+    // Spline points, without the padding of `Coord`.
+    append(&spline_points_size, sizeof(size_t));
+    for (const auto& point : rs.spline_points_) {
+      append(&point.x, sizeof(KeyType));
+      append(&point.y, sizeof(double));
     }
-
-    bytes->append(buffer.str());
   }
 
   static RadixSpline<KeyType> FromBytes(const std::string& bytes) {
-    std::istringstream in(bytes);
-
     RadixSpline<KeyType> rs;
+    size_t offset = 0;
+    const auto read = [&bytes, &offset](void* data, size_t size) {
+      std::memcpy(data, bytes.data() + offset, size);
+      offset += size;
+    };
 
     // Scalar members.
-    in.read(reinterpret_cast<char*>(&rs.min_key_), sizeof(KeyType));
-    in.read(reinterpret_cast<char*>(&rs.max_key_), sizeof(KeyType));
-    in.read(reinterpret_cast<char*>(&rs.num_keys_), sizeof(size_t));
-    in.read(reinterpret_cast<char*>(&rs.num_radix_bits_), sizeof(size_t));
-    in.read(reinterpret_cast<char*>(&rs.num_shift_bits_), sizeof(size_t));
-    in.read(reinterpret_cast<char*>(&rs.max_error_), sizeof(size_t));
+    read(&rs.min_key_, sizeof(KeyType));
+    read(&rs.max_key_, sizeof(KeyType));
+    read(&rs.num_keys_, sizeof(size_t));
+    read(&rs.num_radix_bits_, sizeof(size_t));
+    read(&rs.num_shift_bits_, sizeof(size_t));
+    read(&rs.max_error_, sizeof(size_t));
 
     // Radix table.
     size_t radix_table_size;
-    in.read(reinterpret_cast<char*>(&radix_table_size), sizeof(size_t));
+    read(&radix_table_size, sizeof(size_t));
     rs.radix_table_.resize(radix_table_size);
-    for (int i = 0; i < rs.radix_table_.size(); ++i) {
-      in.read(reinterpret_cast<char*>(&rs.radix_table_[i]), sizeof(uint32_t));
-    }
+    read(rs.radix_table_.data(), radix_table_size * sizeof(uint32_t));
 
     // Spline points.
     size_t spline_points_size;
-    in.read(reinterpret_cast<char*>(&spline_points_size), sizeof(size_t));
+    read(&spline_points_size, sizeof(size_t));
     rs.spline_points_.resize(spline_points_size);
-    for (int i = 0; i < rs.spline_points_.size(); ++i) {
-      in.read(reinterpret_cast<char*>(&rs.spline_points_[i].x),
-              sizeof(KeyType));
-      in.read(reinterpret_cast<char*>(&rs.spline_points_[i].y), sizeof(double));
+    for (auto& point : rs.spline_points_) {
+      read(&point.x, sizeof(KeyType));
+      read(&point.y, sizeof(double));
     }
 
     return rs;
   }
+
+  // Writes `rs` together with the `num_keys` sorted keys it was built on to
+  // `path` in the layout of `RadixSplineFileHeader`, which
+  // `MappedRadixSpline` uses in place. The file is written next to `path` and
+  // renamed into place, so readers never see a partial file. Returns false and
+  // sets `error` on failure.
+  static bool ToFile(const RadixSpline<KeyType>& rs, const KeyType* keys,
+                     size_t num_keys, const std::string& path,
+                     std::string* error) {
+    RadixSplineFileHeader header = {};
+    std::memcpy(header.magic, RadixSplineFileHeader::kMagic,
+                sizeof(header.magic));
+    header.version = RadixSplineFileHeader::kVersion;
+    header.byte_order = RadixSplineFileHeader::kByteOrder;
+    header.key_size = sizeof(KeyType);
+    // A spline over no keys is never built, so its members are not set.
+    if (num_keys > 0) {
+      header.min_key = rs.min_key_;
+      header.max_key = rs.max_key_;
+      header.num_keys = num_keys;
+      header.num_radix_bits = rs.num_radix_bits_;
+      header.num_shift_bits = rs.num_shift_bits_;
+      header.max_error = rs.max_error_;
+      header.radix_table_size = rs.radix_table_.size();
+      header.num_spline_points = rs.spline_points_.size();
+    }
+    header.Layout<KeyType>();
+
+    std::vector<KeyType> spline_x;
+    std::vector<double> spline_y;
+    spline_x.reserve(header.num_spline_points);
+    spline_y.reserve(header.num_spline_points);
+    for (size_t i = 0; i < header.num_spline_points; ++i) {
+      spline_x.push_back(rs.spline_points_[i].x);
+      spline_y.push_back(rs.spline_points_[i].y);
+    }
+
+    const std::string tmp_path = path + ".tmp";
+    {
+      std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+      const auto write_at = [&out](uint64_t offset, const void* data,
+                                   size_t size) {
+        // Pads the gap up to `offset` with zeros.
+        static const char zeros[RadixSplineFileHeader::kAlignment] = {};
+        out.write(zeros, offset - static_cast<uint64_t>(out.tellp()));
+        out.write(static_cast<const char*>(data), size);
+      };
+      out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      write_at(header.radix_table_offset, rs.radix_table_.data(),
+               header.radix_table_size * sizeof(uint32_t));
+      write_at(header.spline_x_offset, spline_x.data(),
+               spline_x.size() * sizeof(KeyType));
+      write_at(header.spline_y_offset, spline_y.data(),
+               spline_y.size() * sizeof(double));
+      write_at(header.keys_offset, keys, num_keys * sizeof(KeyType));
+      out.flush();
+      if (!out) {
+        *error = "could not write " + tmp_path;
+        std::remove(tmp_path.c_str());
+        return false;
+      }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+      *error = "could not rename " + tmp_path + " to " + path;
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+    return true;
+  }
 };
 
 }  // namespace rs
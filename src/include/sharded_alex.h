@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "ALEX/src/core/alex.h"
+#include "learned_index_allocator.h"
+#include "left_right.h"
+
+namespace duckdb {
+
+// An ALEX index whose nodes come from the `LearnedIndexMemoryPool`.
+template <class K, class P>
+using AlexIndex =
+    alex::Alex<K, P, alex::AlexCompare, PoolAllocator<std::pair<K, P>>>;
+
+// Splits the key space into ranges and keeps one ALEX index per range, so
+// that writers on different ranges do not contend. The shard boundaries are
+// picked from the CDF of the keys at bulk load, so every shard starts out with
+// the same number of keys. An unsharded ALEX index is one with a single shard.
+//
+// Every shard keeps two copies of its ALEX index in a `LeftRight`, so lookups
+// never take a lock, not even while an insert splits or expands nodes of the
+// same shard. Writers of a shard are serialized and apply their change to both
+// copies. Point operations touch a single shard; range scans visit the shards
+// in key order, which yields the keys in sorted order without a separate merge
+// step.
+//
+// The lookups of ALEX itself bump cost model counters in the index and its
+// data nodes, which would make concurrent readers of a copy race. Lookups here
+// take the same path through the nodes without touching them, see `Find`, so
+// only writes, which own their copy, update the counters.
+template <class K, class P>
+class ShardedAlex {
+ public:
+  using Index = AlexIndex<K, P>;
+  using value_type = std::pair<K, P>;
+
+  // An index without shards. It stays empty, as there is no shard to insert
+  // into.
+  ShardedAlex() = default;
+
+  // Bulk loads `num_keys` values sorted by key into `num_shards` shards. Uses
+  // fewer shards if there are fewer distinct keys than shards.
+  ShardedAlex(const value_type* values, size_t num_keys, size_t num_shards) {
+    num_shards = std::max<size_t>(1, std::min(num_shards, num_keys));
+    size_t begin = 0;
+    for (size_t shard = 0; shard < num_shards; ++shard) {
+      size_t end = std::max(begin, num_keys * (shard + 1) / num_shards);
+      // All copies of a key go to the same shard.
+      while (end < num_keys && end > begin &&
+             values[end].first == values[end - 1].first)
+        ++end;
+      if (end == begin) continue;
+      if (!shards_.empty()) boundaries_.push_back(values[begin].first);
+      shards_.push_back(std::make_unique<Shard>());
+      shards_.back()->Write([&](Index& index) {
+        index.bulk_load(values + begin, static_cast<int>(end - begin));
+      });
+      begin = end;
+    }
+    if (shards_.empty()) shards_.push_back(std::make_unique<Shard>());
+  }
+
+  ShardedAlex(const ShardedAlex&) = delete;
+  ShardedAlex& operator=(const ShardedAlex&) = delete;
+
+  size_t num_shards() const { return shards_.size(); }
+
+  // Inserts `key`, or sets its payload if it is present already. Returns true
+  // if it was inserted.
+  bool insert(const K& key, const P& payload) {
+    if (shards_.empty()) return false;
+    return GetShard(key).Write(
+        [&](Index& index) { return Upsert(index, key, payload); });
+  }
+
+  // Inserts `values`, which need to be sorted, like `insert`; of equal keys
+  // the last payload wins. Writes each affected shard once.
+  void insert_batch(const std::vector<value_type>& values) {
+    size_t begin = 0;
+    while (begin < values.size() && !shards_.empty()) {
+      const size_t shard_id = GetShardId(values[begin].first);
+      const size_t end =
+          shard_id < boundaries_.size()
+              ? std::lower_bound(values.begin() + begin, values.end(),
+                                 boundaries_[shard_id],
+                                 [](const value_type& value, const K& key) {
+                                   return value.first < key;
+                                 }) -
+                    values.begin()
+              : values.size();
+      shards_[shard_id]->Write([&](Index& index) {
+        for (size_t i = begin; i < end; ++i)
+          Upsert(index, values[i].first, values[i].second);
+      });
+      begin = end;
+    }
+  }
+
+  // Removes all entries with key `key` and returns their number.
+  int erase(const K& key) {
+    if (shards_.empty()) return 0;
+    return GetShard(key).Write([&](Index& index) { return index.erase(key); });
+  }
+
+  // Sets the payload of `key`, if it is present.
+  bool update(const K& key, const P& payload) {
+    if (shards_.empty()) return false;
+    return GetShard(key).Write([&](Index& index) {
+      P* current = index.get_payload(key);
+      if (!current) return false;
+      *current = payload;
+      return true;
+    });
+  }
+
+  // Returns a copy of the payload of `key`. Unlike `AlexIndex::get_payload`
+  // this can not hand out a pointer, as the next write may move the entry.
+  // Never blocks.
+  std::optional<P> get_payload(const K& key) const {
+    if (shards_.empty()) return std::nullopt;
+    return GetShard(key).Read([&](Index& index) -> std::optional<P> {
+      const P* payload = Find(index, key);
+      if (!payload) return std::nullopt;
+      return *payload;
+    });
+  }
+
+  // Calls `callback(key, payload)` for the entries with keys in [lo, hi), in
+  // key order. Writers of a shard wait until the scan has left it, so
+  // `callback` must not modify this index.
+  template <class Callback>
+  void range_scan(const K& lo, const K& hi, Callback&& callback) const {
+    if (shards_.empty() || !(lo < hi)) return;
+    const size_t last = GetShardId(hi);
+    for (size_t shard_id = GetShardId(lo); shard_id <= last; ++shard_id) {
+      shards_[shard_id]->Read(
+          [&](Index& index) { ScanFrom(index, lo, hi, callback); });
+    }
+  }
+
+  // Calls `callback(key, payload)` for all entries, in key order.
+  template <class Callback>
+  void for_each(Callback&& callback) const {
+    for (const auto& shard : shards_) {
+      shard->Read([&](Index& index) {
+        for (auto it = index.begin(); it != index.end(); it++)
+          callback(it.key(), it.payload());
+      });
+    }
+  }
+
+  // Calls `function(index)` with one copy of the ALEX index of every shard,
+  // in key order. Writers of a shard wait until `function` is done with it,
+  // so `function` must not modify this index.
+  template <class Function>
+  void for_each_shard(Function&& function) const {
+    ForEachShard(function);
+  }
+
+  size_t size() const {
+    size_t size = 0;
+    ForEachShard([&size](const Index& index) { size += index.size(); });
+    return size;
+  }
+
+  // The sizes in bytes include both copies of every shard.
+  long long model_size() const {
+    long long size = 0;
+    ForEachShard([&size](const Index& index) { size += index.model_size(); });
+    return size * Shard::kNumCopies;
+  }
+
+  long long data_size() const {
+    long long size = 0;
+    ForEachShard([&size](const Index& index) { size += index.data_size(); });
+    return size * Shard::kNumCopies;
+  }
+
+ private:
+  using Shard = LeftRight<Index>;
+
+  size_t GetShardId(const K& key) const {
+    return std::upper_bound(boundaries_.begin(), boundaries_.end(), key) -
+           boundaries_.begin();
+  }
+
+  Shard& GetShard(const K& key) const { return *shards_[GetShardId(key)]; }
+
+  using DataNode = typename Index::data_node_type;
+  using ModelNode = typename Index::model_node_type;
+
+  // The data node `key` belongs in, as `Alex::get_leaf` finds it.
+  static DataNode* FindLeaf(const Index& index, const K& key) {
+    auto* node = index.root_node_;
+    while (!node->is_leaf_) {
+      auto* model_node = static_cast<ModelNode*>(node);
+      const int child =
+          static_cast<int>(model_node->model_.predict_double(key));
+      node = model_node->children_[std::min(std::max(child, 0),
+                                            model_node->num_children_ - 1)];
+    }
+    return static_cast<DataNode*>(node);
+  }
+
+  // The first slot of `leaf` whose key is not `before` the one looked for,
+  // found by an exponential search from the slot the model of `leaf` predicts
+  // for `key`, like the searches of `AlexDataNode`. The gaps of a data node
+  // hold the key of the next slot in use, so its keys are sorted.
+  template <class Before>
+  static int SearchSlot(DataNode& leaf, const K& key, Before before) {
+    const int size = leaf.data_capacity_;
+    const int predicted = leaf.predict_position(key);
+    // The slot is in [lo, hi].
+    int lo, hi;
+    int bound = 1;
+    if (before(leaf.get_key(predicted))) {
+      while (predicted + bound < size &&
+             before(leaf.get_key(predicted + bound)))
+        bound *= 2;
+      lo = predicted + bound / 2 + 1;
+      hi = std::min(predicted + bound, size);
+    } else {
+      while (bound <= predicted && !before(leaf.get_key(predicted - bound)))
+        bound *= 2;
+      lo = std::max(predicted - bound + 1, 0);
+      hi = predicted - bound / 2;
+    }
+    while (lo < hi) {
+      const int mid = lo + (hi - lo) / 2;
+      if (before(leaf.get_key(mid)))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
+  // Returns the payload of `key`, or nullptr, like `Alex::get_payload`. Of
+  // the slots that hold `key`, the last one is in use, the ones before it are
+  // gaps.
+  static const P* Find(const Index& index, const K& key) {
+    DataNode* leaf = FindLeaf(index, key);
+    if (leaf->data_capacity_ <= 0) return nullptr;
+    const int slot = SearchSlot(*leaf, key, [&key](const K& other) {
+                       return !(key < other);
+                     }) -
+                     1;
+    if (slot < 0 || leaf->get_key(slot) < key) return nullptr;
+    return &leaf->get_payload(slot);
+  }
+
+  // Calls `callback(key, payload)` for the entries of `index` with keys in
+  // [lo, hi), in key order, like iterating from `Alex::lower_bound`.
+  template <class Callback>
+  static void ScanFrom(const Index& index, const K& lo, const K& hi,
+                       Callback& callback) {
+    DataNode* leaf = FindLeaf(index, lo);
+    int slot = leaf->data_capacity_ > 0
+                   ? SearchSlot(*leaf, lo,
+                                [&lo](const K& other) { return other < lo; })
+                   : 0;
+    for (; leaf != nullptr; leaf = leaf->next_leaf_, slot = 0) {
+      for (; slot < leaf->data_capacity_; ++slot) {
+        if (!leaf->check_exists(slot)) continue;
+        if (!(leaf->get_key(slot) < hi)) return;
+        callback(leaf->get_key(slot), leaf->get_payload(slot));
+      }
+    }
+  }
+
+  static bool Upsert(Index& index, const K& key, const P& payload) {
+    P* current = index.get_payload(key);
+    if (current) {
+      *current = payload;
+      return false;
+    }
+    index.insert(key, payload);
+    return true;
+  }
+
+  template <class Function>
+  void ForEachShard(Function&& function) const {
+    for (const auto& shard : shards_) shard->Read(function);
+  }
+
+  // Shard i holds the keys in [boundaries_[i - 1], boundaries_[i]). Both are
+  // fixed at construction, only the shards themselves change.
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::vector<K> boundaries_;
+};
+
+}  // namespace duckdb
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "learned_index_allocator.h"
+#include "pgm/pgm_index.hpp"
+
+namespace duckdb {
+
+// Read-only learned index for columns that never change. The (key, payload)
+// pairs live in one sorted array and a static `pgm::PGMIndex` over the keys
+// narrows every search down to 2 * epsilon + 2 entries. Unlike
+// `pgm::DynamicPGMIndex` there are no insert buffers or per-level overheads.
+// The pairs are allocated from the `LearnedIndexMemoryPool`.
+//
+// The lookup and range functions mirror the ones of `pgm::DynamicPGMIndex`,
+// so code written against either index works with both. The error bound is a
+// template parameter in the PGM-index library, so it is chosen at build time
+// from `kSupportedEpsilons`.
+template <class K, class V>
+class StaticPGMIndex {
+ public:
+  using value_type = std::pair<K, V>;
+  using iterator = typename std::vector<value_type,
+                                        PoolAllocator<value_type>>::const_iterator;
+
+  static constexpr size_t kDefaultEpsilon = 64;
+  static constexpr size_t kSupportedEpsilons[] = {16, 32, 64, 128, 256};
+
+  static bool IsSupportedEpsilon(size_t epsilon) {
+    return std::find(std::begin(kSupportedEpsilons),
+                     std::end(kSupportedEpsilons),
+                     epsilon) != std::end(kSupportedEpsilons);
+  }
+
+  StaticPGMIndex() = default;
+
+  // Builds the index on the pairs in [first, last), which need to be sorted by
+  // key. Of several pairs with the same key only the first is kept.
+  // `epsilon` must be one of `kSupportedEpsilons`.
+  template <class RandomIt>
+  StaticPGMIndex(RandomIt first, RandomIt last,
+                 size_t epsilon = kDefaultEpsilon)
+      : epsilon_(epsilon) {
+    data_.reserve(std::distance(first, last));
+    for (auto it = first; it != last; ++it) {
+      if (data_.empty() || data_.back().first != it->first)
+        data_.emplace_back(it->first, it->second);
+    }
+    std::vector<K> keys;
+    keys.reserve(data_.size());
+    for (const auto& pair : data_) keys.push_back(pair.first);
+    switch (epsilon) {
+      case 16: model_.template emplace<pgm::PGMIndex<K, 16>>(keys); break;
+      case 32: model_.template emplace<pgm::PGMIndex<K, 32>>(keys); break;
+      case 64: model_.template emplace<pgm::PGMIndex<K, 64>>(keys); break;
+      case 128: model_.template emplace<pgm::PGMIndex<K, 128>>(keys); break;
+      case 256: model_.template emplace<pgm::PGMIndex<K, 256>>(keys); break;
+      default: data_.clear(); epsilon_ = 0; break;
+    }
+  }
+
+  // Returns an iterator to the first pair with a key not less than `key`.
+  iterator lower_bound(const K& key) const {
+    if (data_.empty()) return end();
+    size_t lo = 0;
+    size_t hi = data_.size();
+    std::visit(
+        [&](const auto& model) {
+          using Model = std::decay_t<decltype(model)>;
+          if constexpr (!std::is_same<Model, std::monostate>::value) {
+            const auto approx = model.search(key);
+            lo = approx.lo;
+            hi = std::min(approx.hi, data_.size());
+          }
+        },
+        model_);
+    return std::lower_bound(
+        data_.begin() + lo, data_.begin() + hi, key,
+        [](const value_type& pair, const K& k) { return pair.first < k; });
+  }
+
+  // Returns an iterator to the pair with key `key`, or `end()`.
+  iterator find(const K& key) const {
+    const auto it = lower_bound(key);
+    return it != end() && it->first == key ? it : end();
+  }
+
+  // Returns the pairs with keys in [lo, hi).
+  std::vector<value_type> range(const K& lo, const K& hi) const {
+    std::vector<value_type> result;
+    for (auto it = lower_bound(lo); it != end() && it->first < hi; ++it)
+      result.push_back(*it);
+    return result;
+  }
+
+  // Returns the position in the pairs the model estimates for `key`, which
+  // `lower_bound` searches around within epsilon.
+  size_t estimate_position(const K& key) const {
+    return std::visit(
+        [&key](const auto& model) -> size_t {
+          using Model = std::decay_t<decltype(model)>;
+          if constexpr (std::is_same<Model, std::monostate>::value) {
+            return 0;
+          } else {
+            return model.search(key).pos;
+          }
+        },
+        model_);
+  }
+
+  iterator begin() const { return data_.begin(); }
+  iterator end() const { return data_.end(); }
+
+  size_t size() const { return data_.size(); }
+  bool empty() const { return data_.empty(); }
+
+  // Returns the epsilon the index was built with, 0 if it is empty.
+  size_t epsilon() const { return epsilon_; }
+
+  size_t segments_count() const {
+    return std::visit(
+        [](const auto& model) -> size_t {
+          using Model = std::decay_t<decltype(model)>;
+          if constexpr (std::is_same<Model, std::monostate>::value) {
+            return 0;
+          } else {
+            return model.segments_count();
+          }
+        },
+        model_);
+  }
+
+  // Returns the number of levels of the PGM model, 0 if it is empty.
+  size_t height() const {
+    return std::visit(
+        [](const auto& model) -> size_t {
+          using Model = std::decay_t<decltype(model)>;
+          if constexpr (std::is_same<Model, std::monostate>::value) {
+            return 0;
+          } else {
+            return model.height();
+          }
+        },
+        model_);
+  }
+
+  // Returns the size of the PGM model in bytes.
+  size_t index_size_in_bytes() const {
+    return std::visit(
+        [](const auto& model) -> size_t {
+          using Model = std::decay_t<decltype(model)>;
+          if constexpr (std::is_same<Model, std::monostate>::value) {
+            return 0;
+          } else {
+            return model.size_in_bytes();
+          }
+        },
+        model_);
+  }
+
+  // Returns the size of the model plus the pairs in bytes.
+  size_t size_in_bytes() const {
+    return index_size_in_bytes() + data_.size() * sizeof(value_type);
+  }
+
+ private:
+  std::vector<value_type, PoolAllocator<value_type>> data_;
+  size_t epsilon_ = 0;
+  std::variant<std::monostate, pgm::PGMIndex<K, 16>, pgm::PGMIndex<K, 32>,
+               pgm::PGMIndex<K, 64>, pgm::PGMIndex<K, 128>,
+               pgm::PGMIndex<K, 256>>
+      model_;
+};
+
+}  // namespace duckdb
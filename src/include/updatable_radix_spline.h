@@ -0,0 +1,569 @@
+#pragma once
+
+#include <algorithm>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "builder.h"
+#include "common.h"
+#include "compressed_radix_spline.h"
+#include "mapped_radix_spline.h"
+#include "radix_spline.h"
+#include "serializer.h"
+
+namespace rs {
+
+// Makes a `RadixSpline` updatable. The spline is built over a sorted base
+// array of keys and stays read-only; new keys go to a small sorted delta
+// buffer that lookups consult as well, and erased base keys are recorded as
+// sorted tombstones. Once delta keys and tombstones together reach
+// `merge_threshold` they are frozen and merged with the base keys into a
+// freshly built spline on a background thread. The merged version is then
+// swapped in atomically, while new updates keep going to fresh buffers.
+//
+// `Save` writes the keys and the spline to a file that `Load` maps and uses
+// in place, so reopening an index does not rebuild it.
+//
+// With `SetCompressed`, builds and merges keep a `CompressedRadixSpline`
+// instead of the spline itself. With `SetTwoLevelRadixTable`, they refine the
+// dense prefixes of the radix table, see `DensePrefixTable`.
+template <class KeyType>
+class UpdatableRadixSpline {
+ public:
+  static constexpr size_t kDefaultMergeThreshold = 4096;
+
+  UpdatableRadixSpline() : state_(std::make_shared<const State>()) {}
+
+  ~UpdatableRadixSpline() { WaitForMerge(); }
+
+  UpdatableRadixSpline(const UpdatableRadixSpline&) = delete;
+  UpdatableRadixSpline& operator=(const UpdatableRadixSpline&) = delete;
+
+  // Suspends background merges until the next `Build`, so that all updates
+  // made while the caller scans the keys for it stay in the buffers. Optional
+  // if nothing updates the index during the scan.
+  void BeginBuild() {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    building_ = true;
+  }
+
+  // Ends a `BeginBuild` that will not `Build`, e.g. because the scan of the
+  // keys failed, and lets merges run again.
+  void AbortBuild() {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    building_ = false;
+    MaybeStartMerge();
+  }
+
+  // Replaces the content of the index with `keys`, which need to be sorted.
+  // Keys that occur several times are kept once.
+  // The spline is built without holding the lock, so lookups and updates keep
+  // going against the previous version meanwhile. Keys inserted since
+  // `BeginBuild` are kept in the delta buffer unless `keys` already contains
+  // them.
+  void Build(std::vector<KeyType> keys, size_t num_radix_bits = 18,
+             size_t max_error = 32) {
+    BeginBuild();
+    WaitForMerge();
+    SplineOptions options;
+    {
+      std::lock_guard<std::mutex> guard(delta_mutex_);
+      options = options_;
+    }
+    auto base =
+        BuildSnapshot(std::move(keys), num_radix_bits, max_error, options);
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    num_radix_bits_ = num_radix_bits;
+    max_error_ = max_error;
+    std::vector<KeyType> delta;
+    std::set_difference(delta_.begin(), delta_.end(), base->begin(),
+                        base->end(), std::back_inserter(delta));
+    delta_ = std::move(delta);
+    // Erases that raced with the scan of `keys` may or may not be reflected
+    // in it, so tombstones of keys that are still there are kept.
+    std::vector<KeyType> tombstones;
+    std::set_intersection(tombstones_.begin(), tombstones_.end(),
+                          base->begin(), base->end(),
+                          std::back_inserter(tombstones));
+    tombstones_ = std::move(tombstones);
+    auto state = std::make_shared<State>();
+    state->base = std::move(base);
+    state_ = std::move(state);
+    building_ = false;
+    MaybeStartMerge();
+  }
+
+  // Replaces the content of the index with the one saved to `path` by
+  // `Save`. The file is mapped and used in place until the next merge or
+  // build. Returns false and sets `error` if the file can not be used, in
+  // which case the index is left as it is.
+  bool Load(const std::string& path, std::string* error) {
+    auto mapped = MappedRadixSpline<KeyType>::Open(path, error);
+    if (!mapped) return false;
+    BeginBuild();
+    WaitForMerge();
+    auto base = std::make_shared<Snapshot>();
+    base->mapped = std::move(mapped);
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    num_radix_bits_ = base->mapped->num_radix_bits();
+    max_error_ = base->mapped->max_error();
+    delta_.clear();
+    tombstones_.clear();
+    auto state = std::make_shared<State>();
+    state->base = std::move(base);
+    state_ = std::move(state);
+    building_ = false;
+    return true;
+  }
+
+  // Writes the keys of the index to `path` for `Load`. Pending updates are
+  // included: if there are any, a spline over the live keys is built first.
+  // Returns false and sets `error` on failure.
+  bool Save(const std::string& path, std::string* error) const {
+    std::shared_ptr<const State> state;
+    std::vector<KeyType> delta;
+    std::vector<KeyType> tombstones;
+    size_t num_radix_bits;
+    size_t max_error;
+    {
+      std::lock_guard<std::mutex> guard(delta_mutex_);
+      state = state_;
+      delta = delta_;
+      tombstones = tombstones_;
+      num_radix_bits = num_radix_bits_;
+      max_error = max_error_;
+    }
+    std::shared_ptr<const Snapshot> base = state->base;
+    if (base->mapped || base->compressed || !delta.empty() ||
+        !tombstones.empty() || state->frozen_delta) {
+      std::vector<KeyType> keys(base->begin(), base->end());
+      if (state->frozen_delta) keys = Union(keys, *state->frozen_delta);
+      if (state->frozen_tombstones)
+        keys = Difference(keys, *state->frozen_tombstones);
+      keys = Union(Difference(keys, tombstones), delta);
+      base = BuildSnapshot(std::move(keys), num_radix_bits, max_error,
+                           SplineOptions());
+    }
+    return Serializer<KeyType>::ToFile(base->spline, base->begin(),
+                                       base->size(), path, error);
+  }
+
+  // Makes the next build or merge compress the spline, or not. Lookups get a
+  // little slower, the spline several times smaller.
+  void SetCompressed(bool compressed) {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    options_.compressed = compressed;
+  }
+
+  bool IsCompressed() const {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    return options_.compressed;
+  }
+
+  // Makes the next build or merge add a second radix table level for skewed
+  // keys, or not. Files written by `Save` keep the flat table only.
+  void SetTwoLevelRadixTable(bool two_level) {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    options_.two_level = two_level;
+  }
+
+  bool IsTwoLevelRadixTable() const {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    return options_.two_level;
+  }
+
+  // Returns the number of radix table prefixes with a second level.
+  size_t GetNumRefinedPrefixes() const {
+    return GetBase()->num_refined_prefixes;
+  }
+
+  void SetMergeThreshold(size_t merge_threshold) {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    merge_threshold_ = std::max<size_t>(merge_threshold, 1);
+  }
+
+  // Adds `key` to the delta buffer and starts a background merge if the
+  // buffers are full and no merge is running yet. The index holds every key
+  // once: inserting a key that is there does nothing, and inserting an erased
+  // key of the spline only drops its tombstone.
+  void Insert(KeyType key) {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    if (InsertLocked(key)) MaybeStartMerge();
+  }
+
+  // Like `Insert` for each of `keys`, under a single lock and with at most one
+  // merge started at the end.
+  void InsertBatch(const std::vector<KeyType>& keys) {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    bool inserted = false;
+    for (const KeyType key : keys) inserted |= InsertLocked(key);
+    if (inserted) MaybeStartMerge();
+  }
+
+  // Removes `key`. Keys that only live in the delta buffer are dropped right
+  // away, keys of the spline are hidden by a tombstone until the next merge.
+  void Erase(KeyType key) {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    const auto delta_it = std::lower_bound(delta_.begin(), delta_.end(), key);
+    if (delta_it != delta_.end() && *delta_it == key) {
+      delta_.erase(delta_it);
+      return;
+    }
+    if (!ContainsFrozen(key)) return;
+    const auto it =
+        std::lower_bound(tombstones_.begin(), tombstones_.end(), key);
+    if (it != tombstones_.end() && *it == key) return;
+    tombstones_.insert(it, key);
+    MaybeStartMerge();
+  }
+
+  // Returns true if `key` is in the base keys or in one of the delta buffers,
+  // and has not been erased since.
+  bool Contains(KeyType key) const {
+    std::shared_ptr<const State> state;
+    {
+      std::lock_guard<std::mutex> guard(delta_mutex_);
+      if (std::binary_search(delta_.begin(), delta_.end(), key)) return true;
+      if (std::binary_search(tombstones_.begin(), tombstones_.end(), key))
+        return false;
+      state = state_;
+    }
+    if (state->frozen_tombstones &&
+        std::binary_search(state->frozen_tombstones->begin(),
+                           state->frozen_tombstones->end(), key))
+      return false;
+    if (state->frozen_delta &&
+        std::binary_search(state->frozen_delta->begin(),
+                           state->frozen_delta->end(), key))
+      return true;
+    return state->base->Contains(key);
+  }
+
+  // Returns the number of keys in [lo, hi), counted like `GetNumKeys`.
+  size_t CountRange(KeyType lo, KeyType hi) const {
+    if (!(lo < hi)) return 0;
+    std::shared_ptr<const State> state;
+    size_t added = 0;
+    size_t removed = 0;
+    {
+      std::lock_guard<std::mutex> guard(delta_mutex_);
+      added += CountSorted(delta_, lo, hi);
+      removed += CountSorted(tombstones_, lo, hi);
+      state = state_;
+    }
+    if (state->frozen_delta) added += CountSorted(*state->frozen_delta, lo, hi);
+    if (state->frozen_tombstones)
+      removed += CountSorted(*state->frozen_tombstones, lo, hi);
+    added += state->base->LowerBound(hi) - state->base->LowerBound(lo);
+    return added > removed ? added - removed : 0;
+  }
+
+  // Returns the estimated position of `key` in the current base keys.
+  double GetEstimatedPosition(KeyType key) const {
+    const auto base = GetBase();
+    if (base->size() == 0) return 0;
+    return base->GetEstimatedPosition(key);
+  }
+
+  // Sets `min_key` and `max_key` to the smallest and largest key the spline
+  // was built on. Returns false if there are none.
+  bool GetBaseKeyRange(KeyType* min_key, KeyType* max_key) const {
+    const auto base = GetBase();
+    if (base->size() == 0) return false;
+    *min_key = *base->begin();
+    *max_key = *(base->end() - 1);
+    return true;
+  }
+
+  // Returns the shape of the current base spline. Its keys are the base keys,
+  // without the delta buffers and tombstones.
+  SplineStats GetStats() const {
+    const auto base = GetBase();
+    if (base->size() == 0) return SplineStats();
+    return base->GetStats();
+  }
+
+  // Profiles the estimated positions of every `step`-th base key against
+  // their actual positions, see `ErrorProfile`. Segments are the ones of the
+  // spline.
+  ErrorProfile ProfileErrors(size_t step = 1) const {
+    const auto base = GetBase();
+    if (base->size() == 0) return ErrorProfile();
+    return rs::ProfileErrors(*base, base->begin(), base->size(),
+                             base->GetStats().max_error, step);
+  }
+
+  // Returns the number of keys, including the ones in the delta buffers and
+  // excluding erased ones.
+  size_t GetNumKeys() const {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    return state_->base->size() + delta_.size() +
+           (state_->frozen_delta ? state_->frozen_delta->size() : 0) -
+           tombstones_.size() -
+           (state_->frozen_tombstones ? state_->frozen_tombstones->size() : 0);
+  }
+
+  size_t GetDeltaSize() const {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    return delta_.size() +
+           (state_->frozen_delta ? state_->frozen_delta->size() : 0);
+  }
+
+  size_t GetTombstoneCount() const {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    return tombstones_.size() + (state_->frozen_tombstones
+                                     ? state_->frozen_tombstones->size()
+                                     : 0);
+  }
+
+  // Blocks until a running background merge has been swapped in.
+  void WaitForMerge() {
+    std::future<void> merge;
+    {
+      std::lock_guard<std::mutex> guard(delta_mutex_);
+      merge = std::move(merge_);
+    }
+    if (merge.valid()) merge.wait();
+  }
+
+  // Returns the size in bytes.
+  size_t GetSize() const {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    size_t size = sizeof(*this) + state_->base->GetSize() +
+                  (delta_.capacity() + tombstones_.capacity()) * sizeof(KeyType);
+    if (state_->frozen_delta)
+      size += state_->frozen_delta->capacity() * sizeof(KeyType);
+    if (state_->frozen_tombstones)
+      size += state_->frozen_tombstones->capacity() * sizeof(KeyType);
+    return size;
+  }
+
+ private:
+  // Immutable spline together with the sorted keys it was built on, either
+  // built in memory or mapped from a file written by `Save`.
+  struct Snapshot {
+    std::vector<KeyType> keys;
+    RadixSpline<KeyType> spline;
+    // Set instead of `spline` if built compressed.
+    std::shared_ptr<const CompressedRadixSpline<KeyType>> compressed;
+    size_t num_refined_prefixes = 0;
+    // Set instead of `keys` and `spline` if loaded from a file.
+    std::shared_ptr<const MappedRadixSpline<KeyType>> mapped;
+
+    const KeyType* begin() const {
+      return mapped ? mapped->keys() : keys.data();
+    }
+    const KeyType* end() const { return begin() + size(); }
+    size_t size() const { return mapped ? mapped->num_keys() : keys.size(); }
+
+    double GetEstimatedPosition(KeyType key) const {
+      if (mapped) return mapped->GetEstimatedPosition(key);
+      if (compressed) return compressed->GetEstimatedPosition(key);
+      return spline.GetEstimatedPosition(key);
+    }
+
+    size_t GetSegment(KeyType key) const {
+      if (mapped) return mapped->GetSegment(key);
+      if (compressed) return compressed->GetSegment(key);
+      return spline.GetSegment(key);
+    }
+
+    SplineStats GetStats() const {
+      if (mapped) return mapped->GetStats();
+      if (compressed) return compressed->GetStats();
+      return spline.GetStats();
+    }
+
+    SearchBound GetSearchBound(KeyType key) const {
+      if (mapped) return mapped->GetSearchBound(key);
+      if (compressed) return compressed->GetSearchBound(key);
+      return spline.GetSearchBound(key);
+    }
+
+    bool Contains(KeyType key) const {
+      const size_t position = LowerBound(key);
+      return position != size() && begin()[position] == key;
+    }
+
+    // Returns the position of the first key not less than `key`.
+    size_t LowerBound(KeyType key) const {
+      if (size() == 0) return 0;
+      const SearchBound bound = GetSearchBound(key);
+      return std::lower_bound(begin() + bound.begin, begin() + bound.end,
+                              key) -
+             begin();
+    }
+
+    size_t GetSize() const {
+      if (mapped) return sizeof(*this) + mapped->GetSize();
+      size_t size = sizeof(*this) + keys.capacity() * sizeof(KeyType);
+      if (compressed) return size + compressed->GetSize();
+      return size + (keys.empty() ? 0 : spline.GetSize());
+    }
+  };
+
+  // How builds and merges lay out the spline.
+  struct SplineOptions {
+    bool compressed = false;
+    bool two_level = false;
+  };
+
+  // What lookups see besides the mutable delta buffer and tombstones.
+  // Replaced as a whole under `delta_mutex_` whenever a merge starts or
+  // finishes. The frozen delta keys are never tombstoned by the frozen
+  // tombstones, as erasing a delta key removes it from the buffer.
+  struct State {
+    std::shared_ptr<const Snapshot> base = std::make_shared<const Snapshot>();
+    std::shared_ptr<const std::vector<KeyType>> frozen_delta;
+    std::shared_ptr<const std::vector<KeyType>> frozen_tombstones;
+  };
+
+  static std::vector<KeyType> Union(const std::vector<KeyType>& a,
+                                    const std::vector<KeyType>& b) {
+    std::vector<KeyType> result;
+    result.reserve(a.size() + b.size());
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+                   std::back_inserter(result));
+    return result;
+  }
+
+  static std::vector<KeyType> Difference(const std::vector<KeyType>& a,
+                                         const std::vector<KeyType>& b) {
+    std::vector<KeyType> result;
+    result.reserve(a.size());
+    std::copy_if(a.begin(), a.end(), std::back_inserter(result),
+                 [&b](KeyType key) {
+                   return !std::binary_search(b.begin(), b.end(), key);
+                 });
+    return result;
+  }
+
+  static size_t CountSorted(const std::vector<KeyType>& keys, KeyType lo,
+                            KeyType hi) {
+    return std::lower_bound(keys.begin(), keys.end(), hi) -
+           std::lower_bound(keys.begin(), keys.end(), lo);
+  }
+
+  // Inserts `key` as described at `Insert`, returns true if it went to the
+  // delta buffer. Requires `delta_mutex_`.
+  bool InsertLocked(KeyType key) {
+    const auto delta_it = std::lower_bound(delta_.begin(), delta_.end(), key);
+    if (delta_it != delta_.end() && *delta_it == key) return false;
+    const auto tombstone =
+        std::lower_bound(tombstones_.begin(), tombstones_.end(), key);
+    if (tombstone != tombstones_.end() && *tombstone == key) {
+      tombstones_.erase(tombstone);
+      return false;
+    }
+    if (ContainsFrozen(key)) return false;
+    delta_.insert(delta_it, key);
+    return true;
+  }
+
+  // Returns whether `key` is in the frozen delta buffer, or in the base keys
+  // and not frozen as tombstone, i.e. there apart from the mutable buffers.
+  // Requires `delta_mutex_`.
+  bool ContainsFrozen(KeyType key) const {
+    const State& state = *state_;
+    if (state.frozen_delta &&
+        std::binary_search(state.frozen_delta->begin(),
+                           state.frozen_delta->end(), key))
+      return true;
+    if (state.frozen_tombstones &&
+        std::binary_search(state.frozen_tombstones->begin(),
+                           state.frozen_tombstones->end(), key))
+      return false;
+    return state.base->Contains(key);
+  }
+
+  // Requires `delta_mutex_`.
+  void MaybeStartMerge() {
+    if (delta_.size() + tombstones_.size() >= merge_threshold_ &&
+        !state_->frozen_delta && !building_)
+      StartMerge();
+  }
+
+  std::shared_ptr<const Snapshot> GetBase() const {
+    std::lock_guard<std::mutex> guard(delta_mutex_);
+    return state_->base;
+  }
+
+  // Builds a spline over the sorted `keys`, keeping every key once.
+  static std::shared_ptr<const Snapshot> BuildSnapshot(
+      std::vector<KeyType> keys, size_t num_radix_bits, size_t max_error,
+      SplineOptions options) {
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    auto snapshot = std::make_shared<Snapshot>();
+    if (!keys.empty()) {
+      Builder<KeyType> builder(keys.front(), keys.back(), num_radix_bits,
+                               max_error);
+      for (const auto& key : keys) builder.AddKey(key);
+      RadixSpline<KeyType> spline = builder.Finalize();
+      if (options.two_level) spline.RefineDensePrefixes();
+      snapshot->num_refined_prefixes = spline.GetNumRefinedPrefixes();
+      if (options.compressed) {
+        snapshot->compressed =
+            std::make_shared<const CompressedRadixSpline<KeyType>>(spline);
+      } else {
+        snapshot->spline = std::move(spline);
+      }
+    }
+    snapshot->keys = std::move(keys);
+    return snapshot;
+  }
+
+  // Requires `delta_mutex_`.
+  void StartMerge() {
+    auto state = std::make_shared<State>();
+    state->base = state_->base;
+    state->frozen_delta =
+        std::make_shared<const std::vector<KeyType>>(std::move(delta_));
+    state->frozen_tombstones =
+        std::make_shared<const std::vector<KeyType>>(std::move(tombstones_));
+    delta_.clear();
+    tombstones_.clear();
+    state_ = state;
+    merge_ = std::async(std::launch::async, [this, state,
+                                             num_radix_bits = num_radix_bits_,
+                                             max_error = max_error_,
+                                             options = options_]() {
+      const auto& tombstones = *state->frozen_tombstones;
+      std::vector<KeyType> live;
+      live.reserve(state->base->size());
+      std::copy_if(state->base->begin(), state->base->end(),
+                   std::back_inserter(live), [&tombstones](KeyType key) {
+                     return !std::binary_search(tombstones.begin(),
+                                                tombstones.end(), key);
+                   });
+      std::vector<KeyType> merged;
+      merged.reserve(live.size() + state->frozen_delta->size());
+      std::merge(live.begin(), live.end(), state->frozen_delta->begin(),
+                 state->frozen_delta->end(), std::back_inserter(merged));
+      auto merged_base = BuildSnapshot(std::move(merged), num_radix_bits,
+                                       max_error, options);
+
+      auto next_state = std::make_shared<State>();
+      next_state->base = std::move(merged_base);
+      std::lock_guard<std::mutex> guard(delta_mutex_);
+      state_ = std::move(next_state);
+    });
+  }
+
+  size_t num_radix_bits_ = 18;
+  size_t max_error_ = 32;
+  size_t merge_threshold_ = kDefaultMergeThreshold;
+  SplineOptions options_;
+  bool building_ = false;
+
+  mutable std::mutex delta_mutex_;
+  std::vector<KeyType> delta_;
+  std::vector<KeyType> tombstones_;
+  std::shared_ptr<const State> state_;
+  std::future<void> merge_;
+};
+
+}  // namespace rs
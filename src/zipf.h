@@ -1,6 +1,8 @@
 // Copyright (c) Microsoft Corporation.
 // Licensed under the MIT license.
 
+#pragma once
+
 // Zipf generator, inspired by
 // https://github.com/brianfrankcooper/YCSB/blob/master/core/src/main/java/site/ycsb/generator/ScrambledZipfianGenerator.java
 // https://github.com/brianfrankcooper/YCSB/blob/master/core/src/main/java/site/ycsb/generator/ZipfianGenerator.java
@@ -16,15 +18,20 @@ class ScrambledZipfianGenerator {
   std::mt19937_64 gen_;
   std::uniform_real_distribution<double> dis_;
 
-  explicit ScrambledZipfianGenerator(int num_keys)
-      : num_keys_(num_keys), gen_(std::random_device{}()), dis_(0, 1) {
+  explicit ScrambledZipfianGenerator(int num_keys,
+                                     uint64_t seed = std::random_device{}())
+      : num_keys_(num_keys), gen_(seed), dis_(0, 1) {
     double zeta2theta = zeta(2);
     alpha_ = 1. / (1. - ZIPFIAN_CONSTANT);
     eta_ = (1 - std::pow(2. / num_keys_, 1 - ZIPFIAN_CONSTANT)) /
            (1 - zeta2theta / ZETAN);
   }
 
-  int nextValue() {
+  int nextValue() { return fnv1a(nextRank()) % num_keys_; }
+
+  // Returns the rank of the next item before it is scrambled, 0 being the
+  // most popular one.
+  int nextRank() {
     double u = dis_(gen_);
     double uz = u * ZETAN;
 
@@ -36,8 +43,6 @@ class ScrambledZipfianGenerator {
     } else {
       ret = (int)(num_keys_ * std::pow(eta_ * u - eta_ + 1, alpha_));
     }
-
-    ret = fnv1a(ret) % num_keys_;
     return ret;
   }
 
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+// Minimal checks for the unit tests of the header-only data structures in
+// src/include. A failed check prints where it failed and makes the test
+// return 1 from `main`, so CTest reports it.
+namespace duckdb {
+namespace test {
+
+inline int& Failures() {
+  static int failures = 0;
+  return failures;
+}
+
+}  // namespace test
+}  // namespace duckdb
+
+#define CHECK(condition)                                                   \
+  do {                                                                     \
+    if (!(condition)) {                                                    \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition   \
+                << ") failed\n";                                           \
+      ++duckdb::test::Failures();                                          \
+    }                                                                      \
+  } while (0)
+
+#define CHECK_EQ(a, b)                                                     \
+  do {                                                                     \
+    const auto check_a = (a);                                              \
+    const auto check_b = (b);                                              \
+    if (!(check_a == check_b)) {                                           \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #a ", " #b \
+                << ") failed: " << check_a << " != " << check_b << "\n";   \
+      ++duckdb::test::Failures();                                          \
+    }                                                                      \
+  } while (0)
+
+#define CHECK_THROWS(statement)                                            \
+  do {                                                                     \
+    bool check_threw = false;                                              \
+    try {                                                                  \
+      statement;                                                           \
+    } catch (...) {                                                        \
+      check_threw = true;                                                  \
+    }                                                                      \
+    if (!check_threw) {                                                    \
+      std::cerr << __FILE__ << ":" << __LINE__                             \
+                << ": CHECK_THROWS(" #statement ") did not throw\n";      \
+      ++duckdb::test::Failures();                                          \
+    }                                                                      \
+  } while (0)
+
+#define TEST_RESULT() (duckdb::test::Failures() == 0 ? 0 : 1)
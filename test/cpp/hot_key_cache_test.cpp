@@ -0,0 +1,99 @@
+#include "hot_key_cache.h"
+
+#include <cstdint>
+
+#include "check.h"
+
+namespace duckdb {
+namespace {
+
+void TestDisabled() {
+  HotKeyCache<int64_t, double> cache;
+  CHECK(!cache.Enabled());
+  double payload = 0;
+  CHECK(!cache.Lookup(1, &payload));
+  cache.Admit(1, 2.0);
+  cache.Invalidate(1);
+  cache.Clear();
+  CHECK(!cache.Lookup(1, &payload));
+  CHECK_EQ(cache.GetHits(), 0u);
+  CHECK_EQ(cache.GetMisses(), 0u);
+
+  cache.Resize(16);
+  cache.Resize(0);
+  CHECK(!cache.Lookup(1, &payload));
+}
+
+void TestAdmitAndInvalidate() {
+  HotKeyCache<int64_t, double> cache(16);
+  double payload = 0;
+  CHECK(!cache.Lookup(7, &payload));
+  cache.Admit(7, 1.5);
+  CHECK(cache.Lookup(7, &payload));
+  CHECK_EQ(payload, 1.5);
+  // Admitting a cached key again replaces its payload.
+  cache.Admit(7, 2.5);
+  CHECK(cache.Lookup(7, &payload));
+  CHECK_EQ(payload, 2.5);
+  cache.Invalidate(7);
+  CHECK(!cache.Lookup(7, &payload));
+  CHECK_EQ(cache.GetHits(), 2u);
+  CHECK_EQ(cache.GetMisses(), 2u);
+}
+
+// A payload read from the index before a write invalidated its key is not
+// cached, it may be the one the write replaced.
+void TestAdmitAfterInvalidation() {
+  HotKeyCache<int64_t, double> cache(16);
+  double payload = 0;
+  uint64_t invalidations = cache.GetInvalidations();
+  cache.Invalidate(3);
+  cache.Admit(5, 1.0, invalidations);
+  CHECK(!cache.Lookup(5, &payload));
+
+  invalidations = cache.GetInvalidations();
+  cache.Clear();
+  cache.Admit(5, 1.0, invalidations);
+  CHECK(!cache.Lookup(5, &payload));
+
+  invalidations = cache.GetInvalidations();
+  cache.Admit(5, 2.0, invalidations);
+  CHECK(cache.Lookup(5, &payload));
+  CHECK_EQ(payload, 2.0);
+}
+
+void TestEviction() {
+  // One bucket: the ninth key evicts one of the first eight.
+  HotKeyCache<int64_t, double> cache(HotKeyCache<int64_t, double>::kBucketSize);
+  for (int64_t key = 0; key <= 8; ++key) cache.Admit(key, key);
+  int cached = 0;
+  double payload = 0;
+  for (int64_t key = 0; key <= 8; ++key) {
+    if (cache.Lookup(key, &payload)) {
+      CHECK_EQ(payload, static_cast<double>(key));
+      ++cached;
+    }
+  }
+  CHECK_EQ(cached, 8);
+  CHECK(cache.Lookup(8, &payload));
+}
+
+void TestSignedZero() {
+  HotKeyCache<double, double> cache(16);
+  cache.Admit(-0.0, 3);
+  double payload = 0;
+  CHECK(cache.Lookup(0.0, &payload));
+  CHECK_EQ(payload, 3.0);
+}
+
+}  // namespace
+}  // namespace duckdb
+
+int main() {
+  duckdb::TestDisabled();
+  duckdb::TestAdmitAndInvalidate();
+  duckdb::TestAdmitAfterInvalidation();
+  duckdb::TestEviction();
+  duckdb::TestSignedZero();
+  return TEST_RESULT();
+}
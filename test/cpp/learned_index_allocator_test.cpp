@@ -0,0 +1,130 @@
+#include "learned_index_allocator.h"
+
+#include <cstddef>
+#include <vector>
+
+#include "check.h"
+#include "duckdb/common/exception.hpp"
+
+namespace duckdb {
+namespace {
+
+constexpr size_t kSlabSize = LearnedIndexMemoryPool::kSlabSize;
+
+// A memory manager with a limit, like the buffer manager of a database.
+struct MemoryManager {
+  size_t limit = 0;
+  size_t reserved = 0;
+  bool closed = false;
+
+  void AddTo(LearnedIndexMemoryPool& pool) {
+    pool.AddMemoryReservation(
+        this,
+        [this](size_t bytes) {
+          if (closed) return false;
+          if (reserved + bytes > limit)
+            throw OutOfMemoryException("memory limit reached");
+          reserved += bytes;
+          return true;
+        },
+        [this](size_t bytes) { reserved -= bytes; });
+  }
+};
+
+// The pool is a process singleton, so the tests free everything they allocate
+// and run in a fixed order. Their memory managers are static: the pool only
+// drops a closed one the next time it grows.
+void TestRefusedReservationThrows() {
+  auto& pool = LearnedIndexMemoryPool::Get();
+  static MemoryManager manager;
+  manager.limit = 3 * kSlabSize;
+  manager.AddTo(pool);
+
+  void* large = pool.Allocate(2 * kSlabSize);
+  CHECK_EQ(manager.reserved, 2 * kSlabSize);
+  CHECK_THROWS(pool.Allocate(2 * kSlabSize));
+  CHECK_EQ(pool.GetReservedBytes(), 2 * kSlabSize);
+
+  // A refill needs another slab, which the manager has room for once.
+  void* block = pool.Allocate(64);
+  CHECK_EQ(pool.GetReservedBytes(), 3 * kSlabSize);
+  CHECK_THROWS(pool.Allocate(128));
+  CHECK_EQ(pool.GetReservedBytes(), 3 * kSlabSize);
+
+  pool.Free(large, 2 * kSlabSize);
+  pool.Free(block, 64);
+  manager.closed = true;
+}
+
+// Freeing every block of a size class gives its slabs back to the allocator
+// and the memory manager, but for one.
+void TestEmptySlabsAreReleased() {
+  auto& pool = LearnedIndexMemoryPool::Get();
+  static MemoryManager manager;
+  manager.limit = 64 * kSlabSize;
+  manager.AddTo(pool);
+  const size_t reserved_before = pool.GetReservedBytes();
+
+  const size_t blocks_per_slab = kSlabSize / 256;
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < 8 * blocks_per_slab; ++i)
+    blocks.push_back(pool.Allocate(256));
+  CHECK_EQ(pool.GetReservedBytes(), reserved_before + 8 * kSlabSize);
+  // Every other block first, so that no slab is empty for a while.
+  for (size_t i = 0; i < blocks.size(); i += 2) pool.Free(blocks[i], 256);
+  CHECK_EQ(pool.GetReservedBytes(), reserved_before + 8 * kSlabSize);
+  for (size_t i = 1; i < blocks.size(); i += 2) pool.Free(blocks[i], 256);
+  CHECK(pool.GetReservedBytes() <= reserved_before + 2 * kSlabSize);
+  CHECK(manager.reserved <= pool.GetReservedBytes() + kSlabSize);
+
+  // The blocks that are left are handed out again.
+  void* block = pool.Allocate(256);
+  CHECK(pool.GetReservedBytes() <= reserved_before + 2 * kSlabSize);
+  pool.Free(block, 256);
+  manager.closed = true;
+}
+
+// Every database reserves what the pool holds, and keeps its reservation when
+// another one is added.
+void TestReservationPerDatabase() {
+  auto& pool = LearnedIndexMemoryPool::Get();
+  static MemoryManager first;
+  static MemoryManager second;
+  first.limit = second.limit = 64 * kSlabSize;
+  first.AddTo(pool);
+  void* large = pool.Allocate(4 * kSlabSize);
+  second.AddTo(pool);
+  const size_t held = pool.GetReservedBytes();
+  CHECK_EQ(first.reserved, held);
+  CHECK_EQ(second.reserved, held);
+
+  // Adding the same database again replaces its reservation.
+  first.AddTo(pool);
+  CHECK_EQ(first.reserved, held);
+
+  // Either one refusing fails the allocation.
+  second.limit = held;
+  CHECK_THROWS(pool.Allocate(kSlabSize + 1));
+  CHECK_EQ(pool.GetReservedBytes(), held);
+
+  // A closed database is dropped, the others still count the pool.
+  second.closed = true;
+  void* more = pool.Allocate(kSlabSize + 1);
+  CHECK_EQ(first.reserved, held + kSlabSize + 1);
+  CHECK_EQ(pool.GetAccountedBytes(), held + kSlabSize + 1);
+
+  pool.Free(more, kSlabSize + 1);
+  pool.Free(large, 4 * kSlabSize);
+  CHECK(first.reserved <= pool.GetReservedBytes() + kSlabSize);
+  first.closed = true;
+}
+
+}  // namespace
+}  // namespace duckdb
+
+int main() {
+  duckdb::TestRefusedReservationThrows();
+  duckdb::TestEmptySlabsAreReleased();
+  duckdb::TestReservationPerDatabase();
+  return TEST_RESULT();
+}
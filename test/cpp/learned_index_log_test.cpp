@@ -0,0 +1,153 @@
+#include "learned_index_log.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+namespace duckdb {
+namespace {
+
+const std::string kDirectory = "learned_index_log_test";
+
+std::string LogPath() {
+  return kDirectory + "/" + LearnedIndexLog::kLogName;
+}
+
+LearnedIndexLog::Record MakeRecord(int64_t key) {
+  LearnedIndexLog::Record record;
+  record.op = LearnedIndexLog::Op::kInsert;
+  record.key_type = "bigint";
+  record.table_name = "memory.main.t";
+  record.key = LearnedIndexLog::EncodeKey(key);
+  record.payload = static_cast<double>(key) / 2;
+  record.row_delta = 1;
+  record.hash_delta = static_cast<uint64_t>(-key);
+  return record;
+}
+
+std::vector<LearnedIndexLog::Record> ReadAll(const LearnedIndexLog& log) {
+  std::vector<LearnedIndexLog::Record> records;
+  std::string error;
+  CHECK(log.ReadRecords(&records, &error));
+  return records;
+}
+
+void AppendBytes(const std::vector<char>& bytes) {
+  std::ofstream out(LogPath(), std::ios::binary | std::ios::app);
+  out.write(bytes.data(), bytes.size());
+}
+
+void TestAppendAndRead() {
+  std::filesystem::remove_all(kDirectory);
+  std::filesystem::create_directory(kDirectory);
+  LearnedIndexLog log;
+  std::string error;
+  CHECK(log.Open(kDirectory, 1, &error));
+  CHECK(log.Append(MakeRecord(1)));
+  CHECK(log.Append(MakeRecord(2)));
+  auto records = ReadAll(log);
+  CHECK_EQ(records.size(), 2u);
+  CHECK_EQ(LearnedIndexLog::DecodeKey<int64_t>(records[1].key), 2);
+  CHECK_EQ(records[1].payload, 1.0);
+  CHECK_EQ(records[1].hash_delta, static_cast<uint64_t>(-2));
+  CHECK_EQ(records[1].table_name, std::string("memory.main.t"));
+
+  // The records of a batch are appended together.
+  CHECK(log.Append(std::vector<LearnedIndexLog::Record>{MakeRecord(3), MakeRecord(4)}));
+  CHECK(log.Append(std::vector<LearnedIndexLog::Record>{}));
+  records = ReadAll(log);
+  CHECK_EQ(records.size(), 4u);
+  CHECK_EQ(LearnedIndexLog::DecodeKey<int64_t>(records[3].key), 4);
+
+  // Another generation starts over.
+  CHECK(log.Open(kDirectory, 2, &error));
+  CHECK(ReadAll(log).empty());
+}
+
+// A crash in the middle of an append leaves part of a record behind. Opening
+// the log again cuts it off, so records appended afterwards are read.
+void TestTornRecordIsTruncated() {
+  std::filesystem::remove_all(kDirectory);
+  std::filesystem::create_directory(kDirectory);
+  std::string error;
+  uintmax_t valid_size;
+  {
+    LearnedIndexLog log;
+    CHECK(log.Open(kDirectory, 1, &error));
+    CHECK(log.Append(MakeRecord(1)));
+    CHECK(log.Append(MakeRecord(2)));
+    log.Close();
+    valid_size = std::filesystem::file_size(LogPath());
+  }
+  // The size and checksum of a record, and the first bytes of its body.
+  AppendBytes({40, 0, 0, 0, 1, 2, 3, 4, 1, 6, 0});
+
+  LearnedIndexLog log;
+  CHECK(log.Open(kDirectory, 1, &error));
+  CHECK_EQ(std::filesystem::file_size(LogPath()), valid_size);
+  CHECK(log.Append(MakeRecord(3)));
+  auto records = ReadAll(log);
+  CHECK_EQ(records.size(), 3u);
+  CHECK_EQ(LearnedIndexLog::DecodeKey<int64_t>(records[2].key), 3);
+}
+
+// A torn size field is bounded by the rest of the file rather than trusted.
+void TestTornSizeIsBounded() {
+  std::filesystem::remove_all(kDirectory);
+  std::filesystem::create_directory(kDirectory);
+  std::string error;
+  LearnedIndexLog log;
+  CHECK(log.Open(kDirectory, 1, &error));
+  CHECK(log.Append(MakeRecord(1)));
+  AppendBytes({'\xf0', '\xff', '\xff', '\xff', 0, 0, 0, 0});
+  auto records = ReadAll(log);
+  CHECK_EQ(records.size(), 1u);
+
+  CHECK(log.Open(kDirectory, 1, &error));
+  CHECK(log.Append(MakeRecord(2)));
+  CHECK_EQ(ReadAll(log).size(), 2u);
+}
+
+// A record whose checksum does not match ends the log, even if valid records
+// follow it.
+void TestCorruptRecordEndsLog() {
+  std::filesystem::remove_all(kDirectory);
+  std::filesystem::create_directory(kDirectory);
+  std::string error;
+  uintmax_t first_end;
+  {
+    LearnedIndexLog log;
+    CHECK(log.Open(kDirectory, 1, &error));
+    CHECK(log.Append(MakeRecord(1)));
+    first_end = std::filesystem::file_size(LogPath());
+    CHECK(log.Append(MakeRecord(2)));
+    CHECK(log.Append(MakeRecord(3)));
+  }
+  {
+    std::fstream file(LogPath(), std::ios::binary | std::ios::in | std::ios::out);
+    // The last byte of the second record's key.
+    file.seekp(first_end + 8 + 5 + 7);
+    file.put('\x7f');
+  }
+  LearnedIndexLog log;
+  CHECK(log.Open(kDirectory, 1, &error));
+  CHECK_EQ(ReadAll(log).size(), 1u);
+  CHECK_EQ(std::filesystem::file_size(LogPath()), first_end);
+  std::filesystem::remove_all(kDirectory);
+}
+
+}  // namespace
+}  // namespace duckdb
+
+int main() {
+  duckdb::TestAppendAndRead();
+  duckdb::TestTornRecordIsTruncated();
+  duckdb::TestTornSizeIsBounded();
+  duckdb::TestCorruptRecordEndsLog();
+  return TEST_RESULT();
+}
@@ -0,0 +1,122 @@
+#include "learned_index_sidecar.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "check.h"
+
+namespace duckdb {
+namespace {
+
+const std::string kDirectory = "learned_index_sidecar_test";
+
+void Reset() {
+  std::filesystem::remove_all(kDirectory);
+  std::filesystem::create_directory(kDirectory);
+}
+
+void WriteText(const std::string& path, const std::string& text) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out << text;
+}
+
+void TestManifestRoundTrip() {
+  Reset();
+  LearnedIndexManifestEntry entry;
+  entry.kind = "alex";
+  entry.key_type = "bigint";
+  entry.table_name = "memory.main.t";
+  entry.column_name = "id";
+  entry.option = 4;
+  entry.row_count = 1000;
+  entry.fingerprint = 12345;
+  entry.content_hash = UINT64_MAX;
+  entry.file_name = "alex_bigint.3.lidx";
+  std::string error;
+  CHECK(LearnedIndexSidecar::WriteManifest(kDirectory, 3, {entry}, &error));
+
+  uint64_t generation = 0;
+  std::vector<LearnedIndexManifestEntry> entries;
+  CHECK(LearnedIndexSidecar::ReadManifest(kDirectory, &generation, &entries,
+                                          &error));
+  CHECK_EQ(generation, 3u);
+  CHECK_EQ(entries.size(), 1u);
+  CHECK_EQ(entries[0].option, 4u);
+  CHECK_EQ(entries[0].content_hash, UINT64_MAX);
+  CHECK_EQ(entries[0].file_name, entry.file_name);
+}
+
+// Numbers that do not parse make the manifest corrupt, they do not throw.
+void TestCorruptManifestIsReported() {
+  const std::string path =
+      kDirectory + "/" + LearnedIndexSidecar::kManifestName;
+  const std::string header = "learned_index_manifest\t" +
+                             std::to_string(LearnedIndexSidecar::kVersion) +
+                             "\t";
+  for (const std::string& contents :
+       {header + "x1\n",
+        header + "1\nalex\tbigint\tt\tid\t0\tmany\t1\t2\tf.lidx\n",
+        header + "1\nalex\tbigint\tt\tid\t0\t99999999999999999999\t1\t2\tf\n",
+        header + "1\nalex\tbigint\tt\tid\t0\t-1\t1\t2\tf.lidx\n"}) {
+    Reset();
+    WriteText(path, contents);
+    uint64_t generation = 0;
+    std::vector<LearnedIndexManifestEntry> entries;
+    std::string error;
+    CHECK(!LearnedIndexSidecar::ReadManifest(kDirectory, &generation,
+                                             &entries, &error));
+    CHECK(!error.empty());
+  }
+}
+
+void TestPairsRoundTrip() {
+  Reset();
+  const std::string path = kDirectory + "/pairs.lidx";
+  std::vector<std::pair<int64_t, double>> pairs = {{1, 0.5}, {2, 1.5}};
+  std::string error;
+  CHECK(LearnedIndexSidecar::WritePairs(path, pairs, &error));
+  std::vector<std::pair<int64_t, double>> read;
+  CHECK(LearnedIndexSidecar::ReadPairs(path, &read, &error));
+  CHECK(read == pairs);
+}
+
+// A count beyond what the file holds is rejected before anything is
+// allocated for it.
+void TestPairsCountIsBounded() {
+  Reset();
+  const std::string path = kDirectory + "/pairs.lidx";
+  std::vector<std::pair<int64_t, double>> pairs = {{1, 0.5}, {2, 1.5}};
+  std::string error;
+  CHECK(LearnedIndexSidecar::WritePairs(path, pairs, &error));
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    // The count is the last field of the header.
+    const uint64_t count = UINT64_MAX / 2;
+    file.seekp(24);
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+  }
+  std::vector<std::pair<int64_t, double>> read;
+  CHECK(!LearnedIndexSidecar::ReadPairs(path, &read, &error));
+  CHECK(read.empty());
+
+  // So is a file that lost its last pair.
+  CHECK(LearnedIndexSidecar::WritePairs(path, pairs, &error));
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+  CHECK(!LearnedIndexSidecar::ReadPairs(path, &read, &error));
+  std::filesystem::remove_all(kDirectory);
+}
+
+}  // namespace
+}  // namespace duckdb
+
+int main() {
+  duckdb::TestManifestRoundTrip();
+  duckdb::TestCorruptManifestIsReported();
+  duckdb::TestPairsRoundTrip();
+  duckdb::TestPairsCountIsBounded();
+  return TEST_RESULT();
+}
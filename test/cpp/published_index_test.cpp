@@ -0,0 +1,107 @@
+#include "published_index.h"
+
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+namespace duckdb {
+namespace {
+
+using Index = std::map<int, double>;
+
+void TestPublishReplaysWrites() {
+  PublishedIndex<Index> index;
+  index.ApplyWrite([](Index& map) { map[1] = 1.0; });
+  {
+    PublishedIndex<Index>::ScopedRebuild rebuild(index);
+    CHECK(index.IsRebuilding());
+    // The scan of the rebuild saw key 1, key 2 is written while it runs.
+    auto next = std::make_shared<Index>(Index{{1, 1.0}});
+    index.ApplyWrite([](Index& map) { map[2] = 2.0; });
+    index.Publish(next);
+    CHECK(!index.IsRebuilding());
+  }
+  CHECK(!index.IsRebuilding());
+  CHECK_EQ(index->size(), 2u);
+  CHECK_EQ(index->at(2), 2.0);
+}
+
+void TestFailedRebuildIsAborted() {
+  PublishedIndex<Index> index;
+  try {
+    PublishedIndex<Index>::ScopedRebuild rebuild(index);
+    index.ApplyWrite([](Index& map) { map[1] = 1.0; });
+    throw std::runtime_error("scan failed");
+  } catch (const std::runtime_error&) {
+  }
+  CHECK(!index.IsRebuilding());
+  // The current version kept the write, later writes are not queued for a
+  // rebuild that will never publish.
+  CHECK_EQ(index->size(), 1u);
+  index.ApplyWrite([](Index& map) { map[2] = 2.0; });
+  auto next = std::make_shared<Index>();
+  index.Publish(next);
+  CHECK(index->empty());
+}
+
+void TestAbortRebuild() {
+  PublishedIndex<Index> index;
+  index.BeginRebuild();
+  index.ApplyWrite([](Index& map) { map[1] = 1.0; });
+  index.AbortRebuild();
+  CHECK(!index.IsRebuilding());
+  CHECK_EQ(index->size(), 1u);
+}
+
+void TestLoader() {
+  PublishedIndex<Index> index;
+  int loads = 0;
+  index.SetLoader([&loads]() {
+    ++loads;
+    return std::make_shared<Index>(Index{{1, 1.0}});
+  });
+  CHECK_EQ(loads, 0);
+  CHECK_EQ(index->size(), 1u);
+  CHECK_EQ(index->size(), 1u);
+  CHECK_EQ(loads, 1);
+
+  // A rebuild before the first access drops the loader.
+  PublishedIndex<Index> rebuilt;
+  rebuilt.SetLoader([]() { return std::make_shared<Index>(Index{{1, 1.0}}); });
+  { PublishedIndex<Index>::ScopedRebuild rebuild(rebuilt); }
+  CHECK(rebuilt->empty());
+}
+
+// Exclusive reads may update the index, like the lookup counters of ALEX, as
+// they run one at a time and never alongside a write.
+void TestReadExclusive() {
+  PublishedIndex<Index> index;
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < 4; ++thread) {
+    threads.emplace_back([&index, thread]() {
+      for (int i = 0; i < 1000; ++i) {
+        index.ReadExclusive([](Index& map) { map[0] += 1; });
+        index.ApplyWrite([thread](Index& map) { map[thread + 1] += 1; });
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  CHECK_EQ(index.ReadExclusive([](Index& map) { return map.at(0); }), 4000.0);
+  CHECK_EQ(index->at(4), 1000.0);
+}
+
+}  // namespace
+}  // namespace duckdb
+
+int main() {
+  duckdb::TestPublishReplaysWrites();
+  duckdb::TestFailedRebuildIsAborted();
+  duckdb::TestAbortRebuild();
+  duckdb::TestLoader();
+  duckdb::TestReadExclusive();
+  return TEST_RESULT();
+}
@@ -0,0 +1,192 @@
+#include "updatable_radix_spline.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+namespace rs {
+namespace {
+
+using Index = UpdatableRadixSpline<uint64_t>;
+
+std::vector<uint64_t> Range(uint64_t begin, uint64_t end, uint64_t step) {
+  std::vector<uint64_t> keys;
+  for (uint64_t key = begin; key < end; key += step) keys.push_back(key);
+  return keys;
+}
+
+void TestEmpty() {
+  Index index;
+  CHECK_EQ(index.GetNumKeys(), 0u);
+  CHECK(!index.Contains(1));
+  CHECK_EQ(index.CountRange(0, 100), 0u);
+  CHECK_EQ(index.GetStats().num_keys, 0u);
+  CHECK_EQ(index.ProfileErrors().num_keys, 0u);
+  index.Build({});
+  CHECK_EQ(index.GetNumKeys(), 0u);
+  index.Erase(1);
+  CHECK_EQ(index.GetNumKeys(), 0u);
+  index.Insert(1);
+  CHECK(index.Contains(1));
+  CHECK_EQ(index.GetNumKeys(), 1u);
+}
+
+void TestSingleKey() {
+  Index index;
+  index.Build({42});
+  CHECK(index.Contains(42));
+  CHECK(!index.Contains(41));
+  CHECK(!index.Contains(43));
+  CHECK_EQ(index.GetNumKeys(), 1u);
+  CHECK_EQ(index.CountRange(0, 100), 1u);
+  CHECK_EQ(index.ProfileErrors().max_measured_error, 0u);
+}
+
+void TestEqualKeys() {
+  // All keys equal: the builder must not take the leading zeros of 0.
+  Index index;
+  index.Build(std::vector<uint64_t>(100, 7));
+  CHECK(index.Contains(7));
+  CHECK_EQ(index.GetNumKeys(), 1u);
+  CHECK_EQ(index.CountRange(7, 8), 1u);
+}
+
+void TestDuplicateInserts() {
+  Index index;
+  index.SetMergeThreshold(1000000);
+  index.Build(Range(0, 1000, 10));
+  // A key of the spline and a key of the delta buffer, inserted again.
+  index.Insert(10);
+  index.Insert(15);
+  index.Insert(15);
+  CHECK_EQ(index.GetNumKeys(), 101u);
+  CHECK_EQ(index.GetDeltaSize(), 1u);
+  CHECK_EQ(index.CountRange(10, 20), 2u);
+
+  // An erased key of the spline comes back without a second copy.
+  index.Erase(20);
+  CHECK(!index.Contains(20));
+  CHECK_EQ(index.GetNumKeys(), 100u);
+  index.Insert(20);
+  CHECK(index.Contains(20));
+  CHECK_EQ(index.GetNumKeys(), 101u);
+  CHECK_EQ(index.GetTombstoneCount(), 0u);
+
+  index.Erase(15);
+  index.Erase(15);
+  CHECK(!index.Contains(15));
+  CHECK_EQ(index.GetNumKeys(), 100u);
+}
+
+void TestInsertBatch() {
+  Index index;
+  index.SetMergeThreshold(8);
+  index.Build(Range(0, 100, 10));
+  index.Erase(20);
+  // Keys of the spline, an erased one, new ones and new ones twice.
+  index.InsertBatch({10, 20, 25, 25, 35, 1000});
+  CHECK_EQ(index.GetNumKeys(), 13u);
+  CHECK_EQ(index.GetTombstoneCount(), 0u);
+  CHECK_EQ(index.GetDeltaSize(), 3u);
+  index.InsertBatch({});
+  // A batch larger than the buffer merges once.
+  index.InsertBatch(Range(2000, 2100, 1));
+  index.WaitForMerge();
+  CHECK_EQ(index.GetNumKeys(), 113u);
+  CHECK_EQ(index.GetDeltaSize(), 0u);
+  for (uint64_t key : {20, 25, 35, 1000, 2050}) CHECK(index.Contains(key));
+}
+
+void TestMergeKeepsKeysOnce() {
+  Index index;
+  index.SetMergeThreshold(4);
+  index.Build(Range(0, 100, 1));
+  // Keys that are there, then new ones that fill the buffer and merge.
+  for (uint64_t key = 0; key < 10; ++key) index.Insert(key);
+  for (uint64_t key = 100; key < 110; ++key) index.Insert(key);
+  for (uint64_t key = 100; key < 110; ++key) index.Insert(key);
+  index.WaitForMerge();
+  CHECK_EQ(index.GetNumKeys(), 110u);
+  CHECK_EQ(index.CountRange(0, 1000), 110u);
+  for (uint64_t key = 0; key < 110; ++key) CHECK(index.Contains(key));
+
+  // A merge down to a single key.
+  for (uint64_t key = 1; key < 110; ++key) index.Erase(key);
+  index.WaitForMerge();
+  CHECK_EQ(index.GetNumKeys(), 1u);
+  CHECK(index.Contains(0));
+  index.Insert(0);
+  index.Erase(0);
+  index.WaitForMerge();
+  CHECK_EQ(index.GetNumKeys(), 0u);
+}
+
+void TestAbortedBuild() {
+  Index index;
+  index.SetMergeThreshold(4);
+  index.Build(Range(0, 100, 1));
+  // Updates during a build that fails stay in the delta buffer, and merges
+  // resume once the build is aborted.
+  index.BeginBuild();
+  for (uint64_t key = 100; key < 110; ++key) index.Insert(key);
+  index.Erase(0);
+  index.AbortBuild();
+  index.WaitForMerge();
+  CHECK_EQ(index.GetNumKeys(), 109u);
+  CHECK_EQ(index.GetDeltaSize(), 0u);
+  CHECK(!index.Contains(0));
+  CHECK(index.Contains(109));
+}
+
+void TestBuildWithDuplicates() {
+  Index index;
+  index.Build({1, 1, 2, 3, 3, 3, 4});
+  CHECK_EQ(index.GetNumKeys(), 4u);
+  CHECK_EQ(index.CountRange(1, 4), 3u);
+  CHECK_EQ(index.ProfileErrors().num_keys, 4u);
+}
+
+void TestSaveAndLoadSingleKey() {
+  const std::string path = "updatable_radix_spline_test.rs";
+  std::string error;
+  Index index;
+  index.Build({5, 5});
+  CHECK(index.Save(path, &error));
+  Index loaded;
+  CHECK(loaded.Load(path, &error));
+  CHECK(loaded.Contains(5));
+  CHECK_EQ(loaded.GetNumKeys(), 1u);
+  std::remove(path.c_str());
+}
+
+void TestCompressed() {
+  Index index;
+  index.SetCompressed(true);
+  index.Build({3});
+  CHECK(index.Contains(3));
+  index.Build(Range(0, 100000, 3));
+  CHECK(index.Contains(99999));
+  CHECK(!index.Contains(100000));
+  CHECK(index.ProfileErrors().max_measured_error <=
+        index.GetStats().max_error + 1);
+}
+
+}  // namespace
+}  // namespace rs
+
+int main() {
+  rs::TestEmpty();
+  rs::TestSingleKey();
+  rs::TestEqualKeys();
+  rs::TestDuplicateInserts();
+  rs::TestInsertBatch();
+  rs::TestMergeKeepsKeysOnce();
+  rs::TestAbortedBuild();
+  rs::TestBuildWithDuplicates();
+  rs::TestSaveAndLoadSingleKey();
+  rs::TestCompressed();
+  return TEST_RESULT();
+}